@@ -0,0 +1,64 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__COALESCING_OPTIONS_H_
+#define RCL__COALESCING_OPTIONS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+/// Settings coalescing the messages of a publisher into frames.
+/**
+ * A coalescing publisher serializes its messages into a frame instead of
+ * publishing them one by one, and publishes the frame as a single serialized
+ * message once it is due: when the window opened by the frame's first message
+ * elapsed, when it holds max_messages messages or reaches max_frame_size
+ * bytes, on rcl_publisher_flush(), or when the publisher is finalized.
+ * Each coalescing publisher has a thread of its own publishing the frames whose
+ * window elapsed while the publisher was idle, so no message waits much longer
+ * than the window.
+ *
+ * Frames are published on a topic of their own, the publisher's topic name
+ * followed by `/_coalesced`, which is also what rcl_publisher_get_topic_name()
+ * returns. Only subscriptions with split_coalesced_frames set subscribe to it,
+ * and split the frames back into the original messages in rcl_take() and
+ * rcl_take_sequence(). Other subscriptions to the topic do not receive the
+ * messages of coalescing publishers, nor splitting subscriptions the messages
+ * of publishers that do not coalesce.
+ *
+ * A window of `0` disables coalescing, the other `0` values select the
+ * built-in defaults:
+ *
+ * - max_messages: 256
+ * - max_frame_size: 8192 bytes
+ */
+typedef struct rcl_coalescing_options_t
+{
+  /// Longest time in seconds the first message of a frame waits for others.
+  double window;
+  /// Most messages in a frame.
+  size_t max_messages;
+  /// Size in bytes at which a frame is published, a larger message gets a frame of its own.
+  size_t max_frame_size;
+} rcl_coalescing_options_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__COALESCING_OPTIONS_H_
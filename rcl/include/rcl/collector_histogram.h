@@ -0,0 +1,169 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__COLLECTOR_HISTOGRAM_H_
+#define RCL__COLLECTOR_HISTOGRAM_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcl/macros.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+
+/// Each power of two range is split into 2^(bits - 1) buckets, i.e. ~3% relative precision.
+#define RCL_COLLECTOR_HISTOGRAM_SUB_BUCKET_BITS 5
+/// Values of 2^bits and more are counted in the last bucket, ~18 minutes in nanoseconds.
+#define RCL_COLLECTOR_HISTOGRAM_VALUE_BITS 40
+#define RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT \
+  ((RCL_COLLECTOR_HISTOGRAM_VALUE_BITS - RCL_COLLECTOR_HISTOGRAM_SUB_BUCKET_BITS + 2) << \
+  (RCL_COLLECTOR_HISTOGRAM_SUB_BUCKET_BITS - 1))
+
+#define RCL_COLLECTOR_HISTOGRAM_MAGIC "RCLTHIST"
+#define RCL_COLLECTOR_HISTOGRAM_VERSION 2u
+#define RCL_COLLECTOR_HISTOGRAM_SLOT_COUNT 64u
+
+/// Log-bucketed histogram with linear sub-buckets, HDR histogram style.
+typedef struct rcl_collector_histogram_t
+{
+  /// Number of recorded values.
+  uint64_t total;
+  /// Number of recorded values per bucket.
+  uint64_t counts[RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT];
+} rcl_collector_histogram_t;
+
+#define RCL_COLLECTOR_HISTOGRAM_TOPIC_NAME_MAX 256
+
+/// Histograms of one collector-enabled publisher.
+typedef struct rcl_collector_histogram_slot_t
+{
+  /// Non zero while a publisher owns the slot.
+  uint32_t in_use;
+  /// Messages collected but not recorded, as concurrent publishes outpaced the collector.
+  uint32_t dropped;
+  /// Null terminated, possibly truncated, topic name.
+  char topic_name[RCL_COLLECTOR_HISTOGRAM_TOPIC_NAME_MAX];
+  /// Nanoseconds between two publishes, or two takes.
+  rcl_collector_histogram_t interval;
+  /// Message sizes in bytes.
+  rcl_collector_histogram_t size;
+  /// Nanoseconds spent publishing, from the collector sample to the middleware's return,
+  /// or for subscriptions (topic name `<topic>@<node>`) from the source timestamp to the take.
+  rcl_collector_histogram_t duration;
+} rcl_collector_histogram_slot_t;
+
+/// Header of the shared memory file, followed by `slot_count` slots.
+/**
+ * Each context with collector-enabled publishers or subscriptions maps a
+ * shared memory file named `/rcl_traffic_histograms_<pid>_<context instance id>`,
+ * removed when the context is finalized.
+ * The file is an rcl_collector_histogram_file_header_t followed by `slot_count`
+ * rcl_collector_histogram_slot_t, laid out with the platform's natural alignment.
+ *
+ * The layout is an ABI, versioned by #RCL_COLLECTOR_HISTOGRAM_VERSION:
+ *
+ * - Any change to the layout of the file, or to the bucket boundaries computed by
+ *   rcl_collector_histogram_index() and rcl_collector_histogram_lowest(), bumps the version.
+ * - Readers must check `magic`, which is written last, and `version` before
+ *   interpreting anything else, and take `slot_count`, `bucket_count` and
+ *   `sub_bucket_bits` from the header rather than from the macros they were built with.
+ * - Version 2, the current one, has 64 slots of 592 buckets, with 5 sub-bucket bits.
+ *
+ * Readers may see a histogram mid-update, i.e. `total` may briefly disagree
+ * with the sum of the counts.
+ */
+typedef struct rcl_collector_histogram_file_header_t
+{
+  /// #RCL_COLLECTOR_HISTOGRAM_MAGIC, without its null terminator.
+  char magic[8];
+  /// #RCL_COLLECTOR_HISTOGRAM_VERSION of the writer.
+  uint32_t version;
+  uint32_t slot_count;
+  /// Number of buckets of each histogram.
+  uint32_t bucket_count;
+  /// #RCL_COLLECTOR_HISTOGRAM_SUB_BUCKET_BITS of the writer, the bucket boundaries follow.
+  uint32_t sub_bucket_bits;
+  /// Process writing the file.
+  uint64_t pid;
+} rcl_collector_histogram_file_header_t;
+
+/// Return the bucket `value` is counted in.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[in] value to count, values above 2^#RCL_COLLECTOR_HISTOGRAM_VALUE_BITS - 1
+ *   are counted in the last bucket
+ * \return the index of the bucket, less than #RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+size_t
+rcl_collector_histogram_index(uint64_t value);
+
+/// Return the lowest value counted in bucket `index`.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[in] index of the bucket, less than #RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT
+ * \return the lowest value of the bucket
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+uint64_t
+rcl_collector_histogram_lowest(size_t index);
+
+/// Return the lowest value of the bucket holding the given percentile, `0` if empty.
+/**
+ * Histograms read from a shared memory file may be mid-update, the result is
+ * then that of a histogram with a few more or fewer values.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[in] histogram to read
+ * \param[in] percentile between `0` and `100`
+ * \return the lowest value of the bucket holding the percentile
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+uint64_t
+rcl_collector_histogram_percentile(const rcl_collector_histogram_t * histogram, double percentile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__COLLECTOR_HISTOGRAM_H_
@@ -0,0 +1,60 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__COLLECTOR_OPTIONS_H_
+#define RCL__COLLECTOR_OPTIONS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+/// Settings of the traffic model collector of a collector-enabled publisher or subscription.
+/**
+ * A value of `0` selects the value of the corresponding environment variable,
+ * or the built-in default if that is not set either:
+ *
+ * - history_length: `ROS_TRAFFIC_MODEL_HISTORY_LENGTH`, 100 samples
+ * - warmup: `ROS_TRAFFIC_MODEL_WARMUP`, 10 samples
+ * - model_freshness: `ROS_TRAFFIC_MODEL_FRESHNESS`, 15 seconds
+ * - predictable_threshold: `ROS_TRAFFIC_MODEL_PREDICTABLE_THRESHOLD`, 5e-3
+ * - max_period_components: `ROS_TRAFFIC_MODEL_MAX_PERIOD_COMPONENTS`, 1, i.e. no periodicity
+ *   analysis
+ */
+typedef struct rcl_collector_options_t
+{
+  /// Number of most recent messages the traffic model is fitted over, at least 3.
+  size_t history_length;
+  /// Number of messages collected before the first fit, at most history_length.
+  size_t warmup;
+  /// Age in seconds after which the model is refitted even if it still predicts well.
+  double model_freshness;
+  /// Period jitter, relative to the period, under which the topic is considered predictable.
+  double predictable_threshold;
+  /// Most messages per cycle a composite (bursty or multi-rate) time model may have, at most 16.
+  /**
+   * Above 1, the collector looks for the shortest cycle of messages over which
+   * message times repeat, e.g. 3 for a camera sending 3 frames per trigger, and
+   * reports one component per message of the cycle.
+   */
+  size_t max_period_components;
+} rcl_collector_options_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__COLLECTOR_OPTIONS_H_
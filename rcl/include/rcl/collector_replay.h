@@ -0,0 +1,143 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__COLLECTOR_REPLAY_H_
+#define RCL__COLLECTOR_REPLAY_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcl/allocator.h"
+#include "rcl/collector_options.h"
+#include "rcl/macros.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+
+/// Model of one message position within the cycle of a composite time model.
+typedef struct rcl_collector_replay_component_t
+{
+  /// Phase in seconds and time sigma of the messages at this position.
+  double b;
+  double sigma_t;
+  /// Mean size and size sigma in bytes of the messages at this position.
+  double s;
+  double sigma_s;
+} rcl_collector_replay_component_t;
+
+/// A traffic model fitted while replaying, as a collector would report it.
+typedef struct rcl_collector_replay_update_t
+{
+  /// Number of samples fed before the update, counting the one that caused it.
+  size_t sample;
+  /// Time of that sample, in seconds.
+  double time;
+  /// Period and phase in seconds, and time sigma, of the time model.
+  double a;
+  double b;
+  double sigma_t;
+  /// Mean size and size sigma in bytes.
+  double s;
+  double sigma_s;
+  /// Cycle in seconds of a composite time model, and its components, `0` if there are none.
+  double cycle;
+  size_t component_count;
+  const rcl_collector_replay_component_t * components;
+} rcl_collector_replay_update_t;
+
+/// Called with every model update, the update is only valid during the call.
+typedef void (* rcl_collector_replay_callback_t)(
+  const rcl_collector_replay_update_t * update, void * state);
+
+struct rcl_collector_replay_impl_t;
+
+/// Traffic model fitter of a collector, driven by recorded message times instead of a topic.
+/**
+ * Replaying a trace of (time, size) samples, e.g. derived from a bag, yields
+ * the same model updates a collector with the same options would have reported
+ * for the topic, which allows tuning the collector options offline.
+ */
+typedef struct rcl_collector_replay_t
+{
+  struct rcl_collector_replay_impl_t * impl;
+} rcl_collector_replay_t;
+
+/// Return a rcl_collector_replay_t struct with members set to `NULL`.
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_collector_replay_t
+rcl_get_zero_initialized_collector_replay(void);
+
+/// Initialize a replay.
+/**
+ * \param[inout] replay zero initialized replay
+ * \param[in] options collector options, `0` values resolved as for a publisher
+ * \param[in] sampling only every sampling-th sample is collected, `0` or `1` for all
+ * \param[in] callback called with every model update, may be `NULL`
+ * \param[in] callback_state passed to the callback
+ * \param[in] allocator allocator for the replay state
+ * \return `RCL_RET_OK` if the replay was initialized, or
+ * \return `RCL_RET_ALREADY_INIT` if the replay was already initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_collector_replay_init(
+  rcl_collector_replay_t * replay,
+  const rcl_collector_options_t * options,
+  size_t sampling,
+  rcl_collector_replay_callback_t callback,
+  void * callback_state,
+  rcl_allocator_t allocator);
+
+/// Feed a batch of samples, in the order they were recorded.
+/**
+ * \param[in] replay initialized replay
+ * \param[in] times sample times in nanoseconds of any monotonic clock
+ * \param[in] sizes serialized message sizes in bytes
+ * \param[in] count number of samples
+ * \return `RCL_RET_OK` if the samples were fed, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_collector_replay_feed(
+  rcl_collector_replay_t * replay,
+  const int64_t * times,
+  const size_t * sizes,
+  size_t count);
+
+/// Finalize a replay.
+/**
+ * \return `RCL_RET_OK` if the replay was finalized or was not initialized, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_collector_replay_fini(rcl_collector_replay_t * replay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__COLLECTOR_REPLAY_H_
@@ -32,8 +32,40 @@ typedef enum rcl_publisher_event_type_t
   RCL_PUBLISHER_OFFERED_DEADLINE_MISSED,
   RCL_PUBLISHER_LIVELINESS_LOST,
   RCL_PUBLISHER_OFFERED_INCOMPATIBLE_QOS,
+  /// Publishes departing from the traffic model of the publisher's collector.
+  /**
+   * Only publishers with a collector, as selected by the collector policy, support it.
+   * The event info taken is a rcl_traffic_anomaly_status_t.
+   */
+  RCL_PUBLISHER_TRAFFIC_ANOMALY,
 } rcl_publisher_event_type_t;
 
+/// Ways a collected publish can depart from the traffic model of its topic.
+typedef enum rcl_traffic_anomaly_kind_t
+{
+  /// The publish is off its predicted time by more than 3 sigma, with no period skipped.
+  RCL_TRAFFIC_ANOMALY_MODEL_BREAK,
+  /// Whole periods went by since the previous publish, offset from one period after it.
+  RCL_TRAFFIC_ANOMALY_MISSED_PERIOD,
+  /// The message size is off the modelled size by more than 3 sigma.
+  RCL_TRAFFIC_ANOMALY_SIZE_OUTLIER,
+} rcl_traffic_anomaly_kind_t;
+
+/// Event info of RCL_PUBLISHER_TRAFFIC_ANOMALY.
+typedef struct rcl_traffic_anomaly_status_t
+{
+  /// Total number of anomalies detected since the event was initialized.
+  int32_t total_count;
+  /// Number of anomalies detected since the last take.
+  int32_t total_count_change;
+  /// Kind of the latest anomaly.
+  rcl_traffic_anomaly_kind_t last_kind;
+  /// Measured minus modelled value of the latest anomaly, in seconds or bytes.
+  double offset;
+  /// The offset in standard deviations of the model, infinite if the model has none.
+  double deviation;
+} rcl_traffic_anomaly_status_t;
+
 typedef enum rcl_subscription_event_type_t
 {
   RCL_SUBSCRIPTION_REQUESTED_DEADLINE_MISSED,
@@ -68,6 +100,10 @@ rcl_get_zero_initialized_event(void);
 /**
  * Fill the rcl_event_t with the publisher and desired event_type.
  *
+ * RCL_PUBLISHER_TRAFFIC_ANOMALY events are raised by rcl rather than the
+ * middleware, a publisher has at most one of them at a time.
+ * Anomalies are only detected while the event exists.
+ *
  * \param[in,out] event pointer to fill
  * \param[in] publisher to get events from
  * \param[in] event_type to listen for
@@ -153,6 +189,8 @@ rcl_event_fini(rcl_event_t * event);
  * Therefore it is recommended to get the handle from the event using
  * this function each time it is needed and avoid use of the handle
  * concurrently with functions that might change it.
+ * Events raised by rcl, such as RCL_PUBLISHER_TRAFFIC_ANOMALY, have a handle
+ * without middleware data.
  *
  * <hr>
  * Attribute          | Adherence
@@ -22,8 +22,11 @@ extern "C"
 
 #include "rosidl_runtime_c/message_type_support_struct.h"
 
+#include "rcl/coalescing_options.h"
+#include "rcl/collector_options.h"
 #include "rcl/macros.h"
 #include "rcl/node.h"
+#include "rcl/traffic_shaping_options.h"
 #include "rcl/visibility_control.h"
 
 /// Internal rcl publisher implementation struct.
@@ -46,8 +49,40 @@ typedef struct rcl_publisher_options_t
   rcl_allocator_t allocator;
   /// rmw specific publisher options, e.g. the rmw implementation specific payload.
   rmw_publisher_options_t rmw_publisher_options;
+  /// Traffic model collector settings, only used if the publisher has a collector.
+  rcl_collector_options_t collector_options;
+  /// Shaping of the publisher's sends around urgent traffic, only used without a collector.
+  rcl_traffic_shaping_options_t traffic_shaping;
+  /// Idle buffers kept for rcl_publisher_acquire_serialized_message(), `0` for no pool.
+  size_t serialized_message_pool_size;
+  /// Coalescing of the publisher's messages into frames, disabled by a `0` window.
+  rcl_coalescing_options_t coalescing;
 } rcl_publisher_options_t;
 
+/// Number of buckets of the publish duration histogram of rcl_publisher_statistics_t.
+#define RCL_PUBLISHER_STATISTICS_DURATION_BUCKETS 32
+
+/// Counters of the middleware publish calls of a publisher, see rcl_publisher_get_statistics().
+typedef struct rcl_publisher_statistics_t
+{
+  /// Messages the middleware accepted, each message of a coalesced frame counting.
+  uint64_t message_count;
+  /// Serialized size in bytes of those messages, as far as rcl knows it.
+  /**
+   * Serialized messages and coalesced frames are counted in full, other
+   * messages only if the publisher's collector estimated their size.
+   */
+  uint64_t byte_count;
+  /// Middleware publish calls that failed.
+  uint64_t error_count;
+  /// Middleware publish calls by duration, bucket `i` counting those of [2^i, 2^(i+1)) ns.
+  /**
+   * The first bucket also counts calls shorter than a nanosecond, the last one
+   * all calls longer than its lower bound, i.e. about 2.1 seconds.
+   */
+  uint64_t publish_duration[RCL_PUBLISHER_STATISTICS_DURATION_BUCKETS];
+} rcl_publisher_statistics_t;
+
 /// Return a rcl_publisher_t struct with members set to `NULL`.
 /**
  * Should be called to get a null rcl_publisher_t before passing to
@@ -202,6 +237,10 @@ rcl_publisher_init_internal(
  * - qos = rmw_qos_profile_default
  * - allocator = rcl_get_default_allocator()
  * - rmw_publisher_options = rmw_get_default_publisher_options()
+ * - collector_options = all `0`, i.e. environment or built-in defaults
+ * - traffic_shaping = all `0`, i.e. RCL_TRAFFIC_SHAPING_NONE
+ * - serialized_message_pool_size = `0`
+ * - coalescing = all `0`, i.e. no coalescing
  */
 RCL_PUBLIC
 RCL_WARN_UNUSED
@@ -292,6 +331,10 @@ rcl_return_loaned_message_from_publisher(
  * For example, if the reliability is set to reliable, then a publish may block
  * until space in the publish queue is available, but if the reliability is set
  * to best effort then it should not block.
+ * Publishers with traffic shaping enabled, see rcl_traffic_shaping_options_t,
+ * also block before calling the middleware until the message may be sent.
+ * Coalescing publishers, see rcl_coalescing_options_t, serialize the message
+ * into a frame instead, and only call the middleware when the frame is due.
  *
  * The ROS message given by the `ros_message` void pointer is always owned by
  * the calling code, but should remain constant during publish.
@@ -334,6 +377,46 @@ rcl_publish(
   const void * ros_message,
   rmw_publisher_allocation_t * allocation);
 
+/// Publish several ROS messages on a topic using a publisher.
+/**
+ * Equivalent to calling rcl_publish() for each message in order, except that
+ * the publisher and arguments are validated once for the whole batch, and that
+ * the messages of collected publishers whose type supports size estimation are
+ * sampled and recorded by the collector at once, as published together.
+ * The publish duration of such a batch is shared evenly between its messages.
+ *
+ * The middleware has no batch publish, each message is passed to it in turn.
+ * Publishing stops at the first message the middleware fails to publish.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes [1]
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ * <i>[1] as for rcl_publish()</i>
+ *
+ * \param[in] publisher handle to the publisher which will do the publishing
+ * \param[in] ros_messages type-erased pointers to `count` ROS messages
+ * \param[in] count number of messages, `0` publishes nothing
+ * \param[in] allocation structure pointer, used for memory preallocation (may be NULL)
+ * \param[out] published_count set to the number of messages published, may be `NULL`
+ * \return `RCL_RET_OK` if all messages were published successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_publish_batch(
+  const rcl_publisher_t * publisher,
+  const void * const * ros_messages,
+  size_t count,
+  rmw_publisher_allocation_t * allocation,
+  size_t * published_count);
+
 /// Publish a serialized message on a topic using a publisher.
 /**
  * It is the job of the caller to ensure that the type of the serialized message
@@ -415,6 +498,95 @@ rcl_publish_loaned_message(
   void * ros_message,
   rmw_publisher_allocation_t * allocation);
 
+/// Publish the frame of a coalescing publisher right away.
+/**
+ * A coalescing publisher, see rcl_coalescing_options_t, publishes its frame
+ * once the window elapsed or the frame is full.
+ * This function publishes it before, e.g. ahead of a pause in the traffic.
+ * Nothing is published if the frame is empty or the publisher does not coalesce.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | No [1]
+ * <i>[1] waits for concurrent publishes appending to the frame, and for the frame before</i>
+ *
+ * \param[in] publisher handle to the publisher to flush
+ * \return `RCL_RET_OK` if the frame was published or there was nothing to publish, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_publisher_flush(const rcl_publisher_t * publisher);
+
+/// Acquire a serialized message buffer from the publisher's pool.
+/**
+ * The buffer is empty, with a capacity for the messages typically published
+ * on the topic, as learned from the buffers released to the pool, or from the
+ * collector's size model if the publisher has a collector.
+ * It is meant to be serialized into, or filled with a message received
+ * elsewhere, published with rcl_publish_serialized_message() and then returned
+ * with rcl_publisher_release_serialized_message(), which keeps up to the
+ * publisher's `serialized_message_pool_size` buffers for reuse, so that
+ * bridges republishing many topics do not allocate a buffer per message.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Maybe [1]
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ * <i>[1] only if the pool has no idle buffer</i>
+ *
+ * \param[in] publisher publisher created with a `serialized_message_pool_size` other than `0`
+ * \param[out] serialized_message set to the acquired buffer, owned by the pool
+ * \return `RCL_RET_OK` if a buffer was acquired, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_UNSUPPORTED` if the publisher has no serialized message pool, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_publisher_acquire_serialized_message(
+  const rcl_publisher_t * publisher,
+  rcl_serialized_message_t ** serialized_message);
+
+/// Return a serialized message buffer acquired from the publisher's pool.
+/**
+ * The buffer is kept for reuse if the pool has room for it, and freed
+ * otherwise, as are buffers grown far beyond the typical message size.
+ * It must not be used after this call.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[in] publisher publisher the buffer was acquired from
+ * \param[in] serialized_message buffer returned by rcl_publisher_acquire_serialized_message()
+ * \return `RCL_RET_OK` if the buffer was returned, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_UNSUPPORTED` if the publisher has no serialized message pool.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_publisher_release_serialized_message(
+  const rcl_publisher_t * publisher,
+  rcl_serialized_message_t * serialized_message);
+
 /// Manually assert that this Publisher is alive (for RMW_QOS_POLICY_LIVELINESS_MANUAL_BY_TOPIC)
 /**
  * If the rmw Liveliness policy is set to RMW_QOS_POLICY_LIVELINESS_MANUAL_BY_TOPIC, the creator of
@@ -651,6 +823,40 @@ RCL_PUBLIC
 bool
 rcl_publisher_can_loan_messages(const rcl_publisher_t * publisher);
 
+/// Get the counters of the middleware publish calls of a publisher.
+/**
+ * The counters are kept from the publisher's initialization on, for every
+ * call to the middleware's publish functions, without enabling tracing.
+ * Each counter is read atomically, but the counters are not read together,
+ * so a publish concurrent with this call may be counted in some and not yet
+ * in others.
+ *
+ * Statistics are only kept if rcl is built with the CMake option
+ * `RCL_ENABLE_PUBLISHER_STATISTICS`, on by default; without it publishing
+ * neither reads the clock nor updates any counter.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[in] publisher pointer to the rcl publisher
+ * \param[out] statistics set to the counters of the publisher
+ * \return `RCL_RET_OK` if the statistics were copied, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_UNSUPPORTED` if rcl was built without publisher statistics.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_publisher_get_statistics(
+  const rcl_publisher_t * publisher,
+  rcl_publisher_statistics_t * statistics);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,385 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__SHARDED_WAIT_SET_H_
+#define RCL__SHARDED_WAIT_SET_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcl/allocator.h"
+#include "rcl/client.h"
+#include "rcl/context.h"
+#include "rcl/event.h"
+#include "rcl/guard_condition.h"
+#include "rcl/macros.h"
+#include "rcl/service.h"
+#include "rcl/subscription.h"
+#include "rcl/timer.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+#include "rcl/work_deque.h"
+
+/// Type of the entity behind the work of a sharded wait set.
+typedef enum rcl_sharded_work_type_t
+{
+  RCL_SHARDED_WORK_SUBSCRIPTION,
+  RCL_SHARDED_WORK_GUARD_CONDITION,
+  RCL_SHARDED_WORK_TIMER,
+  RCL_SHARDED_WORK_CLIENT,
+  RCL_SHARDED_WORK_SERVICE,
+  RCL_SHARDED_WORK_EVENT,
+} rcl_sharded_work_type_t;
+
+/// An entity of a sharded wait set, pushed to a work deque whenever it is ready.
+typedef struct rcl_sharded_work_t
+{
+  /// Type of the entity.
+  rcl_sharded_work_type_t type;
+  /// The entity, e.g. a `const rcl_subscription_t *`, or `NULL` once it was removed.
+  const void * entity;
+  /// Index of the shard waiting for the entity.
+  size_t shard;
+} rcl_sharded_work_t;
+
+struct rcl_sharded_wait_set_impl_t;
+
+/// Entities spread across several wait sets, each waited on by a thread of its own.
+/**
+ * Each shard is a persistent wait set, see rcl_wait_set_set_persistent(), and
+ * a new entity is given to the shard with the fewest entities of its type.
+ * The threads of an executor each wait on a shard with
+ * rcl_sharded_wait_set_wait(), which pushes the work of the ready entities to
+ * the work deque of the waiting thread.
+ * Idle threads steal work from the deques of the others before they wait.
+ *
+ * Once pushed, an entity is taken out of its shard until its work is handed
+ * back with rcl_sharded_wait_set_done(), so that it is processed by one thread
+ * at a time, and neither wakes its shard nor is pushed again meanwhile.
+ *
+ * Every shard has a guard condition of its own, triggered to wake it by
+ * rcl_sharded_wait_set_wake(), by rcl_sharded_wait_set_wake_all() e.g. to
+ * shut the executor down, and when work of the shard is handed back.
+ */
+typedef struct rcl_sharded_wait_set_t
+{
+  /// Number of shards.
+  size_t size_of_shards;
+  /// Private implementation pointer.
+  struct rcl_sharded_wait_set_impl_t * impl;
+} rcl_sharded_wait_set_t;
+
+/// Return a rcl_sharded_wait_set_t struct with members set to `NULL`.
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_sharded_wait_set_t
+rcl_get_zero_initialized_sharded_wait_set(void);
+
+/// Initialize a sharded wait set.
+/**
+ * The numbers of entities are those of the whole set, as given to
+ * rcl_wait_set_init(), and each shard has room for its share of them.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] sharded_wait_set the zero initialized sharded wait set
+ * \param[in] number_of_shards number of wait sets, greater than `0`
+ * \param[in] number_of_subscriptions most subscriptions in the set
+ * \param[in] number_of_guard_conditions most guard conditions in the set
+ * \param[in] number_of_timers most timers in the set
+ * \param[in] number_of_clients most clients in the set
+ * \param[in] number_of_services most services in the set
+ * \param[in] number_of_events most events in the set
+ * \param[in] context the context that the wait sets are associated with
+ * \param[in] allocator the allocator to use
+ * \return `RCL_RET_OK` if the sharded wait set was initialized successfully, or
+ * \return `RCL_RET_ALREADY_INIT` if the sharded wait set was already initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if creating a wait set failed, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_init(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  size_t number_of_shards,
+  size_t number_of_subscriptions,
+  size_t number_of_guard_conditions,
+  size_t number_of_timers,
+  size_t number_of_clients,
+  size_t number_of_services,
+  size_t number_of_events,
+  rcl_context_t * context,
+  rcl_allocator_t allocator);
+
+/// Finalize a sharded wait set.
+/**
+ * No thread may wait on a shard, or hold work of the set, at the time.
+ * Work still in deques is invalid afterwards.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] sharded_wait_set the sharded wait set to be finalized
+ * \return `RCL_RET_OK` if finalized successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if finalizing a wait set failed, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_fini(rcl_sharded_wait_set_t * sharded_wait_set);
+
+/// Add a subscription to the shard with the fewest subscriptions.
+/**
+ * Entities are added and removed while no thread waits on a shard or
+ * processes work of the set, e.g. after rcl_sharded_wait_set_wake_all().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Maybe [1]
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ * <i>[1] unless the work of a removed entity is reused</i>
+ *
+ * \param[inout] sharded_wait_set the sharded wait set to add the subscription to
+ * \param[in] subscription the subscription to be added
+ * \param[out] work the work of the subscription, to remove it (optional)
+ * \return `RCL_RET_OK` if added successfully, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the sharded wait set is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_FULL` if the set already holds its number of subscriptions, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_add_subscription(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_subscription_t * subscription,
+  const rcl_sharded_work_t ** work);
+
+/// Add a guard condition to the shard with the fewest guard conditions.
+/**
+ * \sa rcl_sharded_wait_set_add_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_add_guard_condition(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_guard_condition_t * guard_condition,
+  const rcl_sharded_work_t ** work);
+
+/// Add a timer to the shard with the fewest timers.
+/**
+ * \sa rcl_sharded_wait_set_add_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_add_timer(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_timer_t * timer,
+  const rcl_sharded_work_t ** work);
+
+/// Add a client to the shard with the fewest clients.
+/**
+ * \sa rcl_sharded_wait_set_add_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_add_client(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_client_t * client,
+  const rcl_sharded_work_t ** work);
+
+/// Add a service to the shard with the fewest services.
+/**
+ * \sa rcl_sharded_wait_set_add_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_add_service(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_service_t * service,
+  const rcl_sharded_work_t ** work);
+
+/// Add an event to the shard with the fewest events.
+/**
+ * \sa rcl_sharded_wait_set_add_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_add_event(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_event_t * event,
+  const rcl_sharded_work_t ** work);
+
+/// Remove an entity from a sharded wait set.
+/**
+ * Entities are added and removed while no thread waits on a shard or
+ * processes work of the set.
+ * If the work of the entity is in a deque, its entity becomes `NULL`, and it
+ * is still handed back with rcl_sharded_wait_set_done() once popped or stolen.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] sharded_wait_set the sharded wait set holding the entity
+ * \param[in] work the work of the entity
+ * \return `RCL_RET_OK` if removed successfully, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the sharded wait set is zero initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ *   the entity was removed already.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_remove(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_sharded_work_t * work);
+
+/// Wait on a shard, and push the work of its ready entities to a work deque.
+/**
+ * Entities whose work was handed back since the last wait on the shard are
+ * put back into its wait set first.
+ * The wait ends as rcl_wait() does, and also when the shard is woken, in
+ * which case no work may be pushed.
+ *
+ * Only one thread at a time may wait on a shard, and it has to own the deque.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Maybe [1]
+ * Thread-Safe        | Yes, for distinct shards
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ * <i>[1] if the deque grows, or as rcl_wait() does</i>
+ *
+ * \param[inout] sharded_wait_set the sharded wait set
+ * \param[in] shard the index of the shard to wait on
+ * \param[in] timeout the duration to wait, as with rcl_wait()
+ * \param[inout] deque the work deque of the calling thread
+ * \param[out] work_count the number of work items pushed to the deque
+ * \return `RCL_RET_OK` if the shard was ready or woken, or
+ * \return `RCL_RET_TIMEOUT` if the timeout expired before anything was ready, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the sharded wait set is zero initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if growing the deque failed, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_wait(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  size_t shard,
+  int64_t timeout,
+  rcl_work_deque_t * deque,
+  size_t * work_count);
+
+/// Hand back processed work, so that its shard waits for the entity again.
+/**
+ * The shard is woken to put the entity back into its wait set.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] sharded_wait_set the sharded wait set the work came from
+ * \param[in] work the work popped or stolen from a deque
+ * \return `RCL_RET_OK` if the work was handed back, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the sharded wait set is zero initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_ERROR` if waking the shard failed.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_done(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_sharded_work_t * work);
+
+/// Wake the thread waiting on a shard, or the next one to wait on it.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] sharded_wait_set the sharded wait set
+ * \param[in] shard the index of the shard to wake
+ * \return `RCL_RET_OK` if the shard was woken, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the sharded wait set is zero initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_wake(rcl_sharded_wait_set_t * sharded_wait_set, size_t shard);
+
+/// Wake the threads waiting on any shard.
+/**
+ * \sa rcl_sharded_wait_set_wake
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_sharded_wait_set_wake_all(rcl_sharded_wait_set_t * sharded_wait_set);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__SHARDED_WAIT_SET_H_
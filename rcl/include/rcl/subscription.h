@@ -22,6 +22,7 @@ extern "C"
 
 #include "rosidl_runtime_c/message_type_support_struct.h"
 
+#include "rcl/collector_options.h"
 #include "rcl/macros.h"
 #include "rcl/node.h"
 #include "rcl/visibility_control.h"
@@ -48,6 +49,16 @@ typedef struct rcl_subscription_options_t
   rcl_allocator_t allocator;
   /// rmw specific subscription options, e.g. the rmw implementation specific payload.
   rmw_subscription_options_t rmw_subscription_options;
+  /// Traffic model collector settings, only used if the subscription has a collector.
+  rcl_collector_options_t collector_options;
+  /// Split the frames of coalescing publishers into their messages in rcl_take().
+  /**
+   * The subscription then subscribes to the topic coalescing publishers put
+   * their frames on, and only receives their messages, see rcl_coalescing_options_t.
+   * Messages are taken serialized from the middleware and deserialized by rcl.
+   * rcl_take_serialized_message() still returns frames as they were published.
+   */
+  bool split_coalesced_frames;
 } rcl_subscription_options_t;
 
 /// Return a rcl_subscription_t struct with members set to `NULL`.
@@ -198,6 +209,8 @@ rcl_subscription_fini(rcl_subscription_t * subscription, rcl_node_t * node);
  * - qos = rmw_qos_profile_default
  * - allocator = rcl_get_default_allocator()
  * - rmw_subscription_options = rmw_get_default_subscription_options();
+ * - collector_options = all `0`, i.e. environment or built-in defaults
+ * - split_coalesced_frames = false
  */
 RCL_PUBLIC
 RCL_WARN_UNUSED
@@ -21,6 +21,8 @@ extern "C"
 #endif
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "rcl/allocator.h"
 #include "rcl/context.h"
@@ -324,6 +326,33 @@ RCL_WARN_UNUSED
 rcl_ret_t
 rcl_timer_get_time_until_next_call(const rcl_timer_t * timer, int64_t * time_until_next_call);
 
+/// Retrieve the time at which the timer is next due, in nanoseconds.
+/**
+ * The time is that of the timer's clock, and is the last call time plus the
+ * period, unless the timer was reset since.
+ * Unlike rcl_timer_get_time_until_next_call(), the clock is not read, so the
+ * times of many timers on one clock can be compared to a single reading of it.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[in] timer the handle to the timer that is being queried
+ * \param[out] next_call_time the output variable for the result
+ * \return `RCL_RET_OK` if the next call time was retrieved successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer is invalid.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_get_next_call_time(const rcl_timer_t * timer, int64_t * next_call_time);
+
 /// Retrieve the time since the previous call to rcl_timer_call() occurred.
 /**
  * This function calculates the time since the last call and copies it into
@@ -587,6 +616,231 @@ RCL_WARN_UNUSED
 rcl_guard_condition_t *
 rcl_timer_get_guard_condition(const rcl_timer_t * timer);
 
+/// Identifier of an entry scheduled in a timer wheel, `0` is never used.
+typedef uint64_t rcl_timer_wheel_entry_id_t;
+
+/// Signature of the callback of a timer wheel entry.
+/**
+ * The callback may schedule and cancel entries of the same wheel, including
+ * its own entry if it is periodic.
+ */
+typedef void (* rcl_timer_wheel_callback_t)(rcl_timer_wheel_entry_id_t id, void * data);
+
+struct rcl_timer_wheel_impl_t;
+
+/// Structure which encapsulates a hierarchical wheel of many timeouts.
+/**
+ * A timer wheel keeps its entries in four levels of 64 slots each, a slot
+ * of level `n` spanning `64^n` ticks of the wheel's resolution.
+ * Scheduling and canceling an entry take constant time, and so does expiring
+ * it, apart from moving it down the levels at most three times before it is
+ * due.
+ * Entries with a delay beyond `64^4` ticks wait in the top level until they
+ * get closer.
+ *
+ * The wheel is driven by a timer of its own, which is due whenever the wheel
+ * has entries to expire or to move down a level.
+ * Add it to a wait set with rcl_wait_set_add_timer() and call it with
+ * rcl_timer_call() once it is ready, as any other timer, to run the callbacks
+ * of the due entries: the whole wheel is a single timer of the wait set.
+ */
+typedef struct rcl_timer_wheel_t
+{
+  /// Private implementation pointer.
+  struct rcl_timer_wheel_impl_t * impl;
+} rcl_timer_wheel_t;
+
+/// Return a zero initialized timer wheel.
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_timer_wheel_t
+rcl_get_zero_initialized_timer_wheel(void);
+
+/// Initialize a timer wheel.
+/**
+ * The wheel counts time from its initialization in ticks of `resolution`
+ * nanoseconds, and an entry never expires before its delay elapsed, but up
+ * to one tick later.
+ * The clock has to be a steady or a system clock, as ROS time may jump.
+ *
+ * The wheel is driven by its timer, see rcl_timer_wheel_get_timer(), which
+ * is initialized with the wheel and canceled while the wheel has no entries.
+ * The callback of that timer advances the wheel, and must not be exchanged.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[inout] wheel the timer wheel handle to be initialized
+ * \param[in] clock the steady or system clock providing the current time
+ * \param[in] context the context that this timer wheel is to be associated with
+ * \param[in] resolution the length of a tick in nanoseconds, greater than `0`
+ * \param[in] capacity the most entries the wheel can hold at once, greater than `0`
+ * \param[in] allocator the allocator used for allocations
+ * \return `RCL_RET_OK` if the timer wheel was initialized successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_ALREADY_INIT` if the timer wheel was already initialized, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_wheel_init(
+  rcl_timer_wheel_t * wheel,
+  rcl_clock_t * clock,
+  rcl_context_t * context,
+  int64_t resolution,
+  size_t capacity,
+  rcl_allocator_t allocator);
+
+/// Finalize a timer wheel.
+/**
+ * The entries still scheduled are dropped without calling their callbacks.
+ * The timer of the wheel is finalized too, and has to be removed from any
+ * wait set first.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[inout] wheel the handle to the timer wheel to be finalized
+ * \return `RCL_RET_OK` if the timer wheel was finalized successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_wheel_fini(rcl_timer_wheel_t * wheel);
+
+/// Schedule a callback to be called once a delay elapsed.
+/**
+ * With a `period` greater than `0`, the entry is scheduled again every time
+ * it expires, `period` nanoseconds after it was due, until it is canceled.
+ * As with rcl_timer_call(), periods missed entirely are skipped.
+ *
+ * If the entry becomes the earliest of the wheel, the guard condition of the
+ * wheel's timer is triggered to wake the wait set waiting on it.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[inout] wheel the timer wheel to schedule the entry in
+ * \param[in] delay the time in nanoseconds until the entry is due, not negative
+ * \param[in] period the period of the entry in nanoseconds, or `0` to call it once
+ * \param[in] callback the callback to be called when the entry is due
+ * \param[in] data passed to the callback
+ * \param[out] id the identifier of the entry, to cancel it
+ * \return `RCL_RET_OK` if the entry was scheduled successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer wheel is invalid, or
+ * \return `RCL_RET_ERROR` if the wheel is full, or an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_wheel_schedule(
+  rcl_timer_wheel_t * wheel,
+  int64_t delay,
+  int64_t period,
+  rcl_timer_wheel_callback_t callback,
+  void * data,
+  rcl_timer_wheel_entry_id_t * id);
+
+/// Cancel an entry of a timer wheel, so that its callback is not called again.
+/**
+ * Entries are identified by a generation as well as by their place in the
+ * wheel, so the identifier of an entry which expired or was canceled never
+ * cancels another entry.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[inout] wheel the timer wheel the entry was scheduled in
+ * \param[in] id the identifier of the entry
+ * \return `RCL_RET_OK` if the entry was canceled successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer wheel is invalid, or
+ * \return `RCL_RET_TIMER_CANCELED` if the entry already expired or was canceled.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_wheel_cancel(rcl_timer_wheel_t * wheel, rcl_timer_wheel_entry_id_t id);
+
+/// Call the callbacks of the entries of a timer wheel which are due.
+/**
+ * This is what calling the wheel's timer with rcl_timer_call() does, and
+ * only needed if the wheel is driven without a wait set.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[inout] wheel the timer wheel to advance
+ * \return `RCL_RET_OK` if the timer wheel was advanced successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer wheel is invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_wheel_advance(rcl_timer_wheel_t * wheel);
+
+/// Return the timer driving a timer wheel.
+/**
+ * The timer is due when the wheel next has to be advanced, and canceled while
+ * the wheel has no entries.
+ * It is owned by the wheel and must not be reset, canceled or finalized.
+ *
+ * The returned pointer is only valid as long as the timer wheel is valid.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[in] wheel the timer wheel to be queried
+ * \return `NULL` if the timer wheel is invalid, or
+ * \return a pointer to the timer of the wheel.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_timer_t *
+rcl_timer_wheel_get_timer(const rcl_timer_wheel_t * wheel);
+
 #ifdef __cplusplus
 }
 #endif
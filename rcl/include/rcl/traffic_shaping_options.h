@@ -0,0 +1,68 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__TRAFFIC_SHAPING_OPTIONS_H_
+#define RCL__TRAFFIC_SHAPING_OPTIONS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+/// How a publisher's sends are shaped around the urgent traffic of its context.
+typedef enum rcl_traffic_shaping_mode_t
+{
+  /// Messages are published as soon as they are given, the default.
+  RCL_TRAFFIC_SHAPING_NONE = 0,
+  /// Each publish is deferred into the next gap predicted free of urgent messages.
+  RCL_TRAFFIC_SHAPING_PACED,
+  /// As paced, after limiting the publish rate with a token bucket.
+  RCL_TRAFFIC_SHAPING_TOKEN_BUCKET
+} rcl_traffic_shaping_mode_t;
+
+/// Settings shaping the sends of a publisher without a traffic model collector.
+/**
+ * Shaping relies on the traffic models the collectors of the publisher's
+ * context fit for the topics their policy selects, i.e. the urgent topics:
+ * a shaped publish blocks the caller until no urgent message is predicted
+ * within the guard time, or for at most max_delay.
+ * Publishers that have a collector themselves are never shaped.
+ *
+ * A value of `0` selects the built-in default:
+ *
+ * - guard_time: 3 sigma of each urgent topic's time model, at least 100 microseconds
+ * - max_delay: 10 milliseconds
+ * - burst: 1 message
+ */
+typedef struct rcl_traffic_shaping_options_t
+{
+  /// Shaping applied to the publisher, RCL_TRAFFIC_SHAPING_NONE disables all others.
+  rcl_traffic_shaping_mode_t mode;
+  /// Time in seconds kept clear on either side of a predicted urgent message.
+  double guard_time;
+  /// Longest time in seconds a publish is deferred waiting for a gap.
+  double max_delay;
+  /// Sustained rate in messages per second of the token bucket, required by that mode.
+  double rate;
+  /// Messages the token bucket lets through back to back, after a pause.
+  size_t burst;
+} rcl_traffic_shaping_options_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__TRAFFIC_SHAPING_OPTIONS_H_
@@ -373,6 +373,132 @@ rcl_wait_set_add_event(
   const rcl_event_t * event,
   size_t * index);
 
+/// Make the entities added to the wait set stay in it across waits, or not.
+/**
+ * Entities added to a persistent wait set are registered until they are
+ * removed with one of the rcl_wait_set_remove_* functions, or until the wait
+ * set is cleared or resized.
+ * rcl_wait() leaves the entity arrays untouched, and reports the indices of
+ * the ready entities through rcl_wait_set_get_ready() instead, so the wait set
+ * is neither cleared nor refilled between waits.
+ * This saves the per entity work of refilling the wait set on every wait, in
+ * exchange for memory to keep track of the registered entities.
+ *
+ * The timers on steady and system clocks are kept in order of their next call
+ * time, so rcl_wait() reads each of these clocks once before and once after
+ * waiting, and only looks at the timers that are due.
+ * These timers must not have their next call time brought forward without
+ * triggering their guard condition, as rcl_timer_reset() does.
+ *
+ * An entity added to a persistent wait set takes the place of the last one
+ * removed, if any, and the next empty spot otherwise.
+ * Changing the mode clears the wait set.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] wait_set the wait set to change the mode of
+ * \param[in] persistent whether the wait set should be persistent
+ * \return `RCL_RET_OK` if the mode was changed, or already set, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the wait set is zero initialized, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, the wait set is
+ *   then left not persistent.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_set_persistent(rcl_wait_set_t * wait_set, bool persistent);
+
+/// Return `true` if the wait set is valid and persistent, else `false`.
+/**
+ * \see rcl_wait_set_set_persistent
+ */
+RCL_PUBLIC
+bool
+rcl_wait_set_is_persistent(const rcl_wait_set_t * wait_set);
+
+/// Remove the subscription at the given index from a persistent wait set.
+/**
+ * The subscription's place in the set is set to `NULL`, and reused by the
+ * next subscription added.
+ * Removing does not depend on the number of entities in the wait set.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] wait_set persistent wait set to remove the subscription from
+ * \param[in] index the index of the subscription, as given when it was added
+ * \return `RCL_RET_OK` if removed successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, there is no
+ *   subscription at the index, or the wait set is not persistent, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the wait set is zero initialized.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_remove_subscription(rcl_wait_set_t * wait_set, size_t index);
+
+/// Remove the guard condition at the given index from a persistent wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_remove_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_remove_guard_condition(rcl_wait_set_t * wait_set, size_t index);
+
+/// Remove the timer at the given index from a persistent wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_remove_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_remove_timer(rcl_wait_set_t * wait_set, size_t index);
+
+/// Remove the client at the given index from a persistent wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_remove_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_remove_client(rcl_wait_set_t * wait_set, size_t index);
+
+/// Remove the service at the given index from a persistent wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_remove_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_remove_service(rcl_wait_set_t * wait_set, size_t index);
+
+/// Remove the event at the given index from a persistent wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_remove_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_remove_event(rcl_wait_set_t * wait_set, size_t index);
+
 /// Block until the wait set is ready or until the timeout has been exceeded.
 /**
  * This function will collect the items in the rcl_wait_set_t and pass them
@@ -456,6 +582,12 @@ rcl_wait_set_add_event(
  * For example, calling rcl_wait() in two threads on two different wait sets
  * that both contain a single, shared guard condition is undefined behavior.
  *
+ * The items of a persistent wait set are left untouched, the ready ones are
+ * given by rcl_wait_set_get_ready() instead, as they are for a wait set with
+ * the ready lists enabled.
+ * \see rcl_wait_set_set_persistent
+ * \see rcl_wait_set_set_ready_lists
+ *
  * \param[inout] wait_set the set of things to be waited on and to be pruned if not ready
  * \param[in] timeout the duration to wait for the wait set to be ready, in nanoseconds
  * \return `RCL_RET_OK` something in the wait set became ready, or
@@ -470,6 +602,111 @@ RCL_WARN_UNUSED
 rcl_ret_t
 rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout);
 
+/// Indices of the entities of a wait set found ready by rcl_wait().
+typedef struct rcl_wait_set_ready_t
+{
+  /// Indices of the ready subscriptions in the wait set.
+  const size_t * subscriptions;
+  /// Number of ready subscriptions
+  size_t size_of_subscriptions;
+  /// Indices of the ready guard conditions in the wait set.
+  const size_t * guard_conditions;
+  /// Number of ready guard conditions
+  size_t size_of_guard_conditions;
+  /// Indices of the ready timers in the wait set.
+  const size_t * timers;
+  /// Number of ready timers
+  size_t size_of_timers;
+  /// Indices of the ready clients in the wait set.
+  const size_t * clients;
+  /// Number of ready clients
+  size_t size_of_clients;
+  /// Indices of the ready services in the wait set.
+  const size_t * services;
+  /// Number of ready services
+  size_t size_of_services;
+  /// Indices of the ready events in the wait set.
+  const size_t * events;
+  /// Number of ready events
+  size_t size_of_events;
+} rcl_wait_set_ready_t;
+
+/// List the ready entities in rcl_wait(), besides setting the others to `NULL`.
+/**
+ * rcl_wait() then records the index of each ready entity in the same pass
+ * that sets the entities which are not ready to `NULL`, and the ready
+ * entities can be found with rcl_wait_set_get_ready() rather than by scanning
+ * the whole sets.
+ * This costs an index per entity the sets have space for, and is always the
+ * case for a persistent wait set.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] wait_set the wait set to list the ready entities of
+ * \param[in] enabled whether rcl_wait() should list the ready entities
+ * \return `RCL_RET_OK` if the lists were enabled or disabled, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the wait set is zero initialized, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, the lists are then
+ *   left disabled.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_set_ready_lists(rcl_wait_set_t * wait_set, bool enabled);
+
+/// Retrieve the indices of the entities found ready by the last rcl_wait().
+/**
+ * The entities of a persistent wait set, or of one with the ready lists
+ * enabled, are reported this way, the indices being those the entities were
+ * added at.
+ * The indices are in no particular order for a persistent wait set, and in
+ * increasing order otherwise.
+ * Dispatching the ready entities thus does not depend on the number of entities
+ * in the wait set:
+ *
+ * ```c
+ * rcl_wait_set_ready_t ready;
+ * ret = rcl_wait(&wait_set, RCL_MS_TO_NS(1000));
+ * // ... error handling
+ * ret = rcl_wait_set_get_ready(&wait_set, &ready);
+ * // ... error handling
+ * for (size_t i = 0; i < ready.size_of_subscriptions; ++i) {
+ *   const rcl_subscription_t * subscription = wait_set.subscriptions[ready.subscriptions[i]];
+ *   // The subscription is ready...
+ * }
+ * ```
+ *
+ * The arrays belong to the wait set and are only valid until the next call to
+ * rcl_wait(), or until the wait set is changed.
+ * An entity removed after the wait is still reported, its place being `NULL`.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[in] wait_set the wait set waited on
+ * \param[out] ready the indices of the ready entities
+ * \return `RCL_RET_OK` if the indices were retrieved, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or the wait
+ *   set neither is persistent nor has the ready lists enabled, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the wait set is zero initialized.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_get_ready(const rcl_wait_set_t * wait_set, rcl_wait_set_ready_t * ready);
+
 /// Return `true` if the wait set is valid, else `false`.
 /**
  * A wait set is invalid if:
@@ -0,0 +1,195 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__WORK_DEQUE_H_
+#define RCL__WORK_DEQUE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "rcl/allocator.h"
+#include "rcl/macros.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+
+struct rcl_work_deque_impl_t;
+
+/// Lock-free work-stealing deque of pointers to work items.
+/**
+ * A work deque is owned by a single thread, which pushes and pops items at
+ * its bottom end, newest first.
+ * Any other thread may steal items from its top end, oldest first, so that
+ * idle threads of an executor take over the work queued by busy ones.
+ *
+ * This is the deque of Chase and Lev, with the C11 memory orderings given by
+ * Lê et al. in "Correct and Efficient Work-Stealing for Weak Memory Models".
+ * The deque grows when it is full.
+ * Buffers it outgrew are kept until it is finalized, as thieves may still be
+ * reading them.
+ */
+typedef struct rcl_work_deque_t
+{
+  /// Private implementation pointer.
+  struct rcl_work_deque_impl_t * impl;
+} rcl_work_deque_t;
+
+/// Return a rcl_work_deque_t struct with members set to `NULL`.
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_work_deque_t
+rcl_get_zero_initialized_work_deque(void);
+
+/// Initialize a work deque.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] deque the zero initialized work deque to be initialized
+ * \param[in] capacity the number of items the deque holds before it grows,
+ *   rounded up to a power of two
+ * \param[in] allocator the allocator used for the buffers of the deque
+ * \return `RCL_RET_OK` if the deque was initialized successfully, or
+ * \return `RCL_RET_ALREADY_INIT` if the deque was already initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_deque_init(rcl_work_deque_t * deque, size_t capacity, rcl_allocator_t allocator);
+
+/// Finalize a work deque, the items still in it are dropped.
+/**
+ * No thread may use the deque while it is finalized, or afterwards.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] deque the work deque to be finalized
+ * \return `RCL_RET_OK` if the deque was finalized successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_deque_fini(rcl_work_deque_t * deque);
+
+/// Push an item onto the bottom of a work deque.
+/**
+ * Only the thread owning the deque may push.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes, if the deque is full
+ * Thread-Safe        | Yes, with steals
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] deque the work deque owned by the calling thread
+ * \param[in] item the item, which must not be `NULL`
+ * \return `RCL_RET_OK` if the item was pushed, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if growing the deque failed.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_deque_push(rcl_work_deque_t * deque, void * item);
+
+/// Pop the newest item from the bottom of a work deque.
+/**
+ * Only the thread owning the deque may pop.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes, with steals
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] deque the work deque owned by the calling thread
+ * \param[out] item the item popped
+ * \return `true` if an item was popped, or
+ * \return `false` if the deque is empty, or any arguments are invalid.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+bool
+rcl_work_deque_pop(rcl_work_deque_t * deque, void ** item);
+
+/// Steal the oldest item from the top of a work deque.
+/**
+ * Any thread may steal.
+ * A steal fails when it loses the race for an item to another thief or to
+ * the owner, the thief then rather tries another deque than this one again.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] deque the work deque to steal from
+ * \param[out] item the item stolen
+ * \return `true` if an item was stolen, or
+ * \return `false` if the deque is empty, the steal lost a race, or any
+ *   arguments are invalid.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+bool
+rcl_work_deque_steal(rcl_work_deque_t * deque, void ** item);
+
+/// Return the number of items in a work deque, which is stale if other threads use it.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[in] deque the work deque
+ * \return the number of items, or `0` if the deque is invalid.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+size_t
+rcl_work_deque_size(const rcl_work_deque_t * deque);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__WORK_DEQUE_H_
@@ -0,0 +1,583 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "./coalescing.h"
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <pthread.h>
+# include <time.h>
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "rcl/error_handling.h"
+#include "rcutils/format_string.h"
+#include "rcutils/logging_macros.h"
+#include "rcutils/time.h"
+#include "rmw/error_handling.h"
+#include "rmw/serialized_message.h"
+
+#define RCL_COALESCING_DEFAULT_MAX_MESSAGES 256u
+#define RCL_COALESCING_DEFAULT_MAX_FRAME_SIZE 8192u
+
+#define FRAME_HEADER_SIZE 16u
+#define ENTRY_HEADER_SIZE 8u
+#define FRAME_ALIGNMENT 8u
+#define INITIAL_MESSAGE_CAPACITY 256u
+
+static const uint8_t frame_magic[4] = {'R', 'C', 'L', 'F'};
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION rcl_coalescer_mutex_t;
+typedef CONDITION_VARIABLE rcl_coalescer_cond_t;
+typedef HANDLE rcl_coalescer_thread_t;
+#else
+typedef pthread_mutex_t rcl_coalescer_mutex_t;
+typedef pthread_cond_t rcl_coalescer_cond_t;
+typedef pthread_t rcl_coalescer_thread_t;
+#endif
+
+struct rcl_coalescer_impl_t
+{
+  rcl_allocator_t allocator;
+  /// Held while the frame is appended to, or swapped out to be published.
+  rcl_coalescer_mutex_t frame_mutex;
+  /// Held while a frame is published, taken with the frame locked, so frames go out in order.
+  rcl_coalescer_mutex_t publish_mutex;
+  /// Signaled with the frame locked when a frame is opened, or the flusher is stopped.
+  rcl_coalescer_cond_t frame_opened;
+  /// Publishes each frame once its window elapsed, when no later message did.
+  rcl_coalescer_thread_t flusher;
+  /// Guarded by the frame mutex.
+  bool stopping;
+};
+
+static void
+_store_uint32(uint8_t * buffer, uint32_t value)
+{
+  buffer[0] = (uint8_t)value;
+  buffer[1] = (uint8_t)(value >> 8);
+  buffer[2] = (uint8_t)(value >> 16);
+  buffer[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t
+_load_uint32(const uint8_t * buffer)
+{
+  return (uint32_t)buffer[0] | (uint32_t)buffer[1] << 8 | (uint32_t)buffer[2] << 16 |
+    (uint32_t)buffer[3] << 24;
+}
+
+static size_t
+_align(size_t offset)
+{
+  return (offset + FRAME_ALIGNMENT - 1u) & ~(size_t)(FRAME_ALIGNMENT - 1u);
+}
+
+static void
+_mutex_init(rcl_coalescer_mutex_t * mutex)
+{
+#ifdef _WIN32
+  InitializeCriticalSection(mutex);
+#else
+  pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+static void
+_mutex_lock(rcl_coalescer_mutex_t * mutex)
+{
+#ifdef _WIN32
+  EnterCriticalSection(mutex);
+#else
+  pthread_mutex_lock(mutex);
+#endif
+}
+
+static void
+_mutex_unlock(rcl_coalescer_mutex_t * mutex)
+{
+#ifdef _WIN32
+  LeaveCriticalSection(mutex);
+#else
+  pthread_mutex_unlock(mutex);
+#endif
+}
+
+static void
+_mutex_destroy(rcl_coalescer_mutex_t * mutex)
+{
+#ifdef _WIN32
+  DeleteCriticalSection(mutex);
+#else
+  pthread_mutex_destroy(mutex);
+#endif
+}
+
+static void
+_cond_init(rcl_coalescer_cond_t * cond)
+{
+#ifdef _WIN32
+  InitializeConditionVariable(cond);
+#else
+  pthread_cond_init(cond, NULL);
+#endif
+}
+
+static void
+_cond_signal(rcl_coalescer_cond_t * cond)
+{
+#ifdef _WIN32
+  WakeConditionVariable(cond);
+#else
+  pthread_cond_signal(cond);
+#endif
+}
+
+// wait for the condition with the mutex locked, for at most timeout nanoseconds if positive
+static void
+_cond_wait(rcl_coalescer_cond_t * cond, rcl_coalescer_mutex_t * mutex, int64_t timeout)
+{
+#ifdef _WIN32
+  DWORD milliseconds = timeout > 0 ? (DWORD)((timeout + 999999) / 1000000) : INFINITE;
+  (void)SleepConditionVariableCS(cond, mutex, milliseconds);
+#else
+  if (timeout > 0) {
+    // the condition waits on the system clock, waking early or late is checked by the caller
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    int64_t nanoseconds = deadline.tv_nsec + timeout;
+    deadline.tv_sec += (time_t)(nanoseconds / 1000000000);
+    deadline.tv_nsec = (long)(nanoseconds % 1000000000);
+    (void)pthread_cond_timedwait(cond, mutex, &deadline);
+  } else {
+    (void)pthread_cond_wait(cond, mutex);
+  }
+#endif
+}
+
+static void
+_cond_destroy(rcl_coalescer_cond_t * cond)
+{
+#ifdef _WIN32
+  (void)cond;
+#else
+  pthread_cond_destroy(cond);
+#endif
+}
+
+static void
+_open_frame(rcl_coalescer_t * coalescer)
+{
+  memset(coalescer->frame.buffer, 0, FRAME_HEADER_SIZE);
+  memcpy(coalescer->frame.buffer, frame_magic, sizeof(frame_magic));
+  _store_uint32(coalescer->frame.buffer + 4, RCL_COALESCING_FRAME_VERSION);
+  coalescer->frame.buffer_length = FRAME_HEADER_SIZE;
+  coalescer->count = 0u;
+}
+
+// publish the frame, called with the frame locked, which is unlocked once the frame is swapped
+// out for the next one, the next frame is opened even if publishing failed
+static rcl_ret_t
+_flush_and_unlock(rcl_coalescer_t * coalescer)
+{
+  struct rcl_coalescer_impl_t * impl = coalescer->impl;
+  size_t count = coalescer->count;
+  if (0u == count) {
+    _mutex_unlock(&impl->frame_mutex);
+    return RCL_RET_OK;
+  }
+  // the frame before is out once the lock is taken, its buffer opens the next frame
+  _mutex_lock(&impl->publish_mutex);
+  _store_uint32(coalescer->frame.buffer + 8, (uint32_t)count);
+  rcl_serialized_message_t due = coalescer->frame;
+  coalescer->frame = coalescer->sending;
+  coalescer->sending = due;
+  _open_frame(coalescer);
+  _mutex_unlock(&impl->frame_mutex);
+
+  rcl_ret_t ret = coalescer->publish(&coalescer->sending, count, coalescer->publish_state);
+  // a frame grown past its size for a large message is not kept at that size
+  if (coalescer->sending.buffer_capacity > coalescer->max_frame_size + FRAME_HEADER_SIZE &&
+    RMW_RET_OK != rmw_serialized_message_resize(
+      &coalescer->sending, coalescer->max_frame_size + FRAME_HEADER_SIZE))
+  {
+    rmw_reset_error();
+  }
+  _mutex_unlock(&impl->publish_mutex);
+  return ret;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+#else
+static void *
+#endif
+_run_flusher(void * arg)
+{
+  rcl_coalescer_t * coalescer = (rcl_coalescer_t *)arg;
+  struct rcl_coalescer_impl_t * impl = coalescer->impl;
+  _mutex_lock(&impl->frame_mutex);
+  while (!impl->stopping) {
+    if (0u == coalescer->count) {
+      _cond_wait(&impl->frame_opened, &impl->frame_mutex, 0);
+      continue;
+    }
+    rcutils_time_point_value_t now = 0;
+    (void)rcutils_steady_time_now(&now);
+    int64_t remaining = coalescer->opened_at + coalescer->window - now;
+    if (remaining > 0) {
+      // a frame published and opened again meanwhile is waited for anew
+      _cond_wait(&impl->frame_opened, &impl->frame_mutex, remaining);
+      continue;
+    }
+    if (RCL_RET_OK != _flush_and_unlock(coalescer)) {
+      RCUTILS_LOG_ERROR_NAMED(
+        ROS_PACKAGE_NAME, "Failed to publish a coalesced frame, '%s'",
+        rcl_get_error_string().str);
+      rcl_reset_error();
+    }
+    _mutex_lock(&impl->frame_mutex);
+  }
+  _mutex_unlock(&impl->frame_mutex);
+#ifdef _WIN32
+  return 0;
+#else
+  return NULL;
+#endif
+}
+
+char *
+rcl_get_coalesced_topic_name(const char * topic_name, rcl_allocator_t allocator)
+{
+  return rcutils_format_string(allocator, "%s" RCL_COALESCED_TOPIC_SUFFIX, topic_name);
+}
+
+rcl_ret_t
+rcl_coalescer_init(
+  rcl_coalescer_t * coalescer,
+  const rosidl_message_type_support_t * ts,
+  const rcl_coalescing_options_t * options,
+  rcl_coalescer_publish_t publish,
+  void * publish_state,
+  rcl_allocator_t allocator)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(coalescer, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(ts, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(options, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(publish, RCL_RET_INVALID_ARGUMENT);
+  if (!(options->window > 0.0) || !isfinite(options->window)) {
+    RCL_SET_ERROR_MSG("coalescing window must be positive and finite");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  coalescer->ts = ts;
+  coalescer->window = (int64_t)(options->window * 1e9);
+  coalescer->max_messages = options->max_messages ?
+    options->max_messages : RCL_COALESCING_DEFAULT_MAX_MESSAGES;
+  if (coalescer->max_messages > UINT32_MAX) {
+    coalescer->max_messages = UINT32_MAX;
+  }
+  coalescer->max_frame_size = options->max_frame_size ?
+    options->max_frame_size : RCL_COALESCING_DEFAULT_MAX_FRAME_SIZE;
+  coalescer->publish = publish;
+  coalescer->publish_state = publish_state;
+  coalescer->frame = rmw_get_zero_initialized_serialized_message();
+  coalescer->sending = rmw_get_zero_initialized_serialized_message();
+  coalescer->scratch = rmw_get_zero_initialized_serialized_message();
+  coalescer->count = 0u;
+  coalescer->opened_at = 0;
+  coalescer->impl = (struct rcl_coalescer_impl_t *)allocator.allocate(
+    sizeof(struct rcl_coalescer_impl_t), allocator.state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    coalescer->impl, "allocating memory failed", return RCL_RET_BAD_ALLOC);
+  coalescer->impl->allocator = allocator;
+  if (RMW_RET_OK != rmw_serialized_message_init(
+      &coalescer->frame, coalescer->max_frame_size + FRAME_HEADER_SIZE, &allocator) ||
+    RMW_RET_OK != rmw_serialized_message_init(
+      &coalescer->sending, coalescer->max_frame_size + FRAME_HEADER_SIZE, &allocator) ||
+    RMW_RET_OK != rmw_serialized_message_init(
+      &coalescer->scratch, INITIAL_MESSAGE_CAPACITY, &allocator))
+  {
+    rmw_reset_error();
+    (void)rmw_serialized_message_fini(&coalescer->frame);
+    (void)rmw_serialized_message_fini(&coalescer->sending);
+    rmw_reset_error();
+    allocator.deallocate(coalescer->impl, allocator.state);
+    coalescer->impl = NULL;
+    RCL_SET_ERROR_MSG("allocating memory failed");
+    return RCL_RET_BAD_ALLOC;
+  }
+  _mutex_init(&coalescer->impl->frame_mutex);
+  _mutex_init(&coalescer->impl->publish_mutex);
+  _cond_init(&coalescer->impl->frame_opened);
+  coalescer->impl->stopping = false;
+  _open_frame(coalescer);
+#ifdef _WIN32
+  coalescer->impl->flusher = CreateThread(NULL, 0, _run_flusher, coalescer, 0, NULL);
+  bool started = NULL != coalescer->impl->flusher;
+#else
+  bool started = 0 == pthread_create(&coalescer->impl->flusher, NULL, _run_flusher, coalescer);
+#endif
+  if (!started) {
+    _cond_destroy(&coalescer->impl->frame_opened);
+    _mutex_destroy(&coalescer->impl->frame_mutex);
+    _mutex_destroy(&coalescer->impl->publish_mutex);
+    (void)rmw_serialized_message_fini(&coalescer->frame);
+    (void)rmw_serialized_message_fini(&coalescer->sending);
+    (void)rmw_serialized_message_fini(&coalescer->scratch);
+    allocator.deallocate(coalescer->impl, allocator.state);
+    coalescer->impl = NULL;
+    RCL_SET_ERROR_MSG("failed to start the coalescing flusher thread");
+    return RCL_RET_ERROR;
+  }
+  return RCL_RET_OK;
+}
+
+void
+rcl_coalescer_fini(rcl_coalescer_t * coalescer)
+{
+  rcl_allocator_t allocator = coalescer->impl->allocator;
+  _mutex_lock(&coalescer->impl->frame_mutex);
+  coalescer->impl->stopping = true;
+  _cond_signal(&coalescer->impl->frame_opened);
+  _mutex_unlock(&coalescer->impl->frame_mutex);
+#ifdef _WIN32
+  WaitForSingleObject(coalescer->impl->flusher, INFINITE);
+  CloseHandle(coalescer->impl->flusher);
+#else
+  pthread_join(coalescer->impl->flusher, NULL);
+#endif
+  _cond_destroy(&coalescer->impl->frame_opened);
+  _mutex_destroy(&coalescer->impl->frame_mutex);
+  _mutex_destroy(&coalescer->impl->publish_mutex);
+  allocator.deallocate(coalescer->impl, allocator.state);
+  coalescer->impl = NULL;
+  (void)rmw_serialized_message_fini(&coalescer->frame);
+  (void)rmw_serialized_message_fini(&coalescer->sending);
+  (void)rmw_serialized_message_fini(&coalescer->scratch);
+}
+
+rcl_ret_t
+rcl_coalescer_append(
+  rcl_coalescer_t * coalescer,
+  const void * ros_message,
+  const rcl_serialized_message_t * serialized_message)
+{
+  rcutils_time_point_value_t now = 0;
+  (void)rcutils_steady_time_now(&now);
+  rcl_coalescer_mutex_t * frame_mutex = &coalescer->impl->frame_mutex;
+  const rcl_serialized_message_t * message = serialized_message;
+  rcl_ret_t ret = RCL_RET_OK;
+  size_t offset = 0u;
+  size_t end = 0u;
+  _mutex_lock(frame_mutex);
+  // a due frame is published first, the frame is only locked again once it is swapped out, so
+  // the message is serialized again as other publishes may have used the buffer meanwhile
+  for (;;) {
+    if (coalescer->count > 0u && now - coalescer->opened_at >= coalescer->window) {
+      ret = _flush_and_unlock(coalescer);
+      if (RCL_RET_OK != ret) {
+        return ret;  // error already set
+      }
+      _mutex_lock(frame_mutex);
+      continue;
+    }
+    if (NULL == serialized_message) {
+      // serialized separately, as rmw_serialize() overwrites its buffer from the start
+      if (RMW_RET_OK != rmw_serialize(ros_message, coalescer->ts, &coalescer->scratch)) {
+        RCL_SET_ERROR_MSG(rmw_get_error_string().str);
+        _mutex_unlock(frame_mutex);
+        return RCL_RET_ERROR;
+      }
+      message = &coalescer->scratch;
+    }
+    if (message->buffer_length > UINT32_MAX) {
+      RCL_SET_ERROR_MSG("message too large to be coalesced");
+      _mutex_unlock(frame_mutex);
+      return RCL_RET_ERROR;
+    }
+    offset = _align(coalescer->frame.buffer_length);
+    end = offset + ENTRY_HEADER_SIZE + message->buffer_length;
+    if (coalescer->count > 0u && end - FRAME_HEADER_SIZE > coalescer->max_frame_size) {
+      // the message starts the next frame instead of overfilling this one
+      ret = _flush_and_unlock(coalescer);
+      if (RCL_RET_OK != ret) {
+        return ret;  // error already set
+      }
+      _mutex_lock(frame_mutex);
+      continue;
+    }
+    break;
+  }
+  if (end > coalescer->frame.buffer_capacity &&
+    RMW_RET_OK != rmw_serialized_message_resize(&coalescer->frame, end))
+  {
+    rmw_reset_error();
+    RCL_SET_ERROR_MSG("allocating memory failed");
+    _mutex_unlock(frame_mutex);
+    return RCL_RET_BAD_ALLOC;
+  }
+  size_t length = message->buffer_length;
+  uint8_t * entry = coalescer->frame.buffer + offset;
+  memset(
+    coalescer->frame.buffer + coalescer->frame.buffer_length, 0,
+    offset - coalescer->frame.buffer_length + ENTRY_HEADER_SIZE);
+  _store_uint32(entry, (uint32_t)length);
+  memcpy(entry + ENTRY_HEADER_SIZE, message->buffer, length);
+  coalescer->frame.buffer_length = end;
+  if (0u == coalescer->count++) {
+    coalescer->opened_at = now;
+    _cond_signal(&coalescer->impl->frame_opened);
+  }
+  if (coalescer->count >= coalescer->max_messages ||
+    end - FRAME_HEADER_SIZE >= coalescer->max_frame_size)
+  {
+    return _flush_and_unlock(coalescer);
+  }
+  _mutex_unlock(frame_mutex);
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_coalescer_flush(rcl_coalescer_t * coalescer)
+{
+  _mutex_lock(&coalescer->impl->frame_mutex);
+  return _flush_and_unlock(coalescer);
+}
+
+rcl_ret_t
+rcl_frame_splitter_init(
+  rcl_frame_splitter_t * splitter,
+  const rosidl_message_type_support_t * ts,
+  rcl_allocator_t allocator)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(splitter, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(ts, RCL_RET_INVALID_ARGUMENT);
+  splitter->ts = ts;
+  splitter->frame = rmw_get_zero_initialized_serialized_message();
+  splitter->message_info = rmw_get_zero_initialized_message_info();
+  splitter->offset = 0u;
+  splitter->remaining = 0u;
+  splitter->message_size = 0u;
+  if (RMW_RET_OK != rmw_serialized_message_init(
+      &splitter->frame, INITIAL_MESSAGE_CAPACITY, &allocator))
+  {
+    rmw_reset_error();
+    RCL_SET_ERROR_MSG("allocating memory failed");
+    return RCL_RET_BAD_ALLOC;
+  }
+  return RCL_RET_OK;
+}
+
+void
+rcl_frame_splitter_fini(rcl_frame_splitter_t * splitter)
+{
+  (void)rmw_serialized_message_fini(&splitter->frame);
+}
+
+// deserialize the next message of the frame
+static rcl_ret_t
+_split_next(rcl_frame_splitter_t * splitter, void * ros_message)
+{
+  const rcl_serialized_message_t * frame = &splitter->frame;
+  size_t offset = _align(splitter->offset);
+  if (offset + ENTRY_HEADER_SIZE > frame->buffer_length) {
+    splitter->remaining = 0u;
+    RCL_SET_ERROR_MSG("coalesced frame is truncated");
+    return RCL_RET_ERROR;
+  }
+  size_t length = _load_uint32(frame->buffer + offset);
+  offset += ENTRY_HEADER_SIZE;
+  if (length > frame->buffer_length - offset) {
+    splitter->remaining = 0u;
+    RCL_SET_ERROR_MSG("coalesced frame is truncated");
+    return RCL_RET_ERROR;
+  }
+  // a view of the message within the frame, never resized by deserializing
+  rcl_serialized_message_t message = *frame;
+  message.buffer = frame->buffer + offset;
+  message.buffer_length = length;
+  message.buffer_capacity = length;
+  splitter->offset = offset + length;
+  splitter->message_size = length;
+  --splitter->remaining;
+  if (RMW_RET_OK != rmw_deserialize(&message, splitter->ts, ros_message)) {
+    RCL_SET_ERROR_MSG(rmw_get_error_string().str);
+    return RCL_RET_ERROR;
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_frame_splitter_take(
+  rcl_frame_splitter_t * splitter,
+  const rmw_subscription_t * rmw_handle,
+  void * ros_message,
+  rmw_message_info_t * message_info,
+  rmw_subscription_allocation_t * allocation)
+{
+  rcl_ret_t ret = RCL_RET_OK;
+  // frames without messages are skipped
+  while (0u == splitter->remaining && RCL_RET_OK == ret) {
+    bool taken = false;
+    rmw_ret_t rmw_ret = rmw_take_serialized_message_with_info(
+      rmw_handle, &splitter->frame, &taken, &splitter->message_info, allocation);
+    if (RMW_RET_OK != rmw_ret) {
+      RCL_SET_ERROR_MSG(rmw_get_error_string().str);
+      ret = RMW_RET_BAD_ALLOC == rmw_ret ? RCL_RET_BAD_ALLOC : RCL_RET_ERROR;
+      break;
+    }
+    if (!taken) {
+      ret = RCL_RET_SUBSCRIPTION_TAKE_FAILED;
+      break;
+    }
+    const uint8_t * buffer = splitter->frame.buffer;
+    if (splitter->frame.buffer_length < FRAME_HEADER_SIZE ||
+      0 != memcmp(buffer, frame_magic, sizeof(frame_magic)))
+    {
+      // not coalesced, e.g. published without coalescing or by a serialized message publish
+      *message_info = splitter->message_info;
+      splitter->message_size = splitter->frame.buffer_length;
+      if (RMW_RET_OK != rmw_deserialize(&splitter->frame, splitter->ts, ros_message)) {
+        RCL_SET_ERROR_MSG(rmw_get_error_string().str);
+        ret = RCL_RET_ERROR;
+      }
+      return ret;
+    }
+    if (RCL_COALESCING_FRAME_VERSION != _load_uint32(buffer + 4)) {
+      RCL_SET_ERROR_MSG("coalesced frame has an unknown version");
+      ret = RCL_RET_ERROR;
+      break;
+    }
+    splitter->remaining = _load_uint32(buffer + 8);
+    splitter->offset = FRAME_HEADER_SIZE;
+  }
+  if (RCL_RET_OK == ret) {
+    *message_info = splitter->message_info;
+    ret = _split_next(splitter, ros_message);
+  }
+  return ret;
+}
+
+#ifdef __cplusplus
+}
+#endif
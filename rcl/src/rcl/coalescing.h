@@ -0,0 +1,213 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__COALESCING_H_
+#define RCL__COALESCING_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcl/allocator.h"
+#include "rcl/coalescing_options.h"
+#include "rcl/macros.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+#include "rmw/rmw.h"
+#include "rosidl_runtime_c/message_type_support_struct.h"
+
+// A frame is a little endian header followed by its messages, each of them
+// preceded by its length and starting at a multiple of 8 bytes into the frame:
+//
+//   "RCLF" | uint32 version | uint32 message count | uint32 reserved
+//   uint32 length | uint32 reserved | serialized message | padding to 8 bytes
+//   ...
+//
+// The magic cannot start a CDR encapsulation, whose first byte is always `0`,
+// so a frame is told apart from a single serialized message.
+
+#define RCL_COALESCING_FRAME_VERSION 1u
+
+// Frames go on a topic of their own next to the one of their messages, so that
+// subscriptions not splitting frames never receive one.
+#define RCL_COALESCED_TOPIC_SUFFIX "/_coalesced"
+
+/// Publishes a due frame of `count` messages.
+/**
+ * Called with no other frame of the coalescer being published, in the order
+ * the frames were completed, while messages are appended to the next frame.
+ */
+typedef rcl_ret_t (* rcl_coalescer_publish_t)(
+  const rcl_serialized_message_t * frame, size_t count, void * state);
+
+struct rcl_coalescer_impl_t;
+
+/// Frame under construction of a coalescing publisher.
+typedef struct rcl_coalescer_t
+{
+  const rosidl_message_type_support_t * ts;
+  /// Resolved options, the window in nanoseconds.
+  int64_t window;
+  size_t max_messages;
+  size_t max_frame_size;
+  rcl_coalescer_publish_t publish;
+  void * publish_state;
+  /// Locks of the frame and of the frame being published.
+  struct rcl_coalescer_impl_t * impl;
+  rcl_serialized_message_t frame;
+  /// The last frame published, swapped with the frame when it is due.
+  rcl_serialized_message_t sending;
+  /// Serialization buffer of the message being appended.
+  rcl_serialized_message_t scratch;
+  size_t count;
+  /// Steady time the frame's first message was appended.
+  int64_t opened_at;
+} rcl_coalescer_t;
+
+/// Messages of the frame a subscription is splitting.
+typedef struct rcl_frame_splitter_t
+{
+  const rosidl_message_type_support_t * ts;
+  rcl_serialized_message_t frame;
+  /// Message info of the frame, given to each of its messages.
+  rmw_message_info_t message_info;
+  /// Serialized size of the message taken last.
+  size_t message_size;
+  size_t offset;
+  size_t remaining;
+} rcl_frame_splitter_t;
+
+/// Return the topic name the frames of messages on topic_name are published on.
+/**
+ * \param[in] topic_name fully qualified, remapped topic name of the messages
+ * \param[in] allocator allocator for the returned name
+ * \return the name, to be deallocated with allocator, or
+ * \return `NULL` if allocating memory failed.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+char *
+rcl_get_coalesced_topic_name(const char * topic_name, rcl_allocator_t allocator);
+
+/// Initialize the coalescer of a publisher, and start its thread publishing due frames.
+/**
+ * \param[out] coalescer the coalescer to initialize
+ * \param[in] ts type support of the publisher's messages
+ * \param[in] options coalescing options of the publisher, with a window
+ * \param[in] publish called to publish every frame
+ * \param[in] publish_state passed to publish
+ * \param[in] allocator allocator for the frame buffers
+ * \return `RCL_RET_OK` if the coalescer was initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` if the thread could not be started.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_coalescer_init(
+  rcl_coalescer_t * coalescer,
+  const rosidl_message_type_support_t * ts,
+  const rcl_coalescing_options_t * options,
+  rcl_coalescer_publish_t publish,
+  void * publish_state,
+  rcl_allocator_t allocator);
+
+/// Stop the thread and free the frame buffers, messages not flushed are lost.
+RCL_LOCAL
+void
+rcl_coalescer_fini(rcl_coalescer_t * coalescer);
+
+/// Append a message to the frame, publishing the frame before or after if it is due.
+/**
+ * Exactly one of ros_message and serialized_message is given.
+ * Thread-safe, concurrent appends take turns.
+ * If publishing a frame fails, its messages are dropped.
+ *
+ * \return `RCL_RET_OK` if the message was appended, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` if serializing or publishing failed.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_coalescer_append(
+  rcl_coalescer_t * coalescer,
+  const void * ros_message,
+  const rcl_serialized_message_t * serialized_message);
+
+/// Publish the frame right away, if it holds any message.
+/**
+ * Thread-safe.
+ * \return `RCL_RET_OK` if the frame was published or empty, or
+ * \return the error of the publish callback.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_coalescer_flush(rcl_coalescer_t * coalescer);
+
+/// Initialize the frame splitter of a subscription.
+/**
+ * \return `RCL_RET_OK` if the splitter was initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_frame_splitter_init(
+  rcl_frame_splitter_t * splitter,
+  const rosidl_message_type_support_t * ts,
+  rcl_allocator_t allocator);
+
+/// Free the frame buffer, messages not taken yet are lost.
+RCL_LOCAL
+void
+rcl_frame_splitter_fini(rcl_frame_splitter_t * splitter);
+
+/// Take the next message of the current frame, or of a newly taken one.
+/**
+ * Serialized messages that are no frame are deserialized as they are.
+ * Not thread-safe, as taking from a subscription is not.
+ *
+ * \param[in] splitter the splitter of the subscription
+ * \param[in] rmw_handle the subscription's rmw handle
+ * \param[out] ros_message the message deserialized into
+ * \param[out] message_info the info of the frame the message came with
+ * \param[in] allocation passed to rmw when taking a frame
+ * \return `RCL_RET_OK` if a message was taken, or
+ * \return `RCL_RET_SUBSCRIPTION_TAKE_FAILED` if no message was available, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` if taking failed, or the frame is malformed.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_frame_splitter_take(
+  rcl_frame_splitter_t * splitter,
+  const rmw_subscription_t * rmw_handle,
+  void * ros_message,
+  rmw_message_info_t * message_info,
+  rmw_subscription_allocation_t * allocation);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__COALESCING_H_
@@ -18,20 +18,131 @@ extern "C"
 #endif
 
 #include <math.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include "rcutils/error_handling.h"
+#include "rcutils/format_string.h"
+#include "rcutils/get_env.h"
 #include "rcutils/logging_macros.h"
+#include "rcutils/strdup.h"
+#include "rcutils/time.h"
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
 #include "rcl_interfaces/msg/traffic_model.h"
 #include "rosidl_runtime_c/string_functions.h"
 
 #include "./collector.h"
+#include "./collector_reporter.h"
+#include "./context_impl.h"
 
-#define HISTORY_LENGTH 100
-#define WARMUP 10
+#define DEFAULT_HISTORY_LENGTH 100
+#define DEFAULT_WARMUP 10
+#define DEFAULT_MODEL_FRESHNESS 15.0
+#define DEFAULT_PREDICTABLE_THRESH 5e-3
+#define DEFAULT_MAX_PERIOD_COMPONENTS 1
 
-const double MODEL_FRESHNESS = 15;
-const double PREDICTABLE_THRESH = 5e-3;
+#define HISTORY_LENGTH_ENV_VAR "ROS_TRAFFIC_MODEL_HISTORY_LENGTH"
+#define WARMUP_ENV_VAR "ROS_TRAFFIC_MODEL_WARMUP"
+#define MODEL_FRESHNESS_ENV_VAR "ROS_TRAFFIC_MODEL_FRESHNESS"
+#define PREDICTABLE_THRESH_ENV_VAR "ROS_TRAFFIC_MODEL_PREDICTABLE_THRESHOLD"
+#define MAX_PERIOD_COMPONENTS_ENV_VAR "ROS_TRAFFIC_MODEL_MAX_PERIOD_COMPONENTS"
+
+// the least samples a time model with a residual sigma can be fitted over
+#define MIN_HISTORY_LENGTH 3
+
+// set in traffic_sample_t::dt when it counts microseconds, for gaps of 2^31 ns (~2.1 s) and more
+#define SAMPLE_DT_COARSE 0x80000000u
+// traffic_sample_t::size of a message recorded for its timing only, known sizes saturate below
+#define SAMPLE_SIZE_UNKNOWN UINT32_MAX
+
+// least number of cycles in the window before a composite model is considered
+#define MIN_CYCLES 3
+// lags whose spread is within this factor of the lowest one are multiples of the same cycle
+#define CYCLE_SPREAD_MARGIN 1.5
+// spread below the clock resolution, in seconds, is rounding noise
+#define CYCLE_SPREAD_FLOOR 1e-9
+
+// set in report_middle while the snapshot it indexes has not been reported
+#define REPORT_PENDING 4u
+// set in anomaly_middle while the anomaly it indexes has not been taken
+#define ANOMALY_PENDING 4u
+
+static uint32_t
+sample_dt_encode(int64_t dt)
+{
+    if (dt < 0)
+        return 0;
+    if (dt < (int64_t)SAMPLE_DT_COARSE)
+        return (uint32_t)dt;
+    int64_t dt_us = dt / 1000;
+    return (uint32_t)(dt_us < (int64_t)SAMPLE_DT_COARSE ? dt_us : SAMPLE_DT_COARSE - 1) | SAMPLE_DT_COARSE;
+}
+
+static int64_t
+sample_dt_decode(uint32_t dt)
+{
+    return (dt & SAMPLE_DT_COARSE) ? (int64_t)(dt & ~SAMPLE_DT_COARSE) * 1000 : (int64_t)dt;
+}
+
+// size of a history entry, NAN if it was recorded for its timing only
+static double
+sample_size(const traffic_sample_t * sample)
+{
+    return sample->size == SAMPLE_SIZE_UNKNOWN ? NAN : sample->size;
+}
+
+// option value if set, else the environment variable if set and valid, else the default
+static size_t
+resolve_size_option(size_t value, const char *env_var, size_t default_value)
+{
+    const char *env_value = NULL;
+    if (value)
+        return value;
+    if (NULL == rcutils_get_env(env_var, &env_value) && env_value && strcmp(env_value, "") != 0) {
+        char *end = NULL;
+        unsigned long number = strtoul(env_value, &end, 10);  // NOLINT(runtime/int)
+        if (*end == '\0' && number > 0)
+            return (size_t)number;
+        RCUTILS_LOG_WARN_NAMED(
+            ROS_PACKAGE_NAME "_collector", "Ignoring invalid %s '%s'", env_var, env_value);
+    }
+    return default_value;
+}
+
+static double
+resolve_double_option(double value, const char *env_var, double default_value)
+{
+    const char *env_value = NULL;
+    if (value > 0)
+        return value;
+    if (NULL == rcutils_get_env(env_var, &env_value) && env_value && strcmp(env_value, "") != 0) {
+        char *end = NULL;
+        double number = strtod(env_value, &end);
+        if (*end == '\0' && number > 0)
+            return number;
+        RCUTILS_LOG_WARN_NAMED(
+            ROS_PACKAGE_NAME "_collector", "Ignoring invalid %s '%s'", env_var, env_value);
+    }
+    return default_value;
+}
+
+static int64_t
+get_local_time() {
+    struct timespec param_time;
+    clock_gettime(CLOCK_MONOTONIC, &param_time);
+    return (int64_t)param_time.tv_sec*1000000000 + param_time.tv_nsec;
+}
+
+static int64_t
+monotonic_clock(void * state)
+{
+    (void)state;
+    return get_local_time();
+}
 
 rcl_collector_t
 rcl_get_zero_initialized_collector()
@@ -42,44 +153,144 @@ rcl_get_zero_initialized_collector()
 
 rcl_ret_t
 rcl_collector_init(
-    rcl_collector_t *collector, const rcl_node_t *node, const rosidl_message_type_support_t *type_support, const char *topic_name)
+    rcl_collector_t *collector, const rcl_node_t *node, const rosidl_message_type_support_t *type_support, const char *topic_name,
+    const rcl_collector_options_t *options, const rcl_collector_policy_match_t *policy, bool receive)
 {
     rcutils_allocator_t allocator = rcutils_get_default_allocator();
 
     collector->ts = type_support;
+    collector->clock = monotonic_clock;
+    collector->clock_state = NULL;
+    collector->on_model_update = NULL;
 
-    collector->times = allocator.allocate(
-        sizeof(double)*(HISTORY_LENGTH+1),
-        allocator.state);
-    collector->sizes = allocator.allocate(
-        sizeof(double)*(HISTORY_LENGTH+1),
-        allocator.state);
+    if (NULL == type_support ||
+        RCL_RET_OK != rcl_serialized_size_estimator_init(&collector->size_estimator, type_support)) {
+        // the publish and take paths fall back to serializing to learn message sizes
+        collector->size_estimator = rcl_get_zero_initialized_serialized_size_estimator();
+    }
+
+    collector->serialized_message = rmw_get_zero_initialized_serialized_message();
+    if (RMW_RET_OK != rmw_serialized_message_init(&collector->serialized_message, 0, &allocator)) {
+        RCUTILS_SET_ERROR_MSG("Failed to initialize serialization buffer");
+        return RCL_RET_ERROR;
+    }
+    atomic_init(&collector->serialized_message_in_use, false);
+    atomic_init(&collector->serialized_message_reserve, 0);
 
-    collector->publisher = rcl_get_zero_initialized_publisher();
-    rcl_publisher_options_t options = rcl_publisher_get_default_options();  // TODO: we may need non-default options
-    const rosidl_message_type_support_t * ts = ROSIDL_GET_MSG_TYPE_SUPPORT(rcl_interfaces, msg, TrafficModel);
+    collector->history_length = resolve_size_option(
+        options->history_length, HISTORY_LENGTH_ENV_VAR, DEFAULT_HISTORY_LENGTH);
+    if (collector->history_length < MIN_HISTORY_LENGTH)
+        collector->history_length = MIN_HISTORY_LENGTH;
+    collector->warmup = resolve_size_option(options->warmup, WARMUP_ENV_VAR, DEFAULT_WARMUP);
+    if (collector->warmup < MIN_HISTORY_LENGTH)
+        collector->warmup = MIN_HISTORY_LENGTH;
+    if (collector->warmup > collector->history_length)
+        collector->warmup = collector->history_length;
+    collector->model_freshness = resolve_double_option(
+        options->model_freshness, MODEL_FRESHNESS_ENV_VAR, DEFAULT_MODEL_FRESHNESS);
+    collector->predictable_threshold = resolve_double_option(
+        options->predictable_threshold, PREDICTABLE_THRESH_ENV_VAR, DEFAULT_PREDICTABLE_THRESH);
+    collector->max_period_components = resolve_size_option(
+        options->max_period_components, MAX_PERIOD_COMPONENTS_ENV_VAR, DEFAULT_MAX_PERIOD_COMPONENTS);
+    if (collector->max_period_components > MAX_PERIOD_COMPONENTS)
+        collector->max_period_components = MAX_PERIOD_COMPONENTS;
 
-    const char * machine_id = getenv("ROS_MACHINE_ID");
-    const char * report_topic_prefix = "ros_traffic_model_";
-    char * report_topic = allocator.allocate(
-        sizeof(char)*(strlen(report_topic_prefix)+strlen(machine_id)+1),
+    collector->samples = allocator.allocate(
+        sizeof(traffic_sample_t)*(collector->history_length+1),
         allocator.state);
-    strcpy(report_topic, report_topic_prefix);
-    strcat(report_topic, machine_id);
-    if(RCL_RET_OK != rcl_publisher_init_internal(
-            &collector->publisher, node, ts, report_topic, &options, false)) {
-        RCUTILS_SET_ERROR_MSG("Failed to create publisher on topic 'ros2_traffic_model'");
-        return RCL_RET_ERROR;
+    if (NULL == collector->samples) {
+        RCUTILS_SET_ERROR_MSG("Failed to allocate the traffic history");
+        return RCL_RET_BAD_ALLOC;
+    }
+    collector->staging_capacity = 1;
+    while (collector->staging_capacity < collector->history_length &&
+           collector->staging_capacity < COLLECTOR_MAX_STAGING_CAPACITY)
+        collector->staging_capacity *= 2;
+    collector->staged = allocator.allocate(
+        sizeof(traffic_staged_t)*collector->staging_capacity, allocator.state);
+    if (NULL == collector->staged) {
+        RCUTILS_SET_ERROR_MSG("Failed to allocate the staging ring");
+        return RCL_RET_BAD_ALLOC;
+    }
+
+    collector->topic_name = rcutils_strdup(topic_name, allocator);
+    if (NULL == collector->topic_name) {
+        RCUTILS_SET_ERROR_MSG("Failed to copy the topic name");
+        return RCL_RET_BAD_ALLOC;
     }
-    allocator.deallocate(report_topic, allocator.state);
+    collector->receive = receive;
 
-    collector->topic_name = topic_name;
+    for (size_t i = 0; i < collector->staging_capacity; ++i)
+        atomic_init(&collector->staged[i].sequence, i);
+    atomic_init(&collector->staged_claim, 0);
+    collector->staged_next = 0;
+    atomic_init(&collector->ingest_busy, false);
+    atomic_init(&collector->staged_dropped, 0);
+
+    collector->sampling = collector->sampling_base = policy->sampling ? policy->sampling : 1;
+    collector->overhead_budget = policy->overhead_budget;
+    atomic_init(&collector->sampling_shared, collector->sampling);
+    atomic_init(&collector->sample_skip, 0);
+    collector->sample_end = 0;
+    collector->budget_count = 0;
 
     // initialize traffic model
+    memset(&collector->stats, 0, sizeof(collector->stats));
+    memset(collector->lags, 0, sizeof(collector->lags));
+    collector->latency_count = 0;
     collector->traffic_model.initialized = false;
+    collector->traffic_model.latency = NAN;
+    atomic_init(&collector->model_size, 0);
+
+    // preallocate the report, only the model fields change from one report to the next,
+    // receive-side reports are told apart from the publish-side one by the receiving node
+    char *receive_id = NULL;
+    if (receive && NULL != node) {
+        receive_id = rcutils_format_string(
+            allocator, "%s@%s", topic_name, rcl_node_get_fully_qualified_name(node));
+    }
+    bool report_ok = (!receive || NULL == node || NULL != receive_id) &&
+        rcl_interfaces__msg__TrafficModel__init(&collector->report_msg) &&
+        rosidl_runtime_c__String__assign(&collector->report_msg.id, receive_id ? receive_id : topic_name) &&
+        rcl_interfaces__msg__TrafficModel__init(&collector->component_msg);
+    if (NULL != receive_id)
+        allocator.deallocate(receive_id, allocator.state);
+    if (!report_ok) {
+        RCUTILS_SET_ERROR_MSG("Failed to allocate the traffic model report");
+        return RCL_RET_BAD_ALLOC;
+    }
+    collector->report_back = 0;
+    atomic_init(&collector->report_middle, 1);
+    collector->report_front = 2;
+
+    atomic_init(&collector->anomaly_listening, false);
+    memset(collector->anomalies, 0, sizeof(collector->anomalies));
+    collector->anomaly_back = 0;
+    atomic_init(&collector->anomaly_middle, 1);
+    collector->anomaly_front = 2;
+    collector->anomaly_count = 0;
+    collector->anomaly_guard_condition = NULL;
+
+    if (NULL == node) {
+        collector->reporter = NULL;
+        collector->histograms = allocator.zero_allocate(
+            1, sizeof(rcl_collector_histogram_slot_t), allocator.state);
+    } else {
+        collector->reporter = node->context->impl->collector_reporter;
+        collector->histograms = rcl_collector_reporter_acquire_histograms(
+            collector->reporter, collector->report_msg.id.data);
+    }
+    if (NULL == collector->histograms) {
+        RCUTILS_SET_ERROR_MSG("Failed to allocate the traffic histograms");
+        return RCL_RET_BAD_ALLOC;
+    }
+    if (NULL != collector->reporter &&
+        RCL_RET_OK != rcl_collector_reporter_register(collector->reporter, collector)) {
+        return RCL_RET_ERROR;  // error already set
+    }
 
     RCUTILS_LOG_DEBUG_NAMED(
-        ROS_PACKAGE_NAME "_collector", "Collector initialized for topic %s", collector->topic_name);
+        ROS_PACKAGE_NAME "_collector", "Collector initialized for %s", collector->report_msg.id.data);
 
     return RCL_RET_OK;
 }
@@ -90,144 +301,1081 @@ rcl_collector_fini(
 {
     rcutils_allocator_t allocator = rcutils_get_default_allocator();
 
-    if (RCL_RET_OK
-            != rcl_publisher_fini(&collector->publisher, node)) {
-        RCUTILS_SET_ERROR_MSG("Failed to finalize publisher");
-        return RCL_RET_ERROR;
+    (void)node;
+
+    // the reporter must be done with the report before it is finalized
+    if (NULL != collector->reporter) {
+        rcl_collector_reporter_unregister(collector->reporter, collector);
+        if (NULL != collector->histograms)
+            rcl_collector_reporter_release_histograms(collector->reporter, collector->histograms);
+    } else {
+        allocator.deallocate(collector->histograms, allocator.state);
     }
+    rcl_interfaces__msg__TrafficModel__fini(&collector->report_msg);
+    rcl_interfaces__msg__TrafficModel__fini(&collector->component_msg);
+
+    allocator.deallocate(collector->samples, allocator.state);
+    allocator.deallocate(collector->staged, allocator.state);
+    allocator.deallocate(collector->topic_name, allocator.state);
 
-    if (RCL_RET_OK
-            != rcl_publisher_fini(&collector->publisher, node)) {
-        RCUTILS_SET_ERROR_MSG("Failed to finalize publisher");
+    rcl_ret_t ret = RCL_RET_OK;
+    if (NULL != collector->anomaly_guard_condition) {
+        ret = rcl_guard_condition_fini(collector->anomaly_guard_condition);
+        allocator.deallocate(collector->anomaly_guard_condition, allocator.state);
+    }
+
+    // a failed init may not have got as far as the serialization buffer
+    if (rcutils_allocator_is_valid(&collector->serialized_message.allocator) &&
+            RMW_RET_OK != rmw_serialized_message_fini(&collector->serialized_message)) {
+        RCUTILS_SET_ERROR_MSG("Failed to finalize serialization buffer");
         return RCL_RET_ERROR;
     }
 
-    allocator.deallocate(collector->times, allocator.state);
-    allocator.deallocate(collector->sizes, allocator.state);
+    return ret;
+}
 
-    return RCL_RET_OK;
+void
+rcl_collector_set_clock(
+    rcl_collector_t * collector,
+    rcl_collector_clock_t clock,
+    void * state)
+{
+    collector->clock = clock;
+    collector->clock_state = state;
 }
 
-double get_local_time() {
-    struct timespec param_time;
-    clock_gettime(CLOCK_MONOTONIC, &param_time);
-    return ((double)param_time.tv_sec + (double)param_time.tv_nsec*1e-9);
+void
+rcl_collector_set_model_callback(
+    rcl_collector_t * collector,
+    rcl_collector_model_callback_t callback,
+    void * state)
+{
+    collector->on_model_update = callback;
+    collector->on_model_update_state = state;
 }
 
-rcl_ret_t
-rcl_collector_on_message(
+size_t
+rcl_collector_serialized_message_reserve(
+    rcl_collector_t * collector)
+{
+    size_t reserve;
+    rcutils_atomic_load(&collector->serialized_message_reserve, reserve);
+    return reserve;
+}
+
+rmw_serialized_message_t *
+rcl_collector_acquire_serialized_message(
+    rcl_collector_t * collector)
+{
+    if (rcutils_atomic_exchange_bool(&collector->serialized_message_in_use, true)) {
+        // another thread is publishing through this collector, let the caller use its own buffer
+        return NULL;
+    }
+    rmw_serialized_message_t * serialized_message = &collector->serialized_message;
+    // grow ahead of time so that messages within the size model do not trigger a realloc
+    // inside rmw_serialize, but never shrink to avoid thrashing on bursty sizes
+    size_t reserve = rcl_collector_serialized_message_reserve(collector);
+    if (serialized_message->buffer_capacity < reserve) {
+        if (RMW_RET_OK != rmw_serialized_message_resize(serialized_message, reserve)) {
+            // not fatal, rmw_serialize grows the buffer on demand
+            rcutils_reset_error();
+        }
+    }
+    serialized_message->buffer_length = 0;
+    return serialized_message;
+}
+
+void
+rcl_collector_release_serialized_message(
+    rcl_collector_t * collector,
+    rmw_serialized_message_t * serialized_message)
+{
+    if (serialized_message == &collector->serialized_message) {
+        rcutils_atomic_store(&collector->serialized_message_in_use, false);
+    }
+}
+
+// Welford update of the window moments with a sample appended at index n, size NAN if unknown
+static void
+stats_push(traffic_stats_t * stats, double time, double size)
+{
+    double k = stats->n;
+    double mean_k = (k - 1) / 2;  // mean of the indices 0..k-1 already in the window
+    ++stats->n;
+
+    double dt = time - stats->mean_t;
+    stats->mean_t += dt / stats->n;
+    stats->m2_t += dt * (time - stats->mean_t);
+    stats->c_kt += (k - mean_k) * (time - stats->mean_t);
+
+    if (isnan(size))
+        return;
+    ++stats->n_s;
+    double ds = size - stats->mean_s;
+    stats->mean_s += ds / stats->n_s;
+    stats->m2_s += ds * (size - stats->mean_s);
+}
+
+// inverse Welford update removing the oldest sample, the remaining indices shift down by one
+static void
+stats_evict(traffic_stats_t * stats, double time, double size)
+{
+    if (stats->n <= 1) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    double n = stats->n;
+    // the co-moment is shift invariant, so only the removal of index 0 needs accounting for
+    stats->c_kt += n / 2 * (time - stats->mean_t);
+
+    double mean_t = (n * stats->mean_t - time) / (n - 1);
+    stats->m2_t -= (time - mean_t) * (time - stats->mean_t);
+    stats->mean_t = mean_t;
+
+    if (!isnan(size)) {
+        double n_s = stats->n_s;
+        if (n_s <= 1) {
+            stats->mean_s = stats->m2_s = 0;
+        } else {
+            double mean_s = (n_s * stats->mean_s - size) / (n_s - 1);
+            stats->m2_s -= (size - mean_s) * (size - stats->mean_s);
+            stats->mean_s = mean_s;
+        }
+        --stats->n_s;
+    }
+
+    --stats->n;
+    ++stats->evictions;
+}
+
+// recompute the moments from the window to discard rounding error accumulated by evictions,
+// done once per window turnover so the amortized cost per message stays constant
+static void
+stats_resync(rcl_collector_t * collector)
+{
+    traffic_stats_t * stats = &collector->stats;
+    size_t capacity = collector->history_length+1;
+    double n = stats->n;
+    // times relative to the head entry, then shifted back, to keep the sums well conditioned
+    double head_time = collector->head_time*1e-9;
+    double sum_t = 0, sum_s = 0;
+    size_t n_s = 0;
+    int64_t time = 0;
+    for (size_t cur = collector->head; cur != collector->tail; cur=(cur+1)%capacity) {
+        if (cur != collector->head)
+            time += sample_dt_decode(collector->samples[cur].dt);
+        sum_t += time*1e-9;
+        double size = sample_size(&collector->samples[cur]);
+        if (!isnan(size)) {
+            sum_s += size;
+            ++n_s;
+        }
+    }
+    double mean_t = sum_t / n;
+    stats->n_s = n_s;
+    stats->mean_s = n_s ? sum_s / n_s : 0;
+
+    double mean_k = (n - 1) / 2;
+    stats->m2_t = stats->m2_s = stats->c_kt = 0;
+    time = 0;
+    for (size_t cur = collector->head, k=0; cur != collector->tail; cur=(cur+1)%capacity, ++k) {
+        if (cur != collector->head)
+            time += sample_dt_decode(collector->samples[cur].dt);
+        double dt = time*1e-9 - mean_t;
+        double ds = sample_size(&collector->samples[cur]) - stats->mean_s;
+        stats->m2_t += dt * dt;
+        stats->c_kt += (k - mean_k) * dt;
+        if (!isnan(ds))
+            stats->m2_s += ds * ds;
+    }
+    stats->mean_t = head_time + mean_t;
+    stats->evictions = 0;
+}
+
+static void
+lag_stats_push(traffic_lag_stats_t * lag, double diff)
+{
+    ++lag->n;
+    double d = diff - lag->mean;
+    lag->mean += d / lag->n;
+    lag->m2 += d * (diff - lag->mean);
+}
+
+static void
+lag_stats_evict(traffic_lag_stats_t * lag, double diff)
+{
+    if (lag->n <= 1) {
+        memset(lag, 0, sizeof(*lag));
+        return;
+    }
+    double n = lag->n;
+    double mean = (n * lag->mean - diff) / (n - 1);
+    lag->m2 -= (diff - mean) * (diff - lag->mean);
+    lag->mean = mean;
+    --lag->n;
+}
+
+// add the differences between the entry and each of the max_period_components entries before it
+static void
+lags_push(rcl_collector_t * collector, size_t entry)
+{
+    size_t capacity = collector->history_length+1;
+    int64_t diff = 0;
+    for (size_t m = 1; m <= collector->max_period_components && entry != collector->head; ++m) {
+        diff += sample_dt_decode(collector->samples[entry].dt);
+        entry = (entry+capacity-1)%capacity;
+        lag_stats_push(&collector->lags[m-1], diff*1e-9);
+    }
+}
+
+// remove the differences between the head entry, about to be evicted, and the entries after it
+static void
+lags_evict(rcl_collector_t * collector)
+{
+    size_t capacity = collector->history_length+1;
+    size_t entry = collector->head;
+    int64_t diff = 0;
+    for (size_t m = 1; m <= collector->max_period_components; ++m) {
+        entry = (entry+1)%capacity;
+        if (entry == collector->tail)
+            break;
+        diff += sample_dt_decode(collector->samples[entry].dt);
+        lag_stats_evict(&collector->lags[m-1], diff*1e-9);
+    }
+}
+
+static void
+lags_resync(rcl_collector_t * collector)
+{
+    size_t capacity = collector->history_length+1;
+    memset(collector->lags, 0, sizeof(collector->lags));
+    for (size_t cur = collector->head; cur != collector->tail; cur=(cur+1)%capacity)
+        lags_push(collector, cur);
+}
+
+// shortest number of messages after which publish times repeat, 1 if none within the window
+static size_t
+detect_cycle(const rcl_collector_t * collector)
+{
+    double spread[MAX_PERIOD_COMPONENTS];
+    double lowest = INFINITY;
+    size_t lags = 0;
+    while (lags < collector->max_period_components && (lags+1)*MIN_CYCLES <= collector->stats.n) {
+        const traffic_lag_stats_t * lag = &collector->lags[lags];
+        spread[lags] = sqrt(fmax(lag->m2, 0)/(lag->n-1));
+        lowest = fmin(lowest, spread[lags]);
+        ++lags;
+    }
+    // whole multiples of the cycle repeat just as well, the first lag close to the lowest is it
+    for (size_t m = 1; m <= lags; ++m) {
+        if (spread[m-1] <= CYCLE_SPREAD_MARGIN*lowest + CYCLE_SPREAD_FLOOR)
+            return m;
+    }
+    return 1;
+}
+
+// sums over the messages at one position of the cycle, for fit_components
+typedef struct
+{
+    double n, mean_c, mean_y;
+    // over the messages of known size only
+    double n_s, mean_s;
+    double m2_c, c_cy, m2_y, m2_s;
+} component_sums_t;
+
+// least squares fit of one cycle length shared by all components and one phase per component,
+// over the window with message k at position k%cycle of cycle k/cycle
+static void
+fit_components(rcl_collector_t * collector, size_t cycle)
+{
+    traffic_model_t * model = &collector->traffic_model;
+    size_t capacity = collector->history_length+1;
+    component_sums_t sums[MAX_PERIOD_COMPONENTS];
+    memset(sums, 0, sizeof(sums));
+    // detrend by the mean cycle from the lag statistics so that only small residuals are summed
+    double cycle_guess = collector->lags[cycle-1].mean;
+    double head_time = collector->head_time*1e-9;
+
+    // two passes, for the means and then the centered sums, as in stats_resync
+    for (int pass = 0; pass < 2; ++pass) {
+        int64_t time = 0;
+        for (size_t cur = collector->head, k = 0; cur != collector->tail; cur=(cur+1)%capacity, ++k) {
+            if (cur != collector->head)
+                time += sample_dt_decode(collector->samples[cur].dt);
+            component_sums_t * sum = &sums[k % cycle];
+            double c = (double)(k / cycle);
+            double y = time*1e-9 - cycle_guess*c;
+            double size = sample_size(&collector->samples[cur]);
+            bool size_known = !isnan(size);
+            if (pass == 0) {
+                sum->n += 1;
+                sum->mean_c += c;
+                sum->mean_y += y;
+                sum->n_s += size_known;
+                sum->mean_s += size_known ? size : 0;
+            } else {
+                double dc = c - sum->mean_c, dy = y - sum->mean_y, ds = size - sum->mean_s;
+                sum->m2_c += dc * dc;
+                sum->c_cy += dc * dy;
+                sum->m2_y += dy * dy;
+                sum->m2_s += size_known ? ds * ds : 0;
+            }
+        }
+        for (size_t r = 0; pass == 0 && r < cycle; ++r) {
+            sums[r].mean_c /= sums[r].n;
+            sums[r].mean_y /= sums[r].n;
+            if (sums[r].n_s > 0)
+                sums[r].mean_s /= sums[r].n_s;
+        }
+    }
+
+    double m2_c = 0, c_cy = 0;
+    for (size_t r = 0; r < cycle; ++r) {
+        m2_c += sums[r].m2_c;
+        c_cy += sums[r].c_cy;
+    }
+    double correction = m2_c > 0 ? c_cy / m2_c : 0;
+
+    model->cycle = cycle_guess + correction;
+    model->components = cycle;
+    for (size_t r = 0; r < cycle; ++r) {
+        const component_sums_t * sum = &sums[r];
+        traffic_component_t * component = &model->component[r];
+        double ssr = fmax(sum->m2_y - 2*correction*sum->c_cy + correction*correction*sum->m2_c, 0);
+        component->b = head_time + sum->mean_y - correction*sum->mean_c;
+        component->sigma_t = sqrt(ssr/(sum->n-1));
+        component->s = sum->n_s > 0 ? sum->mean_s : model->s;
+        component->sigma_s = sum->n_s > 1 ? sqrt(sum->m2_s/(sum->n_s-1)) : model->sigma_s;
+    }
+}
+
+// publish time predicted closest to `time`, and the time sigma of the prediction
+static double
+model_predict(const traffic_model_t * model, double time, double * sigma_t)
+{
+    double time_pred = model->a*round((time - model->b) / model->a) + model->b;
+    *sigma_t = model->sigma_t;
+    for (size_t r = 0; r < model->components; ++r) {
+        const traffic_component_t * component = &model->component[r];
+        double pred = model->cycle*round((time - component->b) / model->cycle) + component->b;
+        if (r == 0 || fabs(time - pred) < fabs(time - time_pred)) {
+            time_pred = pred;
+            *sigma_t = component->sigma_t;
+        }
+    }
+    return time_pred;
+}
+
+// publish a model related to the collector's, with the collector's report id followed by suffix
+static rcl_ret_t
+publish_related_report(
     rcl_collector_t * collector,
-    size_t param_size)
+    const rcl_publisher_t * publisher,
+    const char * suffix,
+    double a, double b, double sigma_t, double s, double sigma_s)
+{
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    rcl_interfaces__msg__TrafficModel *msg = &collector->component_msg;
+    char *id = rcutils_format_string(allocator, "%s%s", collector->report_msg.id.data, suffix);
+    bool assigned = NULL != id && rosidl_runtime_c__String__assign(&msg->id, id);
+    if (NULL != id)
+        allocator.deallocate(id, allocator.state);
+    if (!assigned) {
+        RCUTILS_SET_ERROR_MSG("Failed to allocate the traffic model report id");
+        return RCL_RET_BAD_ALLOC;
+    }
+    msg->a = a;
+    msg->b = b;
+    msg->sigma_t = sigma_t;
+    msg->s = s;
+    msg->sigma_s = sigma_s;
+    return rcl_publish(publisher, msg, NULL);
+}
+
+bool
+rcl_collector_publish_report(
+    rcl_collector_t * collector,
+    const rcl_publisher_t * publisher)
+{
+    if (!(rcutils_atomic_load_uint64_t(&collector->report_middle) & REPORT_PENDING))
+        return false;
+    // models posted since the last report are coalesced, only the latest one is taken
+    collector->report_front = rcutils_atomic_exchange_uint64_t(
+        &collector->report_middle, collector->report_front) & ~REPORT_PENDING;
+    const traffic_model_t *model = &collector->reports[collector->report_front];
+
+    rcl_interfaces__msg__TrafficModel *msg = &collector->report_msg;
+    msg->a = model->a;
+    msg->b = model->b;
+    msg->sigma_t = model->sigma_t;
+    msg->s = model->s;
+    msg->sigma_s = model->sigma_s;
+    rcl_ret_t ret_pub = rcl_publish(publisher, msg, NULL);
+
+    // components follow their model, as "<id>#<position>/<cycle length>"
+    for (size_t r = 0; r < model->components && RCL_RET_OK == ret_pub; ++r) {
+        const traffic_component_t * component = &model->component[r];
+        char suffix[48];
+        snprintf(suffix, sizeof(suffix), "#%zu/%zu", r, model->components);
+        ret_pub = publish_related_report(
+            collector, publisher, suffix, model->cycle, component->b, component->sigma_t,
+            component->s, component->sigma_s);
+    }
+    // the latency of receive-side models as "<id>/latency", in the size fields for lack of others
+    if (RCL_RET_OK == ret_pub && isfinite(model->latency)) {
+        ret_pub = publish_related_report(
+            collector, publisher, "/latency", 0, 0, 0, model->latency, model->sigma_latency);
+    }
+    if (RCL_RET_OK == ret_pub) {
+        RCUTILS_LOG_DEBUG_NAMED(
+            ROS_PACKAGE_NAME "_collector", "Successfully published new model");
+    } else {
+        RCUTILS_LOG_ERROR_NAMED(
+            ROS_PACKAGE_NAME "_collector", "Failed publishing new model, '%s'", rcutils_get_error_string().str);
+        rcutils_reset_error();
+    }
+    return true;
+}
+
+const traffic_model_t *
+rcl_collector_get_reported_model(
+    const rcl_collector_t * collector)
+{
+    return &collector->reports[collector->report_front];
+}
+
+// exponentially weighted update, the weight makes the last history_length messages dominate
+static void
+latency_push(rcl_collector_t * collector, double latency)
 {
-    double time = get_local_time();
-    double size = param_size;
+    if (0 == collector->latency_count++) {
+        collector->latency_mean = latency;
+        collector->latency_var = 0;
+        return;
+    }
+    double alpha = 2.0 / (collector->history_length + 1);
+    double d = latency - collector->latency_mean;
+    collector->latency_mean += alpha * d;
+    collector->latency_var = (1 - alpha) * (collector->latency_var + alpha * d * d);
+}
 
+// hand an anomaly to the listening event, and wake the waits on it
+static void
+anomaly_raise(
+    rcl_collector_t * collector,
+    rcl_traffic_anomaly_kind_t kind,
+    double offset,
+    double sigma)
+{
+    rcl_traffic_anomaly_status_t *status = &collector->anomalies[collector->anomaly_back];
+    status->total_count = ++collector->anomaly_count;
+    status->total_count_change = 0;
+    status->last_kind = kind;
+    status->offset = offset;
+    status->deviation = sigma > 0 ? offset/sigma : copysign(INFINITY, offset);
+    collector->anomaly_back = rcutils_atomic_exchange_uint64_t(
+        &collector->anomaly_middle, collector->anomaly_back | ANOMALY_PENDING) & ~ANOMALY_PENDING;
     RCUTILS_LOG_DEBUG_NAMED(
-        ROS_PACKAGE_NAME "_collector", "On message with size %zu time %f", param_size, time);
+        ROS_PACKAGE_NAME "_collector", "Traffic anomaly %d on %s, %f sigma",
+        (int)kind, collector->topic_name, status->deviation);
+    if (RCL_RET_OK != rcl_trigger_guard_condition(collector->anomaly_guard_condition)) {
+        // the anomaly is still taken by the next wait that checks the event
+        rcutils_reset_error();
+    }
+}
+
+// record a published or received message, latency in seconds is NAN when not known
+static rcl_ret_t
+collector_record(
+    rcl_collector_t * collector,
+    int64_t time_ns,
+    size_t param_size,
+    double latency)
+{
+    bool size_known = RCL_COLLECTOR_SIZE_UNKNOWN != param_size;
+    uint32_t stored_size = !size_known ? SAMPLE_SIZE_UNKNOWN :
+        param_size >= SAMPLE_SIZE_UNKNOWN ? SAMPLE_SIZE_UNKNOWN - 1 : (uint32_t)param_size;
+    double size = size_known ? stored_size : NAN;
 
     ++collector->count;
 
-    // append time log
-    if ((collector->tail+1)%(HISTORY_LENGTH+1) == collector->head)
-        collector->head = (collector->head+1)%(HISTORY_LENGTH+1);
-    collector->times[collector->tail] = time;
-    collector->sizes[collector->tail] = size;
-    collector->tail = (collector->tail+1)%(HISTORY_LENGTH+1);
+    // append time log, entries store the time since the previous entry
+    size_t capacity = collector->history_length+1;
+    uint32_t dt = 0;
+    bool has_previous = collector->head != collector->tail;
+    int64_t previous_time_ns = collector->tail_time;
+    if (size_known)
+        rcl_collector_histogram_record(&collector->histograms->size, stored_size);
+    if (collector->head == collector->tail) {
+        collector->head_time = time_ns;
+    } else {
+        // concurrent publishers read the clock before claiming their slot, in either order
+        if (time_ns < collector->tail_time)
+            time_ns = collector->tail_time;
+        rcl_collector_histogram_record(
+            &collector->histograms->interval, (uint64_t)(time_ns - collector->tail_time));
+        dt = sample_dt_encode(time_ns - collector->tail_time);
+        // coarse deltas round the time, the ring must stay consistent with what it stores
+        time_ns = collector->tail_time + sample_dt_decode(dt);
+    }
+    if ((collector->tail+1)%capacity == collector->head) {
+        lags_evict(collector);
+        double evicted_size = sample_size(&collector->samples[collector->head]);
+        stats_evict(&collector->stats, collector->head_time*1e-9, evicted_size);
+        collector->head = (collector->head+1)%capacity;
+        collector->head_time += sample_dt_decode(collector->samples[collector->head].dt);
+    }
+    collector->samples[collector->tail].dt = dt;
+    collector->samples[collector->tail].size = stored_size;
+    collector->tail = (collector->tail+1)%capacity;
+    collector->tail_time = time_ns;
+
+    if (isfinite(latency)) {
+        latency_push(collector, latency);
+        rcl_collector_histogram_record(
+            &collector->histograms->duration, latency > 0 ? (uint64_t)(latency*1e9) : 0);
+    }
+
+    double time = time_ns*1e-9;
+    RCUTILS_LOG_DEBUG_NAMED(
+        ROS_PACKAGE_NAME "_collector", "On message with size %zu time %f", param_size, time);
+
+    stats_push(&collector->stats, time, size);
+    lags_push(collector, (collector->tail+capacity-1)%capacity);
+    if (collector->stats.evictions >= collector->history_length) {
+        stats_resync(collector);
+        lags_resync(collector);
+    }
 
-    if ((collector->tail+(HISTORY_LENGTH+1)-collector->head)%(HISTORY_LENGTH+1) < WARMUP)
+    if ((collector->tail+capacity-collector->head)%capacity < collector->warmup)
         return RCL_RET_OK;
 
     bool model_updated = false;
-    bool force_update = !collector->traffic_model.initialized || (time - collector->traffic_model.last_update > MODEL_FRESHNESS);
+    bool force_update = !collector->traffic_model.initialized || (time - collector->traffic_model.last_update > collector->model_freshness);
 
     // recompute time model if the prediction is inaccurate
     double time_pred = NAN;
+    double sigma_pred = NAN;
     if (collector->traffic_model.initialized) {
-        time_pred = collector->traffic_model.a*round((time - collector->traffic_model.b) / collector->traffic_model.a)
-            + collector->traffic_model.b;
+        time_pred = model_predict(&collector->traffic_model, time, &sigma_pred);
         RCUTILS_LOG_DEBUG_NAMED(
             ROS_PACKAGE_NAME "_collector", "Predicted time %f", time_pred);
     }
-    if (force_update || fabs(time-time_pred) > 3*collector->traffic_model.sigma_t) {
-        double n = (collector->tail+(HISTORY_LENGTH+1)-collector->head)%(HISTORY_LENGTH+1);
-        double sum_x = (n-1)*n/2,  // sum of {0, 1, 2, ...}
-              sum_x2 = (n-1)*n*(2*n-1)/6;  // sum of {0^2, 1^2, 2^2, ...}
-        double sum_y = 0, sum_xy = 0;
-        for (size_t cur = collector->head, k=0; cur != collector->tail; cur=(cur+1)%(HISTORY_LENGTH+1), ++k) {
-            sum_y += collector->times[cur];
-            sum_xy += k*collector->times[cur];
+
+    // anomalies are judged against the model as it was before this message
+    if (collector->traffic_model.initialized &&
+            rcutils_atomic_load_bool(&collector->anomaly_listening)) {
+        // the nearest slot hides skipped publishes, they are counted from the previous one
+        double a = collector->traffic_model.a;
+        double since_previous = has_previous ? (time_ns - previous_time_ns)*1e-9 : 0;
+        double offset;
+        if (a > 0 && round(since_previous / a) - 1 >= 1) {
+            offset = since_previous - a;
+            anomaly_raise(collector, RCL_TRAFFIC_ANOMALY_MISSED_PERIOD, offset, sigma_pred);
+        } else {
+            offset = time - time_pred;
+            if (fabs(offset) > 3*sigma_pred)
+                anomaly_raise(collector, RCL_TRAFFIC_ANOMALY_MODEL_BREAK, offset, sigma_pred);
         }
+        offset = size - collector->traffic_model.s;
+        if (size_known && fabs(offset) > 3*collector->traffic_model.sigma_s)
+            anomaly_raise(
+                collector, RCL_TRAFFIC_ANOMALY_SIZE_OUTLIER, offset, collector->traffic_model.sigma_s);
+    }
+    if (force_update || fabs(time-time_pred) > 3*sigma_pred) {
+        // least squares fit of time against sample index, from the running moments
+        const traffic_stats_t * stats = &collector->stats;
+        double n = stats->n;
+        double m2_k = n*(n*n-1)/12;  // sum of squared deviations of {0, 1, 2, ...}
 
-        double a = (n*sum_xy - sum_x * sum_y) / (n*sum_x2 - sum_x*sum_x);
-        double b = (sum_y - a*sum_x) / n;
+        double a = stats->c_kt / m2_k;
+        double b = stats->mean_t - a*(n-1)/2;
 
-        // sigma
-        double tmp_sum = 0;
-        for (size_t cur = collector->head, k=0; cur != collector->tail; cur=(cur+1)%(HISTORY_LENGTH+1), ++k) {
-            double tmp = (a*k+b-collector->times[cur]);
-            tmp_sum += tmp*tmp;
-        }
-        double sigma = sqrt(tmp_sum/(n-2));
+        // sigma, from the residual sum of squares
+        double ssr = fmax(stats->m2_t - a*stats->c_kt, 0);
+        double sigma = sqrt(ssr/(n-2));
 
         // update model
         collector->traffic_model.a = a;
         collector->traffic_model.b = b;
         collector->traffic_model.sigma_t = sigma;
 
+        // bursty and multi-rate topics repeat over a cycle of several messages
+        // cycles of sampled messages say little about the topic, only look for them unsampled
+        size_t cycle = collector->max_period_components > 1 && collector->sampling == 1 ?
+            detect_cycle(collector) : 1;
+        double jitter = sigma;
+        collector->traffic_model.components = 0;
+        if (cycle > 1) {
+            fit_components(collector, cycle);
+            jitter = 0;
+            for (size_t r = 0; r < cycle; ++r)
+                jitter = fmax(jitter, collector->traffic_model.component[r].sigma_t);
+            RCUTILS_LOG_DEBUG_NAMED(
+                ROS_PACKAGE_NAME "_collector", "New composite time model for %s: %zu messages every %f",
+                collector->topic_name, cycle, collector->traffic_model.cycle);
+        }
+
+        if (jitter < collector->predictable_threshold*a) {
+            RCUTILS_LOG_DEBUG_NAMED(
+                ROS_PACKAGE_NAME "_collector", "Topic %s is predictable", collector->topic_name);
+        }
+
         model_updated = true;
         RCUTILS_LOG_DEBUG_NAMED(
             ROS_PACKAGE_NAME "_collector", "New time model for %s: a=%f b=%f sigma=%f", collector->topic_name, a, b, sigma);
     }
 
-    // recompute size model if the probability is rare
-    if (force_update || fabs(size - collector->traffic_model.s) > 3*collector->traffic_model.sigma_s) {
-        double n = (collector->tail+(HISTORY_LENGTH+1)-collector->head)%(HISTORY_LENGTH+1);
-
-        double sum_x = 0, sum_x2 = 0;
-        for (size_t cur = collector->head; cur != collector->tail; cur=(cur+1)%(HISTORY_LENGTH+1)) {
-            sum_x += collector->sizes[cur];
-            sum_x2 += collector->sizes[cur]*collector->sizes[cur];
-        }
+    // recompute size model if the probability is rare, messages of unknown size leave it as is
+    double size_offset = size - collector->traffic_model.s;
+    if (collector->stats.n_s > 1 && (force_update ||
+            (size_known && fabs(size_offset) > 3*collector->traffic_model.sigma_s))) {
+        const traffic_stats_t * stats = &collector->stats;
+        double n = stats->n_s;
 
         // sigma
-        double s = sum_x / n;
-        double sigma = sqrt((n*sum_x2-sum_x*sum_x)/n/(n-1));
+        double s = stats->mean_s;
+        double sigma = sqrt(fmax(stats->m2_s, 0)/(n-1));
 
         // update model
         collector->traffic_model.s = s;
         collector->traffic_model.sigma_s = sigma;
 
+        // size the serialization buffer for messages up to 3 sigma above the mean
+        if (isfinite(sigma))
+            rcutils_atomic_store(&collector->serialized_message_reserve, (size_t)ceil(s + 3*sigma));
+        rcutils_atomic_store(&collector->model_size, (uint64_t)llround(s) + 1);
+
         model_updated = true;
         RCUTILS_LOG_DEBUG_NAMED(
             ROS_PACKAGE_NAME "_collector", "New size model for %s: s=%f sigma=%f", collector->topic_name, s, sigma);
     }
 
+    // recompute latency model if the latency is rare
+    if (isfinite(latency) && (force_update || !isfinite(collector->traffic_model.latency) ||
+            fabs(latency - collector->traffic_model.latency) > 3*collector->traffic_model.sigma_latency)) {
+        collector->traffic_model.latency = collector->latency_mean;
+        collector->traffic_model.sigma_latency = sqrt(collector->latency_var);
+
+        model_updated = true;
+        RCUTILS_LOG_DEBUG_NAMED(
+            ROS_PACKAGE_NAME "_collector", "New latency model for %s: latency=%f sigma=%f",
+            collector->report_msg.id.data, collector->traffic_model.latency,
+            collector->traffic_model.sigma_latency);
+    }
+
     if (model_updated) {
         collector->traffic_model.initialized = true;
         collector->traffic_model.last_update = time;
-        // inform application layer collector about the new model
-        rcl_interfaces__msg__TrafficModel *msg = rcl_interfaces__msg__TrafficModel__create();
-        rosidl_runtime_c__String__assign(&msg->id, collector->topic_name);
-        msg->a = collector->traffic_model.a;
-        msg->b = collector->traffic_model.b;
-        msg->sigma_t = collector->traffic_model.sigma_t;
-        msg->s = collector->traffic_model.s;
-        msg->sigma_s = collector->traffic_model.sigma_s;
-        rcl_ret_t ret_pub = rcl_publish(&collector->publisher, msg, NULL);
-        if (RCL_RET_OK == ret_pub) {
-            RCUTILS_LOG_DEBUG_NAMED(
-                ROS_PACKAGE_NAME "_collector", "Successfully published new model");
+        // hand the new model to the reporter, which informs the application layer collector
+        collector->reports[collector->report_back] = collector->traffic_model;
+        // the model is fitted over sampled messages, the topic itself publishes sampling times as often
+        collector->reports[collector->report_back].a /= collector->sampling;
+        if (collector->on_model_update)
+            collector->on_model_update(
+                collector, &collector->reports[collector->report_back],
+                collector->on_model_update_state);
+        collector->report_back = rcutils_atomic_exchange_uint64_t(
+            &collector->report_middle, collector->report_back | REPORT_PENDING) & ~REPORT_PENDING;
+    }
+
+    return RCL_RET_OK;
+}
+
+// forget the history, whose sampling no longer matches, the model is refitted after warmup
+static void
+history_reset(rcl_collector_t * collector)
+{
+    collector->head = collector->tail = 0;
+    memset(&collector->stats, 0, sizeof(collector->stats));
+    memset(collector->lags, 0, sizeof(collector->lags));
+    // sizes do not depend on the sampling, model_size stays until the next size model
+    collector->traffic_model.initialized = false;
+}
+
+#define BUDGET_WEIGHT 0.1
+// sampled messages the cost and interval averages settle over before the budget is enforced
+#define BUDGET_WARMUP 8
+// sampling is never raised above the policy's by more than this factor
+#define BUDGET_MAX_BACKOFF 1024
+
+// double or halve the sampling when the share of time spent collecting leaves the budget,
+// the cost is real time spent, hence the monotonic clock even when messages are replayed
+static void
+overhead_account(rcl_collector_t * collector, int64_t staged_at, int64_t cost_ns)
+{
+    double cost = cost_ns*1e-9;
+    bool first = 0 == collector->sample_end;
+    double interval = (staged_at - collector->sample_end)*1e-9;
+    collector->sample_end = staged_at;
+    if (first)
+        return;
+    if (0 == collector->budget_count++) {
+        collector->sample_cost = cost;
+        collector->sample_interval = interval;
+        return;
+    }
+    collector->sample_cost += BUDGET_WEIGHT * (cost - collector->sample_cost);
+    collector->sample_interval += BUDGET_WEIGHT * (interval - collector->sample_interval);
+    if (collector->budget_count < BUDGET_WARMUP)
+        return;
+
+    double share = collector->sample_cost / collector->sample_interval;
+    size_t sampling = collector->sampling;
+    if (share > collector->overhead_budget &&
+        sampling < collector->sampling_base * BUDGET_MAX_BACKOFF)
+        sampling *= 2;
+    else if (share < collector->overhead_budget / 4 && sampling > collector->sampling_base)
+        sampling /= 2;
+    if (sampling != collector->sampling) {
+        RCUTILS_LOG_DEBUG_NAMED(
+            ROS_PACKAGE_NAME "_collector", "Collecting 1 in %zu messages of %s to stay within budget",
+            sampling, collector->topic_name);
+        collector->sampling = sampling;
+        rcutils_atomic_store(&collector->sampling_shared, sampling);
+        collector->budget_count = 0;
+        collector->sample_end = 0;
+        history_reset(collector);
+    }
+}
+
+static void
+collector_on_sample(
+    rcl_collector_t * collector,
+    const traffic_staged_t * entry)
+{
+    int64_t start = collector->overhead_budget > 0 ? get_local_time() : 0;
+    (void)collector_record(collector, entry->time, entry->value, entry->latency);
+    // the cost to the collecting thread up to staging, and to this one recording the message
+    if (collector->overhead_budget > 0)
+        overhead_account(collector, entry->staged_at, entry->cost + get_local_time() - start);
+}
+
+// the staging slot of the entry at position
+static traffic_staged_t *
+staged_entry(
+    const rcl_collector_t * collector,
+    uint64_t position)
+{
+    return &collector->staged[position & (collector->staging_capacity - 1)];
+}
+
+// whether the entry at position was staged and is yet to be recorded
+static bool
+staged_ready(
+    const rcl_collector_t * collector,
+    uint64_t position)
+{
+    return rcutils_atomic_load_uint64_t(&staged_entry(collector, position)->sequence) ==
+        position + 1;
+}
+
+// record the staged entries in claim order, by whichever thread gets to it first,
+// the others leave their entries to it instead of waiting
+static void
+collector_drain(
+    rcl_collector_t * collector)
+{
+    while (!rcutils_atomic_exchange_bool(&collector->ingest_busy, true)) {
+        uint64_t next = collector->staged_next;
+        for (; staged_ready(collector, next); ++next) {
+            traffic_staged_t *entry = staged_entry(collector, next);
+            if (entry->duration)
+                rcl_collector_histogram_record(&collector->histograms->duration, entry->value);
+            else
+                collector_on_sample(collector, entry);
+            rcutils_atomic_store(&entry->sequence, next + collector->staging_capacity);
+        }
+        collector->staged_next = next;
+        uint64_t dropped = rcutils_atomic_load_uint64_t(&collector->staged_dropped);
+        collector->histograms->dropped = dropped > UINT32_MAX ? UINT32_MAX : (uint32_t)dropped;
+        rcutils_atomic_store(&collector->ingest_busy, false);
+        // threads that staged or dropped an entry since left it to this one, unless a thread
+        // took over in the meantime it is recorded on the next iteration
+        if (!staged_ready(collector, next) &&
+            rcutils_atomic_load_uint64_t(&collector->staged_dropped) == dropped)
+            return;
+    }
+}
+
+// claim count consecutive staging slots, false if the recording thread is too far behind
+static bool
+staged_claim(
+    rcl_collector_t * collector,
+    size_t count,
+    uint64_t * position)
+{
+    uint64_t claim = rcutils_atomic_load_uint64_t(&collector->staged_claim);
+    for (;;) {
+        // entries are recorded in claim order, if the last slot is free all of them are
+        uint64_t last = claim + count - 1;
+        uint64_t sequence = rcutils_atomic_load_uint64_t(
+            &staged_entry(collector, last)->sequence);
+        if (sequence == last) {
+            bool claimed;
+            // a failed exchange reloads claim
+            rcutils_atomic_compare_exchange_strong(
+                &collector->staged_claim, claimed, &claim, claim + count);
+            if (claimed) {
+                *position = claim;
+                return true;
+            }
+        } else if (sequence < last) {
+            return false;  // the entry of the previous round was not recorded yet
         } else {
-            RCUTILS_LOG_ERROR_NAMED(
-                ROS_PACKAGE_NAME "_collector", "Failed publishing new model, '%s'", rcutils_get_error_string().str);
-            rcutils_reset_error();
+            claim = rcutils_atomic_load_uint64_t(&collector->staged_claim);
+        }
+    }
+}
+
+// stage count entries of the given time, sizes[i] or value each, and record them if no
+// other thread is recording, count is at most the staging capacity
+static void
+collector_stage(
+    rcl_collector_t * collector,
+    const rcl_collector_sample_t * sample,
+    bool duration,
+    int64_t time,
+    const size_t * sizes,
+    uint64_t value,
+    size_t count,
+    double latency)
+{
+    uint64_t position;
+    if (staged_claim(collector, count, &position)) {
+        int64_t staged_at = 0;
+        int64_t cost = 0;
+        if (!duration && collector->overhead_budget > 0) {
+            staged_at = get_local_time();
+            // the collection of a batch is shared by its messages
+            cost = (staged_at - sample->sample_start) / (int64_t)count;
         }
-        rcl_interfaces__msg__TrafficModel__destroy(msg);
+        for (size_t i = 0; i < count; ++i) {
+            traffic_staged_t *entry = staged_entry(collector, position + i);
+            entry->duration = duration;
+            entry->time = time;
+            entry->value = sizes ? sizes[i] : value;
+            entry->latency = latency;
+            entry->staged_at = staged_at;
+            entry->cost = cost;
+            rcutils_atomic_store(&entry->sequence, position + i + 1);
+        }
+    } else if (!duration) {
+        uint64_t dropped;
+        rcutils_atomic_fetch_add(&collector->staged_dropped, dropped, count);
+        (void)dropped;
+    }
+    collector_drain(collector);
+}
+
+bool
+rcl_collector_sample(
+    rcl_collector_t * collector,
+    rcl_collector_sample_t * sample)
+{
+    uint64_t sampling = rcutils_atomic_load_uint64_t(&collector->sampling_shared);
+    uint64_t skip;
+    rcutils_atomic_fetch_add(&collector->sample_skip, skip, 1);
+    if ((skip + 1) % sampling != 0)
+        return false;
+    sample->sample_start = collector->overhead_budget > 0 ? get_local_time() : 0;
+    sample->publish_start = 0;
+    return true;
+}
+
+rcl_ret_t
+rcl_collector_on_message(
+    rcl_collector_t * collector,
+    rcl_collector_sample_t * sample,
+    size_t size)
+{
+    sample->publish_start = collector->clock(collector->clock_state);
+    collector_stage(collector, sample, false, sample->publish_start, &size, 0, 1, NAN);
+    return RCL_RET_OK;
+}
+
+size_t
+rcl_collector_sample_batch(
+    rcl_collector_t * collector,
+    rcl_collector_sample_t * sample,
+    bool * sampled,
+    size_t count)
+{
+    uint64_t sampling = rcutils_atomic_load_uint64_t(&collector->sampling_shared);
+    uint64_t skip;
+    rcutils_atomic_fetch_add(&collector->sample_skip, skip, count);
+    size_t collected = 0;
+    for (size_t i = 0; i < count; ++i) {
+        sampled[i] = (skip + i + 1) % sampling == 0;
+        collected += sampled[i];
     }
+    sample->sample_start = collected && collector->overhead_budget > 0 ? get_local_time() : 0;
+    sample->publish_start = 0;
+    return collected;
+}
+
+void
+rcl_collector_on_messages(
+    rcl_collector_t * collector,
+    rcl_collector_sample_t * sample,
+    const size_t * sizes,
+    size_t count)
+{
+    sample->publish_start = collector->clock(collector->clock_state);
+    for (size_t i = 0; i < count; i += collector->staging_capacity) {
+        size_t chunk = count - i < collector->staging_capacity ?
+            count - i : collector->staging_capacity;
+        collector_stage(collector, sample, false, sample->publish_start, sizes + i, 0, chunk, NAN);
+    }
+}
+
+rcl_ret_t
+rcl_collector_on_receive(
+    rcl_collector_t * collector,
+    rcl_collector_sample_t * sample,
+    size_t size,
+    const rmw_message_info_t * message_info)
+{
+    int64_t time = collector->clock(collector->clock_state);
+    // source timestamps are wall clock times, 0 if the middleware does not provide them
+    double latency = NAN;
+    rcutils_time_point_value_t now;
+    if (0 != message_info->source_timestamp && RCUTILS_RET_OK == rcutils_system_time_now(&now))
+        latency = (now - message_info->source_timestamp)*1e-9;
+    collector_stage(collector, sample, false, time, &size, 0, 1, latency);
+    return RCL_RET_OK;
+}
+
+size_t
+rcl_collector_message_size(
+    rcl_collector_t * collector,
+    const void * ros_message)
+{
+    if (collector->size_estimator.estimate)
+        return rcl_estimate_serialized_size(&collector->size_estimator, ros_message);
+    rmw_serialized_message_t * serialized_message = rcl_collector_acquire_serialized_message(collector);
+    if (NULL == serialized_message)
+        return RCL_COLLECTOR_SIZE_UNKNOWN;  // a concurrent take holds the buffer, not worth another
+    size_t size = RCL_COLLECTOR_SIZE_UNKNOWN;
+    if (RMW_RET_OK == rmw_serialize(ros_message, collector->ts, serialized_message))
+        size = serialized_message->buffer_length;
+    else
+        rcutils_reset_error();
+    rcl_collector_release_serialized_message(collector, serialized_message);
+    return size;
+}
 
+size_t
+rcl_collector_taken_message_size(
+    const rcl_collector_t * collector,
+    const void * ros_message)
+{
+    if (collector->size_estimator.estimate)
+        return rcl_estimate_serialized_size(&collector->size_estimator, ros_message);
+    return RCL_COLLECTOR_SIZE_UNKNOWN;
+}
+
+size_t
+rcl_collector_loaned_message_size(
+    rcl_collector_t * collector,
+    const void * ros_message)
+{
+    // fixed size types, the usual loanable ones, cost nothing, others an introspection walk
+    if (collector->size_estimator.estimate)
+        return rcl_estimate_serialized_size(&collector->size_estimator, ros_message);
+    // serializing the loan would cost what the loan saves, it is only timed once a size
+    // model exists, and its size left out of the model
+    if (rcutils_atomic_load_uint64_t(&collector->model_size) > 0)
+        return RCL_COLLECTOR_SIZE_UNKNOWN;
+    // the warmup messages are serialized to learn the sizes the first model starts from
+    return rcl_collector_message_size(collector, ros_message);
+}
+
+rcl_ret_t
+rcl_collector_anomaly_listen(
+    rcl_collector_t * collector,
+    rcl_context_t * context)
+{
+    if (rcutils_atomic_load_bool(&collector->anomaly_listening)) {
+        RCUTILS_SET_ERROR_MSG("publisher already has a traffic anomaly event");
+        return RCL_RET_ERROR;
+    }
+    if (NULL == collector->anomaly_guard_condition) {
+        rcutils_allocator_t allocator = rcutils_get_default_allocator();
+        rcl_guard_condition_t *guard_condition = allocator.allocate(
+            sizeof(rcl_guard_condition_t), allocator.state);
+        if (NULL == guard_condition) {
+            RCUTILS_SET_ERROR_MSG("Failed to allocate the traffic anomaly guard condition");
+            return RCL_RET_BAD_ALLOC;
+        }
+        *guard_condition = rcl_get_zero_initialized_guard_condition();
+        rcl_ret_t ret = rcl_guard_condition_init(
+            guard_condition, context, rcl_guard_condition_get_default_options());
+        if (RCL_RET_OK != ret) {
+            allocator.deallocate(guard_condition, allocator.state);
+            return ret;  // error already set
+        }
+        collector->anomaly_guard_condition = guard_condition;
+    }
+    // an anomaly left over from a previous event is not for this one
+    if (rcl_collector_anomaly_pending(collector))
+        (void)rcl_collector_take_anomaly(collector);
+    rcutils_atomic_store(&collector->anomaly_listening, true);
     return RCL_RET_OK;
 }
 
+void
+rcl_collector_anomaly_unlisten(
+    rcl_collector_t * collector)
+{
+    rcutils_atomic_store(&collector->anomaly_listening, false);
+}
+
+bool
+rcl_collector_anomaly_pending(
+    const rcl_collector_t * collector)
+{
+    return rcutils_atomic_load_uint64_t(
+        (atomic_uint_least64_t *)&collector->anomaly_middle) & ANOMALY_PENDING;
+}
+
+const rcl_traffic_anomaly_status_t *
+rcl_collector_take_anomaly(
+    rcl_collector_t * collector)
+{
+    // anomalies raised since the last take are coalesced, their count is in total_count
+    if (rcl_collector_anomaly_pending(collector))
+        collector->anomaly_front = rcutils_atomic_exchange_uint64_t(
+            &collector->anomaly_middle, collector->anomaly_front) & ~ANOMALY_PENDING;
+    return &collector->anomalies[collector->anomaly_front];
+}
+
+void
+rcl_collector_on_published(
+    rcl_collector_t * collector,
+    const rcl_collector_sample_t * sample)
+{
+    int64_t now = collector->clock(collector->clock_state);
+    collector_stage(
+        collector, sample, true, now, NULL, (uint64_t)(now - sample->publish_start), 1, NAN);
+}
+
+void
+rcl_collector_on_published_batch(
+    rcl_collector_t * collector,
+    const rcl_collector_sample_t * sample,
+    size_t count,
+    size_t collected)
+{
+    int64_t now = collector->clock(collector->clock_state);
+    uint64_t duration = (uint64_t)(now - sample->publish_start) / (count ? count : 1);
+    for (size_t i = 0; i < collected; i += collector->staging_capacity) {
+        size_t chunk = collected - i < collector->staging_capacity ?
+            collected - i : collector->staging_capacity;
+        collector_stage(collector, sample, true, now, NULL, duration, chunk, NAN);
+    }
+}
+
 #ifdef __cplusplus
 }
 #endif
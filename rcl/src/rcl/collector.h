@@ -24,7 +24,30 @@ extern "C"
 #include "rcl/types.h"
 #include "rcl/visibility_control.h"
 #include "rcl/time.h"
+#include "rcl/collector_options.h"
+#include "rcl/event.h"
+#include "rcl/guard_condition.h"
+#include "rcl/node.h"
 #include "rcl/publisher.h"
+#include "rcutils/stdatomic_helper.h"
+#include "rmw/serialized_message.h"
+#include "rmw/types.h"
+#include "rcl_interfaces/msg/traffic_model.h"
+
+#include "./collector_histogram_file.h"
+#include "./collector_policy.h"
+#include "./serialized_size.h"
+
+// most messages per cycle of a composite time model
+#define MAX_PERIOD_COMPONENTS 16
+
+// one message position within the cycle of a composite time model
+typedef struct
+{
+    // phase, time sigma and size model of the messages at this position
+    double b, sigma_t;
+    double s, sigma_s;
+} traffic_component_t;
 
 typedef struct
 {
@@ -34,40 +57,213 @@ typedef struct
     double sigma_s;
     bool initialized;
     double last_update;
+    // composite model of bursty or multi-rate topics, every component repeats each cycle,
+    // components is 0 when a single period describes the topic
+    double cycle;
+    size_t components;
+    traffic_component_t component[MAX_PERIOD_COMPONENTS];
+    // source timestamp to take latency in seconds, receive collectors only, NAN until known
+    double latency, sigma_latency;
 } traffic_model_t;
 
+// running moments of the history window, updated on every push and evict
+typedef struct
+{
+    // samples in the window, indexed 0..n-1 from the oldest
+    size_t n;
+    // mean and sum of squared deviations of the publish times
+    double mean_t, m2_t;
+    // co-moment of sample index and publish time
+    double c_kt;
+    // samples of known size in the window, the mean and sum of squared deviations of their sizes
+    size_t n_s;
+    double mean_s, m2_s;
+    // evictions since the moments were last recomputed from the window
+    size_t evictions;
+} traffic_stats_t;
+
+// running moments of the differences between publish times a given number of messages apart
+typedef struct
+{
+    size_t n;
+    double mean, m2;
+} traffic_lag_stats_t;
+
+// one history entry, half the size of the former pair of doubles
 typedef struct
 {
-    // the name of the topic being collected
-    const char *topic_name;
+    // time since the previous entry, in nanoseconds or coarse microseconds (see collector.c)
+    uint32_t dt;
+    // size in bytes, saturated
+    uint32_t size;
+} traffic_sample_t;
 
-    // associated publisher for reporting the model
-    rcl_publisher_t publisher;
+// most entries concurrent publishers may stage ahead of the thread recording them, a power of 2
+#define COLLECTOR_MAX_STAGING_CAPACITY 256
+
+// a collected message, or the duration of its publish, waiting to be recorded
+typedef struct
+{
+    // the claim position once written, the claim position of the next round once recorded
+    atomic_uint_least64_t sequence;
+    bool duration;
+    // collector clock time of the message, in nanoseconds
+    int64_t time;
+    // size in bytes, or publish duration in nanoseconds
+    uint64_t value;
+    // seconds from the source timestamp to the take, NAN when not known
+    double latency;
+    // monotonic time of staging and nanoseconds spent collecting until then, for the budget
+    int64_t staged_at, cost;
+} traffic_staged_t;
+
+// state of one collected message, held by the thread publishing or taking it
+typedef struct
+{
+    // monotonic time the message was sampled at, for the budget
+    int64_t sample_start;
+    // collector clock time of rcl_collector_on_message, for the publish duration
+    int64_t publish_start;
+} rcl_collector_sample_t;
+
+struct rcl_collector_t;
+
+// time source of a collector, in nanoseconds of a monotonic clock
+typedef int64_t (*rcl_collector_clock_t)(void * state);
+
+// observer of the models a collector fits, given the model as it is handed to the reporter
+typedef void (*rcl_collector_model_callback_t)(
+    const struct rcl_collector_t * collector, const traffic_model_t * model, void * state);
+
+typedef struct rcl_collector_t
+{
+    // the fully qualified name of the topic being collected, owned by the collector
+    char *topic_name;
+    // set for subscription collectors, which model message arrivals instead of publishes
+    bool receive;
+
+    // background reporter of the node's context, publishes the model off the publish path
+    // on the report publisher it shares between all collectors of the context
+    struct rcl_collector_reporter_t * reporter;
+    // triple buffer handing model snapshots to the reporter without locking,
+    // the publish path owns reports[report_back] and the reporter reports[report_front]
+    traffic_model_t reports[3];
+    size_t report_back;
+    size_t report_front;
+    // index of the latest complete snapshot, or'ed with REPORT_PENDING until the reporter takes it
+    atomic_uint_least64_t report_middle;
+    // preallocated report messages, only accessed by the reporter
+    rcl_interfaces__msg__TrafficModel report_msg;
+    rcl_interfaces__msg__TrafficModel component_msg;
 
     // type support corresponding to the message of this publisher
     const rosidl_message_type_support_t * ts;
 
-    // time history
-    double *times;
-    // size history
-    double *sizes;
+    // computes message sizes without serializing, unset if the type has no C introspection
+    rcl_serialized_size_estimator_t size_estimator;
+
+    // persistent serialization buffer reused across publishes, grown to fit the size model
+    rmw_serialized_message_t serialized_message;
+    // set while a publish is using serialized_message
+    atomic_bool serialized_message_in_use;
+    // capacity serialized_message is grown to on its next acquisition, set by the recording
+    // thread with each size model and read by the publishing ones
+    atomic_size_t serialized_message_reserve;
+
+    // settings resolved from the publisher options, the environment and the defaults
+    size_t history_length;
+    size_t warmup;
+    double model_freshness;
+    double predictable_threshold;
+    size_t max_period_components;
+
+    // messages are staged by the threads publishing or taking them, and recorded in claim order
+    // by whichever of them holds ingest_busy, the others return without waiting, so concurrent
+    // publishes never touch the history and model at once
+    // a ring of staging_capacity entries, the power of 2 the history length rounds up to,
+    // at most COLLECTOR_MAX_STAGING_CAPACITY, as staging further ahead would evict the history
+    traffic_staged_t *staged;
+    size_t staging_capacity;
+    // next position to claim, and next to record, the latter owned by the recording thread
+    atomic_uint_least64_t staged_claim;
+    uint64_t staged_next;
+    atomic_bool ingest_busy;
+    // messages not recorded because the recording thread was a full ring behind
+    atomic_uint_least64_t staged_dropped;
+
+    // everything below is owned by the recording thread, unless noted otherwise
+
+    // time and size history, a ring of history_length+1 entries
+    traffic_sample_t *samples;
     size_t head, tail;
+    // time of the entries at head and before tail, in nanoseconds
+    int64_t head_time, tail_time;
     size_t count;  // the total number of samples
 
+    // only every sampling-th message is collected, sampling_base as set by the policy,
+    // sampling as raised from it to keep within overhead_budget
+    size_t sampling, sampling_base;
+    double overhead_budget;
+    // sampling as read by the publishing threads, and the messages they have seen
+    atomic_uint_least64_t sampling_shared;
+    atomic_uint_least64_t sample_skip;
+    // staging time of the previous sampled message, for the budget
+    int64_t sample_end;
+    // exponentially weighted cost of and time between sampled messages, in seconds
+    double sample_cost, sample_interval;
+    size_t budget_count;
+
+    traffic_stats_t stats;
+    // lags[m-1] covers the publish time differences of messages m apart, up to
+    // max_period_components, a cycle of m messages shows as a lag of low spread
+    traffic_lag_stats_t lags[MAX_PERIOD_COMPONENTS];
+    // exponentially weighted mean and variance of the latency, over ~history_length messages
+    double latency_mean, latency_var;
+    size_t latency_count;
     traffic_model_t traffic_model;
+    // the size model as the publishing threads see it, the rounded mean size plus 1,
+    // 0 until the first model, traffic_model itself is only for the recording thread
+    atomic_uint_least64_t model_size;
+
+    // interval, size and publish duration distributions, possibly in shared memory
+    rcl_collector_histogram_slot_t *histograms;
+
+    // time messages are recorded at, the monotonic clock unless replaced for replay
+    rcl_collector_clock_t clock;
+    void *clock_state;
+    // called with every new model, unset unless observed
+    rcl_collector_model_callback_t on_model_update;
+    void *on_model_update_state;
+
+    // anomalies are only detected while a traffic anomaly event listens
+    atomic_bool anomaly_listening;
+    // triple buffer handing the latest anomaly to the event, as reports are handed to the reporter
+    rcl_traffic_anomaly_status_t anomalies[3];
+    size_t anomaly_back;
+    size_t anomaly_front;
+    atomic_uint_least64_t anomaly_middle;
+    int32_t anomaly_count;
+    // wakes waits on the event, created with the first event and kept until fini
+    rcl_guard_condition_t *anomaly_guard_condition;
 } rcl_collector_t;
 
 RCL_LOCAL
 rcl_collector_t
 rcl_get_zero_initialized_collector();
 
+// node may be NULL for a collector detached from any context, e.g. to replay recorded traffic,
+// which reports nothing and keeps its histograms on the heap, type_support may be NULL then,
+// a zero initialized collector that fails to initialize is still finalized
 RCL_LOCAL
 rcl_ret_t
 rcl_collector_init(
     rcl_collector_t * collector,
     const rcl_node_t * node,
     const rosidl_message_type_support_t *ts,
-    const char *topic_name
+    const char *topic_name,
+    const rcl_collector_options_t *options,
+    const rcl_collector_policy_match_t *policy,
+    bool receive
 );
 
 RCL_LOCAL
@@ -77,13 +273,186 @@ rcl_collector_fini(
     rcl_node_t * node
 );
 
+// replace the time messages are recorded at, before the first message is recorded
+RCL_LOCAL
+void
+rcl_collector_set_clock(
+    rcl_collector_t * collector,
+    rcl_collector_clock_t clock,
+    void * state
+);
+
+// observe the models the collector fits, NULL to stop observing
+RCL_LOCAL
+void
+rcl_collector_set_model_callback(
+    rcl_collector_t * collector,
+    rcl_collector_model_callback_t callback,
+    void * state
+);
+
+// capacity of a buffer fitting messages of the size model, 0 before the first model
+RCL_LOCAL
+size_t
+rcl_collector_serialized_message_reserve(
+    rcl_collector_t * collector
+);
+
+RCL_LOCAL
+rmw_serialized_message_t *
+rcl_collector_acquire_serialized_message(
+    rcl_collector_t * collector
+);
+
+RCL_LOCAL
+void
+rcl_collector_release_serialized_message(
+    rcl_collector_t * collector,
+    rmw_serialized_message_t * serialized_message
+);
+
+// publish the latest model posted by rcl_collector_on_message, called by the reporter only,
+// returns whether there was a new model
+RCL_LOCAL
+bool
+rcl_collector_publish_report(
+    rcl_collector_t * collector,
+    const rcl_publisher_t * publisher
+);
+
+// the model last published by rcl_collector_publish_report, called by the reporter only
+RCL_LOCAL
+const traffic_model_t *
+rcl_collector_get_reported_model(
+    const rcl_collector_t * collector
+);
+
+// whether the next message is collected, the caller skips the collector for it otherwise,
+// sample is passed on to the collector calls for the message
+// the collector calls are safe to make from concurrent publishes or takes
+RCL_LOCAL
+bool
+rcl_collector_sample(
+    rcl_collector_t * collector,
+    rcl_collector_sample_t * sample
+);
+
+// size of a message collected for its timing only, its size moments are left as they are
+#define RCL_COLLECTOR_SIZE_UNKNOWN SIZE_MAX
+
 RCL_LOCAL
 rcl_ret_t
 rcl_collector_on_message(
     rcl_collector_t * collector,
+    rcl_collector_sample_t * sample,
     size_t size
 );
 
+// rcl_collector_sample for each of count messages published at once, sampled[i] tells whether
+// message i is collected, returns the number of collected messages
+RCL_LOCAL
+size_t
+rcl_collector_sample_batch(
+    rcl_collector_t * collector,
+    rcl_collector_sample_t * sample,
+    bool * sampled,
+    size_t count
+);
+
+// record the collected messages of a batch at once, with the sizes of each
+RCL_LOCAL
+void
+rcl_collector_on_messages(
+    rcl_collector_t * collector,
+    rcl_collector_sample_t * sample,
+    const size_t * sizes,
+    size_t count
+);
+
+// record a message taken by a subscription, with the timestamps of its message info
+RCL_LOCAL
+rcl_ret_t
+rcl_collector_on_receive(
+    rcl_collector_t * collector,
+    rcl_collector_sample_t * sample,
+    size_t size,
+    const rmw_message_info_t * message_info
+);
+
+// serialized size of a message, from the estimator or by serializing it,
+// RCL_COLLECTOR_SIZE_UNKNOWN if it could not be serialized
+RCL_LOCAL
+size_t
+rcl_collector_message_size(
+    rcl_collector_t * collector,
+    const void * ros_message
+);
+
+// serialized size of a taken message from the estimator, RCL_COLLECTOR_SIZE_UNKNOWN for types
+// without one, a take is not worth serializing the message again
+RCL_LOCAL
+size_t
+rcl_collector_taken_message_size(
+    const rcl_collector_t * collector,
+    const void * ros_message
+);
+
+// serialized size of a loaned message, from the estimator, or RCL_COLLECTOR_SIZE_UNKNOWN for
+// types without one, the loans before the first size model are serialized to bootstrap it
+RCL_LOCAL
+size_t
+rcl_collector_loaned_message_size(
+    rcl_collector_t * collector,
+    const void * ros_message
+);
+
+// start handing anomalies to a traffic anomaly event, RCL_RET_ERROR if one already listens
+RCL_LOCAL
+rcl_ret_t
+rcl_collector_anomaly_listen(
+    rcl_collector_t * collector,
+    rcl_context_t * context
+);
+
+RCL_LOCAL
+void
+rcl_collector_anomaly_unlisten(
+    rcl_collector_t * collector
+);
+
+// whether an anomaly was detected since the last rcl_collector_take_anomaly
+RCL_LOCAL
+bool
+rcl_collector_anomaly_pending(
+    const rcl_collector_t * collector
+);
+
+// latest anomaly detected, the last one taken if none is pending
+RCL_LOCAL
+const rcl_traffic_anomaly_status_t *
+rcl_collector_take_anomaly(
+    rcl_collector_t * collector
+);
+
+// record the duration of the publish started by rcl_collector_on_message
+RCL_LOCAL
+void
+rcl_collector_on_published(
+    rcl_collector_t * collector,
+    const rcl_collector_sample_t * sample
+);
+
+// record the publish duration of a batch of count messages started by rcl_collector_on_messages,
+// shared evenly between its messages, once for each of the collected ones
+RCL_LOCAL
+void
+rcl_collector_on_published_batch(
+    rcl_collector_t * collector,
+    const rcl_collector_sample_t * sample,
+    size_t count,
+    size_t collected
+);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,213 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "rcl/collector_histogram.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include "rcutils/logging_macros.h"
+
+#include "./collector_histogram_file.h"
+
+#define SUB_BUCKET_BITS RCL_COLLECTOR_HISTOGRAM_SUB_BUCKET_BITS
+#define SUB_BUCKET_HALF ((size_t)1 << (SUB_BUCKET_BITS - 1))
+#define VALUE_MAX ((UINT64_C(1) << RCL_COLLECTOR_HISTOGRAM_VALUE_BITS) - 1)
+
+// the file layout is read by other processes, changing it needs a new version
+static_assert(
+  RCL_COLLECTOR_HISTOGRAM_VERSION != 2u ||
+  (sizeof(rcl_collector_histogram_file_header_t) == 32u &&
+  RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT == 592u &&
+  sizeof(rcl_collector_histogram_slot_t) == 264u + 3u * 8u * (1u + 592u)),
+  "the histogram file layout changed, bump RCL_COLLECTOR_HISTOGRAM_VERSION");
+
+// Index of the most significant bit set, value must not be 0.
+static unsigned int
+_msb(uint64_t value)
+{
+  unsigned int msb = 0;
+  for (unsigned int shift = 32; shift > 0; shift >>= 1) {
+    if (value >> shift) {
+      value >>= shift;
+      msb += shift;
+    }
+  }
+  return msb;
+}
+
+size_t
+rcl_collector_histogram_index(uint64_t value)
+{
+  if (value > VALUE_MAX) {
+    value = VALUE_MAX;
+  }
+  if (value < ((uint64_t)1 << SUB_BUCKET_BITS)) {
+    return (size_t)value;
+  }
+  // keep the SUB_BUCKET_BITS most significant bits, the top one selects the upper half
+  unsigned int shift = _msb(value) - SUB_BUCKET_BITS + 1;
+  return shift * SUB_BUCKET_HALF + (size_t)(value >> shift);
+}
+
+uint64_t
+rcl_collector_histogram_lowest(size_t index)
+{
+  if (index < 2 * SUB_BUCKET_HALF) {
+    return index;
+  }
+  size_t shift = index / SUB_BUCKET_HALF - 1;
+  return (uint64_t)(index - shift * SUB_BUCKET_HALF) << shift;
+}
+
+void
+rcl_collector_histogram_record(rcl_collector_histogram_t * histogram, uint64_t value)
+{
+  ++histogram->counts[rcl_collector_histogram_index(value)];
+  ++histogram->total;
+}
+
+uint64_t
+rcl_collector_histogram_percentile(const rcl_collector_histogram_t * histogram, double percentile)
+{
+  if (0u == histogram->total) {
+    return 0u;
+  }
+  double rank = percentile / 100.0 * (double)histogram->total;
+  uint64_t seen = 0u;
+  for (size_t i = 0; i < RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT; ++i) {
+    seen += histogram->counts[i];
+    if (seen > 0u && (double)seen >= rank) {
+      return rcl_collector_histogram_lowest(i);
+    }
+  }
+  return rcl_collector_histogram_lowest(RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT - 1);
+}
+
+static bool
+_file_map(rcl_collector_histogram_file_t * file, uint64_t instance_id)
+{
+#ifdef _WIN32
+  (void)file;
+  (void)instance_id;
+  return false;
+#else
+  snprintf(
+    file->name, sizeof(file->name), "/rcl_traffic_histograms_%lld_%llu",
+    (long long)getpid(), (unsigned long long)instance_id);  // NOLINT(runtime/int)
+  size_t size = sizeof(rcl_collector_histogram_file_header_t) +
+    RCL_COLLECTOR_HISTOGRAM_SLOT_COUNT * sizeof(rcl_collector_histogram_slot_t);
+  int fd = shm_open(file->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  void * mapping = MAP_FAILED;
+  if (0 == ftruncate(fd, (off_t)size)) {
+    mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (MAP_FAILED == mapping) {
+    shm_unlink(file->name);
+    return false;
+  }
+  // the file starts zeroed, which marks every slot free
+  file->header = (rcl_collector_histogram_file_header_t *)mapping;
+  file->slots = (rcl_collector_histogram_slot_t *)(file->header + 1);
+  file->size = size;
+  file->header->version = RCL_COLLECTOR_HISTOGRAM_VERSION;
+  file->header->slot_count = RCL_COLLECTOR_HISTOGRAM_SLOT_COUNT;
+  file->header->bucket_count = RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT;
+  file->header->sub_bucket_bits = RCL_COLLECTOR_HISTOGRAM_SUB_BUCKET_BITS;
+  file->header->pid = (uint64_t)getpid();
+  // written last, readers ignore files without the magic
+  memcpy(file->header->magic, RCL_COLLECTOR_HISTOGRAM_MAGIC, sizeof(file->header->magic));
+  return true;
+#endif
+}
+
+rcl_collector_histogram_slot_t *
+rcl_collector_histogram_slot_acquire(
+  rcl_collector_histogram_file_t * file,
+  uint64_t instance_id,
+  const char * topic_name,
+  rcl_allocator_t allocator)
+{
+  rcl_collector_histogram_slot_t * slot = NULL;
+  if (NULL == file->header && !file->unavailable && !_file_map(file, instance_id)) {
+    RCUTILS_LOG_DEBUG_NAMED(
+      ROS_PACKAGE_NAME "_collector", "Traffic histograms are not shared, no shared memory file");
+    file->unavailable = true;
+  }
+  if (NULL != file->header) {
+    for (size_t i = 0; i < RCL_COLLECTOR_HISTOGRAM_SLOT_COUNT && NULL == slot; ++i) {
+      if (!file->slots[i].in_use) {
+        slot = &file->slots[i];
+      }
+    }
+  }
+  if (NULL == slot) {
+    slot = allocator.allocate(sizeof(rcl_collector_histogram_slot_t), allocator.state);
+    if (NULL == slot) {
+      return NULL;
+    }
+  }
+  memset(slot, 0, sizeof(*slot));
+  strncpy(slot->topic_name, topic_name, sizeof(slot->topic_name) - 1);
+  slot->in_use = 1u;
+  return slot;
+}
+
+void
+rcl_collector_histogram_slot_release(
+  rcl_collector_histogram_file_t * file,
+  rcl_collector_histogram_slot_t * slot,
+  rcl_allocator_t allocator)
+{
+  if (NULL != file->header && slot >= file->slots &&
+    slot < file->slots + RCL_COLLECTOR_HISTOGRAM_SLOT_COUNT)
+  {
+    slot->in_use = 0u;
+    return;
+  }
+  allocator.deallocate(slot, allocator.state);
+}
+
+void
+rcl_collector_histogram_file_fini(rcl_collector_histogram_file_t * file)
+{
+#ifndef _WIN32
+  if (NULL != file->header) {
+    munmap(file->header, file->size);
+    shm_unlink(file->name);
+  }
+#endif
+  memset(file, 0, sizeof(*file));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,80 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__COLLECTOR_HISTOGRAM_FILE_H_
+#define RCL__COLLECTOR_HISTOGRAM_FILE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcl/allocator.h"
+#include "rcl/collector_histogram.h"
+#include "rcl/macros.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+
+/// Shared memory file of a context, mapped on first use, see rcl_collector_histogram_file_header_t.
+typedef struct rcl_collector_histogram_file_t
+{
+  rcl_collector_histogram_file_header_t * header;
+  rcl_collector_histogram_slot_t * slots;
+  size_t size;
+  /// Set once mapping was attempted and failed, slots then come from the heap.
+  bool unavailable;
+  char name[64];
+} rcl_collector_histogram_file_t;
+
+/// Count `value`, only one thread may record into a histogram at a time.
+RCL_LOCAL
+void
+rcl_collector_histogram_record(rcl_collector_histogram_t * histogram, uint64_t value);
+
+/// Claim a zeroed slot for `topic_name`, from the file if possible, else from the heap.
+/**
+ * Not thread-safe, callers serialize access to `file`.
+ *
+ * \return the slot, or `NULL` if allocating memory failed.
+ */
+RCL_LOCAL
+rcl_collector_histogram_slot_t *
+rcl_collector_histogram_slot_acquire(
+  rcl_collector_histogram_file_t * file,
+  uint64_t instance_id,
+  const char * topic_name,
+  rcl_allocator_t allocator);
+
+/// Return a slot obtained from rcl_collector_histogram_slot_acquire().
+RCL_LOCAL
+void
+rcl_collector_histogram_slot_release(
+  rcl_collector_histogram_file_t * file,
+  rcl_collector_histogram_slot_t * slot,
+  rcl_allocator_t allocator);
+
+/// Unmap and remove the file, if it was created.
+RCL_LOCAL
+void
+rcl_collector_histogram_file_fini(rcl_collector_histogram_file_t * file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__COLLECTOR_HISTOGRAM_FILE_H_
@@ -0,0 +1,308 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "./collector_policy.h"
+
+#include <string.h>
+
+#ifndef _WIN32
+# include <regex.h>
+#endif
+
+#include "rcl/error_handling.h"
+#include "rcutils/get_env.h"
+#include "rcutils/logging_macros.h"
+
+#include "./arguments_impl.h"
+
+#define RCL_COLLECTOR_POLICY_PREFIX "traffic_collector."
+#define RCL_COLLECTOR_POLICY_RULES_PREFIX "rules."
+#define RCL_COLLECTOR_POLICY_DEFAULT_RULE "urgent"
+#define RCL_COLLECTOR_POLICY_DEFAULT_TOPIC "**/urg_*"
+
+/// One rule of the policy, its strings are borrowed from the parameter overrides.
+typedef struct rcl_collector_policy_rule_t
+{
+  const char * name;
+  size_t name_length;
+  const char * topic;
+  const char * regex;
+  bool enabled;
+  int64_t sampling;
+  /// Negative until set, the policy-wide budget applies then.
+  double overhead_budget;
+} rcl_collector_policy_rule_t;
+
+typedef struct rcl_collector_policy_t
+{
+  rcl_collector_policy_rule_t * rules;
+  size_t rule_count;
+  size_t rule_capacity;
+  double overhead_budget;
+  rcl_allocator_t allocator;
+} rcl_collector_policy_t;
+
+static bool
+_glob_match(const char * pattern, const char * name)
+{
+  while ('\0' != *pattern) {
+    if ('*' == pattern[0]) {
+      // "**" may cross token separators, "*" may not
+      bool deep = '*' == pattern[1];
+      pattern += deep ? 2 : 1;
+      for (;; ++name) {
+        if (_glob_match(pattern, name)) {
+          return true;
+        }
+        if ('\0' == *name || (!deep && '/' == *name)) {
+          return false;
+        }
+      }
+    }
+    if ('\0' == *name || ('?' == *pattern ? '/' == *name : *pattern != *name)) {
+      return false;
+    }
+    ++pattern;
+    ++name;
+  }
+  return '\0' == *name;
+}
+
+static bool
+_regex_match(const char * pattern, const char * name)
+{
+#ifdef _WIN32
+  (void)name;
+  RCUTILS_LOG_WARN_NAMED(
+    ROS_PACKAGE_NAME "_collector", "Ignoring collector rule regex '%s', unsupported", pattern);
+  return false;
+#else
+  regex_t regex;
+  if (0 != regcomp(&regex, pattern, REG_EXTENDED | REG_NOSUB)) {
+    RCUTILS_LOG_WARN_NAMED(
+      ROS_PACKAGE_NAME "_collector", "Ignoring invalid collector rule regex '%s'", pattern);
+    return false;
+  }
+  bool matched = 0 == regexec(&regex, name, 0, NULL, 0);
+  regfree(&regex);
+  return matched;
+#endif
+}
+
+/// Whether parameter overrides given for `params_node_name` apply to the node.
+static bool
+_node_matches(const char * params_node_name, const char * fully_qualified_name)
+{
+  if (0 == strcmp(params_node_name, "/**") || 0 == strcmp(params_node_name, "**")) {
+    return true;
+  }
+  // names in parameter files may leave out the leading slash
+  if ('/' == params_node_name[0]) {
+    ++params_node_name;
+  }
+  return 0 == strcmp(params_node_name, fully_qualified_name + 1);
+}
+
+static rcl_collector_policy_rule_t *
+_rule_get(rcl_collector_policy_t * policy, const char * name, size_t name_length)
+{
+  for (size_t i = 0; i < policy->rule_count; ++i) {
+    rcl_collector_policy_rule_t * rule = &policy->rules[i];
+    if (rule->name_length == name_length && 0 == strncmp(rule->name, name, name_length)) {
+      return rule;
+    }
+  }
+  if (policy->rule_count == policy->rule_capacity) {
+    size_t capacity = policy->rule_capacity ? 2 * policy->rule_capacity : 4;
+    rcl_collector_policy_rule_t * rules = policy->allocator.reallocate(
+      policy->rules, capacity * sizeof(rcl_collector_policy_rule_t), policy->allocator.state);
+    if (NULL == rules) {
+      return NULL;
+    }
+    policy->rules = rules;
+    policy->rule_capacity = capacity;
+  }
+  rcl_collector_policy_rule_t * rule = &policy->rules[policy->rule_count++];
+  rule->name = name;
+  rule->name_length = name_length;
+  rule->topic = NULL;
+  rule->regex = NULL;
+  rule->enabled = true;
+  rule->sampling = 1;
+  rule->overhead_budget = -1.0;
+  return rule;
+}
+
+static bool
+_variant_get_double(const rcl_variant_t * value, double * number)
+{
+  if (NULL != value->double_value) {
+    *number = *value->double_value;
+    return true;
+  }
+  if (NULL != value->integer_value) {
+    *number = (double)*value->integer_value;
+    return true;
+  }
+  return false;
+}
+
+/// Apply one `traffic_collector.` parameter, `key` is its name past that prefix.
+static rcl_ret_t
+_policy_set(rcl_collector_policy_t * policy, const char * key, const rcl_variant_t * value)
+{
+  bool valid = false;
+  if (0 == strcmp(key, "overhead_budget")) {
+    valid = _variant_get_double(value, &policy->overhead_budget);
+  } else if (0 == strncmp(
+      key, RCL_COLLECTOR_POLICY_RULES_PREFIX, strlen(RCL_COLLECTOR_POLICY_RULES_PREFIX)))
+  {
+    const char * name = key + strlen(RCL_COLLECTOR_POLICY_RULES_PREFIX);
+    const char * field = strrchr(name, '.');
+    if (NULL != field && field != name) {
+      rcl_collector_policy_rule_t * rule = _rule_get(policy, name, (size_t)(field - name));
+      if (NULL == rule) {
+        RCL_SET_ERROR_MSG("allocating memory failed");
+        return RCL_RET_BAD_ALLOC;
+      }
+      ++field;
+      if (0 == strcmp(field, "topic")) {
+        valid = NULL != (rule->topic = value->string_value);
+      } else if (0 == strcmp(field, "regex")) {
+        valid = NULL != (rule->regex = value->string_value);
+      } else if (0 == strcmp(field, "enabled")) {
+        valid = NULL != value->bool_value;
+        rule->enabled = valid ? *value->bool_value : rule->enabled;
+      } else if (0 == strcmp(field, "sampling")) {
+        valid = NULL != value->integer_value && *value->integer_value > 0;
+        rule->sampling = valid ? *value->integer_value : rule->sampling;
+      } else if (0 == strcmp(field, "overhead_budget")) {
+        valid = _variant_get_double(value, &rule->overhead_budget);
+      }
+    }
+  }
+  if (!valid) {
+    RCUTILS_LOG_WARN_NAMED(
+      ROS_PACKAGE_NAME "_collector", "Ignoring invalid collector policy parameter '%s%s'",
+      RCL_COLLECTOR_POLICY_PREFIX, key);
+  }
+  return RCL_RET_OK;
+}
+
+static rcl_ret_t
+_policy_load(
+  rcl_collector_policy_t * policy,
+  const rcl_arguments_t * arguments,
+  const char * fully_qualified_name)
+{
+  if (NULL == arguments || NULL == arguments->impl ||
+    NULL == arguments->impl->parameter_overrides)
+  {
+    return RCL_RET_OK;
+  }
+  const rcl_params_t * params = arguments->impl->parameter_overrides;
+  const size_t prefix_length = strlen(RCL_COLLECTOR_POLICY_PREFIX);
+  for (size_t i = 0; i < params->num_nodes; ++i) {
+    if (!_node_matches(params->node_names[i], fully_qualified_name)) {
+      continue;
+    }
+    const rcl_node_params_t * node_params = &params->params[i];
+    for (size_t j = 0; j < node_params->num_params; ++j) {
+      const char * name = node_params->parameter_names[j];
+      if (0 != strncmp(name, RCL_COLLECTOR_POLICY_PREFIX, prefix_length)) {
+        continue;
+      }
+      rcl_ret_t ret = _policy_set(policy, name + prefix_length, &node_params->parameter_values[j]);
+      if (RCL_RET_OK != ret) {
+        return ret;
+      }
+    }
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_collector_policy_match(
+  const rcl_node_t * node,
+  const char * topic_name,
+  rcl_allocator_t allocator,
+  rcl_collector_policy_match_t * match)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(topic_name, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(match, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ALLOCATOR_WITH_MSG(&allocator, "invalid allocator", return RCL_RET_INVALID_ARGUMENT);
+  match->enabled = false;
+  match->sampling = 1u;
+  match->overhead_budget = 0.0;
+
+  const char * machine_id = NULL;
+  if (NULL != rcutils_get_env("ROS_MACHINE_ID", &machine_id) || NULL == machine_id ||
+    0 == strcmp(machine_id, ""))
+  {
+    return RCL_RET_OK;
+  }
+  const rcl_node_options_t * node_options = rcl_node_get_options(node);
+  const char * fully_qualified_name = rcl_node_get_fully_qualified_name(node);
+  if (NULL == node_options || NULL == fully_qualified_name) {
+    return RCL_RET_NODE_INVALID;  // error already set
+  }
+
+  rcl_collector_policy_t policy = {NULL, 0u, 0u, 0.0, allocator};
+  // node arguments come last so that their rule fields win over the global ones
+  rcl_ret_t ret = RCL_RET_OK;
+  if (node_options->use_global_arguments) {
+    ret = _policy_load(&policy, &node->context->global_arguments, fully_qualified_name);
+  }
+  if (RCL_RET_OK == ret) {
+    ret = _policy_load(&policy, &node_options->arguments, fully_qualified_name);
+  }
+  const char * default_rule = RCL_COLLECTOR_POLICY_DEFAULT_RULE;
+  rcl_collector_policy_rule_t * rule = NULL;
+  if (RCL_RET_OK == ret) {
+    rule = _rule_get(&policy, default_rule, strlen(default_rule));
+    if (NULL == rule) {
+      RCL_SET_ERROR_MSG("allocating memory failed");
+      ret = RCL_RET_BAD_ALLOC;
+    } else if (NULL == rule->topic && NULL == rule->regex) {
+      rule->topic = RCL_COLLECTOR_POLICY_DEFAULT_TOPIC;
+    }
+  }
+
+  for (size_t i = 0; RCL_RET_OK == ret && i < policy.rule_count; ++i) {
+    rule = &policy.rules[i];
+    if ((NULL != rule->topic && _glob_match(rule->topic, topic_name)) ||
+      (NULL != rule->regex && _regex_match(rule->regex, topic_name)))
+    {
+      match->enabled = rule->enabled;
+      match->sampling = (size_t)rule->sampling;
+      match->overhead_budget =
+        rule->overhead_budget >= 0.0 ? rule->overhead_budget : policy.overhead_budget;
+      RCUTILS_LOG_DEBUG_NAMED(
+        ROS_PACKAGE_NAME "_collector", "Collector rule '%.*s' matches topic '%s'",
+        (int)rule->name_length, rule->name, topic_name);
+      break;
+    }
+  }
+  allocator.deallocate(policy.rules, allocator.state);
+  return ret;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,95 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__COLLECTOR_POLICY_H_
+#define RCL__COLLECTOR_POLICY_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "rcl/allocator.h"
+#include "rcl/macros.h"
+#include "rcl/node.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+
+/// Outcome of the collector policy for one topic.
+typedef struct rcl_collector_policy_match_t
+{
+  /// Whether the topic gets a traffic model collector.
+  bool enabled;
+  /// Only every sampling-th message is collected, at least 1.
+  size_t sampling;
+  /// Largest fraction of wall time collecting may take on the topic, `0` for no limit.
+  double overhead_budget;
+} rcl_collector_policy_match_t;
+
+/// Decide whether and how a topic is collected, from the collector policy of a node.
+/**
+ * Collectors are only enabled if `ROS_MACHINE_ID` is set, as it names the
+ * topic models are reported on.
+ *
+ * The policy is read from the parameter overrides, i.e. `--params-file` and
+ * `-p` ROS arguments, of the node and, if the node uses them, of the context,
+ * for the node's name, fully qualified or not, or the wildcard matching every node:
+ *
+ * ```yaml
+ * my_node:
+ *   ros__parameters:
+ *     traffic_collector:
+ *       overhead_budget: 0.01
+ *       rules:
+ *         camera: {topic: "/camera/image_*", sampling: 10}
+ *         fast: {regex: "^/fast_[0-9]+$", sampling: 100, overhead_budget: 0.001}
+ *         urgent: {enabled: false}
+ * ```
+ *
+ * Rules are tried in the order they first appear and the first rule whose
+ * `topic` glob or `regex` (POSIX extended, unsupported on Windows) matches
+ * the fully expanded and remapped topic name applies.
+ * In globs, `*` matches within a name token, `**` across tokens and `?` any
+ * single character but `/`; patterns starting with `*` must be quoted in YAML.
+ * A rule's `enabled` defaults to `true`, its `sampling` to `1` and its
+ * `overhead_budget` to the policy-wide one.
+ * A built-in `urgent` rule, matching every topic whose last token starts with
+ * `urg_`, comes last unless a rule of that name is given.
+ *
+ * \param[in] node node the publisher or subscription is created for
+ * \param[in] topic_name fully expanded and remapped topic name
+ * \param[in] allocator allocator used while reading the parameter overrides
+ * \param[out] match policy outcome for the topic
+ * \return `RCL_RET_OK` if the policy was evaluated, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_collector_policy_match(
+  const rcl_node_t * node,
+  const char * topic_name,
+  rcl_allocator_t allocator,
+  rcl_collector_policy_match_t * match);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__COLLECTOR_POLICY_H_
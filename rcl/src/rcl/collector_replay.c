@@ -0,0 +1,156 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "rcl/collector_replay.h"
+
+#include "rcl/error_handling.h"
+
+#include "./collector.h"
+
+#define RCL_COLLECTOR_REPLAY_TOPIC_NAME "/replay"
+
+typedef struct rcl_collector_replay_impl_t
+{
+  rcl_allocator_t allocator;
+  /// A collector detached from any context, whose clock reads the replayed time.
+  rcl_collector_t collector;
+  int64_t time;
+  size_t sample;
+  rcl_collector_replay_callback_t callback;
+  void * callback_state;
+  rcl_collector_replay_component_t components[MAX_PERIOD_COMPONENTS];
+} rcl_collector_replay_impl_t;
+
+static int64_t
+_replay_clock(void * state)
+{
+  return ((const rcl_collector_replay_impl_t *)state)->time;
+}
+
+static void
+_on_model_update(
+  const rcl_collector_t * collector, const traffic_model_t * model, void * state)
+{
+  (void)collector;
+  rcl_collector_replay_impl_t * impl = (rcl_collector_replay_impl_t *)state;
+  for (size_t r = 0; r < model->components; ++r) {
+    impl->components[r].b = model->component[r].b;
+    impl->components[r].sigma_t = model->component[r].sigma_t;
+    impl->components[r].s = model->component[r].s;
+    impl->components[r].sigma_s = model->component[r].sigma_s;
+  }
+  rcl_collector_replay_update_t update = {
+    impl->sample, (double)impl->time * 1e-9, model->a, model->b, model->sigma_t, model->s,
+    model->sigma_s, model->components ? model->cycle : 0.0, model->components, impl->components
+  };
+  impl->callback(&update, impl->callback_state);
+}
+
+rcl_collector_replay_t
+rcl_get_zero_initialized_collector_replay(void)
+{
+  static rcl_collector_replay_t null_replay = {0};
+  return null_replay;
+}
+
+rcl_ret_t
+rcl_collector_replay_init(
+  rcl_collector_replay_t * replay,
+  const rcl_collector_options_t * options,
+  size_t sampling,
+  rcl_collector_replay_callback_t callback,
+  void * callback_state,
+  rcl_allocator_t allocator)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(replay, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(options, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ALLOCATOR_WITH_MSG(&allocator, "invalid allocator", return RCL_RET_INVALID_ARGUMENT);
+  if (NULL != replay->impl) {
+    RCL_SET_ERROR_MSG("replay already initialized, or memory was uninitialized");
+    return RCL_RET_ALREADY_INIT;
+  }
+  rcl_collector_replay_impl_t * impl = (rcl_collector_replay_impl_t *)allocator.zero_allocate(
+    1, sizeof(rcl_collector_replay_impl_t), allocator.state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(impl, "allocating memory failed", return RCL_RET_BAD_ALLOC);
+  impl->allocator = allocator;
+  impl->callback = callback;
+  impl->callback_state = callback_state;
+
+  rcl_collector_policy_match_t policy = {true, sampling ? sampling : 1u, 0.0};
+  impl->collector = rcl_get_zero_initialized_collector();
+  rcl_ret_t ret = rcl_collector_init(
+    &impl->collector, NULL, NULL, RCL_COLLECTOR_REPLAY_TOPIC_NAME, options, &policy, false);
+  if (RCL_RET_OK != ret) {
+    // the collector cleans up after itself on fini only
+    (void)rcl_collector_fini(&impl->collector, NULL);
+    allocator.deallocate(impl, allocator.state);
+    return ret;  // error already set
+  }
+  rcl_collector_set_clock(&impl->collector, _replay_clock, impl);
+  if (NULL != callback) {
+    rcl_collector_set_model_callback(&impl->collector, _on_model_update, impl);
+  }
+  replay->impl = impl;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_collector_replay_feed(
+  rcl_collector_replay_t * replay,
+  const int64_t * times,
+  const size_t * sizes,
+  size_t count)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(replay, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    replay->impl, "replay not initialized", return RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(times, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(sizes, RCL_RET_INVALID_ARGUMENT);
+  rcl_collector_replay_impl_t * impl = replay->impl;
+  rcl_collector_sample_t sample;
+  for (size_t i = 0; i < count; ++i) {
+    impl->time = times[i];
+    ++impl->sample;
+    if (rcl_collector_sample(&impl->collector, &sample)) {
+      rcl_ret_t ret = rcl_collector_on_message(&impl->collector, &sample, sizes[i]);
+      if (RCL_RET_OK != ret) {
+        return ret;
+      }
+    }
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_collector_replay_fini(rcl_collector_replay_t * replay)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(replay, RCL_RET_INVALID_ARGUMENT);
+  if (NULL == replay->impl) {
+    return RCL_RET_OK;
+  }
+  rcl_allocator_t allocator = replay->impl->allocator;
+  rcl_ret_t ret = rcl_collector_fini(&replay->impl->collector, NULL);
+  allocator.deallocate(replay->impl, allocator.state);
+  replay->impl = NULL;
+  return ret;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,472 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "./collector_reporter.h"
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <pthread.h>
+# include <time.h>
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "rcl/error_handling.h"
+#include "rcl/node.h"
+#include "rcl/publisher.h"
+#include "rcl_interfaces/msg/traffic_model.h"
+#include "rcutils/format_string.h"
+#include "rcutils/get_env.h"
+#include "rcutils/logging_macros.h"
+#include "rcutils/stdatomic_helper.h"
+
+#include "./collector.h"
+#include "./collector_histogram_file.h"
+
+// Interval between two drains of the collectors' mailboxes, bounding the report rate.
+#define RCL_COLLECTOR_REPORT_PERIOD_MS 10
+// Hidden node owning the report publisher.
+#define RCL_COLLECTOR_REPORTER_NODE_NAME "_traffic_model_reporter"
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION rcl_reporter_mutex_t;
+typedef HANDLE rcl_reporter_thread_t;
+#else
+typedef pthread_mutex_t rcl_reporter_mutex_t;
+typedef pthread_t rcl_reporter_thread_t;
+#endif
+
+/// Messages of an urgent topic, predicted at phase + k * period for every integer k.
+typedef struct rcl_collector_reporter_window_t
+{
+  double period;
+  double phase;
+  /// Time sigma of the predictions.
+  double sigma;
+  /// Time after which the model is considered stale, if its topic was not refitted since.
+  double expiry;
+} rcl_collector_reporter_window_t;
+
+struct rcl_collector_reporter_t
+{
+  rcl_allocator_t allocator;
+  rcl_context_t * context;
+  /// Node and publisher shared by all collectors of the context, created with the thread.
+  rcl_node_t node;
+  rcl_publisher_t publisher;
+  /// Guards the registry, held by the reporter thread while draining.
+  rcl_reporter_mutex_t mutex;
+  struct rcl_collector_t ** collectors;
+  size_t collector_count;
+  size_t collector_capacity;
+  /// Shared memory the collectors' histograms live in, guarded by the mutex.
+  rcl_collector_histogram_file_t histogram_file;
+  /// Predicted urgent messages of the latest reported models, for traffic shaping.
+  /// Guarded by a mutex of its own, shaped publishers must not wait for a drain.
+  rcl_reporter_mutex_t schedule_mutex;
+  rcl_collector_reporter_window_t * windows;
+  size_t window_count;
+  size_t window_capacity;
+  rcl_reporter_thread_t thread;
+  bool thread_started;
+  bool stopped;
+  atomic_bool running;
+};
+
+static void
+_mutex_init(rcl_reporter_mutex_t * mutex)
+{
+#ifdef _WIN32
+  InitializeCriticalSection(mutex);
+#else
+  pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+static void
+_mutex_lock(rcl_reporter_mutex_t * mutex)
+{
+#ifdef _WIN32
+  EnterCriticalSection(mutex);
+#else
+  pthread_mutex_lock(mutex);
+#endif
+}
+
+static void
+_mutex_unlock(rcl_reporter_mutex_t * mutex)
+{
+#ifdef _WIN32
+  LeaveCriticalSection(mutex);
+#else
+  pthread_mutex_unlock(mutex);
+#endif
+}
+
+static void
+_mutex_destroy(rcl_reporter_mutex_t * mutex)
+{
+#ifdef _WIN32
+  DeleteCriticalSection(mutex);
+#else
+  pthread_mutex_destroy(mutex);
+#endif
+}
+
+static void
+_sleep_period(void)
+{
+#ifdef _WIN32
+  Sleep(RCL_COLLECTOR_REPORT_PERIOD_MS);
+#else
+  struct timespec period = {0, RCL_COLLECTOR_REPORT_PERIOD_MS * 1000000L};
+  nanosleep(&period, NULL);
+#endif
+}
+
+/// Rebuild the schedule from the collectors' reported models, the mutex must be held.
+static void
+_schedule_update(rcl_collector_reporter_t * reporter)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < reporter->collector_count; ++i) {
+    const traffic_model_t * model = rcl_collector_get_reported_model(reporter->collectors[i]);
+    count += model->initialized ? (model->components ? model->components : 1) : 0;
+  }
+  _mutex_lock(&reporter->schedule_mutex);
+  if (count > reporter->window_capacity) {
+    rcl_collector_reporter_window_t * windows = reporter->allocator.reallocate(
+      reporter->windows, count * sizeof(rcl_collector_reporter_window_t),
+      reporter->allocator.state);
+    if (NULL != windows) {
+      reporter->windows = windows;
+      reporter->window_capacity = count;
+    } else {
+      RCUTILS_LOG_WARN_NAMED(
+        ROS_PACKAGE_NAME "_collector", "Failed to allocate the urgent traffic schedule");
+    }
+  }
+  reporter->window_count = 0;
+  for (size_t i = 0; i < reporter->collector_count; ++i) {
+    const struct rcl_collector_t * collector = reporter->collectors[i];
+    const traffic_model_t * model = rcl_collector_get_reported_model(collector);
+    if (!model->initialized) {
+      continue;
+    }
+    // a model that predicts well is refitted at least every model_freshness while messages flow
+    double expiry = model->last_update + 2 * collector->model_freshness;
+    for (size_t r = 0; r < (model->components ? model->components : 1); ++r) {
+      if (reporter->window_count == reporter->window_capacity) {
+        break;
+      }
+      rcl_collector_reporter_window_t * window = &reporter->windows[reporter->window_count++];
+      window->period = model->components ? model->cycle : model->a;
+      window->phase = model->components ? model->component[r].b : model->b;
+      window->sigma = model->components ? model->component[r].sigma_t : model->sigma_t;
+      window->expiry = expiry;
+    }
+  }
+  _mutex_unlock(&reporter->schedule_mutex);
+}
+
+static void
+_drain(rcl_collector_reporter_t * reporter)
+{
+  _mutex_lock(&reporter->mutex);
+  // one batch per period: every topic whose model changed since the last drain, back to back
+  bool updated = false;
+  for (size_t i = 0; i < reporter->collector_count; ++i) {
+    updated |= rcl_collector_publish_report(reporter->collectors[i], &reporter->publisher);
+  }
+  if (updated) {
+    _schedule_update(reporter);
+  }
+  _mutex_unlock(&reporter->mutex);
+}
+
+static rcl_ret_t
+_publisher_init(rcl_collector_reporter_t * reporter)
+{
+  const char * machine_id = NULL;
+  if (NULL != rcutils_get_env("ROS_MACHINE_ID", &machine_id) || NULL == machine_id ||
+    0 == strcmp(machine_id, ""))
+  {
+    RCL_SET_ERROR_MSG("ROS_MACHINE_ID is not set");
+    return RCL_RET_ERROR;
+  }
+  char * report_topic = rcutils_format_string(
+    reporter->allocator, "ros_traffic_model_%s", machine_id);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    report_topic, "allocating memory failed", return RCL_RET_BAD_ALLOC);
+
+  rcl_node_options_t node_options = rcl_node_get_default_options();
+  node_options.allocator = reporter->allocator;
+  node_options.use_global_arguments = false;
+  node_options.enable_rosout = false;
+  reporter->node = rcl_get_zero_initialized_node();
+  rcl_ret_t ret = rcl_node_init(
+    &reporter->node, RCL_COLLECTOR_REPORTER_NODE_NAME, "", reporter->context, &node_options);
+  if (RCL_RET_OK == ret) {
+    rcl_publisher_options_t options = rcl_publisher_get_default_options();
+    options.allocator = reporter->allocator;
+    reporter->publisher = rcl_get_zero_initialized_publisher();
+    ret = rcl_publisher_init_internal(
+      &reporter->publisher, &reporter->node,
+      ROSIDL_GET_MSG_TYPE_SUPPORT(rcl_interfaces, msg, TrafficModel),
+      report_topic, &options, false);
+    if (RCL_RET_OK != ret) {
+      (void)rcl_node_fini(&reporter->node);
+    }
+  }
+  reporter->allocator.deallocate(report_topic, reporter->allocator.state);
+  return ret;
+}
+
+static void
+_publisher_fini(rcl_collector_reporter_t * reporter)
+{
+  if (RCL_RET_OK != rcl_publisher_fini(&reporter->publisher, &reporter->node) ||
+    RCL_RET_OK != rcl_node_fini(&reporter->node))
+  {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME "_collector", "Failed to finalize the report publisher, '%s'",
+      rcl_get_error_string().str);
+    rcl_reset_error();
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+#else
+static void *
+#endif
+_run(void * arg)
+{
+  rcl_collector_reporter_t * reporter = (rcl_collector_reporter_t *)arg;
+  while (rcutils_atomic_load_bool(&reporter->running)) {
+    _sleep_period();
+    _drain(reporter);
+  }
+#ifdef _WIN32
+  return 0;
+#else
+  return NULL;
+#endif
+}
+
+static bool
+_thread_start(rcl_collector_reporter_t * reporter)
+{
+#ifdef _WIN32
+  reporter->thread = CreateThread(NULL, 0, _run, reporter, 0, NULL);
+  return NULL != reporter->thread;
+#else
+  return 0 == pthread_create(&reporter->thread, NULL, _run, reporter);
+#endif
+}
+
+static void
+_thread_join(rcl_collector_reporter_t * reporter)
+{
+#ifdef _WIN32
+  WaitForSingleObject(reporter->thread, INFINITE);
+  CloseHandle(reporter->thread);
+#else
+  pthread_join(reporter->thread, NULL);
+#endif
+}
+
+rcl_ret_t
+rcl_collector_reporter_init(
+  rcl_collector_reporter_t ** reporter,
+  rcl_context_t * context,
+  rcl_allocator_t allocator)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(reporter, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(context, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ALLOCATOR_WITH_MSG(&allocator, "invalid allocator", return RCL_RET_INVALID_ARGUMENT);
+  rcl_collector_reporter_t * new_reporter = (rcl_collector_reporter_t *)allocator.zero_allocate(
+    1, sizeof(rcl_collector_reporter_t), allocator.state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    new_reporter, "allocating memory failed", return RCL_RET_BAD_ALLOC);
+  new_reporter->allocator = allocator;
+  new_reporter->context = context;
+  _mutex_init(&new_reporter->mutex);
+  _mutex_init(&new_reporter->schedule_mutex);
+  atomic_init(&new_reporter->running, false);
+  *reporter = new_reporter;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_collector_reporter_register(
+  rcl_collector_reporter_t * reporter,
+  struct rcl_collector_t * collector)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(reporter, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(collector, RCL_RET_INVALID_ARGUMENT);
+  rcl_ret_t ret = RCL_RET_OK;
+  _mutex_lock(&reporter->mutex);
+  if (reporter->collector_count == reporter->collector_capacity) {
+    size_t capacity = reporter->collector_capacity ? 2 * reporter->collector_capacity : 8;
+    struct rcl_collector_t ** collectors = reporter->allocator.reallocate(
+      reporter->collectors, capacity * sizeof(struct rcl_collector_t *), reporter->allocator.state);
+    if (NULL == collectors) {
+      RCL_SET_ERROR_MSG("allocating memory failed");
+      ret = RCL_RET_BAD_ALLOC;
+      goto unlock;
+    }
+    reporter->collectors = collectors;
+    reporter->collector_capacity = capacity;
+  }
+  reporter->collectors[reporter->collector_count++] = collector;
+
+  if (!reporter->thread_started && !reporter->stopped) {
+    ret = _publisher_init(reporter);
+    if (RCL_RET_OK != ret) {
+      --reporter->collector_count;
+      goto unlock;  // error already set
+    }
+    rcutils_atomic_store(&reporter->running, true);
+    if (!_thread_start(reporter)) {
+      rcutils_atomic_store(&reporter->running, false);
+      _publisher_fini(reporter);
+      --reporter->collector_count;
+      RCL_SET_ERROR_MSG("failed to start the traffic model reporter thread");
+      ret = RCL_RET_ERROR;
+      goto unlock;
+    }
+    reporter->thread_started = true;
+  }
+unlock:
+  _mutex_unlock(&reporter->mutex);
+  return ret;
+}
+
+void
+rcl_collector_reporter_unregister(
+  rcl_collector_reporter_t * reporter,
+  struct rcl_collector_t * collector)
+{
+  _mutex_lock(&reporter->mutex);
+  for (size_t i = 0; i < reporter->collector_count; ++i) {
+    if (reporter->collectors[i] == collector) {
+      reporter->collectors[i] = reporter->collectors[--reporter->collector_count];
+      _schedule_update(reporter);
+      break;
+    }
+  }
+  _mutex_unlock(&reporter->mutex);
+}
+
+rcl_collector_histogram_slot_t *
+rcl_collector_reporter_acquire_histograms(
+  rcl_collector_reporter_t * reporter,
+  const char * topic_name)
+{
+  _mutex_lock(&reporter->mutex);
+  rcl_collector_histogram_slot_t * slot = rcl_collector_histogram_slot_acquire(
+    &reporter->histogram_file, rcl_context_get_instance_id(reporter->context), topic_name,
+    reporter->allocator);
+  _mutex_unlock(&reporter->mutex);
+  return slot;
+}
+
+void
+rcl_collector_reporter_release_histograms(
+  rcl_collector_reporter_t * reporter,
+  rcl_collector_histogram_slot_t * histograms)
+{
+  _mutex_lock(&reporter->mutex);
+  rcl_collector_histogram_slot_release(&reporter->histogram_file, histograms, reporter->allocator);
+  _mutex_unlock(&reporter->mutex);
+}
+
+double
+rcl_collector_reporter_next_gap(
+  rcl_collector_reporter_t * reporter,
+  double now,
+  double guard_time,
+  double horizon)
+{
+  double start = now;
+  _mutex_lock(&reporter->schedule_mutex);
+  // push start past every guard interval it falls into, until none moves it or horizon is hit
+  bool moved = reporter->window_count > 0;
+  for (size_t iteration = 0; moved && iteration < 64; ++iteration) {
+    moved = false;
+    for (size_t i = 0; i < reporter->window_count; ++i) {
+      const rcl_collector_reporter_window_t * window = &reporter->windows[i];
+      double guard = guard_time > 0 ? guard_time : fmax(3 * window->sigma, 1e-4);
+      // topics without gaps between their messages would block every shaped publish
+      if (now > window->expiry || !isfinite(window->phase) || !(window->period > 2 * guard)) {
+        continue;
+      }
+      // the first predicted message whose guard interval does not end before start
+      double pred = window->phase + window->period * ceil((start - guard - window->phase) /
+        window->period);
+      if (pred - guard <= start) {
+        start = pred + guard;
+        moved = true;
+      }
+    }
+    if (start >= now + horizon) {
+      start = now + horizon;
+      break;
+    }
+  }
+  _mutex_unlock(&reporter->schedule_mutex);
+  return start;
+}
+
+void
+rcl_collector_reporter_stop(rcl_collector_reporter_t * reporter)
+{
+  _mutex_lock(&reporter->mutex);
+  bool join = reporter->thread_started;
+  reporter->thread_started = false;
+  reporter->stopped = true;
+  _mutex_unlock(&reporter->mutex);
+  if (join) {
+    rcutils_atomic_store(&reporter->running, false);
+    _thread_join(reporter);
+    // flush whatever was posted during the last period
+    _drain(reporter);
+    _publisher_fini(reporter);
+  }
+}
+
+void
+rcl_collector_reporter_fini(rcl_collector_reporter_t * reporter)
+{
+  rcl_collector_reporter_stop(reporter);
+  rcl_allocator_t allocator = reporter->allocator;
+  rcl_collector_histogram_file_fini(&reporter->histogram_file);
+  _mutex_destroy(&reporter->mutex);
+  _mutex_destroy(&reporter->schedule_mutex);
+  allocator.deallocate(reporter->collectors, allocator.state);
+  allocator.deallocate(reporter->windows, allocator.state);
+  allocator.deallocate(reporter, allocator.state);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,144 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__COLLECTOR_REPORTER_H_
+#define RCL__COLLECTOR_REPORTER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "rcl/allocator.h"
+#include "rcl/context.h"
+#include "rcl/macros.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+
+#include "./collector_histogram_file.h"
+
+struct rcl_collector_t;
+
+/// Per context background thread publishing traffic model reports.
+/**
+ * Collectors post model updates into a lock-free mailbox from the publish
+ * path; the reporter periodically drains every registered collector's mailbox
+ * and publishes the latest model, so updates posted between two drains
+ * coalesce into a single report.
+ * All collectors of a context share one report publisher, owned by a hidden
+ * node of the reporter.
+ * The reporter also keeps the message times the reported models predict, for
+ * shaped publishers to send in between.
+ */
+typedef struct rcl_collector_reporter_t rcl_collector_reporter_t;
+
+/// Allocate a reporter, its node and thread are only created once a collector registers.
+/**
+ * \param[out] reporter set to the new reporter
+ * \param[in] context context the report publisher is created in
+ * \param[in] allocator allocator used for the reporter and its registry
+ * \return `RCL_RET_OK` if the reporter was created, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_collector_reporter_init(
+  rcl_collector_reporter_t ** reporter,
+  rcl_context_t * context,
+  rcl_allocator_t allocator);
+
+/// Add a collector to the reporter, starting the reporter thread if needed.
+/**
+ * Collectors registered after rcl_collector_reporter_stop() are accepted but
+ * never reported.
+ *
+ * \return `RCL_RET_OK` if the collector was registered, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` if the report publisher or the reporter thread could not be
+ *   created.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_collector_reporter_register(
+  rcl_collector_reporter_t * reporter,
+  struct rcl_collector_t * collector);
+
+/// Remove a collector, after which the reporter no longer accesses it.
+RCL_LOCAL
+void
+rcl_collector_reporter_unregister(
+  rcl_collector_reporter_t * reporter,
+  struct rcl_collector_t * collector);
+
+/// Claim histograms for a collector, in the context's shared memory file if possible.
+/**
+ * \return zeroed histograms, or `NULL` if allocating memory failed.
+ */
+RCL_LOCAL
+rcl_collector_histogram_slot_t *
+rcl_collector_reporter_acquire_histograms(
+  rcl_collector_reporter_t * reporter,
+  const char * topic_name);
+
+/// Return histograms obtained from rcl_collector_reporter_acquire_histograms().
+RCL_LOCAL
+void
+rcl_collector_reporter_release_histograms(
+  rcl_collector_reporter_t * reporter,
+  rcl_collector_histogram_slot_t * histograms);
+
+/// Earliest time from `now` that no urgent message of the context is predicted around.
+/**
+ * Predictions come from the models last reported by the context's collectors,
+ * models not refitted for twice their freshness are ignored.
+ * All times are in seconds of the collectors' monotonic clock.
+ *
+ * \param[in] reporter reporter of the context
+ * \param[in] now time from which a gap is looked for
+ * \param[in] guard_time time kept clear on either side of a predicted message, or `0` for 3 sigma
+ *   of the message's time model, at least 100 microseconds
+ * \param[in] horizon longest time after `now` a gap is looked for
+ * \return the start of the gap, or `now + horizon` if no gap starts before that.
+ */
+RCL_LOCAL
+double
+rcl_collector_reporter_next_gap(
+  rcl_collector_reporter_t * reporter,
+  double now,
+  double guard_time,
+  double horizon);
+
+/// Stop the reporter thread, publish any reports still pending and destroy the publisher.
+/**
+ * Must be called before the middleware is shut down; idempotent.
+ */
+RCL_LOCAL
+void
+rcl_collector_reporter_stop(rcl_collector_reporter_t * reporter);
+
+/// Stop the reporter if needed, remove the shared memory file and deallocate it.
+RCL_LOCAL
+void
+rcl_collector_reporter_fini(rcl_collector_reporter_t * reporter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__COLLECTOR_REPORTER_H_
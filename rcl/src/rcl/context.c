@@ -21,6 +21,7 @@ extern "C"
 
 #include <stdbool.h>
 
+#include "./collector_reporter.h"
 #include "./common.h"
 #include "./context_impl.h"
 #include "rcutils/stdatomic_helper.h"
@@ -135,6 +136,11 @@ __cleanup_context(rcl_context_t * context)
       }
     }
 
+    // clean up the collector reporter, stopped already if the context was shut down
+    if (NULL != context->impl->collector_reporter) {
+      rcl_collector_reporter_fini(context->impl->collector_reporter);
+    }
+
     // clean up rmw_context
     if (NULL != context->impl->rmw_context.implementation_identifier) {
       rmw_ret_t rmw_context_fini_ret = rmw_context_fini(&(context->impl->rmw_context));
@@ -25,6 +25,8 @@ extern "C"
 {
 #endif
 
+struct rcl_collector_reporter_t;
+
 /// \internal
 typedef struct rcl_context_impl_t
 {
@@ -38,6 +40,8 @@ typedef struct rcl_context_impl_t
   char ** argv;
   /// rmw context.
   rmw_context_t rmw_context;
+  /// Publishes the traffic models of this context's collectors.
+  struct rcl_collector_reporter_t * collector_reporter;
 } rcl_context_impl_t;
 
 RCL_LOCAL
@@ -20,6 +20,7 @@ extern "C"
 #include "rcl/event.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "rcl/error_handling.h"
 #include "rcl/expand_topic_name.h"
@@ -29,16 +30,12 @@ extern "C"
 #include "rmw/validate_full_topic_name.h"
 #include "rmw/event.h"
 
+#include "./collector.h"
 #include "./common.h"
+#include "./event_impl.h"
 #include "./publisher_impl.h"
 #include "./subscription_impl.h"
 
-typedef struct rcl_event_impl_t
-{
-  rmw_event_t rmw_handle;
-  rcl_allocator_t allocator;
-} rcl_event_impl_t;
-
 rcl_event_t
 rcl_get_zero_initialized_event()
 {
@@ -68,6 +65,13 @@ rcl_publisher_event_init(
     case RCL_PUBLISHER_OFFERED_INCOMPATIBLE_QOS:
       rmw_event_type = RMW_EVENT_OFFERED_QOS_INCOMPATIBLE;
       break;
+    case RCL_PUBLISHER_TRAFFIC_ANOMALY:
+      // raised by the publisher's collector, the middleware knows nothing of it
+      if (NULL == publisher->impl->collector) {
+        RCL_SET_ERROR_MSG("publisher has no collector to detect traffic anomalies");
+        return RCL_RET_UNSUPPORTED;
+      }
+      break;
     default:
       RCL_SET_ERROR_MSG("Event type for publisher not supported");
       return RCL_RET_INVALID_ARGUMENT;
@@ -81,6 +85,24 @@ rcl_publisher_event_init(
 
   event->impl->rmw_handle = rmw_get_zero_initialized_event();
   event->impl->allocator = *allocator;
+  event->impl->collector = NULL;
+  event->impl->base_count = 0;
+  event->impl->taken_count = 0;
+
+  if (RCL_PUBLISHER_TRAFFIC_ANOMALY == event_type) {
+    rcl_ret_t rcl_ret = rcl_collector_anomaly_listen(
+      publisher->impl->collector, publisher->impl->context);
+    if (RCL_RET_OK != rcl_ret) {
+      allocator->deallocate(event->impl, allocator->state);
+      event->impl = NULL;
+      return rcl_ret;  // error already set
+    }
+    event->impl->collector = publisher->impl->collector;
+    // counts start with the event
+    event->impl->base_count = rcl_collector_take_anomaly(event->impl->collector)->total_count;
+    event->impl->taken_count = event->impl->base_count;
+    return RCL_RET_OK;
+  }
 
   rmw_ret_t ret = rmw_publisher_event_init(
     &event->impl->rmw_handle,
@@ -132,6 +154,9 @@ rcl_subscription_event_init(
 
   event->impl->rmw_handle = rmw_get_zero_initialized_event();
   event->impl->allocator = *allocator;
+  event->impl->collector = NULL;
+  event->impl->base_count = 0;
+  event->impl->taken_count = 0;
 
   rmw_ret_t ret = rmw_subscription_event_init(
     &event->impl->rmw_handle,
@@ -156,6 +181,21 @@ rcl_take_event(
   bool taken = false;
   RCL_CHECK_ARGUMENT_FOR_NULL(event, RCL_RET_EVENT_INVALID);
   RCL_CHECK_ARGUMENT_FOR_NULL(event_info, RCL_RET_INVALID_ARGUMENT);
+  if (NULL != event->impl->collector) {
+    // like middleware statuses, taking reports the latest state even if nothing changed
+    rcl_traffic_anomaly_status_t * status = (rcl_traffic_anomaly_status_t *)event_info;
+    *status = *rcl_collector_take_anomaly(event->impl->collector);
+    status->total_count_change = status->total_count - event->impl->taken_count;
+    event->impl->taken_count = status->total_count;
+    status->total_count -= event->impl->base_count;
+    if (0 == status->total_count) {
+      // what the collector holds is from an earlier event
+      memset(status, 0, sizeof(*status));
+    }
+    RCUTILS_LOG_DEBUG_NAMED(
+      ROS_PACKAGE_NAME, "take_event request success");
+    return RCL_RET_OK;
+  }
   rmw_ret_t ret = rmw_take_event(&event->impl->rmw_handle, event_info, &taken);
   if (RMW_RET_OK != ret) {
     RCL_SET_ERROR_MSG(rmw_get_error_string().str);
@@ -180,10 +220,14 @@ rcl_event_fini(rcl_event_t * event)
   RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Finalizing event");
   if (NULL != event->impl) {
     rcl_allocator_t allocator = event->impl->allocator;
-    rmw_ret_t ret = rmw_event_fini(&event->impl->rmw_handle);
-    if (ret != RMW_RET_OK) {
-      RCL_SET_ERROR_MSG(rmw_get_error_string().str);
-      result = rcl_convert_rmw_ret_to_rcl_ret(ret);
+    if (NULL != event->impl->collector) {
+      rcl_collector_anomaly_unlisten(event->impl->collector);
+    } else {
+      rmw_ret_t ret = rmw_event_fini(&event->impl->rmw_handle);
+      if (ret != RMW_RET_OK) {
+        RCL_SET_ERROR_MSG(rmw_get_error_string().str);
+        result = rcl_convert_rmw_ret_to_rcl_ret(ret);
+      }
     }
     allocator.deallocate(event->impl, allocator.state);
     event->impl = NULL;
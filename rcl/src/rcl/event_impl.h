@@ -0,0 +1,36 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__EVENT_IMPL_H_
+#define RCL__EVENT_IMPL_H_
+
+#include "rmw/rmw.h"
+
+#include "rcl/event.h"
+
+// collector internals use C11 atomics, so they are kept out of this header
+struct rcl_collector_t;
+
+typedef struct rcl_event_impl_t
+{
+  rmw_event_t rmw_handle;
+  rcl_allocator_t allocator;
+  /// Collector raising the event, NULL for middleware events.
+  struct rcl_collector_t * collector;
+  /// Total anomaly count of the collector when the event was initialized, and at the last take.
+  int32_t base_count;
+  int32_t taken_count;
+} rcl_event_impl_t;
+
+#endif  // RCL__EVENT_IMPL_H_
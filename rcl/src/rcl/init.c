@@ -36,6 +36,7 @@ extern "C"
 #include "rcl/validate_enclave_name.h"
 
 #include "./arguments_impl.h"
+#include "./collector_reporter.h"
 #include "./common.h"
 #include "./context_impl.h"
 #include "./init_options_impl.h"
@@ -213,6 +214,14 @@ rcl_init(
     goto fail;
   }
 
+  // Create the reporter for collector-enabled publishers, its thread starts on first use.
+  ret = rcl_collector_reporter_init(
+    &(context->impl->collector_reporter), context, allocator);
+  if (RCL_RET_OK != ret) {
+    fail_ret = ret;
+    goto fail;
+  }
+
   // Initialize rmw_init.
   rmw_ret_t rmw_ret = rmw_init(
     &(context->impl->init_options.impl->rmw_init_options),
@@ -245,6 +254,9 @@ rcl_shutdown(rcl_context_t * context)
     return RCL_RET_ALREADY_SHUTDOWN;
   }
 
+  // traffic model reports are published through the middleware, flush them first
+  rcl_collector_reporter_stop(context->impl->collector_reporter);
+
   rmw_ret_t rmw_ret = rmw_shutdown(&(context->impl->rmw_context));
   if (RMW_RET_OK != rmw_ret) {
     RCL_SET_ERROR_MSG(rmw_get_error_string().str);
@@ -32,8 +32,19 @@ extern "C"
 #include "rmw/validate_full_topic_name.h"
 #include "tracetools/tracetools.h"
 
+#include "./coalescing.h"
+#include "./collector.h"
 #include "./common.h"
 #include "./publisher_impl.h"
+#include "./publisher_statistics.h"
+#include "./serialized_message_pool.h"
+#include "./traffic_shaper.h"
+
+/// Messages of a batch the collector samples and records at once.
+#define RCL_PUBLISH_BATCH_CHUNK 64
+
+static rcl_ret_t
+_publish_frame(const rcl_serialized_message_t * frame, size_t count, void * state);
 
 rcl_publisher_t
 rcl_get_zero_initialized_publisher()
@@ -108,6 +119,7 @@ rcl_publisher_init_internal(
   }
   char * expanded_topic_name = NULL;
   char * remapped_topic_name = NULL;
+  char * coalesced_topic_name = NULL;
   ret = rcl_expand_topic_name(
     topic_name,
     rcl_node_get_name(node),
@@ -149,10 +161,18 @@ rcl_publisher_init_internal(
     remapped_topic_name = expanded_topic_name;
     expanded_topic_name = NULL;
   }
+  // frames of a coalescing publisher go on a topic of their own, see rcl_coalescing_options_t
+  const char * rmw_topic_name = remapped_topic_name;
+  if (0.0 != options->coalescing.window) {
+    coalesced_topic_name = rcl_get_coalesced_topic_name(remapped_topic_name, *allocator);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      coalesced_topic_name, "allocating memory failed", ret = RCL_RET_BAD_ALLOC; goto cleanup);
+    rmw_topic_name = coalesced_topic_name;
+  }
 
   // Validate the expanded topic name.
   int validation_result;
-  rmw_ret_t rmw_ret = rmw_validate_full_topic_name(remapped_topic_name, &validation_result, NULL);
+  rmw_ret_t rmw_ret = rmw_validate_full_topic_name(rmw_topic_name, &validation_result, NULL);
   if (rmw_ret != RMW_RET_OK) {
     RCL_SET_ERROR_MSG(rmw_get_error_string().str);
     ret = RCL_RET_ERROR;
@@ -168,6 +188,11 @@ rcl_publisher_init_internal(
     sizeof(rcl_publisher_impl_t), allocator->state);
   RCL_CHECK_FOR_NULL_WITH_MSG(
     publisher->impl, "allocating memory failed", ret = RCL_RET_BAD_ALLOC; goto cleanup);
+  publisher->impl->collector = NULL;
+  publisher->impl->shaper = NULL;
+  publisher->impl->serialized_message_pool = NULL;
+  publisher->impl->coalescer = NULL;
+  publisher->impl->statistics = NULL;
 
   // Fill out implementation struct.
   // rmw handle (create rmw publisher)
@@ -175,7 +200,7 @@ rcl_publisher_init_internal(
   publisher->impl->rmw_handle = rmw_create_publisher(
     rcl_node_get_rmw_handle(node),
     type_support,
-    remapped_topic_name,
+    rmw_topic_name,
     &(options->qos),
     &(options->rmw_publisher_options));
   RCL_CHECK_FOR_NULL_WITH_MSG(
@@ -196,21 +221,84 @@ rcl_publisher_init_internal(
   RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Publisher initialized");
   // context
   publisher->impl->context = node->context;
-  // collector
+#ifdef RCL_ENABLE_PUBLISHER_STATISTICS
+  publisher->impl->statistics = (rcl_publisher_statistics_counters_t *)allocator->zero_allocate(
+    1, sizeof(rcl_publisher_statistics_counters_t), allocator->state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    publisher->impl->statistics, "allocating memory failed",
+    fail_ret = RCL_RET_BAD_ALLOC; goto fail);
+#endif
+  // collector, if the collector policy selects the topic
+  rcl_collector_policy_match_t policy = {false, 1u, 0.0};
   if (collector_needed) {
+    ret = rcl_collector_policy_match(node, remapped_topic_name, *allocator, &policy);
+    if (RCL_RET_OK != ret) {
+      fail_ret = ret;
+      goto fail;  // error already set
+    }
+  }
+  if (policy.enabled) {
     publisher->impl->collector = (rcl_collector_t *)allocator->allocate(
       sizeof(rcl_collector_t), allocator->state);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      publisher->impl->collector, "allocating memory failed",
+      fail_ret = RCL_RET_BAD_ALLOC; goto fail);
     *publisher->impl->collector = rcl_get_zero_initialized_collector();
-    rcl_collector_init(publisher->impl->collector, node, type_support, topic_name);
-  } else {
-    publisher->impl->collector = NULL;
+    ret = rcl_collector_init(
+      publisher->impl->collector, node, type_support, remapped_topic_name,
+      &options->collector_options, &policy, false);
+    if (RCL_RET_OK != ret) {
+      fail_ret = ret;
+      goto fail;  // error already set, the collector is finalized on the way out
+    }
+  } else if (RCL_TRAFFIC_SHAPING_NONE != options->traffic_shaping.mode) {
+    // urgent topics have a collector, only the others are shaped around them
+    rcl_traffic_shaper_t * shaper = (rcl_traffic_shaper_t *)allocator->allocate(
+      sizeof(rcl_traffic_shaper_t), allocator->state);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      shaper, "allocating memory failed", fail_ret = RCL_RET_BAD_ALLOC; goto fail);
+    ret = rcl_traffic_shaper_init(shaper, node->context, &options->traffic_shaping);
+    if (RCL_RET_OK != ret) {
+      allocator->deallocate(shaper, allocator->state);
+      fail_ret = ret;
+      goto fail;  // error already set
+    }
+    publisher->impl->shaper = shaper;
+  }
+  if (options->serialized_message_pool_size > 0u) {
+    rcl_serialized_message_pool_t * pool = (rcl_serialized_message_pool_t *)allocator->allocate(
+      sizeof(rcl_serialized_message_pool_t), allocator->state);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      pool, "allocating memory failed", fail_ret = RCL_RET_BAD_ALLOC; goto fail);
+    ret = rcl_serialized_message_pool_init(
+      pool, options->serialized_message_pool_size, *allocator);
+    if (RCL_RET_OK != ret) {
+      allocator->deallocate(pool, allocator->state);
+      fail_ret = ret;
+      goto fail;  // error already set
+    }
+    publisher->impl->serialized_message_pool = pool;
+  }
+  if (0.0 != options->coalescing.window) {
+    rcl_coalescer_t * coalescer = (rcl_coalescer_t *)allocator->allocate(
+      sizeof(rcl_coalescer_t), allocator->state);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      coalescer, "allocating memory failed", fail_ret = RCL_RET_BAD_ALLOC; goto fail);
+    ret = rcl_coalescer_init(
+      coalescer, type_support, &options->coalescing, _publish_frame, publisher->impl, *allocator);
+    if (RCL_RET_OK != ret) {
+      allocator->deallocate(coalescer, allocator->state);
+      fail_ret = ret;
+      goto fail;  // error already set
+    }
+    publisher->impl->coalescer = coalescer;
   }
   TRACEPOINT(
     rcl_publisher_init,
     (const void *)publisher,
     (const void *)node,
     (const void *)publisher->impl->rmw_handle,
-    remapped_topic_name,
+    rmw_topic_name,
     options->qos.depth);
   goto cleanup;
 fail:
@@ -223,6 +311,16 @@ fail:
         RCUTILS_SAFE_FWRITE_TO_STDERR("\n");
       }
     }
+    if (publisher->impl->collector) {
+      (void)rcl_collector_fini(publisher->impl->collector, NULL);
+      allocator->deallocate(publisher->impl->collector, allocator->state);
+    }
+    allocator->deallocate(publisher->impl->shaper, allocator->state);
+    if (publisher->impl->serialized_message_pool) {
+      rcl_serialized_message_pool_fini(publisher->impl->serialized_message_pool);
+      allocator->deallocate(publisher->impl->serialized_message_pool, allocator->state);
+    }
+    allocator->deallocate(publisher->impl->statistics, allocator->state);
 
     allocator->deallocate(publisher->impl, allocator->state);
     publisher->impl = NULL;
@@ -237,6 +335,9 @@ cleanup:
   if (NULL != remapped_topic_name) {
     allocator->deallocate(remapped_topic_name, allocator->state);
   }
+  if (NULL != coalesced_topic_name) {
+    allocator->deallocate(coalesced_topic_name, allocator->state);
+  }
   return ret;
 }
 
@@ -249,11 +350,7 @@ rcl_publisher_init(
   const rcl_publisher_options_t * options
 )
 {
-  const char * prefix = "urg_";
-  bool collector_needed = 
-    strncmp(prefix, topic_name, strlen(prefix)) == 0 && getenv("ROS_MACHINE_ID") != NULL;
-  return rcl_publisher_init_internal(
-    publisher, node, type_support, topic_name, options, collector_needed);
+  return rcl_publisher_init_internal(publisher, node, type_support, topic_name, options, true);
 }
 
 rcl_ret_t
@@ -277,6 +374,16 @@ rcl_publisher_fini(rcl_publisher_t * publisher, rcl_node_t * node)
     if (!rmw_node) {
       return RCL_RET_INVALID_ARGUMENT;
     }
+    if (publisher->impl->coalescer) {
+      // the last messages go out while the publisher still exists, unless shut down already
+      if (rcl_context_is_valid(publisher->impl->context) &&
+        RCL_RET_OK != rcl_coalescer_flush(publisher->impl->coalescer))
+      {
+        result = RCL_RET_ERROR;  // error already set
+      }
+      rcl_coalescer_fini(publisher->impl->coalescer);
+      allocator.deallocate(publisher->impl->coalescer, allocator.state);
+    }
     rmw_ret_t ret =
       rmw_destroy_publisher(rmw_node, publisher->impl->rmw_handle);
     if (ret != RMW_RET_OK) {
@@ -287,6 +394,12 @@ rcl_publisher_fini(rcl_publisher_t * publisher, rcl_node_t * node)
       rcl_collector_fini(publisher->impl->collector, node);
       allocator.deallocate(publisher->impl->collector, allocator.state);
     }
+    allocator.deallocate(publisher->impl->shaper, allocator.state);
+    if (publisher->impl->serialized_message_pool) {
+      rcl_serialized_message_pool_fini(publisher->impl->serialized_message_pool);
+      allocator.deallocate(publisher->impl->serialized_message_pool, allocator.state);
+    }
+    allocator.deallocate(publisher->impl->statistics, allocator.state);
     allocator.deallocate(publisher->impl, allocator.state);
     publisher->impl = NULL;
   }
@@ -332,6 +445,52 @@ rcl_return_loaned_message_from_publisher(
     rmw_return_loaned_message_from_publisher(publisher->impl->rmw_handle, loaned_message));
 }
 
+rcl_ret_t
+rcl_publisher_acquire_serialized_message(
+  const rcl_publisher_t * publisher,
+  rcl_serialized_message_t ** serialized_message)
+{
+  if (!rcl_publisher_is_valid(publisher)) {
+    return RCL_RET_PUBLISHER_INVALID;  // error already set
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(serialized_message, RCL_RET_INVALID_ARGUMENT);
+  if (NULL == publisher->impl->serialized_message_pool) {
+    RCL_SET_ERROR_MSG("publisher has no serialized message pool");
+    return RCL_RET_UNSUPPORTED;
+  }
+  // the collector's size model covers all messages of the topic, not only the pooled ones
+  size_t size_hint = 0u;
+  if (publisher->impl->collector) {
+    size_hint = rcl_collector_serialized_message_reserve(publisher->impl->collector);
+  }
+  return rcl_serialized_message_pool_acquire(
+    publisher->impl->serialized_message_pool, size_hint, serialized_message);
+}
+
+rcl_ret_t
+rcl_publisher_release_serialized_message(
+  const rcl_publisher_t * publisher,
+  rcl_serialized_message_t * serialized_message)
+{
+  if (!rcl_publisher_is_valid(publisher)) {
+    return RCL_RET_PUBLISHER_INVALID;  // error already set
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(serialized_message, RCL_RET_INVALID_ARGUMENT);
+  if (NULL == publisher->impl->serialized_message_pool) {
+    RCL_SET_ERROR_MSG("publisher has no serialized message pool");
+    return RCL_RET_UNSUPPORTED;
+  }
+  rcl_serialized_message_pool_release(
+    publisher->impl->serialized_message_pool, serialized_message);
+  return RCL_RET_OK;
+}
+
+static rcl_ret_t
+_publish(
+  const rcl_publisher_t * publisher,
+  const void * ros_message,
+  rmw_publisher_allocation_t * allocation);
+
 rcl_ret_t
 rcl_publish(
   const rcl_publisher_t * publisher,
@@ -345,26 +504,84 @@ rcl_publish(
     return RCL_RET_PUBLISHER_INVALID;  // error already set
   }
   RCL_CHECK_ARGUMENT_FOR_NULL(ros_message, RCL_RET_INVALID_ARGUMENT);
-  if (publisher->impl->collector) {
-    // serialize the message
-    rmw_serialized_message_t serialized_message = rmw_get_zero_initialized_serialized_message();
-    rcutils_allocator_t allocator = rcutils_get_default_allocator();
-    rmw_serialized_message_init(&serialized_message, 0, &allocator);
-    if (rmw_serialize(ros_message, publisher->impl->collector->ts, &serialized_message) != RMW_RET_OK) {
-      rmw_serialized_message_fini(&serialized_message);
-      RCL_SET_ERROR_MSG(rmw_get_error_string().str);
-      return RCL_RET_ERROR;
-    }
+  return _publish(publisher, ros_message, allocation);
+}
 
-    rcl_collector_on_message(publisher->impl->collector, serialized_message.buffer_length);
+static rcl_ret_t
+_publish(
+  const rcl_publisher_t * publisher,
+  const void * ros_message,
+  rmw_publisher_allocation_t * allocation)
+{
+  if (publisher->impl->coalescer) {
+    // the collector and shaper see the frames, when they are published
+    return rcl_coalescer_append(publisher->impl->coalescer, ros_message, NULL);
+  }
+  rcl_collector_t * collector = publisher->impl->collector;
+  rcl_collector_sample_t sample;
+  if (collector && !rcl_collector_sample(collector, &sample)) {
+    collector = NULL;
+  }
+  size_t size = 0u;
+  if (collector && collector->size_estimator.estimate) {
+    // the size is all the collector needs, keep the regular (possibly zero-copy) publish path
+    size = rcl_estimate_serialized_size(&collector->size_estimator, ros_message);
+    rcl_collector_on_message(collector, &sample, size);
+  } else if (collector) {
+    // serialize the message into the collector's persistent buffer, or into a temporary one
+    // if a concurrent publish on this publisher already holds it
+    rmw_serialized_message_t temporary_message = rmw_get_zero_initialized_serialized_message();
+    rmw_serialized_message_t * serialized_message =
+      rcl_collector_acquire_serialized_message(collector);
+    if (NULL == serialized_message) {
+      rcutils_allocator_t allocator = rcutils_get_default_allocator();
+      if (rmw_serialized_message_init(
+          &temporary_message, rcl_collector_serialized_message_reserve(collector),
+          &allocator) != RMW_RET_OK)
+      {
+        RCL_SET_ERROR_MSG(rmw_get_error_string().str);
+        return RCL_RET_BAD_ALLOC;
+      }
+      serialized_message = &temporary_message;
+    }
 
-    if (rmw_publish_serialized_message(publisher->impl->rmw_handle, &serialized_message, allocation) != RMW_RET_OK) {
-      rmw_serialized_message_fini(&serialized_message);
+    rcl_ret_t ret = RCL_RET_OK;
+    if (rmw_serialize(ros_message, collector->ts, serialized_message) != RMW_RET_OK) {
       RCL_SET_ERROR_MSG(rmw_get_error_string().str);
-      return RCL_RET_ERROR;
+      ret = RCL_RET_ERROR;
+    } else {
+      rcl_collector_on_message(collector, &sample, serialized_message->buffer_length);
+      int64_t start = rcl_publisher_statistics_start();
+      rmw_ret_t rmw_ret = rmw_publish_serialized_message(
+        publisher->impl->rmw_handle, serialized_message, allocation);
+      rcl_publisher_statistics_record(
+        publisher->impl->statistics, start, 1u, serialized_message->buffer_length,
+        RMW_RET_OK == rmw_ret);
+      rcl_collector_on_published(collector, &sample);
+      if (rmw_ret != RMW_RET_OK) {
+        RCL_SET_ERROR_MSG(rmw_get_error_string().str);
+        ret = RCL_RET_ERROR;
+      }
+    }
+
+    if (serialized_message == &temporary_message) {
+      (void)rmw_serialized_message_fini(&temporary_message);
+    } else {
+      rcl_collector_release_serialized_message(collector, serialized_message);
     }
-    rmw_serialized_message_fini(&serialized_message);
-  } else if (rmw_publish(publisher->impl->rmw_handle, ros_message, allocation) != RMW_RET_OK) {
+    return ret;
+  }
+  if (publisher->impl->shaper) {
+    rcl_traffic_shaper_wait(publisher->impl->shaper);
+  }
+  int64_t start = rcl_publisher_statistics_start();
+  rmw_ret_t rmw_ret = rmw_publish(publisher->impl->rmw_handle, ros_message, allocation);
+  rcl_publisher_statistics_record(
+    publisher->impl->statistics, start, 1u, size, RMW_RET_OK == rmw_ret);
+  if (collector) {
+    rcl_collector_on_published(collector, &sample);
+  }
+  if (rmw_ret != RMW_RET_OK) {
     RCL_SET_ERROR_MSG(rmw_get_error_string().str);
     return RCL_RET_ERROR;
   }
@@ -372,20 +589,109 @@ rcl_publish(
 }
 
 rcl_ret_t
-rcl_publish_serialized_message(
+rcl_publish_batch(
   const rcl_publisher_t * publisher,
-  const rcl_serialized_message_t * serialized_message,
-  rmw_publisher_allocation_t * allocation)
+  const void * const * ros_messages,
+  size_t count,
+  rmw_publisher_allocation_t * allocation,
+  size_t * published_count)
 {
+  RCUTILS_CAN_RETURN_WITH_ERROR_OF(RCL_RET_PUBLISHER_INVALID);
+  RCUTILS_CAN_RETURN_WITH_ERROR_OF(RCL_RET_ERROR);
+
+  if (published_count) {
+    *published_count = 0u;
+  }
   if (!rcl_publisher_is_valid(publisher)) {
     return RCL_RET_PUBLISHER_INVALID;  // error already set
   }
-  RCL_CHECK_ARGUMENT_FOR_NULL(serialized_message, RCL_RET_INVALID_ARGUMENT);
-  if (publisher->impl->collector) {
-    rcl_collector_on_message(publisher->impl->collector, serialized_message->buffer_length);
+  if (0u == count) {
+    return RCL_RET_OK;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(ros_messages, RCL_RET_INVALID_ARGUMENT);
+  for (size_t i = 0u; i < count; ++i) {
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      ros_messages[i], "ros_messages contains a null message", return RCL_RET_INVALID_ARGUMENT);
+  }
+  rcl_collector_t * collector = publisher->impl->collector;
+  size_t published = 0u;
+  rcl_ret_t ret = RCL_RET_OK;
+  if (NULL == collector || NULL == collector->size_estimator.estimate ||
+    NULL != publisher->impl->shaper || NULL != publisher->impl->coalescer)
+  {
+    // serializing for the collector or a frame, or shaping, happens message by message anyway
+    while (published < count && RCL_RET_OK == ret) {
+      ret = _publish(publisher, ros_messages[published], allocation);
+      published += RCL_RET_OK == ret;
+    }
+  } else {
+    // the collector samples and records a chunk of messages at a time, with their sizes
+    bool sampled[RCL_PUBLISH_BATCH_CHUNK];
+    size_t sizes[RCL_PUBLISH_BATCH_CHUNK];
+    while (published < count && RCL_RET_OK == ret) {
+      size_t chunk = count - published;
+      if (chunk > RCL_PUBLISH_BATCH_CHUNK) {
+        chunk = RCL_PUBLISH_BATCH_CHUNK;
+      }
+      const void * const * messages = ros_messages + published;
+      rcl_collector_sample_t sample;
+      size_t collected = rcl_collector_sample_batch(collector, &sample, sampled, chunk);
+      for (size_t i = 0u, n = 0u; n < collected; ++i) {
+        if (sampled[i]) {
+          sizes[n++] = rcl_estimate_serialized_size(&collector->size_estimator, messages[i]);
+        }
+      }
+      if (collected) {
+        rcl_collector_on_messages(collector, &sample, sizes, collected);
+      }
+      size_t i = 0u;
+      for (size_t n = 0u; i < chunk && RCL_RET_OK == ret; ++i) {
+        int64_t start = rcl_publisher_statistics_start();
+        rmw_ret_t rmw_ret = rmw_publish(publisher->impl->rmw_handle, messages[i], allocation);
+        rcl_publisher_statistics_record(
+          publisher->impl->statistics, start, 1u, sampled[i] ? sizes[n++] : 0u,
+          RMW_RET_OK == rmw_ret);
+        if (RMW_RET_OK != rmw_ret) {
+          RCL_SET_ERROR_MSG(rmw_get_error_string().str);
+          ret = RCL_RET_ERROR;
+        }
+      }
+      if (collected) {
+        rcl_collector_on_published_batch(collector, &sample, chunk, collected);
+      }
+      published += RCL_RET_OK == ret ? i : i - 1;
+    }
+  }
+  if (published_count) {
+    *published_count = published;
+  }
+  return ret;
+}
+
+static rcl_ret_t
+_publish_serialized(
+  rcl_publisher_impl_t * impl,
+  const rcl_serialized_message_t * serialized_message,
+  size_t message_count,
+  rmw_publisher_allocation_t * allocation)
+{
+  rcl_collector_t * collector = impl->collector;
+  rcl_collector_sample_t sample;
+  if (collector && !rcl_collector_sample(collector, &sample)) {
+    collector = NULL;
+  }
+  if (collector) {
+    rcl_collector_on_message(collector, &sample, serialized_message->buffer_length);
+  } else if (impl->shaper) {
+    rcl_traffic_shaper_wait(impl->shaper);
+  }
+  int64_t start = rcl_publisher_statistics_start();
+  rmw_ret_t ret = rmw_publish_serialized_message(impl->rmw_handle, serialized_message, allocation);
+  rcl_publisher_statistics_record(
+    impl->statistics, start, message_count, serialized_message->buffer_length, RMW_RET_OK == ret);
+  if (collector) {
+    rcl_collector_on_published(collector, &sample);
   }
-  rmw_ret_t ret = rmw_publish_serialized_message(
-    publisher->impl->rmw_handle, serialized_message, allocation);
   if (ret != RMW_RET_OK) {
     RCL_SET_ERROR_MSG(rmw_get_error_string().str);
     if (ret == RMW_RET_BAD_ALLOC) {
@@ -396,6 +702,28 @@ rcl_publish_serialized_message(
   return RCL_RET_OK;
 }
 
+rcl_ret_t
+rcl_publish_serialized_message(
+  const rcl_publisher_t * publisher,
+  const rcl_serialized_message_t * serialized_message,
+  rmw_publisher_allocation_t * allocation)
+{
+  if (!rcl_publisher_is_valid(publisher)) {
+    return RCL_RET_PUBLISHER_INVALID;  // error already set
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(serialized_message, RCL_RET_INVALID_ARGUMENT);
+  if (publisher->impl->coalescer) {
+    return rcl_coalescer_append(publisher->impl->coalescer, NULL, serialized_message);
+  }
+  return _publish_serialized(publisher->impl, serialized_message, 1u, allocation);
+}
+
+static rcl_ret_t
+_publish_frame(const rcl_serialized_message_t * frame, size_t count, void * state)
+{
+  return _publish_serialized((rcl_publisher_impl_t *)state, frame, count, NULL);
+}
+
 rcl_ret_t
 rcl_publish_loaned_message(
   const rcl_publisher_t * publisher,
@@ -406,10 +734,35 @@ rcl_publish_loaned_message(
     return RCL_RET_PUBLISHER_INVALID;  // error already set
   }
   RCL_CHECK_ARGUMENT_FOR_NULL(ros_message, RCL_RET_INVALID_ARGUMENT);
-  if (publisher->impl->collector) {
-    rcl_collector_on_message(publisher->impl->collector, 0);
+  if (publisher->impl->coalescer) {
+    // loaned messages are not coalesced, they follow the messages published before them
+    rcl_ret_t ret = rcl_coalescer_flush(publisher->impl->coalescer);
+    if (RCL_RET_OK != ret) {
+      return ret;  // error already set
+    }
+  }
+  rcl_collector_t * collector = publisher->impl->collector;
+  rcl_collector_sample_t sample;
+  if (collector && !rcl_collector_sample(collector, &sample)) {
+    collector = NULL;
+  }
+  size_t size = 0u;
+  if (collector) {
+    size_t collected_size = rcl_collector_loaned_message_size(collector, ros_message);
+    rcl_collector_on_message(collector, &sample, collected_size);
+    if (RCL_COLLECTOR_SIZE_UNKNOWN != collected_size) {
+      size = collected_size;
+    }
+  } else if (publisher->impl->shaper) {
+    rcl_traffic_shaper_wait(publisher->impl->shaper);
   }
+  int64_t start = rcl_publisher_statistics_start();
   rmw_ret_t ret = rmw_publish_loaned_message(publisher->impl->rmw_handle, ros_message, allocation);
+  rcl_publisher_statistics_record(
+    publisher->impl->statistics, start, 1u, size, RMW_RET_OK == ret);
+  if (collector) {
+    rcl_collector_on_published(collector, &sample);
+  }
   if (ret != RMW_RET_OK) {
     RCL_SET_ERROR_MSG(rmw_get_error_string().str);
     return RCL_RET_ERROR;
@@ -417,6 +770,44 @@ rcl_publish_loaned_message(
   return RCL_RET_OK;
 }
 
+rcl_ret_t
+rcl_publisher_get_statistics(
+  const rcl_publisher_t * publisher,
+  rcl_publisher_statistics_t * statistics)
+{
+  if (!rcl_publisher_is_valid_except_context(publisher)) {
+    return RCL_RET_PUBLISHER_INVALID;  // error already set
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(statistics, RCL_RET_INVALID_ARGUMENT);
+#ifdef RCL_ENABLE_PUBLISHER_STATISTICS
+  rcl_publisher_statistics_counters_t * counters = publisher->impl->statistics;
+  statistics->message_count =
+    atomic_load_explicit(&counters->message_count, memory_order_relaxed);
+  statistics->byte_count = atomic_load_explicit(&counters->byte_count, memory_order_relaxed);
+  statistics->error_count = atomic_load_explicit(&counters->error_count, memory_order_relaxed);
+  for (size_t i = 0u; i < RCL_PUBLISHER_STATISTICS_DURATION_BUCKETS; ++i) {
+    statistics->publish_duration[i] =
+      atomic_load_explicit(&counters->publish_duration[i], memory_order_relaxed);
+  }
+  return RCL_RET_OK;
+#else
+  RCL_SET_ERROR_MSG("rcl was built without publisher statistics");
+  return RCL_RET_UNSUPPORTED;
+#endif
+}
+
+rcl_ret_t
+rcl_publisher_flush(const rcl_publisher_t * publisher)
+{
+  if (!rcl_publisher_is_valid(publisher)) {
+    return RCL_RET_PUBLISHER_INVALID;  // error already set
+  }
+  if (NULL == publisher->impl->coalescer) {
+    return RCL_RET_OK;
+  }
+  return rcl_coalescer_flush(publisher->impl->coalescer);
+}
+
 rcl_ret_t
 rcl_publisher_assert_liveliness(const rcl_publisher_t * publisher)
 {
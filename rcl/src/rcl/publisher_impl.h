@@ -19,7 +19,12 @@
 
 #include "rcl/publisher.h"
 
-#include "./collector.h"
+// collector and shaper internals use C11 atomics, so they are kept out of this header
+struct rcl_collector_t;
+struct rcl_traffic_shaper_t;
+struct rcl_serialized_message_pool_t;
+struct rcl_coalescer_t;
+struct rcl_publisher_statistics_counters_t;
 
 typedef struct rcl_publisher_impl_t
 {
@@ -27,7 +32,12 @@ typedef struct rcl_publisher_impl_t
   rmw_qos_profile_t actual_qos;
   rcl_context_t * context;
   rmw_publisher_t * rmw_handle;
-  rcl_collector_t * collector;
+  struct rcl_collector_t * collector;
+  struct rcl_traffic_shaper_t * shaper;
+  struct rcl_serialized_message_pool_t * serialized_message_pool;
+  struct rcl_coalescer_t * coalescer;
+  /// Publish call counters, `NULL` if rcl is built without publisher statistics.
+  struct rcl_publisher_statistics_counters_t * statistics;
 } rcl_publisher_impl_t;
 
 #endif  // RCL__PUBLISHER_IMPL_H_
@@ -0,0 +1,130 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__PUBLISHER_STATISTICS_H_
+#define RCL__PUBLISHER_STATISTICS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcl/publisher.h"
+
+// Without RCL_ENABLE_PUBLISHER_STATISTICS the functions below are empty, and a
+// publish neither reads the clock nor touches a counter.
+
+#ifdef RCL_ENABLE_PUBLISHER_STATISTICS
+
+#ifndef _WIN32
+# include <time.h>
+#endif
+
+#include "rcutils/stdatomic_helper.h"
+#include "rcutils/time.h"
+
+/// Counters behind rcl_publisher_statistics_t, updated with relaxed atomics.
+typedef struct rcl_publisher_statistics_counters_t
+{
+  atomic_uint_least64_t message_count;
+  atomic_uint_least64_t byte_count;
+  atomic_uint_least64_t error_count;
+  atomic_uint_least64_t publish_duration[RCL_PUBLISHER_STATISTICS_DURATION_BUCKETS];
+} rcl_publisher_statistics_counters_t;
+
+/// Start timing a middleware publish call.
+static inline int64_t
+rcl_publisher_statistics_start(void)
+{
+#ifdef _WIN32
+  rcutils_time_point_value_t now = 0;
+  (void)rcutils_steady_time_now(&now);
+  return now;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+/// Count a middleware publish call of `message_count` messages and `byte_count` bytes.
+static inline void
+rcl_publisher_statistics_record(
+  rcl_publisher_statistics_counters_t * counters,
+  int64_t start,
+  size_t message_count,
+  size_t byte_count,
+  bool ok)
+{
+  if (NULL == counters) {
+    return;
+  }
+  int64_t duration = rcl_publisher_statistics_start() - start;
+  // floor(log2(duration)), by halving the width of the search each step
+  unsigned int bucket = 0;
+  uint64_t value = duration > 0 ? (uint64_t)duration : 0u;
+  for (unsigned int shift = 32; shift > 0; shift >>= 1) {
+    if (value >> shift) {
+      value >>= shift;
+      bucket += shift;
+    }
+  }
+  if (bucket >= RCL_PUBLISHER_STATISTICS_DURATION_BUCKETS) {
+    bucket = RCL_PUBLISHER_STATISTICS_DURATION_BUCKETS - 1;
+  }
+  atomic_fetch_add_explicit(&counters->publish_duration[bucket], 1u, memory_order_relaxed);
+  if (ok) {
+    atomic_fetch_add_explicit(&counters->message_count, message_count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->byte_count, byte_count, memory_order_relaxed);
+  } else {
+    atomic_fetch_add_explicit(&counters->error_count, 1u, memory_order_relaxed);
+  }
+}
+
+#else
+
+struct rcl_publisher_statistics_counters_t;
+
+static inline int64_t
+rcl_publisher_statistics_start(void)
+{
+  return 0;
+}
+
+static inline void
+rcl_publisher_statistics_record(
+  struct rcl_publisher_statistics_counters_t * counters,
+  int64_t start,
+  size_t message_count,
+  size_t byte_count,
+  bool ok)
+{
+  (void)counters;
+  (void)start;
+  (void)message_count;
+  (void)byte_count;
+  (void)ok;
+}
+
+#endif  // RCL_ENABLE_PUBLISHER_STATISTICS
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__PUBLISHER_STATISTICS_H_
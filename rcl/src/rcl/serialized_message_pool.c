@@ -0,0 +1,158 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "./serialized_message_pool.h"
+
+#include <stdint.h>
+
+#include "rcl/error_handling.h"
+#include "rmw/serialized_message.h"
+
+/// Weight of a released buffer's length in the typical size, as a shift.
+#define RCL_SERIALIZED_MESSAGE_POOL_WEIGHT_SHIFT 3
+/// Buffers larger than this many times the typical size are freed on release.
+#define RCL_SERIALIZED_MESSAGE_POOL_MAX_OVERSIZE 4
+
+rcl_ret_t
+rcl_serialized_message_pool_init(
+  rcl_serialized_message_pool_t * pool,
+  size_t capacity,
+  rcl_allocator_t allocator)
+{
+  pool->allocator = allocator;
+  pool->capacity = capacity;
+  pool->slots = NULL;
+  atomic_init(&pool->typical_size, 0);
+  if (0u == capacity) {
+    return RCL_RET_OK;
+  }
+  pool->slots = (atomic_uintptr_t *)allocator.allocate(
+    capacity * sizeof(atomic_uintptr_t), allocator.state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(pool->slots, "allocating memory failed", return RCL_RET_BAD_ALLOC);
+  for (size_t i = 0; i < capacity; ++i) {
+    atomic_init(&pool->slots[i], 0);
+  }
+  return RCL_RET_OK;
+}
+
+static void
+_buffer_free(rcl_serialized_message_pool_t * pool, rcl_serialized_message_t * serialized_message)
+{
+  if (RMW_RET_OK != rmw_serialized_message_fini(serialized_message)) {
+    rcutils_reset_error();
+  }
+  pool->allocator.deallocate(serialized_message, pool->allocator.state);
+}
+
+void
+rcl_serialized_message_pool_fini(rcl_serialized_message_pool_t * pool)
+{
+  for (size_t i = 0; i < pool->capacity; ++i) {
+    rcl_serialized_message_t * idle =
+      (rcl_serialized_message_t *)rcutils_atomic_exchange_uintptr_t(&pool->slots[i], 0);
+    if (NULL != idle) {
+      _buffer_free(pool, idle);
+    }
+  }
+  pool->allocator.deallocate(pool->slots, pool->allocator.state);
+  pool->slots = NULL;
+  pool->capacity = 0u;
+}
+
+rcl_ret_t
+rcl_serialized_message_pool_acquire(
+  rcl_serialized_message_pool_t * pool,
+  size_t size_hint,
+  rcl_serialized_message_t ** serialized_message)
+{
+  uint64_t typical_size = rcutils_atomic_load_uint64_t(&pool->typical_size);
+  size_t capacity = typical_size > size_hint ? (size_t)typical_size : size_hint;
+  for (size_t i = 0; i < pool->capacity; ++i) {
+    // empty slots are skipped without writing to them
+    if (0 == rcutils_atomic_load_uintptr_t(&pool->slots[i])) {
+      continue;
+    }
+    rcl_serialized_message_t * idle =
+      (rcl_serialized_message_t *)rcutils_atomic_exchange_uintptr_t(&pool->slots[i], 0);
+    if (NULL == idle) {
+      continue;  // taken by a concurrent acquire
+    }
+    idle->buffer_length = 0u;
+    if (idle->buffer_capacity < capacity &&
+      RMW_RET_OK != rmw_serialized_message_resize(idle, capacity))
+    {
+      // serializing grows the buffer as well, the hint is only an optimization
+      rcutils_reset_error();
+    }
+    *serialized_message = idle;
+    return RCL_RET_OK;
+  }
+
+  rcl_serialized_message_t * fresh = (rcl_serialized_message_t *)pool->allocator.allocate(
+    sizeof(rcl_serialized_message_t), pool->allocator.state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(fresh, "allocating memory failed", return RCL_RET_BAD_ALLOC);
+  *fresh = rmw_get_zero_initialized_serialized_message();
+  if (RMW_RET_OK != rmw_serialized_message_init(fresh, capacity, &pool->allocator)) {
+    pool->allocator.deallocate(fresh, pool->allocator.state);
+    RCL_SET_ERROR_MSG("allocating the serialized message buffer failed");
+    return RCL_RET_BAD_ALLOC;
+  }
+  *serialized_message = fresh;
+  return RCL_RET_OK;
+}
+
+void
+rcl_serialized_message_pool_release(
+  rcl_serialized_message_pool_t * pool,
+  rcl_serialized_message_t * serialized_message)
+{
+  // concurrent releases may overwrite each other's update, the size is only an estimate
+  uint64_t typical_size = rcutils_atomic_load_uint64_t(&pool->typical_size);
+  uint64_t length = serialized_message->buffer_length;
+  if (0u == typical_size) {
+    typical_size = length;
+  } else if (length > typical_size) {
+    typical_size += (length - typical_size) >> RCL_SERIALIZED_MESSAGE_POOL_WEIGHT_SHIFT;
+  } else {
+    typical_size -= (typical_size - length) >> RCL_SERIALIZED_MESSAGE_POOL_WEIGHT_SHIFT;
+  }
+  rcutils_atomic_store(&pool->typical_size, typical_size);
+
+  // a rare huge message would otherwise pin its buffer in the pool
+  if (typical_size > 0u &&
+    serialized_message->buffer_capacity > RCL_SERIALIZED_MESSAGE_POOL_MAX_OVERSIZE * typical_size)
+  {
+    _buffer_free(pool, serialized_message);
+    return;
+  }
+  for (size_t i = 0; i < pool->capacity; ++i) {
+    uintptr_t expected = 0;
+    bool kept = false;
+    rcutils_atomic_compare_exchange_strong(
+      &pool->slots[i], kept, &expected, (uintptr_t)serialized_message);
+    if (kept) {
+      return;
+    }
+  }
+  _buffer_free(pool, serialized_message);
+}
+
+#ifdef __cplusplus
+}
+#endif
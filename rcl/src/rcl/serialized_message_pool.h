@@ -0,0 +1,88 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__SERIALIZED_MESSAGE_POOL_H_
+#define RCL__SERIALIZED_MESSAGE_POOL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include "rcl/allocator.h"
+#include "rcl/macros.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+#include "rcutils/stdatomic_helper.h"
+
+/// Bounded pool of serialized message buffers of a publisher.
+typedef struct rcl_serialized_message_pool_t
+{
+  rcl_allocator_t allocator;
+  /// Idle buffers, `0` for empty slots, claimed and filled with atomic exchanges.
+  atomic_uintptr_t * slots;
+  size_t capacity;
+  /// Exponentially weighted mean length of the released buffers, in bytes.
+  atomic_uint_least64_t typical_size;
+} rcl_serialized_message_pool_t;
+
+/// Initialize a pool keeping up to `capacity` idle buffers.
+/**
+ * \return `RCL_RET_OK` if the pool was initialized, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_serialized_message_pool_init(
+  rcl_serialized_message_pool_t * pool,
+  size_t capacity,
+  rcl_allocator_t allocator);
+
+/// Free the idle buffers of a pool, no buffer may be acquired anymore.
+RCL_LOCAL
+void
+rcl_serialized_message_pool_fini(rcl_serialized_message_pool_t * pool);
+
+/// Take an idle buffer, or allocate one, with a capacity of at least `size_hint` bytes.
+/**
+ * Thread-safe and lock-free, new buffers are sized to the typical size if it is larger.
+ * \return `RCL_RET_OK` if a buffer was acquired, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_serialized_message_pool_acquire(
+  rcl_serialized_message_pool_t * pool,
+  size_t size_hint,
+  rcl_serialized_message_t ** serialized_message);
+
+/// Keep a buffer for reuse, or free it if the pool is full or the buffer oversized.
+/**
+ * Thread-safe and lock-free.
+ */
+RCL_LOCAL
+void
+rcl_serialized_message_pool_release(
+  rcl_serialized_message_pool_t * pool,
+  rcl_serialized_message_t * serialized_message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__SERIALIZED_MESSAGE_POOL_H_
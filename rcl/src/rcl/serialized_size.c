@@ -0,0 +1,250 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "./serialized_size.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rcl/error_handling.h"
+#include "rosidl_runtime_c/string.h"
+#include "rosidl_runtime_c/u16string.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+#include "rosidl_typesupport_introspection_c/identifier.h"
+#include "rosidl_typesupport_introspection_c/message_introspection.h"
+
+// CDR encapsulation header preceding the payload
+#define CDR_ENCAPSULATION_SIZE 4u
+
+// Layout shared by every rosidl_runtime_c sequence type.
+typedef struct rcl_generic_sequence_t
+{
+  void * data;
+  size_t size;
+  size_t capacity;
+} rcl_generic_sequence_t;
+
+typedef rosidl_typesupport_introspection_c__MessageMembers rcl_message_members_t;
+typedef rosidl_typesupport_introspection_c__MessageMember rcl_message_member_t;
+
+static inline size_t
+_cdr_align(size_t offset, size_t alignment)
+{
+  return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+// Return the serialized size of a primitive, 0 for strings and messages.
+static size_t
+_primitive_size(uint8_t type_id)
+{
+  switch (type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_BOOLEAN:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_OCTET:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_CHAR:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT8:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT8:
+      return 1u;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT16:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT16:
+      return 2u;
+    // Fast-CDR writes a wchar as a 4 byte wchar_t, like the characters of wide strings
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WCHAR:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+      return 4u;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+      return 8u;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE:
+      return 16u;
+    default:
+      return 0u;
+  }
+}
+
+static inline size_t
+_primitive_alignment(size_t size)
+{
+  // CDR aligns primitives to their size, capped at 8 bytes
+  return size > 8u ? 8u : size;
+}
+
+static inline const rcl_message_members_t *
+_nested_members(const rcl_message_member_t * member)
+{
+  return (const rcl_message_members_t *)member->members_->data;
+}
+
+static inline bool
+_is_sequence(const rcl_message_member_t * member)
+{
+  return member->is_array_ && (0u == member->array_size_ || member->is_upper_bound_);
+}
+
+static bool
+_is_fixed_size(const rcl_message_members_t * members)
+{
+  uint32_t i;
+  for (i = 0; i < members->member_count_; ++i) {
+    const rcl_message_member_t * member = &members->members_[i];
+    if (_is_sequence(member)) {
+      return false;
+    }
+    switch (member->type_id_) {
+      case rosidl_typesupport_introspection_c__ROS_TYPE_STRING:
+      case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING:
+        return false;
+      case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+        if (!_is_fixed_size(_nested_members(member))) {
+          return false;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+static size_t
+_message_size(const rcl_message_members_t * members, const void * ros_message, size_t offset);
+
+// Add `count` elements of one member, stored contiguously at `data`, to `offset`.
+// `data` is only dereferenced for strings and non fixed size messages.
+static size_t
+_elements_size(
+  const rcl_message_member_t * member, const uint8_t * data, size_t count, size_t offset)
+{
+  size_t i;
+  switch (member->type_id_) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING:
+      for (i = 0; i < count; ++i) {
+        const rosidl_runtime_c__String * str = &((const rosidl_runtime_c__String *)data)[i];
+        // length prefix, characters and the null terminator
+        offset = _cdr_align(offset, 4u) + 4u + str->size + 1u;
+      }
+      return offset;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING:
+      for (i = 0; i < count; ++i) {
+        const rosidl_runtime_c__U16String * str =
+          &((const rosidl_runtime_c__U16String *)data)[i];
+        // length prefix and wide characters, serialized as 4 bytes each
+        offset = _cdr_align(offset, 4u) + 4u + 4u * str->size;
+      }
+      return offset;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+      {
+        const rcl_message_members_t * nested = _nested_members(member);
+        for (i = 0; i < count; ++i) {
+          offset = _message_size(nested, data ? data + i * nested->size_of_ : NULL, offset);
+        }
+        return offset;
+      }
+    default:
+      {
+        const size_t size = _primitive_size(member->type_id_);
+        if (0u == count) {
+          return offset;
+        }
+        return _cdr_align(offset, _primitive_alignment(size)) + count * size;
+      }
+  }
+}
+
+static size_t
+_message_size(const rcl_message_members_t * members, const void * ros_message, size_t offset)
+{
+  uint32_t i;
+  for (i = 0; i < members->member_count_; ++i) {
+    const rcl_message_member_t * member = &members->members_[i];
+    const uint8_t * field = ros_message ? (const uint8_t *)ros_message + member->offset_ : NULL;
+    if (!member->is_array_) {
+      offset = _elements_size(member, field, 1u, offset);
+    } else if (!_is_sequence(member)) {
+      offset = _elements_size(member, field, member->array_size_, offset);
+    } else {
+      const rcl_generic_sequence_t * sequence = (const rcl_generic_sequence_t *)field;
+      // length prefix followed by the elements
+      offset = _cdr_align(offset, 4u) + 4u;
+      offset = _elements_size(member, (const uint8_t *)sequence->data, sequence->size, offset);
+    }
+  }
+  return offset;
+}
+
+static size_t
+_introspection_estimate(
+  const rcl_serialized_size_estimator_t * estimator,
+  const void * ros_message)
+{
+  if (estimator->fixed_size) {
+    return estimator->fixed_size;
+  }
+  const rcl_message_members_t * members = (const rcl_message_members_t *)estimator->state;
+  return CDR_ENCAPSULATION_SIZE + _message_size(members, ros_message, 0u);
+}
+
+rcl_serialized_size_estimator_t
+rcl_get_zero_initialized_serialized_size_estimator(void)
+{
+  static rcl_serialized_size_estimator_t null_estimator = {0};
+  return null_estimator;
+}
+
+rcl_ret_t
+rcl_serialized_size_estimator_init(
+  rcl_serialized_size_estimator_t * estimator,
+  const rosidl_message_type_support_t * type_support)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(estimator, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(type_support, RCL_RET_INVALID_ARGUMENT);
+  *estimator = rcl_get_zero_initialized_serialized_size_estimator();
+
+  const rosidl_message_type_support_t * introspection_ts = get_message_typesupport_handle(
+    type_support, rosidl_typesupport_introspection_c__identifier);
+  if (NULL == introspection_ts) {
+    // e.g. C++ type support, callers fall back to serializing
+    rcl_reset_error();
+    return RCL_RET_UNSUPPORTED;
+  }
+  const rcl_message_members_t * members = (const rcl_message_members_t *)introspection_ts->data;
+  estimator->estimate = _introspection_estimate;
+  estimator->state = members;
+  if (_is_fixed_size(members)) {
+    estimator->fixed_size = CDR_ENCAPSULATION_SIZE + _message_size(members, NULL, 0u);
+  }
+  return RCL_RET_OK;
+}
+
+size_t
+rcl_estimate_serialized_size(
+  const rcl_serialized_size_estimator_t * estimator,
+  const void * ros_message)
+{
+  if (NULL == estimator->estimate) {
+    return 0u;
+  }
+  return estimator->estimate(estimator, ros_message);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,94 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__SERIALIZED_SIZE_H_
+#define RCL__SERIALIZED_SIZE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include "rosidl_runtime_c/message_type_support_struct.h"
+
+#include "rcl/macros.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+
+struct rcl_serialized_size_estimator_t;
+
+/// Signature of a function estimating the serialized size of a ROS message.
+/**
+ * \return the estimated size in bytes, including the CDR encapsulation header,
+ *   or `0` if the size cannot be estimated.
+ */
+typedef size_t (* rcl_serialized_size_function_t)(
+  const struct rcl_serialized_size_estimator_t * estimator,
+  const void * ros_message);
+
+/// Estimates serialized message sizes without serializing.
+typedef struct rcl_serialized_size_estimator_t
+{
+  /// Function computing the size, `NULL` if no estimate is available for the type.
+  rcl_serialized_size_function_t estimate;
+  /// Estimator specific state, e.g. the type's introspection members.
+  const void * state;
+  /// Size of every message of the type if it has no strings or sequences, otherwise `0`.
+  size_t fixed_size;
+} rcl_serialized_size_estimator_t;
+
+/// Return a rcl_serialized_size_estimator_t with no estimate available.
+RCL_LOCAL
+rcl_serialized_size_estimator_t
+rcl_get_zero_initialized_serialized_size_estimator(void);
+
+/// Initialize an estimator computing CDR sizes from C introspection type support.
+/**
+ * The estimate walks the message the same way a CDR serializer would, adding
+ * alignment padding, sequence lengths and string terminators, but writes no bytes.
+ * Types with no strings or sequences are computed once and cached in `fixed_size`.
+ *
+ * \param[out] estimator the estimator to initialize
+ * \param[in] type_support type support of the message type
+ * \return `RCL_RET_OK` if the estimator was initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_UNSUPPORTED` if no C introspection type support is available,
+ *   in which case `estimator` is zero initialized.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_serialized_size_estimator_init(
+  rcl_serialized_size_estimator_t * estimator,
+  const rosidl_message_type_support_t * type_support);
+
+/// Estimate the serialized size of a message.
+/**
+ * \param[in] estimator an initialized estimator
+ * \param[in] ros_message type-erased pointer to a message of the estimator's type
+ * \return the estimated size in bytes, or `0` if no estimate is available.
+ */
+RCL_LOCAL
+size_t
+rcl_estimate_serialized_size(
+  const rcl_serialized_size_estimator_t * estimator,
+  const void * ros_message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__SERIALIZED_SIZE_H_
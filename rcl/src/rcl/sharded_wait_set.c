@@ -0,0 +1,596 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "rcl/sharded_wait_set.h"
+
+#include <stdbool.h>
+
+#include "rcl/error_handling.h"
+#include "rcl/wait.h"
+#include "rcutils/logging_macros.h"
+#include "rcutils/stdatomic_helper.h"
+
+#define RCL_SHARDED_WORK_TYPE_COUNT 6u
+
+typedef struct rcl_sharded_work_record_t
+{
+  // The public part, first so that work casts to its record.
+  rcl_sharded_work_t work;
+  // Index of the entity in the wait set of its shard, while it is in there.
+  size_t index;
+  // Whether the work was pushed, and not put back into its shard since.
+  bool queued;
+  // Links the record into a stack of returned work, or a list of free records.
+  struct rcl_sharded_work_record_t * next;
+  // Links every record of the set, to free them.
+  struct rcl_sharded_work_record_t * next_allocated;
+} rcl_sharded_work_record_t;
+
+typedef struct rcl_sharded_wait_set_shard_t
+{
+  // Persistent wait set, with the wake guard condition at index 0.
+  rcl_wait_set_t wait_set;
+  rcl_guard_condition_t wake;
+  // Records of the entities in the wait set, by type and index in the wait set.
+  rcl_sharded_work_record_t ** records[RCL_SHARDED_WORK_TYPE_COUNT];
+  // Entities of each type given to the shard, including those queued.
+  size_t counts[RCL_SHARDED_WORK_TYPE_COUNT];
+  // Top of the stack of records handed back by rcl_sharded_wait_set_done().
+  atomic_uintptr_t returned;
+  // Records of entities removed while queued, freed once handed back.
+  rcl_sharded_work_record_t * free_records;
+} rcl_sharded_wait_set_shard_t;
+
+typedef struct rcl_sharded_wait_set_impl_t
+{
+  rcl_sharded_wait_set_shard_t * shards;
+  // Entities of each type the set, and each of its shards, has room for.
+  size_t sizes[RCL_SHARDED_WORK_TYPE_COUNT];
+  size_t capacities[RCL_SHARDED_WORK_TYPE_COUNT];
+  // Entities of each type in the set.
+  size_t counts[RCL_SHARDED_WORK_TYPE_COUNT];
+  rcl_sharded_work_record_t * allocated_records;
+  rcl_sharded_work_record_t * free_records;
+  rcl_allocator_t allocator;
+} rcl_sharded_wait_set_impl_t;
+
+rcl_sharded_wait_set_t
+rcl_get_zero_initialized_sharded_wait_set(void)
+{
+  static rcl_sharded_wait_set_t null_sharded_wait_set = {
+    .size_of_shards = 0u,
+    .impl = NULL,
+  };
+  return null_sharded_wait_set;
+}
+
+static rcl_ret_t
+__shard_add(rcl_sharded_wait_set_shard_t * shard, rcl_sharded_work_record_t * record)
+{
+  rcl_wait_set_t * wait_set = &shard->wait_set;
+  const void * entity = record->work.entity;
+  size_t index = 0u;
+  rcl_ret_t ret = RCL_RET_ERROR;
+  switch (record->work.type) {
+    case RCL_SHARDED_WORK_SUBSCRIPTION:
+      ret = rcl_wait_set_add_subscription(wait_set, (const rcl_subscription_t *)entity, &index);
+      break;
+    case RCL_SHARDED_WORK_GUARD_CONDITION:
+      ret = rcl_wait_set_add_guard_condition(
+        wait_set, (const rcl_guard_condition_t *)entity, &index);
+      break;
+    case RCL_SHARDED_WORK_TIMER:
+      ret = rcl_wait_set_add_timer(wait_set, (const rcl_timer_t *)entity, &index);
+      break;
+    case RCL_SHARDED_WORK_CLIENT:
+      ret = rcl_wait_set_add_client(wait_set, (const rcl_client_t *)entity, &index);
+      break;
+    case RCL_SHARDED_WORK_SERVICE:
+      ret = rcl_wait_set_add_service(wait_set, (const rcl_service_t *)entity, &index);
+      break;
+    case RCL_SHARDED_WORK_EVENT:
+      ret = rcl_wait_set_add_event(wait_set, (const rcl_event_t *)entity, &index);
+      break;
+  }
+  if (RCL_RET_OK == ret) {
+    record->index = index;
+    shard->records[record->work.type][index] = record;
+  }
+  return ret;
+}
+
+static rcl_ret_t
+__shard_remove(rcl_sharded_wait_set_shard_t * shard, rcl_sharded_work_record_t * record)
+{
+  rcl_wait_set_t * wait_set = &shard->wait_set;
+  rcl_ret_t ret = RCL_RET_ERROR;
+  switch (record->work.type) {
+    case RCL_SHARDED_WORK_SUBSCRIPTION:
+      ret = rcl_wait_set_remove_subscription(wait_set, record->index);
+      break;
+    case RCL_SHARDED_WORK_GUARD_CONDITION:
+      ret = rcl_wait_set_remove_guard_condition(wait_set, record->index);
+      break;
+    case RCL_SHARDED_WORK_TIMER:
+      ret = rcl_wait_set_remove_timer(wait_set, record->index);
+      break;
+    case RCL_SHARDED_WORK_CLIENT:
+      ret = rcl_wait_set_remove_client(wait_set, record->index);
+      break;
+    case RCL_SHARDED_WORK_SERVICE:
+      ret = rcl_wait_set_remove_service(wait_set, record->index);
+      break;
+    case RCL_SHARDED_WORK_EVENT:
+      ret = rcl_wait_set_remove_event(wait_set, record->index);
+      break;
+  }
+  if (RCL_RET_OK == ret) {
+    shard->records[record->work.type][record->index] = NULL;
+  }
+  return ret;
+}
+
+// Push a chain of records onto the stack of returned work of a shard.
+static void
+__shard_push_returned(
+  rcl_sharded_wait_set_shard_t * shard,
+  rcl_sharded_work_record_t * first,
+  rcl_sharded_work_record_t * last)
+{
+  uintptr_t top = atomic_load_explicit(&shard->returned, memory_order_relaxed);
+  do {
+    last->next = (rcl_sharded_work_record_t *)top;
+  } while (!atomic_compare_exchange_weak_explicit(
+    &shard->returned, &top, (uintptr_t)first, memory_order_release, memory_order_relaxed));
+}
+
+static rcl_ret_t
+__sharded_wait_set_clean_up(rcl_sharded_wait_set_t * sharded_wait_set)
+{
+  rcl_ret_t result = RCL_RET_OK;
+  rcl_sharded_wait_set_impl_t * impl = sharded_wait_set->impl;
+  rcl_allocator_t allocator = impl->allocator;
+  if (NULL != impl->shards) {
+    for (size_t i = 0u; i < sharded_wait_set->size_of_shards; ++i) {
+      rcl_sharded_wait_set_shard_t * shard = &impl->shards[i];
+      rcl_ret_t ret = rcl_wait_set_fini(&shard->wait_set);
+      if (RCL_RET_OK != ret) {
+        result = ret;
+      }
+      ret = rcl_guard_condition_fini(&shard->wake);
+      if (RCL_RET_OK != ret) {
+        result = ret;
+      }
+      for (size_t type = 0u; type < RCL_SHARDED_WORK_TYPE_COUNT; ++type) {
+        allocator.deallocate(shard->records[type], allocator.state);
+      }
+    }
+    allocator.deallocate(impl->shards, allocator.state);
+  }
+  while (NULL != impl->allocated_records) {
+    rcl_sharded_work_record_t * record = impl->allocated_records;
+    impl->allocated_records = record->next_allocated;
+    allocator.deallocate(record, allocator.state);
+  }
+  allocator.deallocate(impl, allocator.state);
+  sharded_wait_set->impl = NULL;
+  sharded_wait_set->size_of_shards = 0u;
+  return result;
+}
+
+rcl_ret_t
+rcl_sharded_wait_set_init(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  size_t number_of_shards,
+  size_t number_of_subscriptions,
+  size_t number_of_guard_conditions,
+  size_t number_of_timers,
+  size_t number_of_clients,
+  size_t number_of_services,
+  size_t number_of_events,
+  rcl_context_t * context,
+  rcl_allocator_t allocator)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(sharded_wait_set, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ALLOCATOR_WITH_MSG(&allocator, "invalid allocator", return RCL_RET_INVALID_ARGUMENT);
+  if (NULL != sharded_wait_set->impl) {
+    RCL_SET_ERROR_MSG("sharded wait set already initialized, or memory was uninitialized");
+    return RCL_RET_ALREADY_INIT;
+  }
+  if (0u == number_of_shards) {
+    RCL_SET_ERROR_MSG("sharded wait set needs at least one shard");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  rcl_sharded_wait_set_impl_t * impl = (rcl_sharded_wait_set_impl_t *)allocator.zero_allocate(
+    1u, sizeof(rcl_sharded_wait_set_impl_t), allocator.state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(impl, "allocating memory failed", return RCL_RET_BAD_ALLOC);
+  impl->allocator = allocator;
+  sharded_wait_set->impl = impl;
+  impl->shards = (rcl_sharded_wait_set_shard_t *)allocator.zero_allocate(
+    number_of_shards, sizeof(rcl_sharded_wait_set_shard_t), allocator.state);
+  if (NULL == impl->shards) {
+    (void)__sharded_wait_set_clean_up(sharded_wait_set);
+    RCL_SET_ERROR_MSG("allocating memory failed");
+    return RCL_RET_BAD_ALLOC;
+  }
+  sharded_wait_set->size_of_shards = number_of_shards;
+
+  // Adding entities to the shards with the fewest of their type leaves no
+  // shard with more than its share.
+  const size_t numbers[RCL_SHARDED_WORK_TYPE_COUNT] = {
+    number_of_subscriptions, number_of_guard_conditions, number_of_timers,
+    number_of_clients, number_of_services, number_of_events,
+  };
+  size_t type;
+  for (type = 0u; type < RCL_SHARDED_WORK_TYPE_COUNT; ++type) {
+    impl->sizes[type] = numbers[type];
+    impl->capacities[type] =
+      numbers[type] / number_of_shards + (0u != numbers[type] % number_of_shards ? 1u : 0u);
+  }
+
+  rcl_ret_t ret = RCL_RET_OK;
+  for (size_t i = 0u; i < number_of_shards && RCL_RET_OK == ret; ++i) {
+    rcl_sharded_wait_set_shard_t * shard = &impl->shards[i];
+    shard->wait_set = rcl_get_zero_initialized_wait_set();
+    shard->wake = rcl_get_zero_initialized_guard_condition();
+    atomic_init(&shard->returned, 0u);
+    ret = rcl_wait_set_init(
+      &shard->wait_set,
+      impl->capacities[RCL_SHARDED_WORK_SUBSCRIPTION],
+      impl->capacities[RCL_SHARDED_WORK_GUARD_CONDITION] + 1u,
+      impl->capacities[RCL_SHARDED_WORK_TIMER],
+      impl->capacities[RCL_SHARDED_WORK_CLIENT],
+      impl->capacities[RCL_SHARDED_WORK_SERVICE],
+      impl->capacities[RCL_SHARDED_WORK_EVENT],
+      context, allocator);
+    if (RCL_RET_OK != ret) {
+      break;
+    }
+    ret = rcl_wait_set_set_persistent(&shard->wait_set, true);
+    if (RCL_RET_OK != ret) {
+      break;
+    }
+    ret = rcl_guard_condition_init(
+      &shard->wake, context, rcl_guard_condition_get_default_options());
+    if (RCL_RET_OK != ret) {
+      break;
+    }
+    ret = rcl_wait_set_add_guard_condition(&shard->wait_set, &shard->wake, NULL);
+    if (RCL_RET_OK != ret) {
+      break;
+    }
+    for (type = 0u; type < RCL_SHARDED_WORK_TYPE_COUNT; ++type) {
+      const size_t size = impl->capacities[type] +
+        (RCL_SHARDED_WORK_GUARD_CONDITION == type ? 1u : 0u);
+      if (0u == size) {
+        continue;
+      }
+      shard->records[type] = (rcl_sharded_work_record_t **)allocator.zero_allocate(
+        size, sizeof(rcl_sharded_work_record_t *), allocator.state);
+      if (NULL == shard->records[type]) {
+        RCL_SET_ERROR_MSG("allocating memory failed");
+        ret = RCL_RET_BAD_ALLOC;
+        break;
+      }
+    }
+  }
+  if (RCL_RET_OK != ret) {
+    if (RCL_RET_OK != __sharded_wait_set_clean_up(sharded_wait_set)) {
+      RCUTILS_LOG_ERROR_NAMED(
+        ROS_PACKAGE_NAME, "Failed to clean up sharded wait set after failing to initialize it");
+    }
+    return ret;
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_sharded_wait_set_fini(rcl_sharded_wait_set_t * sharded_wait_set)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(sharded_wait_set, RCL_RET_INVALID_ARGUMENT);
+  if (NULL == sharded_wait_set->impl) {
+    return RCL_RET_OK;
+  }
+  return __sharded_wait_set_clean_up(sharded_wait_set);
+}
+
+static rcl_ret_t
+__sharded_wait_set_add(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  rcl_sharded_work_type_t type,
+  const void * entity,
+  const rcl_sharded_work_t ** work)
+{
+  rcl_sharded_wait_set_impl_t * impl = sharded_wait_set->impl;
+  if (impl->counts[type] >= impl->sizes[type]) {
+    RCL_SET_ERROR_MSG("sharded wait set is full");
+    return RCL_RET_WAIT_SET_FULL;
+  }
+  rcl_sharded_wait_set_shard_t * shard = &impl->shards[0];
+  for (size_t i = 1u; i < sharded_wait_set->size_of_shards; ++i) {
+    if (impl->shards[i].counts[type] < shard->counts[type]) {
+      shard = &impl->shards[i];
+    }
+  }
+  // Reuse the records of removed entities, those freed by the shards included.
+  for (size_t i = 0u; NULL == impl->free_records && i < sharded_wait_set->size_of_shards; ++i) {
+    impl->free_records = impl->shards[i].free_records;
+    impl->shards[i].free_records = NULL;
+  }
+  rcl_sharded_work_record_t * record = impl->free_records;
+  if (NULL != record) {
+    impl->free_records = record->next;
+  } else {
+    record = (rcl_sharded_work_record_t *)impl->allocator.allocate(
+      sizeof(rcl_sharded_work_record_t), impl->allocator.state);
+    RCL_CHECK_FOR_NULL_WITH_MSG(record, "allocating memory failed", return RCL_RET_BAD_ALLOC);
+    record->next_allocated = impl->allocated_records;
+    impl->allocated_records = record;
+  }
+  record->work.type = type;
+  record->work.entity = entity;
+  record->work.shard = (size_t)(shard - impl->shards);
+  record->queued = false;
+  record->next = NULL;
+  rcl_ret_t ret = __shard_add(shard, record);
+  if (RCL_RET_OK != ret) {
+    record->work.entity = NULL;
+    record->next = impl->free_records;
+    impl->free_records = record;
+    return ret;  // rcl error state should already be set.
+  }
+  ++shard->counts[type];
+  ++impl->counts[type];
+  if (NULL != work) {
+    *work = &record->work;
+  }
+  return RCL_RET_OK;
+}
+
+#define SHARDED_WAIT_SET_ADD(Type, TYPE) \
+  RCL_CHECK_ARGUMENT_FOR_NULL(sharded_wait_set, RCL_RET_INVALID_ARGUMENT); \
+  RCL_CHECK_FOR_NULL_WITH_MSG( \
+    sharded_wait_set->impl, "sharded wait set is invalid", return RCL_RET_WAIT_SET_INVALID); \
+  RCL_CHECK_ARGUMENT_FOR_NULL(Type, RCL_RET_INVALID_ARGUMENT); \
+  return __sharded_wait_set_add(sharded_wait_set, RCL_SHARDED_WORK_ ## TYPE, Type, work);
+
+rcl_ret_t
+rcl_sharded_wait_set_add_subscription(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_subscription_t * subscription,
+  const rcl_sharded_work_t ** work)
+{
+  SHARDED_WAIT_SET_ADD(subscription, SUBSCRIPTION)
+}
+
+rcl_ret_t
+rcl_sharded_wait_set_add_guard_condition(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_guard_condition_t * guard_condition,
+  const rcl_sharded_work_t ** work)
+{
+  SHARDED_WAIT_SET_ADD(guard_condition, GUARD_CONDITION)
+}
+
+rcl_ret_t
+rcl_sharded_wait_set_add_timer(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_timer_t * timer,
+  const rcl_sharded_work_t ** work)
+{
+  SHARDED_WAIT_SET_ADD(timer, TIMER)
+}
+
+rcl_ret_t
+rcl_sharded_wait_set_add_client(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_client_t * client,
+  const rcl_sharded_work_t ** work)
+{
+  SHARDED_WAIT_SET_ADD(client, CLIENT)
+}
+
+rcl_ret_t
+rcl_sharded_wait_set_add_service(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_service_t * service,
+  const rcl_sharded_work_t ** work)
+{
+  SHARDED_WAIT_SET_ADD(service, SERVICE)
+}
+
+rcl_ret_t
+rcl_sharded_wait_set_add_event(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_event_t * event,
+  const rcl_sharded_work_t ** work)
+{
+  SHARDED_WAIT_SET_ADD(event, EVENT)
+}
+
+// Check the work argument of a sharded wait set function, and get its record.
+#define SHARDED_WAIT_SET_CHECK_WORK(work) \
+  RCL_CHECK_ARGUMENT_FOR_NULL(sharded_wait_set, RCL_RET_INVALID_ARGUMENT); \
+  RCL_CHECK_FOR_NULL_WITH_MSG( \
+    sharded_wait_set->impl, "sharded wait set is invalid", return RCL_RET_WAIT_SET_INVALID); \
+  RCL_CHECK_ARGUMENT_FOR_NULL(work, RCL_RET_INVALID_ARGUMENT); \
+  if (!(work->shard < sharded_wait_set->size_of_shards)) { \
+    RCL_SET_ERROR_MSG("work is not of this sharded wait set"); \
+    return RCL_RET_INVALID_ARGUMENT; \
+  } \
+  rcl_sharded_work_record_t * record = (rcl_sharded_work_record_t *)work; \
+  rcl_sharded_wait_set_shard_t * shard = &sharded_wait_set->impl->shards[work->shard];
+
+rcl_ret_t
+rcl_sharded_wait_set_remove(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_sharded_work_t * work)
+{
+  SHARDED_WAIT_SET_CHECK_WORK(work)
+  if (NULL == record->work.entity) {
+    RCL_SET_ERROR_MSG("entity was removed already");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  if (!record->queued) {
+    rcl_ret_t ret = __shard_remove(shard, record);
+    if (RCL_RET_OK != ret) {
+      return ret;  // rcl error state should already be set.
+    }
+    record->next = sharded_wait_set->impl->free_records;
+    sharded_wait_set->impl->free_records = record;
+  }
+  // Work of a queued entity is freed once it is handed back.
+  record->work.entity = NULL;
+  --shard->counts[record->work.type];
+  --sharded_wait_set->impl->counts[record->work.type];
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_sharded_wait_set_wait(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  size_t shard_index,
+  int64_t timeout,
+  rcl_work_deque_t * deque,
+  size_t * work_count)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(sharded_wait_set, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    sharded_wait_set->impl, "sharded wait set is invalid", return RCL_RET_WAIT_SET_INVALID);
+  if (!(shard_index < sharded_wait_set->size_of_shards)) {
+    RCL_SET_ERROR_MSG("shard index is out of range");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(deque, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(work_count, RCL_RET_INVALID_ARGUMENT);
+  rcl_sharded_wait_set_shard_t * shard = &sharded_wait_set->impl->shards[shard_index];
+  *work_count = 0u;
+
+  // Wait for the entities whose work was handed back again.
+  rcl_sharded_work_record_t * returned = (rcl_sharded_work_record_t *)atomic_exchange_explicit(
+    &shard->returned, 0u, memory_order_acquire);
+  rcl_ret_t ret;
+  while (NULL != returned) {
+    rcl_sharded_work_record_t * record = returned;
+    returned = record->next;
+    record->queued = false;
+    if (NULL == record->work.entity) {
+      record->next = shard->free_records;
+      shard->free_records = record;
+      continue;
+    }
+    ret = __shard_add(shard, record);
+    if (RCL_RET_OK != ret) {
+      // Keep the work of the next wait.
+      record->queued = true;
+      rcl_sharded_work_record_t * last = record;
+      for (last->next = returned; NULL != last->next; last = last->next) {
+      }
+      __shard_push_returned(shard, record, last);
+      return ret;  // rcl error state should already be set.
+    }
+  }
+
+  ret = rcl_wait(&shard->wait_set, timeout);
+  if (RCL_RET_OK != ret) {
+    return ret;  // The timeout, or rcl error state should already be set.
+  }
+  rcl_wait_set_ready_t ready;
+  ret = rcl_wait_set_get_ready(&shard->wait_set, &ready);
+  if (RCL_RET_OK != ret) {
+    return ret;  // rcl error state should already be set.
+  }
+  const size_t * indices[RCL_SHARDED_WORK_TYPE_COUNT] = {
+    ready.subscriptions, ready.guard_conditions, ready.timers,
+    ready.clients, ready.services, ready.events,
+  };
+  const size_t counts[RCL_SHARDED_WORK_TYPE_COUNT] = {
+    ready.size_of_subscriptions, ready.size_of_guard_conditions, ready.size_of_timers,
+    ready.size_of_clients, ready.size_of_services, ready.size_of_events,
+  };
+  for (size_t type = 0u; type < RCL_SHARDED_WORK_TYPE_COUNT; ++type) {
+    for (size_t i = 0u; i < counts[type]; ++i) {
+      // No record for the wake guard condition.
+      rcl_sharded_work_record_t * record = shard->records[type][indices[type][i]];
+      if (NULL == record) {
+        continue;
+      }
+      ret = rcl_work_deque_push(deque, &record->work);
+      if (RCL_RET_OK != ret) {
+        return ret;  // The others are still ready on the next wait.
+      }
+      ret = __shard_remove(shard, record);
+      if (RCL_RET_OK != ret) {
+        return ret;  // rcl error state should already be set.
+      }
+      record->queued = true;
+      ++*work_count;
+    }
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_sharded_wait_set_done(
+  rcl_sharded_wait_set_t * sharded_wait_set,
+  const rcl_sharded_work_t * work)
+{
+  SHARDED_WAIT_SET_CHECK_WORK(work)
+  __shard_push_returned(shard, record, record);
+  if (RCL_RET_OK != rcl_trigger_guard_condition(&shard->wake)) {
+    return RCL_RET_ERROR;  // rcl error state should already be set.
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_sharded_wait_set_wake(rcl_sharded_wait_set_t * sharded_wait_set, size_t shard)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(sharded_wait_set, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    sharded_wait_set->impl, "sharded wait set is invalid", return RCL_RET_WAIT_SET_INVALID);
+  if (!(shard < sharded_wait_set->size_of_shards)) {
+    RCL_SET_ERROR_MSG("shard index is out of range");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  if (RCL_RET_OK != rcl_trigger_guard_condition(&sharded_wait_set->impl->shards[shard].wake)) {
+    return RCL_RET_ERROR;  // rcl error state should already be set.
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_sharded_wait_set_wake_all(rcl_sharded_wait_set_t * sharded_wait_set)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(sharded_wait_set, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    sharded_wait_set->impl, "sharded wait set is invalid", return RCL_RET_WAIT_SET_INVALID);
+  rcl_ret_t result = RCL_RET_OK;
+  for (size_t shard = 0u; shard < sharded_wait_set->size_of_shards; ++shard) {
+    rcl_ret_t ret = rcl_sharded_wait_set_wake(sharded_wait_set, shard);
+    if (RCL_RET_OK != ret) {
+      result = ret;
+    }
+  }
+  return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -29,6 +29,8 @@ extern "C"
 #include "rmw/validate_full_topic_name.h"
 #include "tracetools/tracetools.h"
 
+#include "./coalescing.h"
+#include "./collector.h"
 #include "./common.h"
 #include "./subscription_impl.h"
 
@@ -95,6 +97,7 @@ rcl_subscription_init(
   }
   char * expanded_topic_name = NULL;
   char * remapped_topic_name = NULL;
+  char * coalesced_topic_name = NULL;
   ret = rcl_expand_topic_name(
     topic_name,
     rcl_node_get_name(node),
@@ -136,10 +139,18 @@ rcl_subscription_init(
     remapped_topic_name = expanded_topic_name;
     expanded_topic_name = NULL;
   }
+  // frames are taken from the topic coalescing publishers put them on
+  const char * rmw_topic_name = remapped_topic_name;
+  if (options->split_coalesced_frames) {
+    coalesced_topic_name = rcl_get_coalesced_topic_name(remapped_topic_name, *allocator);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      coalesced_topic_name, "allocating memory failed", ret = RCL_RET_BAD_ALLOC; goto cleanup);
+    rmw_topic_name = coalesced_topic_name;
+  }
 
   // Validate the expanded topic name.
   int validation_result;
-  rmw_ret_t rmw_ret = rmw_validate_full_topic_name(remapped_topic_name, &validation_result, NULL);
+  rmw_ret_t rmw_ret = rmw_validate_full_topic_name(rmw_topic_name, &validation_result, NULL);
   if (rmw_ret != RMW_RET_OK) {
     RCL_SET_ERROR_MSG(rmw_get_error_string().str);
     ret = RCL_RET_ERROR;
@@ -155,13 +166,15 @@ rcl_subscription_init(
     sizeof(rcl_subscription_impl_t), allocator->state);
   RCL_CHECK_FOR_NULL_WITH_MSG(
     subscription->impl, "allocating memory failed", ret = RCL_RET_BAD_ALLOC; goto cleanup);
+  subscription->impl->collector = NULL;
+  subscription->impl->splitter = NULL;
   // Fill out the implemenation struct.
   // rmw_handle
   // TODO(wjwwood): pass allocator once supported in rmw api.
   subscription->impl->rmw_handle = rmw_create_subscription(
     rcl_node_get_rmw_handle(node),
     type_support,
-    remapped_topic_name,
+    rmw_topic_name,
     &(options->qos),
     &(options->rmw_subscription_options));
   if (!subscription->impl->rmw_handle) {
@@ -181,6 +194,41 @@ rcl_subscription_init(
     options->qos.avoid_ros_namespace_conventions;
   // options
   subscription->impl->options = *options;
+  // collector, topics selected by the collector policy are modeled on the receiving side too
+  rcl_collector_policy_match_t policy;
+  ret = rcl_collector_policy_match(node, remapped_topic_name, *allocator, &policy);
+  if (RCL_RET_OK != ret) {
+    fail_ret = ret;
+    goto fail;  // error already set
+  }
+  if (policy.enabled) {
+    subscription->impl->collector = (rcl_collector_t *)allocator->allocate(
+      sizeof(rcl_collector_t), allocator->state);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      subscription->impl->collector, "allocating memory failed",
+      fail_ret = RCL_RET_BAD_ALLOC; goto fail);
+    *subscription->impl->collector = rcl_get_zero_initialized_collector();
+    ret = rcl_collector_init(
+      subscription->impl->collector, node, type_support, remapped_topic_name,
+      &options->collector_options, &policy, true);
+    if (RCL_RET_OK != ret) {
+      fail_ret = ret;
+      goto fail;  // error already set, the collector is finalized on the way out
+    }
+  }
+  if (options->split_coalesced_frames) {
+    rcl_frame_splitter_t * splitter = (rcl_frame_splitter_t *)allocator->allocate(
+      sizeof(rcl_frame_splitter_t), allocator->state);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      splitter, "allocating memory failed", fail_ret = RCL_RET_BAD_ALLOC; goto fail);
+    ret = rcl_frame_splitter_init(splitter, type_support, *allocator);
+    if (RCL_RET_OK != ret) {
+      allocator->deallocate(splitter, allocator->state);
+      fail_ret = ret;
+      goto fail;  // error already set
+    }
+    subscription->impl->splitter = splitter;
+  }
   RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Subscription initialized");
   ret = RCL_RET_OK;
   TRACEPOINT(
@@ -188,7 +236,7 @@ rcl_subscription_init(
     (const void *)subscription,
     (const void *)node,
     (const void *)subscription->impl->rmw_handle,
-    remapped_topic_name,
+    rmw_topic_name,
     options->qos.depth);
   goto cleanup;
 fail:
@@ -201,6 +249,10 @@ fail:
         RCUTILS_SAFE_FWRITE_TO_STDERR("\n");
       }
     }
+    if (subscription->impl->collector) {
+      (void)rcl_collector_fini(subscription->impl->collector, NULL);
+      allocator->deallocate(subscription->impl->collector, allocator->state);
+    }
 
     allocator->deallocate(subscription->impl, allocator->state);
     subscription->impl = NULL;
@@ -214,6 +266,9 @@ cleanup:
   if (NULL != remapped_topic_name) {
     allocator->deallocate(remapped_topic_name, allocator->state);
   }
+  if (NULL != coalesced_topic_name) {
+    allocator->deallocate(coalesced_topic_name, allocator->state);
+  }
   return ret;
 }
 
@@ -243,6 +298,14 @@ rcl_subscription_fini(rcl_subscription_t * subscription, rcl_node_t * node)
       RCL_SET_ERROR_MSG(rmw_get_error_string().str);
       result = RCL_RET_ERROR;
     }
+    if (subscription->impl->collector) {
+      rcl_collector_fini(subscription->impl->collector, node);
+      allocator.deallocate(subscription->impl->collector, allocator.state);
+    }
+    if (subscription->impl->splitter) {
+      rcl_frame_splitter_fini(subscription->impl->splitter);
+      allocator.deallocate(subscription->impl->splitter, allocator.state);
+    }
     allocator.deallocate(subscription->impl, allocator.state);
     subscription->impl = NULL;
   }
@@ -280,18 +343,36 @@ rcl_take(
   rmw_message_info_t dummy_message_info;
   rmw_message_info_t * message_info_local = message_info ? message_info : &dummy_message_info;
   *message_info_local = rmw_get_zero_initialized_message_info();
-  // Call rmw_take_with_info.
-  bool taken = false;
-  rmw_ret_t ret = rmw_take_with_info(
-    subscription->impl->rmw_handle, ros_message, &taken, message_info_local, allocation);
-  if (ret != RMW_RET_OK) {
-    RCL_SET_ERROR_MSG(rmw_get_error_string().str);
-    return rcl_convert_rmw_ret_to_rcl_ret(ret);
+  if (subscription->impl->splitter) {
+    rcl_ret_t split_ret = rcl_frame_splitter_take(
+      subscription->impl->splitter, subscription->impl->rmw_handle, ros_message,
+      message_info_local, allocation);
+    if (RCL_RET_OK != split_ret) {
+      return split_ret;  // error already set
+    }
+  } else {
+    // Call rmw_take_with_info.
+    bool taken = false;
+    rmw_ret_t ret = rmw_take_with_info(
+      subscription->impl->rmw_handle, ros_message, &taken, message_info_local, allocation);
+    if (ret != RMW_RET_OK) {
+      RCL_SET_ERROR_MSG(rmw_get_error_string().str);
+      return rcl_convert_rmw_ret_to_rcl_ret(ret);
+    }
+    RCUTILS_LOG_DEBUG_NAMED(
+      ROS_PACKAGE_NAME, "Subscription take succeeded: %s", taken ? "true" : "false");
+    if (!taken) {
+      return RCL_RET_SUBSCRIPTION_TAKE_FAILED;
+    }
   }
-  RCUTILS_LOG_DEBUG_NAMED(
-    ROS_PACKAGE_NAME, "Subscription take succeeded: %s", taken ? "true" : "false");
-  if (!taken) {
-    return RCL_RET_SUBSCRIPTION_TAKE_FAILED;
+  rcl_collector_t * collector = subscription->impl->collector;
+  rcl_collector_sample_t sample;
+  if (collector && rcl_collector_sample(collector, &sample)) {
+    // split messages were serialized in the frame, the others are not serialized to be sized
+    size_t size = subscription->impl->splitter ?
+      subscription->impl->splitter->message_size :
+      rcl_collector_taken_message_size(collector, ros_message);
+    rcl_collector_on_receive(collector, &sample, size, message_info_local);
   }
   return RCL_RET_OK;
 }
@@ -326,19 +407,54 @@ rcl_take_sequence(
   message_sequence->size = 0u;
   message_info_sequence->size = 0u;
 
+  rcl_collector_t * collector = subscription->impl->collector;
+  rcl_collector_sample_t sample;
   size_t taken = 0u;
-  rmw_ret_t ret = rmw_take_sequence(
-    subscription->impl->rmw_handle, count, message_sequence, message_info_sequence, &taken,
-    allocation);
-  if (ret != RMW_RET_OK) {
-    RCL_SET_ERROR_MSG(rmw_get_error_string().str);
-    return rcl_convert_rmw_ret_to_rcl_ret(ret);
+  if (subscription->impl->splitter) {
+    // messages of a frame are deserialized one by one anyway, and collected with their size
+    rcl_ret_t split_ret = RCL_RET_OK;
+    for (; taken < count; ++taken) {
+      split_ret = rcl_frame_splitter_take(
+        subscription->impl->splitter, subscription->impl->rmw_handle,
+        message_sequence->data[taken], &message_info_sequence->data[taken], allocation);
+      if (RCL_RET_OK != split_ret) {
+        break;
+      }
+      if (collector && rcl_collector_sample(collector, &sample)) {
+        rcl_collector_on_receive(
+          collector, &sample, subscription->impl->splitter->message_size,
+          &message_info_sequence->data[taken]);
+      }
+    }
+    message_sequence->size = taken;
+    message_info_sequence->size = taken;
+    if (RCL_RET_OK != split_ret && RCL_RET_SUBSCRIPTION_TAKE_FAILED != split_ret) {
+      return split_ret;  // error already set
+    }
+  } else {
+    rmw_ret_t ret = rmw_take_sequence(
+      subscription->impl->rmw_handle, count, message_sequence, message_info_sequence, &taken,
+      allocation);
+    if (ret != RMW_RET_OK) {
+      RCL_SET_ERROR_MSG(rmw_get_error_string().str);
+      return rcl_convert_rmw_ret_to_rcl_ret(ret);
+    }
   }
   RCUTILS_LOG_DEBUG_NAMED(
     ROS_PACKAGE_NAME, "Subscription took %zu messages", taken);
   if (0u == taken) {
     return RCL_RET_SUBSCRIPTION_TAKE_FAILED;
   }
+  for (size_t i = 0u; collector && !subscription->impl->splitter && i < message_sequence->size;
+    ++i)
+  {
+    if (!rcl_collector_sample(collector, &sample)) {
+      continue;
+    }
+    rcl_collector_on_receive(
+      collector, &sample, rcl_collector_taken_message_size(collector, message_sequence->data[i]),
+      &message_info_sequence->data[i]);
+  }
   return RCL_RET_OK;
 }
 
@@ -372,6 +488,12 @@ rcl_take_serialized_message(
   if (!taken) {
     return RCL_RET_SUBSCRIPTION_TAKE_FAILED;
   }
+  rcl_collector_t * collector = subscription->impl->collector;
+  rcl_collector_sample_t sample;
+  if (collector && rcl_collector_sample(collector, &sample)) {
+    rcl_collector_on_receive(
+      collector, &sample, serialized_message->buffer_length, message_info_local);
+  }
   return RCL_RET_OK;
 }
 
@@ -408,6 +530,13 @@ rcl_take_loaned_message(
   if (!taken) {
     return RCL_RET_SUBSCRIPTION_TAKE_FAILED;
   }
+  rcl_collector_t * collector = subscription->impl->collector;
+  rcl_collector_sample_t sample;
+  if (collector && rcl_collector_sample(collector, &sample)) {
+    rcl_collector_on_receive(
+      collector, &sample, rcl_collector_loaned_message_size(collector, *loaned_message),
+      message_info_local);
+  }
   return RCL_RET_OK;
 }
 
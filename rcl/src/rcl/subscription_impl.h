@@ -19,11 +19,17 @@
 
 #include "rcl/subscription.h"
 
+// collector internals use C11 atomics, so they are kept out of this header
+struct rcl_collector_t;
+struct rcl_frame_splitter_t;
+
 typedef struct rcl_subscription_impl_t
 {
   rcl_subscription_options_t options;
   rmw_qos_profile_t actual_qos;
   rmw_subscription_t * rmw_handle;
+  struct rcl_collector_t * collector;
+  struct rcl_frame_splitter_t * splitter;
 } rcl_subscription_impl_t;
 
 #endif  // RCL__SUBSCRIPTION_IMPL_H_
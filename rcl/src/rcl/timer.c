@@ -21,6 +21,10 @@ extern "C"
 
 #include <inttypes.h>
 
+#if defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
 #include "rcl/error_handling.h"
 #include "rcutils/logging_macros.h"
 #include "rcutils/stdatomic_helper.h"
@@ -316,6 +320,16 @@ rcl_timer_get_time_until_next_call(const rcl_timer_t * timer, int64_t * time_unt
   return RCL_RET_OK;
 }
 
+rcl_ret_t
+rcl_timer_get_next_call_time(const rcl_timer_t * timer, int64_t * next_call_time)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(next_call_time, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_FOR_NULL_WITH_MSG(timer->impl, "timer is invalid", return RCL_RET_TIMER_INVALID);
+  *next_call_time = rcutils_atomic_load_int64_t(&timer->impl->next_call_time);
+  return RCL_RET_OK;
+}
+
 rcl_ret_t
 rcl_timer_get_time_since_last_call(
   const rcl_timer_t * timer,
@@ -436,6 +450,507 @@ rcl_timer_get_guard_condition(const rcl_timer_t * timer)
   return &timer->impl->guard_condition;
 }
 
+// Levels of a timer wheel, of RCL_TIMER_WHEEL_SLOTS slots each.
+#define RCL_TIMER_WHEEL_LEVELS 4u
+#define RCL_TIMER_WHEEL_SLOT_BITS 6u
+#define RCL_TIMER_WHEEL_SLOTS (1u << RCL_TIMER_WHEEL_SLOT_BITS)
+// Slot of an entry which is free, or whose callback is about to be called.
+#define RCL_TIMER_WHEEL_FREE UINT16_MAX
+#define RCL_TIMER_WHEEL_EXPIRING (UINT16_MAX - 1u)
+
+typedef struct rcl_timer_wheel_link_t
+{
+  struct rcl_timer_wheel_link_t * next;
+  struct rcl_timer_wheel_link_t * prev;
+} rcl_timer_wheel_link_t;
+
+typedef struct rcl_timer_wheel_entry_t
+{
+  // Links the entry into a circular list, first so that links cast to entries.
+  // While the entry is free, next links it into the free list instead.
+  rcl_timer_wheel_link_t link;
+  rcl_timer_wheel_callback_t callback;
+  void * data;
+  // The time the entry is due at, in nanoseconds since the wheel's epoch.
+  uint64_t due;
+  // The period of the entry in nanoseconds, 0 if it is called once.
+  uint64_t period;
+  // The tick the entry expires at, the first one starting at or after due.
+  uint64_t expiry;
+  // Part of the identifier of the entry, incremented when it is released.
+  uint32_t generation;
+  // level * RCL_TIMER_WHEEL_SLOTS + index of the entry's slot, or one of the markers above.
+  uint16_t slot;
+} rcl_timer_wheel_entry_t;
+
+typedef struct rcl_timer_wheel_impl_t
+{
+  // The timer driving the wheel, first so that its callback finds the wheel.
+  rcl_timer_t timer;
+  rcl_clock_t * clock;
+  // The time at tick 0.
+  int64_t epoch;
+  // The length of a tick in nanoseconds.
+  int64_t resolution;
+  // The next tick to be processed, entries are placed in slots relative to it.
+  uint64_t tick;
+  // Heads of the circular lists of the entries in each slot.
+  rcl_timer_wheel_link_t slots[RCL_TIMER_WHEEL_LEVELS][RCL_TIMER_WHEEL_SLOTS];
+  // A bit per slot of each level, set if the slot holds entries.
+  uint64_t occupied[RCL_TIMER_WHEEL_LEVELS];
+  // Head of the list of the entries of the tick being processed.
+  rcl_timer_wheel_link_t expiring;
+  // The next call time last given to the timer, and whether it was armed then.
+  int64_t deadline;
+  bool armed;
+  rcl_timer_wheel_entry_t * entries;
+  size_t capacity;
+  rcl_timer_wheel_entry_t * free_entries;
+  rcl_allocator_t allocator;
+} rcl_timer_wheel_impl_t;
+
+static inline unsigned int
+__timer_wheel_first_bit(uint64_t bits)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward64(&index, bits);
+  return (unsigned int)index;
+#else
+  return (unsigned int)__builtin_ctzll(bits);
+#endif
+}
+
+static inline void
+__timer_wheel_list_init(rcl_timer_wheel_link_t * head)
+{
+  head->next = head;
+  head->prev = head;
+}
+
+static inline bool
+__timer_wheel_list_is_empty(const rcl_timer_wheel_link_t * head)
+{
+  return head->next == head;
+}
+
+static inline void
+__timer_wheel_list_push(rcl_timer_wheel_link_t * head, rcl_timer_wheel_link_t * link)
+{
+  link->prev = head->prev;
+  link->next = head;
+  head->prev->next = link;
+  head->prev = link;
+}
+
+static inline void
+__timer_wheel_list_remove(rcl_timer_wheel_link_t * link)
+{
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+}
+
+// Move the links of a list to another, empty, one.
+static inline void
+__timer_wheel_list_move(rcl_timer_wheel_link_t * from, rcl_timer_wheel_link_t * to)
+{
+  if (__timer_wheel_list_is_empty(from)) {
+    __timer_wheel_list_init(to);
+    return;
+  }
+  to->next = from->next;
+  to->prev = from->prev;
+  to->next->prev = to;
+  to->prev->next = to;
+  __timer_wheel_list_init(from);
+}
+
+static inline rcl_timer_wheel_entry_id_t
+__timer_wheel_id(const rcl_timer_wheel_impl_t * impl, const rcl_timer_wheel_entry_t * entry)
+{
+  return ((uint64_t)entry->generation << 32) | (uint64_t)(entry - impl->entries);
+}
+
+// The first tick starting at or after a time since the epoch.
+static inline uint64_t
+__timer_wheel_tick_after(const rcl_timer_wheel_impl_t * impl, uint64_t elapsed)
+{
+  const uint64_t resolution = (uint64_t)impl->resolution;
+  return elapsed / resolution + (0u != elapsed % resolution ? 1u : 0u);
+}
+
+static inline uint64_t
+__timer_wheel_elapsed(const rcl_timer_wheel_impl_t * impl, int64_t now)
+{
+  return now > impl->epoch ? (uint64_t)(now - impl->epoch) : 0u;
+}
+
+// Put an entry into the slot of its expiry, relative to the next tick to be processed.
+static void
+__timer_wheel_place(rcl_timer_wheel_impl_t * impl, rcl_timer_wheel_entry_t * entry)
+{
+  if (entry->expiry < impl->tick) {
+    entry->expiry = impl->tick;
+  }
+  uint64_t expiry = entry->expiry;
+  const uint64_t delta = expiry - impl->tick;
+  unsigned int level = 0;
+  while (level + 1u < RCL_TIMER_WHEEL_LEVELS &&
+    delta >= (UINT64_C(1) << ((level + 1u) * RCL_TIMER_WHEEL_SLOT_BITS)))
+  {
+    ++level;
+  }
+  if (delta >= (UINT64_C(1) << (RCL_TIMER_WHEEL_LEVELS * RCL_TIMER_WHEEL_SLOT_BITS))) {
+    // Beyond the top level, wait in its farthest slot and be placed again from there.
+    expiry = impl->tick +
+      (UINT64_C(1) << (RCL_TIMER_WHEEL_LEVELS * RCL_TIMER_WHEEL_SLOT_BITS)) - 1u;
+  }
+  const unsigned int index =
+    (unsigned int)(expiry >> (level * RCL_TIMER_WHEEL_SLOT_BITS)) & (RCL_TIMER_WHEEL_SLOTS - 1u);
+  __timer_wheel_list_push(&impl->slots[level][index], &entry->link);
+  impl->occupied[level] |= UINT64_C(1) << index;
+  entry->slot = (uint16_t)(level * RCL_TIMER_WHEEL_SLOTS + index);
+}
+
+static void
+__timer_wheel_unplace(rcl_timer_wheel_impl_t * impl, rcl_timer_wheel_entry_t * entry)
+{
+  __timer_wheel_list_remove(&entry->link);
+  if (entry->slot < RCL_TIMER_WHEEL_LEVELS * RCL_TIMER_WHEEL_SLOTS) {
+    const unsigned int level = entry->slot / RCL_TIMER_WHEEL_SLOTS;
+    const unsigned int index = entry->slot % RCL_TIMER_WHEEL_SLOTS;
+    if (__timer_wheel_list_is_empty(&impl->slots[level][index])) {
+      impl->occupied[level] &= ~(UINT64_C(1) << index);
+    }
+  }
+}
+
+static void
+__timer_wheel_release(rcl_timer_wheel_impl_t * impl, rcl_timer_wheel_entry_t * entry)
+{
+  entry->callback = NULL;
+  entry->data = NULL;
+  entry->slot = RCL_TIMER_WHEEL_FREE;
+  if (0u == ++entry->generation) {
+    entry->generation = 1u;
+  }
+  entry->link.next = (rcl_timer_wheel_link_t *)impl->free_entries;
+  impl->free_entries = entry;
+}
+
+// Place the entries of a slot again, closer to their expiry.
+static void
+__timer_wheel_cascade(rcl_timer_wheel_impl_t * impl, unsigned int level, unsigned int index)
+{
+  rcl_timer_wheel_link_t pending;
+  __timer_wheel_list_move(&impl->slots[level][index], &pending);
+  impl->occupied[level] &= ~(UINT64_C(1) << index);
+  while (!__timer_wheel_list_is_empty(&pending)) {
+    rcl_timer_wheel_entry_t * entry = (rcl_timer_wheel_entry_t *)pending.next;
+    __timer_wheel_list_remove(&entry->link);
+    __timer_wheel_place(impl, entry);
+  }
+}
+
+// The next tick at which an entry expires or a slot has to be cascaded.
+static bool
+__timer_wheel_next_tick(const rcl_timer_wheel_impl_t * impl, uint64_t * tick)
+{
+  bool found = false;
+  for (unsigned int level = 0; level < RCL_TIMER_WHEEL_LEVELS; ++level) {
+    if (0u == impl->occupied[level]) {
+      continue;
+    }
+    const unsigned int shift = level * RCL_TIMER_WHEEL_SLOT_BITS;
+    // The slots of the level in the order they start from the next tick.
+    const uint64_t start = (impl->tick + ((UINT64_C(1) << shift) - 1u)) >> shift;
+    const unsigned int rotation = (unsigned int)start & (RCL_TIMER_WHEEL_SLOTS - 1u);
+    uint64_t bits = impl->occupied[level];
+    if (0u != rotation) {
+      bits = (bits >> rotation) | (bits << (RCL_TIMER_WHEEL_SLOTS - rotation));
+    }
+    const uint64_t candidate = (start + __timer_wheel_first_bit(bits)) << shift;
+    if (!found || candidate < *tick) {
+      *tick = candidate;
+      found = true;
+    }
+  }
+  return found;
+}
+
+// Make the wheel's timer due at the next tick to be processed, or cancel it.
+static void
+__timer_wheel_update(rcl_timer_wheel_impl_t * impl)
+{
+  rcl_timer_impl_t * timer = impl->timer.impl;
+  uint64_t tick;
+  if (!__timer_wheel_next_tick(impl, &tick)) {
+    rcutils_atomic_store(&timer->canceled, true);
+    impl->armed = false;
+    return;
+  }
+  int64_t deadline = INT64_MAX;
+  if (tick <= (uint64_t)(INT64_MAX - impl->epoch) / (uint64_t)impl->resolution) {
+    deadline = impl->epoch + (int64_t)tick * impl->resolution;
+  }
+  rcutils_atomic_store(&timer->next_call_time, deadline);
+  rcutils_atomic_store(&timer->canceled, false);
+  // Wake the wait set if it may be waiting for a later deadline, as rcl_timer_reset() does.
+  const bool earlier = !impl->armed || deadline < impl->deadline;
+  impl->deadline = deadline;
+  impl->armed = true;
+  if (earlier && RCL_RET_OK != rcl_trigger_guard_condition(&timer->guard_condition)) {
+    RCUTILS_LOG_ERROR_NAMED(ROS_PACKAGE_NAME, "Failed to trigger timer wheel guard condition");
+  }
+}
+
+static rcl_ret_t
+__timer_wheel_advance(rcl_timer_wheel_impl_t * impl)
+{
+  rcl_time_point_value_t now;
+  rcl_ret_t ret = rcl_clock_get_now(impl->clock, &now);
+  if (RCL_RET_OK != ret) {
+    return ret;  // rcl error state should already be set.
+  }
+  const uint64_t elapsed = __timer_wheel_elapsed(impl, now);
+  const uint64_t target = elapsed / (uint64_t)impl->resolution;
+  uint64_t tick;
+  while (__timer_wheel_next_tick(impl, &tick) && tick <= target) {
+    impl->tick = tick;
+    // Higher levels first, their entries may move into the slots cascaded next.
+    for (unsigned int level = RCL_TIMER_WHEEL_LEVELS - 1u; level > 0u; --level) {
+      const unsigned int shift = level * RCL_TIMER_WHEEL_SLOT_BITS;
+      if (0u == (tick & ((UINT64_C(1) << shift) - 1u))) {
+        __timer_wheel_cascade(
+          impl, level, (unsigned int)(tick >> shift) & (RCL_TIMER_WHEEL_SLOTS - 1u));
+      }
+    }
+    const unsigned int index = (unsigned int)tick & (RCL_TIMER_WHEEL_SLOTS - 1u);
+    __timer_wheel_list_move(&impl->slots[0][index], &impl->expiring);
+    impl->occupied[0] &= ~(UINT64_C(1) << index);
+    for (rcl_timer_wheel_link_t * link = impl->expiring.next; link != &impl->expiring;
+      link = link->next)
+    {
+      ((rcl_timer_wheel_entry_t *)link)->slot = RCL_TIMER_WHEEL_EXPIRING;
+    }
+    // Entries scheduled by the callbacks are placed after this tick.
+    impl->tick = tick + 1u;
+    while (!__timer_wheel_list_is_empty(&impl->expiring)) {
+      rcl_timer_wheel_entry_t * entry = (rcl_timer_wheel_entry_t *)impl->expiring.next;
+      __timer_wheel_list_remove(&entry->link);
+      const rcl_timer_wheel_entry_id_t id = __timer_wheel_id(impl, entry);
+      const rcl_timer_wheel_callback_t callback = entry->callback;
+      void * data = entry->data;
+      if (0u != entry->period) {
+        // Scheduled again before the callback, so that it can cancel its own entry.
+        entry->due += entry->period;
+        if (entry->due <= elapsed) {
+          // Skip the periods missed entirely, as rcl_timer_call() does.
+          entry->due += (1u + (elapsed - entry->due) / entry->period) * entry->period;
+        }
+        entry->expiry = __timer_wheel_tick_after(impl, entry->due);
+        __timer_wheel_place(impl, entry);
+      } else {
+        __timer_wheel_release(impl, entry);
+      }
+      callback(id, data);
+    }
+  }
+  if (impl->tick <= target) {
+    impl->tick = target + 1u;
+  }
+  __timer_wheel_update(impl);
+  return RCL_RET_OK;
+}
+
+static void
+__timer_wheel_on_timer(rcl_timer_t * timer, int64_t last_call_time)
+{
+  (void)last_call_time;
+  // Called after rcl_timer_call() moved the next call time, which is overwritten here.
+  rcl_timer_wheel_impl_t * impl = (rcl_timer_wheel_impl_t *)timer;
+  if (RCL_RET_OK != __timer_wheel_advance(impl)) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Failed to advance timer wheel: %s", rcl_get_error_string().str);
+    rcl_reset_error();
+  }
+}
+
+rcl_timer_wheel_t
+rcl_get_zero_initialized_timer_wheel(void)
+{
+  static rcl_timer_wheel_t null_timer_wheel = {0};
+  return null_timer_wheel;
+}
+
+rcl_ret_t
+rcl_timer_wheel_init(
+  rcl_timer_wheel_t * wheel,
+  rcl_clock_t * clock,
+  rcl_context_t * context,
+  int64_t resolution,
+  size_t capacity,
+  rcl_allocator_t allocator)
+{
+  RCL_CHECK_ALLOCATOR_WITH_MSG(&allocator, "invalid allocator", return RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(wheel, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(clock, RCL_RET_INVALID_ARGUMENT);
+  if (RCL_STEADY_TIME != clock->type && RCL_SYSTEM_TIME != clock->type) {
+    RCL_SET_ERROR_MSG("timer wheel clock must be a steady or system clock");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  if (resolution <= 0) {
+    RCL_SET_ERROR_MSG("timer wheel resolution must be positive");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  if (0u == capacity || capacity > UINT32_MAX ||
+    capacity > SIZE_MAX / sizeof(rcl_timer_wheel_entry_t))
+  {
+    RCL_SET_ERROR_MSG("timer wheel capacity is out of range");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  if (wheel->impl) {
+    RCL_SET_ERROR_MSG("timer wheel already initialized, or memory was uninitialized");
+    return RCL_RET_ALREADY_INIT;
+  }
+  rcl_timer_wheel_impl_t * impl = (rcl_timer_wheel_impl_t *)allocator.allocate(
+    sizeof(rcl_timer_wheel_impl_t), allocator.state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(impl, "allocating memory failed", return RCL_RET_BAD_ALLOC);
+  impl->entries = (rcl_timer_wheel_entry_t *)allocator.allocate(
+    capacity * sizeof(rcl_timer_wheel_entry_t), allocator.state);
+  if (NULL == impl->entries) {
+    allocator.deallocate(impl, allocator.state);
+    RCL_SET_ERROR_MSG("allocating memory failed");
+    return RCL_RET_BAD_ALLOC;
+  }
+  impl->timer = rcl_get_zero_initialized_timer();
+  rcl_ret_t ret = rcl_timer_init(
+    &impl->timer, clock, context, resolution, __timer_wheel_on_timer, allocator);
+  if (RCL_RET_OK != ret) {
+    allocator.deallocate(impl->entries, allocator.state);
+    allocator.deallocate(impl, allocator.state);
+    return ret;  // rcl error state should already be set.
+  }
+  // The timer is armed by the first entry.
+  rcutils_atomic_store(&impl->timer.impl->canceled, true);
+  impl->clock = clock;
+  impl->epoch = rcutils_atomic_load_int64_t(&impl->timer.impl->last_call_time);
+  impl->resolution = resolution;
+  impl->tick = 0u;
+  for (unsigned int level = 0; level < RCL_TIMER_WHEEL_LEVELS; ++level) {
+    for (unsigned int index = 0; index < RCL_TIMER_WHEEL_SLOTS; ++index) {
+      __timer_wheel_list_init(&impl->slots[level][index]);
+    }
+    impl->occupied[level] = 0u;
+  }
+  __timer_wheel_list_init(&impl->expiring);
+  impl->deadline = 0;
+  impl->armed = false;
+  impl->capacity = capacity;
+  impl->free_entries = NULL;
+  for (size_t i = capacity; i > 0u; --i) {
+    rcl_timer_wheel_entry_t * entry = &impl->entries[i - 1u];
+    entry->generation = 0u;
+    __timer_wheel_release(impl, entry);
+  }
+  impl->allocator = allocator;
+  wheel->impl = impl;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_timer_wheel_fini(rcl_timer_wheel_t * wheel)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(wheel, RCL_RET_INVALID_ARGUMENT);
+  if (!wheel->impl) {
+    return RCL_RET_OK;
+  }
+  rcl_allocator_t allocator = wheel->impl->allocator;
+  rcl_ret_t result = rcl_timer_fini(&wheel->impl->timer);
+  allocator.deallocate(wheel->impl->entries, allocator.state);
+  allocator.deallocate(wheel->impl, allocator.state);
+  wheel->impl = NULL;
+  return result;
+}
+
+rcl_ret_t
+rcl_timer_wheel_schedule(
+  rcl_timer_wheel_t * wheel,
+  int64_t delay,
+  int64_t period,
+  rcl_timer_wheel_callback_t callback,
+  void * data,
+  rcl_timer_wheel_entry_id_t * id)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(wheel, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_FOR_NULL_WITH_MSG(wheel->impl, "timer wheel is invalid", return RCL_RET_TIMER_INVALID);
+  RCL_CHECK_ARGUMENT_FOR_NULL(callback, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(id, RCL_RET_INVALID_ARGUMENT);
+  if (delay < 0 || period < 0) {
+    RCL_SET_ERROR_MSG("timer wheel delay and period must be non-negative");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  rcl_timer_wheel_impl_t * impl = wheel->impl;
+  if (NULL == impl->free_entries) {
+    RCL_SET_ERROR_MSG("timer wheel is full");
+    return RCL_RET_ERROR;
+  }
+  rcl_time_point_value_t now;
+  rcl_ret_t ret = rcl_clock_get_now(impl->clock, &now);
+  if (RCL_RET_OK != ret) {
+    return ret;  // rcl error state should already be set.
+  }
+  rcl_timer_wheel_entry_t * entry = impl->free_entries;
+  impl->free_entries = (rcl_timer_wheel_entry_t *)entry->link.next;
+  entry->callback = callback;
+  entry->data = data;
+  entry->due = __timer_wheel_elapsed(impl, now) + (uint64_t)delay;
+  entry->period = (uint64_t)period;
+  entry->expiry = __timer_wheel_tick_after(impl, entry->due);
+  __timer_wheel_place(impl, entry);
+  *id = __timer_wheel_id(impl, entry);
+  __timer_wheel_update(impl);
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_timer_wheel_cancel(rcl_timer_wheel_t * wheel, rcl_timer_wheel_entry_id_t id)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(wheel, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_FOR_NULL_WITH_MSG(wheel->impl, "timer wheel is invalid", return RCL_RET_TIMER_INVALID);
+  rcl_timer_wheel_impl_t * impl = wheel->impl;
+  const uint64_t index = id & UINT32_MAX;
+  if (index >= impl->capacity ||
+    RCL_TIMER_WHEEL_FREE == impl->entries[index].slot ||
+    (uint32_t)(id >> 32) != impl->entries[index].generation)
+  {
+    RCL_SET_ERROR_MSG("timer wheel entry expired or was canceled");
+    return RCL_RET_TIMER_CANCELED;
+  }
+  rcl_timer_wheel_entry_t * entry = &impl->entries[index];
+  __timer_wheel_unplace(impl, entry);
+  __timer_wheel_release(impl, entry);
+  __timer_wheel_update(impl);
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_timer_wheel_advance(rcl_timer_wheel_t * wheel)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(wheel, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_FOR_NULL_WITH_MSG(wheel->impl, "timer wheel is invalid", return RCL_RET_TIMER_INVALID);
+  return __timer_wheel_advance(wheel->impl);
+}
+
+rcl_timer_t *
+rcl_timer_wheel_get_timer(const rcl_timer_wheel_t * wheel)
+{
+  if (NULL == wheel || NULL == wheel->impl) {
+    return NULL;
+  }
+  return &wheel->impl->timer;
+}
+
 #ifdef __cplusplus
 }
 #endif
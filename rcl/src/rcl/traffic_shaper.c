@@ -0,0 +1,139 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "./traffic_shaper.h"
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <errno.h>
+# include <time.h>
+#endif
+
+#include <math.h>
+
+#include "rcl/error_handling.h"
+#include "rcutils/time.h"
+
+#include "./collector_reporter.h"
+#include "./context_impl.h"
+
+#define RCL_TRAFFIC_SHAPING_DEFAULT_MAX_DELAY 0.01
+
+/// Nanoseconds of the monotonic clock the collectors fit their models against.
+static int64_t
+_now(void)
+{
+#ifdef _WIN32
+  rcutils_time_point_value_t now = 0;
+  (void)rcutils_steady_time_now(&now);
+  return now;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+static void
+_sleep_until(int64_t time)
+{
+#ifdef _WIN32
+  int64_t remaining = time - _now();
+  if (remaining > 0) {
+    Sleep((DWORD)((remaining + 999999) / 1000000));
+  }
+#else
+  struct timespec until = {(time_t)(time / 1000000000), (long)(time % 1000000000)};
+  while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL)) {
+  }
+#endif
+}
+
+rcl_ret_t
+rcl_traffic_shaper_init(
+  rcl_traffic_shaper_t * shaper,
+  rcl_context_t * context,
+  const rcl_traffic_shaping_options_t * options)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(shaper, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(context, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(options, RCL_RET_INVALID_ARGUMENT);
+  if (RCL_TRAFFIC_SHAPING_PACED != options->mode &&
+    RCL_TRAFFIC_SHAPING_TOKEN_BUCKET != options->mode)
+  {
+    RCL_SET_ERROR_MSG("unknown traffic shaping mode");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  if (!(options->guard_time >= 0) || !(options->max_delay >= 0)) {
+    RCL_SET_ERROR_MSG("traffic shaping times must not be negative");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  if (RCL_TRAFFIC_SHAPING_TOKEN_BUCKET == options->mode &&
+    !(options->rate > 0 && isfinite(options->rate)))
+  {
+    RCL_SET_ERROR_MSG("token bucket traffic shaping requires a positive rate");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  shaper->mode = options->mode;
+  shaper->guard_time = options->guard_time;
+  shaper->max_delay =
+    options->max_delay > 0 ? options->max_delay : RCL_TRAFFIC_SHAPING_DEFAULT_MAX_DELAY;
+  shaper->interval = 0;
+  shaper->tolerance = 0;
+  if (RCL_TRAFFIC_SHAPING_TOKEN_BUCKET == options->mode) {
+    size_t burst = options->burst > 0 ? options->burst : 1u;
+    shaper->interval = (int64_t)ceil(1e9 / options->rate);
+    shaper->tolerance = (int64_t)(burst - 1) * shaper->interval;
+  }
+  atomic_init(&shaper->next_conforming, INT64_MIN / 2);
+  shaper->reporter = context->impl->collector_reporter;
+  return RCL_RET_OK;
+}
+
+void
+rcl_traffic_shaper_wait(rcl_traffic_shaper_t * shaper)
+{
+  int64_t now = _now();
+  int64_t release = now;
+  if (RCL_TRAFFIC_SHAPING_TOKEN_BUCKET == shaper->mode) {
+    // claim the next conforming time, a message that does not conform yet waits for it
+    int64_t next_conforming;
+    rcutils_atomic_load(&shaper->next_conforming, next_conforming);
+    bool claimed = false;
+    do {
+      int64_t conforming = next_conforming - shaper->tolerance;
+      release = conforming > now ? conforming : now;
+      int64_t desired = (next_conforming > now ? next_conforming : now) + shaper->interval;
+      rcutils_atomic_compare_exchange_strong(
+        &shaper->next_conforming, claimed, &next_conforming, desired);
+    } while (!claimed);
+  }
+  double release_time = (double)release * 1e-9;
+  double start = rcl_collector_reporter_next_gap(
+    shaper->reporter, release_time, shaper->guard_time, shaper->max_delay);
+  int64_t start_ns = start > release_time ? (int64_t)ceil(start * 1e9) : release;
+  if (start_ns > now) {
+    _sleep_until(start_ns);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,80 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__TRAFFIC_SHAPER_H_
+#define RCL__TRAFFIC_SHAPER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#include "rcl/context.h"
+#include "rcl/macros.h"
+#include "rcl/traffic_shaping_options.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+#include "rcutils/stdatomic_helper.h"
+
+struct rcl_collector_reporter_t;
+
+/// Send-side shaping state of a publisher, see rcl_traffic_shaping_options_t.
+typedef struct rcl_traffic_shaper_t
+{
+  rcl_traffic_shaping_mode_t mode;
+  /// Resolved options, in seconds, guard_time `0` for the per model guard.
+  double guard_time;
+  double max_delay;
+  /// Token bucket as a virtual scheduling clock (GCRA): time between two conforming
+  /// messages and how far ahead of that clock a burst may run, in nanoseconds.
+  int64_t interval;
+  int64_t tolerance;
+  /// Time the next message conforms to the rate, advanced by every shaped publish.
+  atomic_int_least64_t next_conforming;
+  /// Reporter of the context, which knows the predicted urgent messages.
+  struct rcl_collector_reporter_t * reporter;
+} rcl_traffic_shaper_t;
+
+/// Initialize the shaper of a publisher.
+/**
+ * \param[out] shaper the shaper to initialize
+ * \param[in] context context of the publisher
+ * \param[in] options shaping options of the publisher, with a mode other than
+ *   RCL_TRAFFIC_SHAPING_NONE
+ * \return `RCL_RET_OK` if the shaper was initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid.
+ */
+RCL_LOCAL
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_traffic_shaper_init(
+  rcl_traffic_shaper_t * shaper,
+  rcl_context_t * context,
+  const rcl_traffic_shaping_options_t * options);
+
+/// Block until the next message of the publisher may be sent.
+/**
+ * Thread-safe, concurrent publishes each take their own place in the token bucket.
+ */
+RCL_LOCAL
+void
+rcl_traffic_shaper_wait(rcl_traffic_shaper_t * shaper);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__TRAFFIC_SHAPER_H_
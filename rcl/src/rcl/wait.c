@@ -22,6 +22,7 @@ extern "C"
 #include <assert.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "rcl/error_handling.h"
@@ -31,7 +32,46 @@ extern "C"
 #include "rmw/rmw.h"
 #include "rmw/event.h"
 
+#include "./collector.h"
 #include "./context_impl.h"
+#include "./event_impl.h"
+
+// rmw handles of the entities of one kind registered with a persistent wait set
+typedef struct rcl_wait_set_handles_t
+{
+  // handles packed at the front, as rmw_wait() takes them
+  void ** handles;
+  // index in the wait set of the entity of each handle
+  size_t * indices;
+  // position in handles of the entity at each index in the wait set, or SIZE_MAX
+  size_t * positions;
+  size_t count;
+} rcl_wait_set_handles_t;
+
+// entities of one kind registered with a persistent wait set
+typedef struct rcl_wait_set_registry_t
+{
+  rcl_wait_set_handles_t handles;
+  // indices freed by removals, reused before new ones
+  size_t * free_indices;
+  size_t free_count;
+  // indices of the entities found ready by the last rcl_wait()
+  size_t * ready;
+  size_t ready_count;
+} rcl_wait_set_registry_t;
+
+// timers registered with a persistent wait set, in a min-heap by key if ordered
+typedef struct rcl_wait_set_timers_t
+{
+  bool ordered;
+  // index in the wait set of each timer
+  size_t * indices;
+  // next call time of each timer when last looked at, INT64_MAX if it was canceled
+  int64_t * keys;
+  // position of the timer at each index in the wait set, or SIZE_MAX
+  size_t * positions;
+  size_t count;
+} rcl_wait_set_timers_t;
 
 typedef struct rcl_wait_set_impl_t
 {
@@ -50,6 +90,8 @@ typedef struct rcl_wait_set_impl_t
   // number of events that have been added to the wait set
   size_t event_index;
   rmw_events_t rmw_events;
+  // number of those raised by rcl, which have no place in rmw_events
+  size_t rcl_event_count;
 
   rmw_wait_set_t * rmw_wait_set;
   // number of timers that have been added to the wait set
@@ -58,6 +100,26 @@ typedef struct rcl_wait_set_impl_t
   rcl_context_t * context;
   // allocator used in the wait set
   rcl_allocator_t allocator;
+
+  // whether entities stay registered across waits, see rcl_wait_set_set_persistent()
+  bool persistent;
+  // whether rcl_wait() lists the ready entities, see rcl_wait_set_set_ready_lists()
+  bool ready_lists;
+  // registered entities of a persistent wait set, the handles of the timers
+  // being their guard conditions, if any
+  rcl_wait_set_registry_t subscription_registry;
+  rcl_wait_set_registry_t guard_condition_registry;
+  rcl_wait_set_registry_t timer_registry;
+  rcl_wait_set_registry_t client_registry;
+  rcl_wait_set_registry_t service_registry;
+  rcl_wait_set_registry_t event_registry;
+  // guard conditions of the events raised by rcl, which have no rmw event
+  rcl_wait_set_handles_t event_guard_conditions;
+  // registered timers on steady and on system clocks, ordered by next call time,
+  // and those on other clocks, whose next call time moves on time jumps
+  rcl_wait_set_timers_t steady_timers;
+  rcl_wait_set_timers_t system_timers;
+  rcl_wait_set_timers_t other_timers;
 } rcl_wait_set_impl_t;
 
 rcl_wait_set_t
@@ -215,6 +277,380 @@ rcl_wait_set_get_allocator(const rcl_wait_set_t * wait_set, rcl_allocator_t * al
   return RCL_RET_OK;
 }
 
+#define REGISTRY_REALLOCATE(Array, Capacity, Allocator) \
+  do { \
+    if (0u == (Capacity)) { \
+      if (NULL != (Array)) { \
+        (Allocator).deallocate((void *)(Array), (Allocator).state); \
+        (Array) = NULL; \
+      } \
+    } else { \
+      void * reallocated = (Allocator).reallocate( \
+        (void *)(Array), sizeof(*(Array)) * (Capacity), (Allocator).state); \
+      if (NULL == reallocated) { \
+        RCL_SET_ERROR_MSG("allocating memory failed"); \
+        return RCL_RET_BAD_ALLOC; \
+      } \
+      (Array) = reallocated; \
+    } \
+  } while (false)
+
+static rcl_ret_t
+__handles_resize(rcl_wait_set_handles_t * handles, size_t capacity, rcl_allocator_t allocator)
+{
+  handles->count = 0u;
+  REGISTRY_REALLOCATE(handles->handles, capacity, allocator);
+  REGISTRY_REALLOCATE(handles->indices, capacity, allocator);
+  REGISTRY_REALLOCATE(handles->positions, capacity, allocator);
+  if (capacity > 0u) {
+    // All bits set is SIZE_MAX, no handle.
+    memset(handles->positions, 0xff, sizeof(size_t) * capacity);
+  }
+  return RCL_RET_OK;
+}
+
+static void
+__handles_reset(rcl_wait_set_handles_t * handles)
+{
+  size_t position;
+  for (position = 0u; position < handles->count; ++position) {
+    handles->positions[handles->indices[position]] = SIZE_MAX;
+  }
+  handles->count = 0u;
+}
+
+static void
+__handles_insert(rcl_wait_set_handles_t * handles, size_t index, void * handle)
+{
+  handles->positions[index] = handles->count;
+  handles->indices[handles->count] = index;
+  handles->handles[handles->count] = handle;
+  ++handles->count;
+}
+
+// Move the last handle into the place of the removed one, keeping them packed.
+static void
+__handles_remove(rcl_wait_set_handles_t * handles, size_t index)
+{
+  const size_t position = handles->positions[index];
+  if (SIZE_MAX == position) {
+    return;
+  }
+  handles->positions[index] = SIZE_MAX;
+  const size_t last = --handles->count;
+  if (position != last) {
+    handles->handles[position] = handles->handles[last];
+    handles->indices[position] = handles->indices[last];
+    handles->positions[handles->indices[position]] = position;
+  }
+}
+
+// Copy the handles to the rmw storage, returning their number.
+static size_t
+__handles_copy(void ** storage, const rcl_wait_set_handles_t * handles)
+{
+  if (handles->count > 0u) {
+    memcpy(storage, handles->handles, sizeof(void *) * handles->count);
+  }
+  return handles->count;
+}
+
+static rcl_ret_t
+__registry_resize(
+  rcl_wait_set_registry_t * registry,
+  size_t capacity,
+  size_t ready_capacity,
+  rcl_allocator_t allocator)
+{
+  registry->free_count = 0u;
+  registry->ready_count = 0u;
+  REGISTRY_REALLOCATE(registry->free_indices, capacity, allocator);
+  REGISTRY_REALLOCATE(registry->ready, ready_capacity, allocator);
+  return __handles_resize(&registry->handles, capacity, allocator);
+}
+
+static void
+__registry_reset(rcl_wait_set_registry_t * registry)
+{
+  __handles_reset(&registry->handles);
+  registry->free_count = 0u;
+  registry->ready_count = 0u;
+}
+
+// List the entity at the index as ready, if the wait set lists them.
+static inline void
+__registry_mark_ready(rcl_wait_set_registry_t * registry, size_t index)
+{
+  if (NULL != registry->ready) {
+    registry->ready[registry->ready_count++] = index;
+  }
+}
+
+// Record the indices of the handles rmw_wait() left in the storage as ready.
+static void
+__registry_collect_ready(rcl_wait_set_registry_t * registry, void * const * storage)
+{
+  size_t position;
+  for (position = 0u; position < registry->handles.count; ++position) {
+    if (NULL != storage[position]) {
+      registry->ready[registry->ready_count++] = registry->handles.indices[position];
+    }
+  }
+}
+
+static rcl_ret_t
+__timers_resize(rcl_wait_set_timers_t * timers, size_t capacity, rcl_allocator_t allocator)
+{
+  timers->count = 0u;
+  REGISTRY_REALLOCATE(timers->indices, capacity, allocator);
+  REGISTRY_REALLOCATE(timers->keys, capacity, allocator);
+  REGISTRY_REALLOCATE(timers->positions, capacity, allocator);
+  if (capacity > 0u) {
+    memset(timers->positions, 0xff, sizeof(size_t) * capacity);
+  }
+  return RCL_RET_OK;
+}
+
+static void
+__timers_reset(rcl_wait_set_timers_t * timers)
+{
+  size_t position;
+  for (position = 0u; position < timers->count; ++position) {
+    timers->positions[timers->indices[position]] = SIZE_MAX;
+  }
+  timers->count = 0u;
+}
+
+static void
+__timers_place(rcl_wait_set_timers_t * timers, size_t position, size_t index, int64_t key)
+{
+  timers->indices[position] = index;
+  timers->keys[position] = key;
+  timers->positions[index] = position;
+}
+
+static void
+__timers_sift_up(rcl_wait_set_timers_t * timers, size_t position)
+{
+  const size_t index = timers->indices[position];
+  const int64_t key = timers->keys[position];
+  while (position > 0u) {
+    const size_t parent = (position - 1u) / 2u;
+    if (timers->keys[parent] <= key) {
+      break;
+    }
+    __timers_place(timers, position, timers->indices[parent], timers->keys[parent]);
+    position = parent;
+  }
+  __timers_place(timers, position, index, key);
+}
+
+static void
+__timers_sift_down(rcl_wait_set_timers_t * timers, size_t position)
+{
+  const size_t index = timers->indices[position];
+  const int64_t key = timers->keys[position];
+  for (;; ) {
+    size_t child = 2u * position + 1u;
+    if (child >= timers->count) {
+      break;
+    }
+    if (child + 1u < timers->count && timers->keys[child + 1u] < timers->keys[child]) {
+      ++child;
+    }
+    if (key <= timers->keys[child]) {
+      break;
+    }
+    __timers_place(timers, position, timers->indices[child], timers->keys[child]);
+    position = child;
+  }
+  __timers_place(timers, position, index, key);
+}
+
+// Give the timer at the position a new key, restoring the heap order.
+static void
+__timers_rekey(rcl_wait_set_timers_t * timers, size_t position, int64_t key)
+{
+  const int64_t old_key = timers->keys[position];
+  timers->keys[position] = key;
+  if (!timers->ordered) {
+    return;
+  }
+  if (key < old_key) {
+    __timers_sift_up(timers, position);
+  } else {
+    __timers_sift_down(timers, position);
+  }
+}
+
+static void
+__timers_insert(rcl_wait_set_timers_t * timers, size_t index, int64_t key)
+{
+  const size_t position = timers->count++;
+  __timers_place(timers, position, index, key);
+  if (timers->ordered) {
+    __timers_sift_up(timers, position);
+  }
+}
+
+// Move the last timer into the place of the removed one, restoring the heap order.
+static void
+__timers_remove(rcl_wait_set_timers_t * timers, size_t index)
+{
+  const size_t position = timers->positions[index];
+  if (SIZE_MAX == position) {
+    return;
+  }
+  timers->positions[index] = SIZE_MAX;
+  const size_t last = --timers->count;
+  if (position != last) {
+    const int64_t removed_key = timers->keys[position];
+    __timers_place(timers, position, timers->indices[last], removed_key);
+    __timers_rekey(timers, position, timers->keys[last]);
+  }
+}
+
+// Key a timer on its next call time, canceled timers coming last.
+static rcl_ret_t
+__timer_key(const rcl_timer_t * timer, int64_t * key)
+{
+  bool is_canceled = false;
+  rcl_ret_t ret = rcl_timer_is_canceled(timer, &is_canceled);
+  if (RCL_RET_OK != ret) {
+    return ret;  // The rcl error state should already be set.
+  }
+  if (is_canceled) {
+    *key = INT64_MAX;
+    return RCL_RET_OK;
+  }
+  return rcl_timer_get_next_call_time(timer, key);
+}
+
+static rcl_ret_t
+__timer_now(const rcl_timer_t * timer, int64_t * now)
+{
+  rcl_clock_t * clock = NULL;
+  // The clock is only read.
+  rcl_ret_t ret = rcl_timer_clock((rcl_timer_t *)timer, &clock);
+  if (RCL_RET_OK != ret) {
+    return ret;  // The rcl error state should already be set.
+  }
+  return rcl_clock_get_now(clock, now);
+}
+
+// Correct the key of the first timer of a heap until it matches the timer, the
+// next call time of a called timer having moved on since the timer was keyed.
+static rcl_ret_t
+__timers_fix_first(const rcl_wait_set_t * wait_set, rcl_wait_set_timers_t * timers)
+{
+  while (timers->count > 0u) {
+    int64_t key = INT64_MAX;
+    rcl_ret_t ret = __timer_key(wait_set->timers[timers->indices[0]], &key);
+    if (RCL_RET_OK != ret) {
+      return ret;
+    }
+    if (key == timers->keys[0]) {
+      break;
+    }
+    __timers_rekey(timers, 0u, key);
+  }
+  return RCL_RET_OK;
+}
+
+// List the ready timers among those of the subtree of a heap keyed at or before now.
+static rcl_ret_t
+__timers_collect_expired(
+  const rcl_wait_set_t * wait_set,
+  const rcl_wait_set_timers_t * timers,
+  size_t position,
+  int64_t now,
+  rcl_wait_set_registry_t * registry)
+{
+  if (position >= timers->count || timers->keys[position] > now) {
+    return RCL_RET_OK;
+  }
+  const size_t index = timers->indices[position];
+  int64_t key = INT64_MAX;
+  rcl_ret_t ret = __timer_key(wait_set->timers[index], &key);
+  if (RCL_RET_OK != ret) {
+    return ret;
+  }
+  if (key <= now) {
+    registry->ready[registry->ready_count++] = index;
+  }
+  ret = __timers_collect_expired(wait_set, timers, 2u * position + 1u, now, registry);
+  if (RCL_RET_OK != ret) {
+    return ret;
+  }
+  return __timers_collect_expired(wait_set, timers, 2u * position + 2u, now, registry);
+}
+
+#define REGISTRY_RESIZE(Type) \
+  do { \
+    rcl_ret_t ret = __registry_resize( \
+      &wait_set->impl->Type ## _registry, \
+      wait_set->impl->persistent ? wait_set->size_of_ ## Type ## s : 0u, \
+      wait_set->impl->persistent || wait_set->impl->ready_lists ? \
+      wait_set->size_of_ ## Type ## s : 0u, \
+      wait_set->impl->allocator); \
+    if (RCL_RET_OK != ret) { \
+      return ret; \
+    } \
+  } while (false)
+
+// Size the registries to the sets if the wait set is persistent, else free them,
+// but for the ready lists if they are enabled.
+static rcl_ret_t
+__wait_set_registries_resize(rcl_wait_set_t * wait_set)
+{
+  REGISTRY_RESIZE(subscription);
+  REGISTRY_RESIZE(guard_condition);
+  REGISTRY_RESIZE(timer);
+  REGISTRY_RESIZE(client);
+  REGISTRY_RESIZE(service);
+  REGISTRY_RESIZE(event);
+  rcl_wait_set_impl_t * impl = wait_set->impl;
+  rcl_ret_t ret = __handles_resize(
+    &impl->event_guard_conditions,
+    impl->persistent ? wait_set->size_of_events : 0u,
+    impl->allocator);
+  if (RCL_RET_OK != ret) {
+    return ret;
+  }
+  const size_t timers_capacity = impl->persistent ? wait_set->size_of_timers : 0u;
+  impl->steady_timers.ordered = true;
+  impl->system_timers.ordered = true;
+  impl->other_timers.ordered = false;
+  ret = __timers_resize(&impl->steady_timers, timers_capacity, impl->allocator);
+  if (RCL_RET_OK != ret) {
+    return ret;
+  }
+  ret = __timers_resize(&impl->system_timers, timers_capacity, impl->allocator);
+  if (RCL_RET_OK != ret) {
+    return ret;
+  }
+  return __timers_resize(&impl->other_timers, timers_capacity, impl->allocator);
+}
+
+// Timers of a persistent wait set with a clock of the timer's type.
+static rcl_wait_set_timers_t *
+__wait_set_timers_of(rcl_wait_set_impl_t * impl, const rcl_timer_t * timer)
+{
+  rcl_clock_t * clock = NULL;
+  if (RCL_RET_OK != rcl_timer_clock((rcl_timer_t *)timer, &clock)) {
+    rcl_reset_error();
+    return &impl->other_timers;
+  }
+  switch (clock->type) {
+    case RCL_STEADY_TIME:
+      return &impl->steady_timers;
+    case RCL_SYSTEM_TIME:
+      return &impl->system_timers;
+    default:
+      return &impl->other_timers;
+  }
+}
+
 #define SET_ADD(Type) \
   RCL_CHECK_ARGUMENT_FOR_NULL(wait_set, RCL_RET_INVALID_ARGUMENT); \
   if (!rcl_wait_set_is_valid(wait_set)) { \
@@ -222,11 +658,17 @@ rcl_wait_set_get_allocator(const rcl_wait_set_t * wait_set, rcl_allocator_t * al
     return RCL_RET_WAIT_SET_INVALID; \
   } \
   RCL_CHECK_ARGUMENT_FOR_NULL(Type, RCL_RET_INVALID_ARGUMENT); \
-  if (!(wait_set->impl->Type ## _index < wait_set->size_of_ ## Type ## s)) { \
+  rcl_wait_set_registry_t * registry = &wait_set->impl->Type ## _registry; \
+  size_t current_index = wait_set->impl->Type ## _index; \
+  if (wait_set->impl->persistent && registry->free_count > 0u) { \
+    /* Reuse the place of a removed entity. */ \
+    current_index = registry->free_indices[--registry->free_count]; \
+  } else if (!(current_index < wait_set->size_of_ ## Type ## s)) { \
     RCL_SET_ERROR_MSG(#Type "s set is full"); \
     return RCL_RET_WAIT_SET_FULL; \
+  } else { \
+    ++wait_set->impl->Type ## _index; \
   } \
-  size_t current_index = wait_set->impl->Type ## _index++; \
   wait_set->Type ## s[current_index] = Type; \
   /* Set optional output argument */ \
   if (NULL != index) { \
@@ -238,8 +680,31 @@ rcl_wait_set_get_allocator(const rcl_wait_set_t * wait_set, rcl_allocator_t * al
   rmw_ ## Type ## _t * rmw_handle = rcl_ ## Type ## _get_rmw_handle(Type); \
   RCL_CHECK_FOR_NULL_WITH_MSG( \
     rmw_handle, rcl_get_error_string().str, return RCL_RET_ERROR); \
-  wait_set->impl->RMWStorage[current_index] = rmw_handle->data; \
-  wait_set->impl->RMWCount++;
+  if (wait_set->impl->persistent) { \
+    __handles_insert(&registry->handles, current_index, rmw_handle->data); \
+  } else { \
+    wait_set->impl->RMWStorage[current_index] = rmw_handle->data; \
+    wait_set->impl->RMWCount++; \
+  }
+
+#define SET_REMOVE(Type) \
+  RCL_CHECK_ARGUMENT_FOR_NULL(wait_set, RCL_RET_INVALID_ARGUMENT); \
+  if (!rcl_wait_set_is_valid(wait_set)) { \
+    RCL_SET_ERROR_MSG("wait set is invalid"); \
+    return RCL_RET_WAIT_SET_INVALID; \
+  } \
+  if (!wait_set->impl->persistent) { \
+    RCL_SET_ERROR_MSG("wait set is not persistent"); \
+    return RCL_RET_INVALID_ARGUMENT; \
+  } \
+  if (!(index < wait_set->impl->Type ## _index) || NULL == wait_set->Type ## s[index]) { \
+    RCL_SET_ERROR_MSG("no " #Type " at the given index"); \
+    return RCL_RET_INVALID_ARGUMENT; \
+  } \
+  rcl_wait_set_registry_t * registry = &wait_set->impl->Type ## _registry; \
+  wait_set->Type ## s[index] = NULL; \
+  __handles_remove(&registry->handles, index); \
+  registry->free_indices[registry->free_count++] = index;
 
 #define SET_CLEAR(Type) \
   do { \
@@ -363,6 +828,20 @@ rcl_wait_set_clear(rcl_wait_set_t * wait_set)
     events,
     rmw_events.events,
     rmw_events.event_count);
+  wait_set->impl->rcl_event_count = 0;
+
+  if (wait_set->impl->persistent) {
+    __registry_reset(&wait_set->impl->subscription_registry);
+    __registry_reset(&wait_set->impl->guard_condition_registry);
+    __registry_reset(&wait_set->impl->timer_registry);
+    __registry_reset(&wait_set->impl->client_registry);
+    __registry_reset(&wait_set->impl->service_registry);
+    __registry_reset(&wait_set->impl->event_registry);
+    __handles_reset(&wait_set->impl->event_guard_conditions);
+    __timers_reset(&wait_set->impl->steady_timers);
+    __timers_reset(&wait_set->impl->system_timers);
+    __timers_reset(&wait_set->impl->other_timers);
+  }
 
   return RCL_RET_OK;
 }
@@ -394,9 +873,9 @@ rcl_wait_set_resize(
   // Guard condition RCL size is the resize amount given
   SET_RESIZE(guard_condition,;,;);  // NOLINT
 
-  // Guard condition RMW size needs to be guard conditions + timers
+  // Guard condition RMW size needs to be guard conditions + timers + events raised by rcl
   rmw_guard_conditions_t * rmw_gcs = &(wait_set->impl->rmw_guard_conditions);
-  const size_t num_rmw_gc = guard_conditions_size + timers_size;
+  const size_t num_rmw_gc = guard_conditions_size + timers_size + events_size;
   // Clear added guard conditions
   rmw_gcs->guard_condition_count = 0u;
   if (0u == num_rmw_gc) {
@@ -446,10 +925,108 @@ rcl_wait_set_resize(
     SET_RESIZE_RMW_REALLOC(
       event, rmw_events.events, rmw_events.event_count)
   );
+  wait_set->impl->rcl_event_count = 0;
+
+  if (RCL_RET_OK != __wait_set_registries_resize(wait_set)) {
+    // Leave no set larger than its registry, emptying them cannot fail.
+    rcl_ret_t ret = rcl_wait_set_resize(wait_set, 0u, 0u, 0u, 0u, 0u, 0u);
+    (void)ret;  // NO LINT
+    assert(RCL_RET_OK == ret);
+    return RCL_RET_BAD_ALLOC;
+  }
 
   return RCL_RET_OK;
 }
 
+rcl_ret_t
+rcl_wait_set_set_persistent(rcl_wait_set_t * wait_set, bool persistent)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(wait_set, RCL_RET_INVALID_ARGUMENT);
+  if (!rcl_wait_set_is_valid(wait_set)) {
+    RCL_SET_ERROR_MSG("wait set is invalid");
+    return RCL_RET_WAIT_SET_INVALID;
+  }
+  if (persistent == wait_set->impl->persistent) {
+    return RCL_RET_OK;
+  }
+  rcl_ret_t ret = rcl_wait_set_clear(wait_set);
+  if (RCL_RET_OK != ret) {
+    return ret;
+  }
+  wait_set->impl->persistent = persistent;
+  ret = __wait_set_registries_resize(wait_set);
+  if (RCL_RET_OK != ret) {
+    wait_set->impl->persistent = false;
+    rcl_ret_t fini_ret = __wait_set_registries_resize(wait_set);
+    (void)fini_ret;  // NO LINT
+    assert(RCL_RET_OK == fini_ret);  // Defensive, shouldn't fail with size 0.
+  }
+  return ret;
+}
+
+bool
+rcl_wait_set_is_persistent(const rcl_wait_set_t * wait_set)
+{
+  return rcl_wait_set_is_valid(wait_set) && wait_set->impl->persistent;
+}
+
+rcl_ret_t
+rcl_wait_set_set_ready_lists(rcl_wait_set_t * wait_set, bool enabled)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(wait_set, RCL_RET_INVALID_ARGUMENT);
+  if (!rcl_wait_set_is_valid(wait_set)) {
+    RCL_SET_ERROR_MSG("wait set is invalid");
+    return RCL_RET_WAIT_SET_INVALID;
+  }
+  if (enabled == wait_set->impl->ready_lists) {
+    return RCL_RET_OK;
+  }
+  if (wait_set->impl->persistent) {
+    // The ready lists of a persistent wait set are there already, and emptying
+    // the registries would lose the registered entities.
+    wait_set->impl->ready_lists = enabled;
+    return RCL_RET_OK;
+  }
+  wait_set->impl->ready_lists = enabled;
+  rcl_ret_t ret = __wait_set_registries_resize(wait_set);
+  if (RCL_RET_OK != ret) {
+    wait_set->impl->ready_lists = false;
+    rcl_ret_t fini_ret = __wait_set_registries_resize(wait_set);
+    (void)fini_ret;  // NO LINT
+    assert(RCL_RET_OK == fini_ret);  // Defensive, shouldn't fail with size 0.
+  }
+  return ret;
+}
+
+rcl_ret_t
+rcl_wait_set_get_ready(const rcl_wait_set_t * wait_set, rcl_wait_set_ready_t * ready)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(wait_set, RCL_RET_INVALID_ARGUMENT);
+  if (!rcl_wait_set_is_valid(wait_set)) {
+    RCL_SET_ERROR_MSG("wait set is invalid");
+    return RCL_RET_WAIT_SET_INVALID;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(ready, RCL_RET_INVALID_ARGUMENT);
+  if (!wait_set->impl->persistent && !wait_set->impl->ready_lists) {
+    RCL_SET_ERROR_MSG("wait set neither is persistent nor lists the ready entities");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  const rcl_wait_set_impl_t * impl = wait_set->impl;
+  ready->subscriptions = impl->subscription_registry.ready;
+  ready->size_of_subscriptions = impl->subscription_registry.ready_count;
+  ready->guard_conditions = impl->guard_condition_registry.ready;
+  ready->size_of_guard_conditions = impl->guard_condition_registry.ready_count;
+  ready->timers = impl->timer_registry.ready;
+  ready->size_of_timers = impl->timer_registry.ready_count;
+  ready->clients = impl->client_registry.ready;
+  ready->size_of_clients = impl->client_registry.ready_count;
+  ready->services = impl->service_registry.ready;
+  ready->size_of_services = impl->service_registry.ready_count;
+  ready->events = impl->event_registry.ready;
+  ready->size_of_events = impl->event_registry.ready_count;
+  return RCL_RET_OK;
+}
+
 rcl_ret_t
 rcl_wait_set_add_guard_condition(
   rcl_wait_set_t * wait_set,
@@ -475,11 +1052,23 @@ rcl_wait_set_add_timer(
   rcl_guard_condition_t * guard_condition = rcl_timer_get_guard_condition(timer);
   if (NULL != guard_condition) {
     // rcl_wait() will take care of moving these backwards and setting guard_condition_count.
-    const size_t index = wait_set->size_of_guard_conditions + (wait_set->impl->timer_index - 1);
+    const size_t index = wait_set->size_of_guard_conditions + current_index;
     rmw_guard_condition_t * rmw_handle = rcl_guard_condition_get_rmw_handle(guard_condition);
     RCL_CHECK_FOR_NULL_WITH_MSG(
       rmw_handle, rcl_get_error_string().str, return RCL_RET_ERROR);
-    wait_set->impl->rmw_guard_conditions.guard_conditions[index] = rmw_handle->data;
+    if (wait_set->impl->persistent) {
+      __handles_insert(&registry->handles, current_index, rmw_handle->data);
+    } else {
+      wait_set->impl->rmw_guard_conditions.guard_conditions[index] = rmw_handle->data;
+    }
+  }
+  if (wait_set->impl->persistent) {
+    int64_t key = INT64_MAX;
+    rcl_ret_t ret = __timer_key(timer, &key);
+    if (RCL_RET_OK != ret) {
+      return ret;
+    }
+    __timers_insert(__wait_set_timers_of(wait_set->impl, timer), current_index, key);
   }
   return RCL_RET_OK;
 }
@@ -513,11 +1102,264 @@ rcl_wait_set_add_event(
   size_t * index)
 {
   SET_ADD(event)
-  SET_ADD_RMW(event, rmw_events.events, rmw_events.event_count)
-  wait_set->impl->rmw_events.events[current_index] = rmw_handle;
+  if (NULL != event->impl && NULL != event->impl->collector) {
+    // rcl_wait() will wake on the collector's guard condition instead.
+    if (wait_set->impl->persistent) {
+      rmw_guard_condition_t * rmw_handle =
+        rcl_guard_condition_get_rmw_handle(event->impl->collector->anomaly_guard_condition);
+      RCL_CHECK_FOR_NULL_WITH_MSG(
+        rmw_handle, rcl_get_error_string().str, return RCL_RET_ERROR);
+      __handles_insert(&wait_set->impl->event_guard_conditions, current_index, rmw_handle->data);
+      return RCL_RET_OK;
+    }
+    wait_set->impl->rmw_events.events[current_index] = NULL;
+    ++wait_set->impl->rcl_event_count;
+    return RCL_RET_OK;
+  }
+  // rmw_wait() takes the rmw events themselves rather than their data.
+  rmw_event_t * rmw_handle = rcl_event_get_rmw_handle(event);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    rmw_handle, rcl_get_error_string().str, return RCL_RET_ERROR);
+  if (wait_set->impl->persistent) {
+    __handles_insert(&registry->handles, current_index, rmw_handle);
+  } else {
+    wait_set->impl->rmw_events.events[current_index] = rmw_handle;
+    wait_set->impl->rmw_events.event_count++;
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_remove_subscription(rcl_wait_set_t * wait_set, size_t index)
+{
+  SET_REMOVE(subscription)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_remove_guard_condition(rcl_wait_set_t * wait_set, size_t index)
+{
+  SET_REMOVE(guard_condition)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_remove_timer(rcl_wait_set_t * wait_set, size_t index)
+{
+  SET_REMOVE(timer)
+  __timers_remove(&wait_set->impl->steady_timers, index);
+  __timers_remove(&wait_set->impl->system_timers, index);
+  __timers_remove(&wait_set->impl->other_timers, index);
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_remove_client(rcl_wait_set_t * wait_set, size_t index)
+{
+  SET_REMOVE(client)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_remove_service(rcl_wait_set_t * wait_set, size_t index)
+{
+  SET_REMOVE(service)
   return RCL_RET_OK;
 }
 
+rcl_ret_t
+rcl_wait_set_remove_event(rcl_wait_set_t * wait_set, size_t index)
+{
+  SET_REMOVE(event)
+  __handles_remove(&wait_set->impl->event_guard_conditions, index);
+  return RCL_RET_OK;
+}
+
+// Forget the entities found ready by the last wait.
+static void
+__wait_set_reset_ready(rcl_wait_set_impl_t * impl)
+{
+  impl->subscription_registry.ready_count = 0u;
+  impl->guard_condition_registry.ready_count = 0u;
+  impl->timer_registry.ready_count = 0u;
+  impl->client_registry.ready_count = 0u;
+  impl->service_registry.ready_count = 0u;
+  impl->event_registry.ready_count = 0u;
+}
+
+// Fill the rmw storage with the registered handles, returning whether an event
+// raised by rcl is pending already.
+static bool
+__wait_set_restore(rcl_wait_set_t * wait_set)
+{
+  rcl_wait_set_impl_t * impl = wait_set->impl;
+  impl->rmw_subscriptions.subscriber_count = __handles_copy(
+    impl->rmw_subscriptions.subscribers, &impl->subscription_registry.handles);
+  // Guard conditions come first, then those of the timers and of the events raised by rcl.
+  void ** rmw_gcs = impl->rmw_guard_conditions.guard_conditions;
+  size_t rmw_gc_count = __handles_copy(rmw_gcs, &impl->guard_condition_registry.handles);
+  rmw_gc_count += __handles_copy(rmw_gcs + rmw_gc_count, &impl->timer_registry.handles);
+  rmw_gc_count += __handles_copy(rmw_gcs + rmw_gc_count, &impl->event_guard_conditions);
+  impl->rmw_guard_conditions.guard_condition_count = rmw_gc_count;
+  impl->rmw_clients.client_count = __handles_copy(
+    impl->rmw_clients.clients, &impl->client_registry.handles);
+  impl->rmw_services.service_count = __handles_copy(
+    impl->rmw_services.services, &impl->service_registry.handles);
+  impl->rmw_events.event_count = __handles_copy(
+    impl->rmw_events.events, &impl->event_registry.handles);
+
+  // an anomaly raised before the wait must not wait for the next one
+  bool is_rcl_event_ready = false;
+  size_t position;
+  for (position = 0u; position < impl->event_guard_conditions.count; ++position) {
+    const rcl_event_t * event = wait_set->events[impl->event_guard_conditions.indices[position]];
+    if (rcl_collector_anomaly_pending(event->impl->collector)) {
+      is_rcl_event_ready = true;
+      break;
+    }
+  }
+  return is_rcl_event_ready;
+}
+
+// Find the time until the first timer of a persistent wait set is due, reading
+// the clock once for each of the heaps.
+static rcl_ret_t
+__wait_set_timers_timeout(
+  const rcl_wait_set_t * wait_set,
+  int64_t * min_timeout,
+  bool * is_timer_timeout)
+{
+  rcl_wait_set_timers_t * heaps[] = {
+    &wait_set->impl->steady_timers, &wait_set->impl->system_timers};
+  size_t h;
+  for (h = 0u; h < sizeof(heaps) / sizeof(heaps[0]); ++h) {
+    rcl_wait_set_timers_t * timers = heaps[h];
+    rcl_ret_t ret = __timers_fix_first(wait_set, timers);
+    if (ret != RCL_RET_OK) {
+      return ret;
+    }
+    if (0u == timers->count || INT64_MAX == timers->keys[0]) {
+      continue;  // No timer, or all of them canceled.
+    }
+    int64_t now = 0;
+    ret = __timer_now(wait_set->timers[timers->indices[0]], &now);
+    if (ret != RCL_RET_OK) {
+      return ret;
+    }
+    if (timers->keys[0] - now < *min_timeout) {
+      *is_timer_timeout = true;
+      *min_timeout = timers->keys[0] - now;
+    }
+  }
+  const rcl_wait_set_timers_t * timers = &wait_set->impl->other_timers;
+  size_t position;
+  for (position = 0u; position < timers->count; ++position) {
+    const rcl_timer_t * timer = wait_set->timers[timers->indices[position]];
+    bool is_canceled = false;
+    rcl_ret_t ret = rcl_timer_is_canceled(timer, &is_canceled);
+    if (ret != RCL_RET_OK) {
+      return ret;
+    }
+    if (is_canceled) {
+      continue;
+    }
+    int64_t timer_timeout = INT64_MAX;
+    ret = rcl_timer_get_time_until_next_call(timer, &timer_timeout);
+    if (ret != RCL_RET_OK) {
+      return ret;
+    }
+    if (timer_timeout < *min_timeout) {
+      *is_timer_timeout = true;
+      *min_timeout = timer_timeout;
+    }
+  }
+  return RCL_RET_OK;
+}
+
+// List the ready timers of a persistent wait set, looking only at those of the
+// heaps due by a single reading of the clock.
+static rcl_ret_t
+__wait_set_collect_ready_timers(const rcl_wait_set_t * wait_set)
+{
+  rcl_wait_set_impl_t * impl = wait_set->impl;
+  // A timer triggers its guard condition when reset, which may bring its next
+  // call time forward, or end its cancellation.
+  void ** timer_gcs =
+    impl->rmw_guard_conditions.guard_conditions + impl->guard_condition_registry.handles.count;
+  size_t position;
+  for (position = 0u; position < impl->timer_registry.handles.count; ++position) {
+    if (NULL == timer_gcs[position]) {
+      continue;
+    }
+    const size_t index = impl->timer_registry.handles.indices[position];
+    rcl_wait_set_timers_t * timers = __wait_set_timers_of(impl, wait_set->timers[index]);
+    int64_t key = INT64_MAX;
+    rcl_ret_t ret = __timer_key(wait_set->timers[index], &key);
+    if (ret != RCL_RET_OK) {
+      return ret;
+    }
+    __timers_rekey(timers, timers->positions[index], key);
+  }
+
+  rcl_wait_set_timers_t * heaps[] = {&impl->steady_timers, &impl->system_timers};
+  size_t h;
+  for (h = 0u; h < sizeof(heaps) / sizeof(heaps[0]); ++h) {
+    rcl_wait_set_timers_t * timers = heaps[h];
+    rcl_ret_t ret = __timers_fix_first(wait_set, timers);
+    if (ret != RCL_RET_OK) {
+      return ret;
+    }
+    if (0u == timers->count || INT64_MAX == timers->keys[0]) {
+      continue;
+    }
+    int64_t now = 0;
+    ret = __timer_now(wait_set->timers[timers->indices[0]], &now);
+    if (ret != RCL_RET_OK) {
+      return ret;
+    }
+    ret = __timers_collect_expired(wait_set, timers, 0u, now, &impl->timer_registry);
+    if (ret != RCL_RET_OK) {
+      return ret;
+    }
+  }
+
+  const rcl_wait_set_timers_t * timers = &impl->other_timers;
+  for (position = 0u; position < timers->count; ++position) {
+    const size_t index = timers->indices[position];
+    bool is_ready = false;
+    rcl_ret_t ret = rcl_timer_is_ready(wait_set->timers[index], &is_ready);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+    if (is_ready) {
+      impl->timer_registry.ready[impl->timer_registry.ready_count++] = index;
+    }
+  }
+  return RCL_RET_OK;
+}
+
+// Record the entities of a persistent wait set left ready by rmw_wait().
+static rcl_ret_t
+__wait_set_collect_ready(rcl_wait_set_t * wait_set, bool * is_rcl_event_ready)
+{
+  rcl_wait_set_impl_t * impl = wait_set->impl;
+  __registry_collect_ready(&impl->subscription_registry, impl->rmw_subscriptions.subscribers);
+  __registry_collect_ready(
+    &impl->guard_condition_registry, impl->rmw_guard_conditions.guard_conditions);
+  __registry_collect_ready(&impl->client_registry, impl->rmw_clients.clients);
+  __registry_collect_ready(&impl->service_registry, impl->rmw_services.services);
+  __registry_collect_ready(&impl->event_registry, impl->rmw_events.events);
+  size_t position;
+  for (position = 0u; position < impl->event_guard_conditions.count; ++position) {
+    const size_t index = impl->event_guard_conditions.indices[position];
+    if (rcl_collector_anomaly_pending(wait_set->events[index]->impl->collector)) {
+      impl->event_registry.ready[impl->event_registry.ready_count++] = index;
+      *is_rcl_event_ready = true;
+    }
+  }
+  return __wait_set_collect_ready_timers(wait_set);
+}
+
 rcl_ret_t
 rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
 {
@@ -542,9 +1384,21 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
   rmw_time_t * timeout_argument = NULL;
   rmw_time_t temporary_timeout_storage;
 
+  // A persistent wait set restores the handles rmw_wait() pruned the last time.
+  bool is_rcl_event_ready = false;
+  __wait_set_reset_ready(wait_set->impl);
+  if (wait_set->impl->persistent) {
+    is_rcl_event_ready = __wait_set_restore(wait_set);
+  }
+
   bool is_timer_timeout = false;
   int64_t min_timeout = timeout > 0 ? timeout : INT64_MAX;
-  {  // scope to prevent i from colliding below
+  if (wait_set->impl->persistent) {
+    rcl_ret_t ret = __wait_set_timers_timeout(wait_set, &min_timeout, &is_timer_timeout);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+  } else {  // scope to prevent i from colliding below
     uint64_t i = 0;
     for (i = 0; i < wait_set->impl->timer_index; ++i) {
       if (!wait_set->timers[i]) {
@@ -581,7 +1435,37 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
     }
   }
 
-  if (timeout == 0) {
+  // Events raised by rcl wait on guard conditions, and the rmw events are moved
+  // forward to make a legal wait set, to be moved back once waited on.
+  if (wait_set->impl->rcl_event_count > 0) {
+    rmw_guard_conditions_t * rmw_gcs = &(wait_set->impl->rmw_guard_conditions);
+    void ** rmw_events = wait_set->impl->rmw_events.events;
+    size_t rmw_event_count = 0u;
+    size_t i;
+    for (i = 0; i < wait_set->impl->event_index; ++i) {
+      const rcl_event_t * event = wait_set->events[i];
+      if (NULL == event) {
+        continue;
+      }
+      struct rcl_collector_t * collector = event->impl->collector;
+      if (NULL == collector) {
+        rmw_events[rmw_event_count++] = rmw_events[i];
+        continue;
+      }
+      // an anomaly raised before the wait must not wait for the next one
+      if (rcl_collector_anomaly_pending(collector)) {
+        is_rcl_event_ready = true;
+      }
+      rmw_guard_condition_t * rmw_handle =
+        rcl_guard_condition_get_rmw_handle(collector->anomaly_guard_condition);
+      RCL_CHECK_FOR_NULL_WITH_MSG(
+        rmw_handle, rcl_get_error_string().str, return RCL_RET_ERROR);
+      rmw_gcs->guard_conditions[rmw_gcs->guard_condition_count] = rmw_handle->data;
+      ++(rmw_gcs->guard_condition_count);
+    }
+  }
+
+  if (timeout == 0 || is_rcl_event_ready) {
     // Then it is non-blocking, so set the temporary storage to 0, 0 and pass it.
     temporary_timeout_storage.sec = 0;
     temporary_timeout_storage.nsec = 0;
@@ -615,6 +1499,21 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
     wait_set->impl->rmw_wait_set,
     timeout_argument);
 
+  if (wait_set->impl->persistent) {
+    if (ret != RMW_RET_OK && ret != RMW_RET_TIMEOUT) {
+      RCL_SET_ERROR_MSG(rmw_get_error_string().str);
+      return RCL_RET_ERROR;
+    }
+    rcl_ret_t collect_ret = __wait_set_collect_ready(wait_set, &is_rcl_event_ready);
+    if (RCL_RET_OK != collect_ret) {
+      return collect_ret;
+    }
+    if (RMW_RET_TIMEOUT == ret && !is_timer_timeout && !is_rcl_event_ready) {
+      return RCL_RET_TIMEOUT;
+    }
+    return RCL_RET_OK;
+  }
+
   // Items that are not ready will have been set to NULL by rmw_wait.
   // We now update our handles accordingly.
 
@@ -633,6 +1532,8 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
     RCUTILS_LOG_DEBUG_EXPRESSION_NAMED(is_ready, ROS_PACKAGE_NAME, "Timer in wait set is ready");
     if (!is_ready) {
       wait_set->timers[i] = NULL;
+    } else {
+      __registry_mark_ready(&wait_set->impl->timer_registry, i);
     }
   }
   // Check for timeout, return RCL_RET_TIMEOUT only if it wasn't a timer.
@@ -647,6 +1548,8 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
       is_ready, ROS_PACKAGE_NAME, "Subscription in wait set is ready");
     if (!is_ready) {
       wait_set->subscriptions[i] = NULL;
+    } else {
+      __registry_mark_ready(&wait_set->impl->subscription_registry, i);
     }
   }
   // Set corresponding rcl guard_condition handles NULL.
@@ -656,6 +1559,8 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
       is_ready, ROS_PACKAGE_NAME, "Guard condition in wait set is ready");
     if (!is_ready) {
       wait_set->guard_conditions[i] = NULL;
+    } else {
+      __registry_mark_ready(&wait_set->impl->guard_condition_registry, i);
     }
   }
   // Set corresponding rcl client handles NULL.
@@ -664,6 +1569,8 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
     RCUTILS_LOG_DEBUG_EXPRESSION_NAMED(is_ready, ROS_PACKAGE_NAME, "Client in wait set is ready");
     if (!is_ready) {
       wait_set->clients[i] = NULL;
+    } else {
+      __registry_mark_ready(&wait_set->impl->client_registry, i);
     }
   }
   // Set corresponding rcl service handles NULL.
@@ -672,18 +1579,40 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
     RCUTILS_LOG_DEBUG_EXPRESSION_NAMED(is_ready, ROS_PACKAGE_NAME, "Service in wait set is ready");
     if (!is_ready) {
       wait_set->services[i] = NULL;
+    } else {
+      __registry_mark_ready(&wait_set->impl->service_registry, i);
+    }
+  }
+  // Move the rmw events back to the index of their rcl event.
+  if (wait_set->impl->rcl_event_count > 0) {
+    void ** rmw_events = wait_set->impl->rmw_events.events;
+    size_t rmw_event_count = wait_set->impl->rmw_events.event_count;
+    for (i = wait_set->impl->event_index; i-- > 0; ) {
+      const rcl_event_t * event = wait_set->events[i];
+      if (NULL != event && NULL == event->impl->collector) {
+        rmw_events[i] = rmw_events[--rmw_event_count];
+      } else {
+        rmw_events[i] = NULL;
+      }
     }
   }
   // Set corresponding rcl event handles NULL.
   for (i = 0; i < wait_set->size_of_events; ++i) {
+    const rcl_event_t * event = wait_set->events[i];
     bool is_ready = wait_set->impl->rmw_events.events[i] != NULL;
+    if (NULL != event && NULL != event->impl->collector) {
+      is_ready = rcl_collector_anomaly_pending(event->impl->collector);
+      is_rcl_event_ready = is_rcl_event_ready || is_ready;
+    }
     RCUTILS_LOG_DEBUG_EXPRESSION_NAMED(is_ready, ROS_PACKAGE_NAME, "Event in wait set is ready");
     if (!is_ready) {
       wait_set->events[i] = NULL;
+    } else {
+      __registry_mark_ready(&wait_set->impl->event_registry, i);
     }
   }
 
-  if (RMW_RET_TIMEOUT == ret && !is_timer_timeout) {
+  if (RMW_RET_TIMEOUT == ret && !is_timer_timeout && !is_rcl_event_ready) {
     return RCL_RET_TIMEOUT;
   }
   return RCL_RET_OK;
@@ -0,0 +1,252 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "rcl/work_deque.h"
+
+#include <stdint.h>
+
+#include "rcl/error_handling.h"
+#include "rcutils/stdatomic_helper.h"
+
+// Bytes between the two ends of a deque, so that they don't share a cache line.
+#define RCL_WORK_DEQUE_CACHE_LINE_SIZE 64
+
+typedef struct rcl_work_deque_buffer_t
+{
+  // The capacity minus one, the capacity being a power of two.
+  size_t mask;
+  atomic_uintptr_t * items;
+  // The buffer this one replaced.
+  struct rcl_work_deque_buffer_t * previous;
+} rcl_work_deque_buffer_t;
+
+typedef struct rcl_work_deque_impl_t
+{
+  // Index of the oldest item, advanced by the thread taking it.
+  atomic_int_least64_t top;
+  char padding[RCL_WORK_DEQUE_CACHE_LINE_SIZE];
+  // Index after the newest item, only written by the owner.
+  atomic_int_least64_t bottom;
+  // The current rcl_work_deque_buffer_t.
+  atomic_uintptr_t buffer;
+  rcl_allocator_t allocator;
+} rcl_work_deque_impl_t;
+
+static void
+__work_deque_buffers_destroy(rcl_work_deque_buffer_t * buffer, const rcl_allocator_t * allocator)
+{
+  while (NULL != buffer) {
+    rcl_work_deque_buffer_t * previous = buffer->previous;
+    allocator->deallocate(buffer->items, allocator->state);
+    allocator->deallocate(buffer, allocator->state);
+    buffer = previous;
+  }
+}
+
+static rcl_work_deque_buffer_t *
+__work_deque_buffer_create(size_t capacity, const rcl_allocator_t * allocator)
+{
+  rcl_work_deque_buffer_t * buffer = (rcl_work_deque_buffer_t *)allocator->allocate(
+    sizeof(rcl_work_deque_buffer_t), allocator->state);
+  if (NULL == buffer) {
+    return NULL;
+  }
+  buffer->items = (atomic_uintptr_t *)allocator->allocate(
+    capacity * sizeof(atomic_uintptr_t), allocator->state);
+  if (NULL == buffer->items) {
+    allocator->deallocate(buffer, allocator->state);
+    return NULL;
+  }
+  for (size_t i = 0u; i < capacity; ++i) {
+    atomic_init(&buffer->items[i], 0u);
+  }
+  buffer->mask = capacity - 1u;
+  buffer->previous = NULL;
+  return buffer;
+}
+
+rcl_work_deque_t
+rcl_get_zero_initialized_work_deque(void)
+{
+  static rcl_work_deque_t null_work_deque = {0};
+  return null_work_deque;
+}
+
+rcl_ret_t
+rcl_work_deque_init(rcl_work_deque_t * deque, size_t capacity, rcl_allocator_t allocator)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(deque, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ALLOCATOR_WITH_MSG(&allocator, "invalid allocator", return RCL_RET_INVALID_ARGUMENT);
+  if (NULL != deque->impl) {
+    RCL_SET_ERROR_MSG("work deque already initialized, or memory was uninitialized");
+    return RCL_RET_ALREADY_INIT;
+  }
+  if (0u == capacity || capacity > (SIZE_MAX / sizeof(atomic_uintptr_t)) / 4u) {
+    RCL_SET_ERROR_MSG("work deque capacity is out of range");
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  size_t rounded_capacity = 1u;
+  while (rounded_capacity < capacity) {
+    rounded_capacity <<= 1u;
+  }
+  rcl_work_deque_impl_t * impl = (rcl_work_deque_impl_t *)allocator.allocate(
+    sizeof(rcl_work_deque_impl_t), allocator.state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(impl, "allocating memory failed", return RCL_RET_BAD_ALLOC);
+  rcl_work_deque_buffer_t * buffer = __work_deque_buffer_create(rounded_capacity, &allocator);
+  if (NULL == buffer) {
+    allocator.deallocate(impl, allocator.state);
+    RCL_SET_ERROR_MSG("allocating memory failed");
+    return RCL_RET_BAD_ALLOC;
+  }
+  atomic_init(&impl->top, 0);
+  atomic_init(&impl->bottom, 0);
+  atomic_init(&impl->buffer, (uintptr_t)buffer);
+  impl->allocator = allocator;
+  deque->impl = impl;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_work_deque_fini(rcl_work_deque_t * deque)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(deque, RCL_RET_INVALID_ARGUMENT);
+  if (NULL == deque->impl) {
+    return RCL_RET_OK;
+  }
+  rcl_allocator_t allocator = deque->impl->allocator;
+  __work_deque_buffers_destroy(
+    (rcl_work_deque_buffer_t *)atomic_load_explicit(&deque->impl->buffer, memory_order_relaxed),
+    &allocator);
+  allocator.deallocate(deque->impl, allocator.state);
+  deque->impl = NULL;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_work_deque_push(rcl_work_deque_t * deque, void * item)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(deque, RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    deque->impl, "work deque is invalid", return RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(item, RCL_RET_INVALID_ARGUMENT);
+  rcl_work_deque_impl_t * impl = deque->impl;
+  const int_least64_t bottom = atomic_load_explicit(&impl->bottom, memory_order_relaxed);
+  const int_least64_t top = atomic_load_explicit(&impl->top, memory_order_acquire);
+  rcl_work_deque_buffer_t * buffer =
+    (rcl_work_deque_buffer_t *)atomic_load_explicit(&impl->buffer, memory_order_relaxed);
+  if ((uint64_t)(bottom - top) > buffer->mask) {
+    if (buffer->mask >= (SIZE_MAX / sizeof(atomic_uintptr_t)) / 2u) {
+      RCL_SET_ERROR_MSG("work deque cannot grow any further");
+      return RCL_RET_BAD_ALLOC;
+    }
+    rcl_work_deque_buffer_t * grown =
+      __work_deque_buffer_create(2u * (buffer->mask + 1u), &impl->allocator);
+    RCL_CHECK_FOR_NULL_WITH_MSG(grown, "allocating memory failed", return RCL_RET_BAD_ALLOC);
+    for (int_least64_t i = top; i < bottom; ++i) {
+      atomic_store_explicit(
+        &grown->items[(size_t)i & grown->mask],
+        atomic_load_explicit(&buffer->items[(size_t)i & buffer->mask], memory_order_relaxed),
+        memory_order_relaxed);
+    }
+    grown->previous = buffer;
+    atomic_store_explicit(&impl->buffer, (uintptr_t)grown, memory_order_release);
+    buffer = grown;
+  }
+  atomic_store_explicit(
+    &buffer->items[(size_t)bottom & buffer->mask], (uintptr_t)item, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&impl->bottom, bottom + 1, memory_order_relaxed);
+  return RCL_RET_OK;
+}
+
+bool
+rcl_work_deque_pop(rcl_work_deque_t * deque, void ** item)
+{
+  if (NULL == deque || NULL == deque->impl || NULL == item) {
+    return false;
+  }
+  rcl_work_deque_impl_t * impl = deque->impl;
+  const int_least64_t bottom = atomic_load_explicit(&impl->bottom, memory_order_relaxed) - 1;
+  rcl_work_deque_buffer_t * buffer =
+    (rcl_work_deque_buffer_t *)atomic_load_explicit(&impl->buffer, memory_order_relaxed);
+  // Claim the newest item before looking whether thieves took it.
+  atomic_store_explicit(&impl->bottom, bottom, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  int_least64_t top = atomic_load_explicit(&impl->top, memory_order_relaxed);
+  if (top > bottom) {
+    atomic_store_explicit(&impl->bottom, bottom + 1, memory_order_relaxed);
+    return false;
+  }
+  const uintptr_t value =
+    atomic_load_explicit(&buffer->items[(size_t)bottom & buffer->mask], memory_order_relaxed);
+  if (top == bottom) {
+    // The last item, thieves race for it too.
+    const bool won = atomic_compare_exchange_strong_explicit(
+      &impl->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+    atomic_store_explicit(&impl->bottom, bottom + 1, memory_order_relaxed);
+    if (!won) {
+      return false;
+    }
+  }
+  *item = (void *)value;
+  return true;
+}
+
+bool
+rcl_work_deque_steal(rcl_work_deque_t * deque, void ** item)
+{
+  if (NULL == deque || NULL == deque->impl || NULL == item) {
+    return false;
+  }
+  rcl_work_deque_impl_t * impl = deque->impl;
+  int_least64_t top = atomic_load_explicit(&impl->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  const int_least64_t bottom = atomic_load_explicit(&impl->bottom, memory_order_acquire);
+  if (top >= bottom) {
+    return false;
+  }
+  // Outgrown buffers are still valid, and hold the same item at the top.
+  rcl_work_deque_buffer_t * buffer =
+    (rcl_work_deque_buffer_t *)atomic_load_explicit(&impl->buffer, memory_order_acquire);
+  const uintptr_t value =
+    atomic_load_explicit(&buffer->items[(size_t)top & buffer->mask], memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit(
+      &impl->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+  {
+    return false;
+  }
+  *item = (void *)value;
+  return true;
+}
+
+size_t
+rcl_work_deque_size(const rcl_work_deque_t * deque)
+{
+  if (NULL == deque || NULL == deque->impl) {
+    return 0u;
+  }
+  rcl_work_deque_impl_t * impl = deque->impl;
+  const int_least64_t bottom = atomic_load_explicit(&impl->bottom, memory_order_relaxed);
+  const int_least64_t top = atomic_load_explicit(&impl->top, memory_order_relaxed);
+  return bottom > top ? (size_t)(bottom - top) : 0u;
+}
+
+#ifdef __cplusplus
+}
+#endif
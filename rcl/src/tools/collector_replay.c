@@ -0,0 +1,206 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replay a recorded message trace through the collector's traffic model fitter.
+//
+// The trace is CSV, one message per line as `time,size[,...]`, with the time in
+// nanoseconds if it is an integer, in seconds otherwise, and the serialized size
+// in bytes; lines that do not parse, such as a header, are skipped.
+// Every model update is written to stdout as CSV, the main model first with an
+// empty component column, followed by the components of composite models.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rcl/allocator.h"
+#include "rcl/collector_replay.h"
+#include "rcl/error_handling.h"
+#include "rcutils/time.h"
+
+#define BATCH_SIZE 65536
+#define LINE_LENGTH 1024
+
+static void
+print_usage(const char * name)
+{
+  fprintf(
+    stderr,
+    "usage: %s [options] [trace.csv]\n"
+    "Reads the trace from stdin if no file is given. Options, 0 or unset for the\n"
+    "ROS_TRAFFIC_MODEL_* environment variable or built-in default:\n"
+    "  --history-length N\n"
+    "  --warmup N\n"
+    "  --model-freshness SECONDS\n"
+    "  --predictable-threshold X\n"
+    "  --max-period-components N\n"
+    "  --sampling N              collect 1 in N messages, as a collector policy rule would\n",
+    name);
+}
+
+static void
+print_update(const rcl_collector_replay_update_t * update, void * state)
+{
+  size_t * update_count = (size_t *)state;
+  ++*update_count;
+  printf(
+    "%zu,%.9f,,%.9g,%.9f,%.9g,%.9g,%.9g\n", update->sample, update->time,
+    update->a, update->b, update->sigma_t, update->s, update->sigma_s);
+  for (size_t r = 0; r < update->component_count; ++r) {
+    const rcl_collector_replay_component_t * component = &update->components[r];
+    printf(
+      "%zu,%.9f,%zu,%.9g,%.9f,%.9g,%.9g,%.9g\n", update->sample, update->time, r,
+      update->cycle, component->b, component->sigma_t, component->s, component->sigma_s);
+  }
+}
+
+// parse `time,size`, the time in nanoseconds if integer, in seconds otherwise
+static bool
+parse_line(const char * line, int64_t * time, size_t * size)
+{
+  char * end = NULL;
+  const char * comma = strchr(line, ',');
+  if (NULL == comma) {
+    return false;
+  }
+  const char * fraction = strpbrk(line, ".eE");
+  if (NULL != fraction && fraction < comma) {
+    double seconds = strtod(line, &end);
+    if (end != comma || !isfinite(seconds)) {
+      return false;
+    }
+    *time = llround(seconds * 1e9);
+  } else {
+    long long nanoseconds = strtoll(line, &end, 10);  // NOLINT(runtime/int)
+    if (end != comma) {
+      return false;
+    }
+    *time = (int64_t)nanoseconds;
+  }
+  unsigned long long bytes = strtoull(comma + 1, &end, 10);  // NOLINT(runtime/int)
+  if (end == comma + 1 || (*end != '\0' && *end != ',' && *end != '\n' && *end != '\r')) {
+    return false;
+  }
+  *size = (size_t)bytes;
+  return true;
+}
+
+int
+main(int argc, char ** argv)
+{
+  rcl_collector_options_t options = {0, 0, 0.0, 0.0, 0};
+  size_t sampling = 1u;
+  const char * path = NULL;
+  for (int i = 1; i < argc; ++i) {
+    const char * arg = argv[i];
+    const char * value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (0 == strcmp(arg, "-h") || 0 == strcmp(arg, "--help")) {
+      print_usage(argv[0]);
+      return 0;
+    } else if ('-' != arg[0] || 0 == strcmp(arg, "-")) {
+      path = arg;
+      continue;
+    } else if (NULL == value) {
+      print_usage(argv[0]);
+      return 1;
+    } else if (0 == strcmp(arg, "--history-length")) {
+      options.history_length = strtoul(value, NULL, 10);
+    } else if (0 == strcmp(arg, "--warmup")) {
+      options.warmup = strtoul(value, NULL, 10);
+    } else if (0 == strcmp(arg, "--model-freshness")) {
+      options.model_freshness = strtod(value, NULL);
+    } else if (0 == strcmp(arg, "--predictable-threshold")) {
+      options.predictable_threshold = strtod(value, NULL);
+    } else if (0 == strcmp(arg, "--max-period-components")) {
+      options.max_period_components = strtoul(value, NULL, 10);
+    } else if (0 == strcmp(arg, "--sampling")) {
+      sampling = strtoul(value, NULL, 10);
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+    ++i;
+  }
+
+  FILE * trace = stdin;
+  if (NULL != path && 0 != strcmp(path, "-")) {
+    trace = fopen(path, "r");
+    if (NULL == trace) {
+      fprintf(stderr, "Failed to open '%s'\n", path);
+      return 1;
+    }
+  }
+
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  int64_t * times = allocator.allocate(BATCH_SIZE * sizeof(int64_t), allocator.state);
+  size_t * sizes = allocator.allocate(BATCH_SIZE * sizeof(size_t), allocator.state);
+  size_t update_count = 0u;
+  rcl_collector_replay_t replay = rcl_get_zero_initialized_collector_replay();
+  rcl_ret_t ret = RCL_RET_BAD_ALLOC;
+  if (NULL != times && NULL != sizes) {
+    ret = rcl_collector_replay_init(
+      &replay, &options, sampling, print_update, &update_count, allocator);
+  }
+  if (RCL_RET_OK != ret) {
+    fprintf(stderr, "Failed to initialize the replay: %s\n", rcl_get_error_string().str);
+  }
+
+  size_t sample_count = 0u;
+  size_t skipped_count = 0u;
+  rcutils_time_point_value_t start = 0;
+  rcutils_time_point_value_t end = 0;
+  (void)rcutils_steady_time_now(&start);
+  if (RCL_RET_OK == ret) {
+    printf("sample,time,component,period,phase,sigma_t,s,sigma_s\n");
+    char line[LINE_LENGTH];
+    size_t count = 0u;
+    bool more = true;
+    while (more && RCL_RET_OK == ret) {
+      more = NULL != fgets(line, sizeof(line), trace);
+      if (more && '#' != line[0] && parse_line(line, &times[count], &sizes[count])) {
+        ++count;
+      } else if (more) {
+        ++skipped_count;
+      }
+      if (count == BATCH_SIZE || (!more && count > 0u)) {
+        ret = rcl_collector_replay_feed(&replay, times, sizes, count);
+        sample_count += count;
+        count = 0u;
+      }
+    }
+    if (RCL_RET_OK != ret) {
+      fprintf(stderr, "Failed to replay the trace: %s\n", rcl_get_error_string().str);
+    }
+  }
+  (void)rcutils_steady_time_now(&end);
+
+  if (RCL_RET_OK != rcl_collector_replay_fini(&replay)) {
+    rcl_reset_error();
+  }
+  allocator.deallocate(times, allocator.state);
+  allocator.deallocate(sizes, allocator.state);
+  if (stdin != trace) {
+    fclose(trace);
+  }
+  if (RCL_RET_OK == ret) {
+    double elapsed = (double)(end - start) * 1e-9;
+    fprintf(
+      stderr, "%zu samples, %zu lines skipped, %zu model updates in %.3f s (%.0f samples/s)\n",
+      sample_count, skipped_count, update_count, elapsed,
+      elapsed > 0.0 ? (double)sample_count / elapsed : 0.0);
+  }
+  return RCL_RET_OK == ret ? 0 : 1;
+}
@@ -0,0 +1,288 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "performance_test_fixture/performance_test_fixture.hpp"
+
+#include "rcl/error_handling.h"
+#include "rcl/rcl.h"
+#include "rcutils/env.h"
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+#include "rosidl_runtime_c/primitives_sequence_functions.h"
+#include "test_msgs/msg/unbounded_sequences.h"
+
+#include "../mocking_utils/patch.hpp"
+
+// Collector overhead on the publish paths.
+// The middleware publish functions are replaced by stand-ins returning right away, so only
+// rcl's own work is measured and nothing goes out on the network.
+// Topics starting with "urg_" get a collector from the default collector policy.
+
+namespace
+{
+constexpr int64_t kMinSize = 16;
+constexpr int64_t kMaxSize = 4 << 20;
+constexpr size_t kBatchSize = 64;
+
+class PublishPerformanceTest : public performance_test_fixture::PerformanceTest
+{
+public:
+  void SetUp(benchmark::State & st) override
+  {
+    // TearDown runs even if setting up fails, it must find everything in a known state
+    context = rcl_get_zero_initialized_context();
+    node = rcl_get_zero_initialized_node();
+    test_msgs__msg__UnboundedSequences__init(&msg);
+    serialized_msg = rmw_get_zero_initialized_serialized_message();
+    if (!rcutils_set_env("ROS_MACHINE_ID", "benchmark_publish")) {
+      st.SkipWithError("failed to set ROS_MACHINE_ID");
+      return;
+    }
+    rcl_init_options_t init_options = rcl_get_zero_initialized_init_options();
+    rcl_ret_t ret = rcl_init_options_init(&init_options, rcl_get_default_allocator());
+    if (RCL_RET_OK != ret) {
+      st.SkipWithError(rcl_get_error_string().str);
+      return;
+    }
+    ret = rcl_init(0, nullptr, &init_options, &context);
+    if (RCL_RET_OK != rcl_init_options_fini(&init_options) || RCL_RET_OK != ret) {
+      st.SkipWithError(rcl_get_error_string().str);
+      return;
+    }
+    rcl_node_options_t node_options = rcl_node_get_default_options();
+    if (RCL_RET_OK != rcl_node_init(&node, "benchmark_publish_node", "", &context, &node_options)) {
+      st.SkipWithError(rcl_get_error_string().str);
+      return;
+    }
+    if (!rosidl_runtime_c__uint8__Sequence__init(&msg.uint8_values, st.range(0))) {
+      st.SkipWithError("failed to allocate the message payload");
+      return;
+    }
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    if (RMW_RET_OK != rmw_serialized_message_init(&serialized_msg, 0u, &allocator) ||
+      RMW_RET_OK != rmw_serialize(&msg, ts, &serialized_msg))
+    {
+      st.SkipWithError(rmw_get_error_string().str);
+      return;
+    }
+    performance_test_fixture::PerformanceTest::SetUp(st);
+  }
+
+  void TearDown(benchmark::State & st) override
+  {
+    performance_test_fixture::PerformanceTest::TearDown(st);
+    (void)rmw_serialized_message_fini(&serialized_msg);
+    test_msgs__msg__UnboundedSequences__fini(&msg);
+    if (RCL_RET_OK != rcl_node_fini(&node) || RCL_RET_OK != rcl_shutdown(&context) ||
+      RCL_RET_OK != rcl_context_fini(&context))
+    {
+      rcl_reset_error();
+    }
+    rcutils_set_env("ROS_MACHINE_ID", NULL);
+  }
+
+  bool init_publisher(benchmark::State & st, rcl_publisher_t * publisher, const char * topic)
+  {
+    *publisher = rcl_get_zero_initialized_publisher();
+    rcl_publisher_options_t options = rcl_publisher_get_default_options();
+    if (RCL_RET_OK != rcl_publisher_init(publisher, &node, ts, topic, &options)) {
+      st.SkipWithError(rcl_get_error_string().str);
+      return false;
+    }
+    return true;
+  }
+
+  void fini_publisher(benchmark::State & st, rcl_publisher_t * publisher)
+  {
+    if (RCL_RET_OK != rcl_publisher_fini(publisher, &node)) {
+      st.SkipWithError(rcl_get_error_string().str);
+    }
+  }
+
+  void publish(benchmark::State & st, const char * topic)
+  {
+    // collected messages of types without size estimator are published serialized
+    auto patch = mocking_utils::patch_and_return("lib:rcl", rmw_publish, RMW_RET_OK);
+    auto serialized_patch = mocking_utils::patch_and_return(
+      "lib:rcl", rmw_publish_serialized_message, RMW_RET_OK);
+    rcl_publisher_t publisher;
+    if (!init_publisher(st, &publisher, topic)) {
+      return;
+    }
+    reset_heap_counters();
+    for (auto _ : st) {
+      if (RCL_RET_OK != rcl_publish(&publisher, &msg, nullptr)) {
+        st.SkipWithError(rcl_get_error_string().str);
+        break;
+      }
+    }
+    st.SetBytesProcessed(st.iterations() * st.range(0));
+    fini_publisher(st, &publisher);
+  }
+
+  void publish_batch(benchmark::State & st, const char * topic, bool batched)
+  {
+    // each iteration publishes the same batch, one by one or at once
+    auto patch = mocking_utils::patch_and_return("lib:rcl", rmw_publish, RMW_RET_OK);
+    auto serialized_patch = mocking_utils::patch_and_return(
+      "lib:rcl", rmw_publish_serialized_message, RMW_RET_OK);
+    rcl_publisher_t publisher;
+    if (!init_publisher(st, &publisher, topic)) {
+      return;
+    }
+    const void * messages[kBatchSize];
+    for (size_t i = 0; i < kBatchSize; ++i) {
+      messages[i] = &msg;
+    }
+    reset_heap_counters();
+    for (auto _ : st) {
+      rcl_ret_t ret = RCL_RET_OK;
+      if (batched) {
+        ret = rcl_publish_batch(&publisher, messages, kBatchSize, nullptr, nullptr);
+      } else {
+        for (size_t i = 0; i < kBatchSize && RCL_RET_OK == ret; ++i) {
+          ret = rcl_publish(&publisher, messages[i], nullptr);
+        }
+      }
+      if (RCL_RET_OK != ret) {
+        st.SkipWithError(rcl_get_error_string().str);
+        break;
+      }
+    }
+    st.SetItemsProcessed(st.iterations() * kBatchSize);
+    st.SetBytesProcessed(st.iterations() * kBatchSize * st.range(0));
+    fini_publisher(st, &publisher);
+  }
+
+  void publish_serialized(benchmark::State & st, const char * topic)
+  {
+    // traffic model reports go through rmw_publish
+    auto report_patch = mocking_utils::patch_and_return("lib:rcl", rmw_publish, RMW_RET_OK);
+    auto patch = mocking_utils::patch_and_return(
+      "lib:rcl", rmw_publish_serialized_message, RMW_RET_OK);
+    rcl_publisher_t publisher;
+    if (!init_publisher(st, &publisher, topic)) {
+      return;
+    }
+    reset_heap_counters();
+    for (auto _ : st) {
+      if (RCL_RET_OK != rcl_publish_serialized_message(&publisher, &serialized_msg, nullptr)) {
+        st.SkipWithError(rcl_get_error_string().str);
+        break;
+      }
+    }
+    st.SetBytesProcessed(st.iterations() * st.range(0));
+    fini_publisher(st, &publisher);
+  }
+
+  void publish_loaned(benchmark::State & st, const char * topic)
+  {
+    // the message stands in for a loan, the middleware never sees it
+    auto report_patch = mocking_utils::patch_and_return("lib:rcl", rmw_publish, RMW_RET_OK);
+    auto patch = mocking_utils::patch_and_return(
+      "lib:rcl", rmw_publish_loaned_message, RMW_RET_OK);
+    rcl_publisher_t publisher;
+    if (!init_publisher(st, &publisher, topic)) {
+      return;
+    }
+    reset_heap_counters();
+    for (auto _ : st) {
+      if (RCL_RET_OK != rcl_publish_loaned_message(&publisher, &msg, nullptr)) {
+        st.SkipWithError(rcl_get_error_string().str);
+        break;
+      }
+    }
+    st.SetBytesProcessed(st.iterations() * st.range(0));
+    fini_publisher(st, &publisher);
+  }
+
+protected:
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, UnboundedSequences);
+  rcl_context_t context;
+  rcl_node_t node;
+  test_msgs__msg__UnboundedSequences msg;
+  rmw_serialized_message_t serialized_msg;
+};
+}  // namespace
+
+BENCHMARK_DEFINE_F(PublishPerformanceTest, publish)(benchmark::State & st)
+{
+  publish(st, "benchmark_chatter");
+}
+BENCHMARK_REGISTER_F(PublishPerformanceTest, publish)
+->RangeMultiplier(16)->Range(kMinSize, kMaxSize);
+
+BENCHMARK_DEFINE_F(PublishPerformanceTest, publish_collected)(benchmark::State & st)
+{
+  publish(st, "urg_benchmark_chatter");
+}
+BENCHMARK_REGISTER_F(PublishPerformanceTest, publish_collected)
+->RangeMultiplier(16)->Range(kMinSize, kMaxSize);
+
+BENCHMARK_DEFINE_F(PublishPerformanceTest, publish_unbatched)(benchmark::State & st)
+{
+  publish_batch(st, "benchmark_chatter", false);
+}
+BENCHMARK_REGISTER_F(PublishPerformanceTest, publish_unbatched)
+->RangeMultiplier(16)->Range(kMinSize, kMaxSize >> 4);
+
+BENCHMARK_DEFINE_F(PublishPerformanceTest, publish_batch)(benchmark::State & st)
+{
+  publish_batch(st, "benchmark_chatter", true);
+}
+BENCHMARK_REGISTER_F(PublishPerformanceTest, publish_batch)
+->RangeMultiplier(16)->Range(kMinSize, kMaxSize >> 4);
+
+BENCHMARK_DEFINE_F(PublishPerformanceTest, publish_unbatched_collected)(benchmark::State & st)
+{
+  publish_batch(st, "urg_benchmark_chatter", false);
+}
+BENCHMARK_REGISTER_F(PublishPerformanceTest, publish_unbatched_collected)
+->RangeMultiplier(16)->Range(kMinSize, kMaxSize >> 4);
+
+BENCHMARK_DEFINE_F(PublishPerformanceTest, publish_batch_collected)(benchmark::State & st)
+{
+  publish_batch(st, "urg_benchmark_chatter", true);
+}
+BENCHMARK_REGISTER_F(PublishPerformanceTest, publish_batch_collected)
+->RangeMultiplier(16)->Range(kMinSize, kMaxSize >> 4);
+
+BENCHMARK_DEFINE_F(PublishPerformanceTest, publish_serialized)(benchmark::State & st)
+{
+  publish_serialized(st, "benchmark_chatter");
+}
+BENCHMARK_REGISTER_F(PublishPerformanceTest, publish_serialized)
+->RangeMultiplier(16)->Range(kMinSize, kMaxSize);
+
+BENCHMARK_DEFINE_F(PublishPerformanceTest, publish_serialized_collected)(benchmark::State & st)
+{
+  publish_serialized(st, "urg_benchmark_chatter");
+}
+BENCHMARK_REGISTER_F(PublishPerformanceTest, publish_serialized_collected)
+->RangeMultiplier(16)->Range(kMinSize, kMaxSize);
+
+BENCHMARK_DEFINE_F(PublishPerformanceTest, publish_loaned)(benchmark::State & st)
+{
+  publish_loaned(st, "benchmark_chatter");
+}
+BENCHMARK_REGISTER_F(PublishPerformanceTest, publish_loaned)
+->RangeMultiplier(16)->Range(kMinSize, kMaxSize);
+
+BENCHMARK_DEFINE_F(PublishPerformanceTest, publish_loaned_collected)(benchmark::State & st)
+{
+  publish_loaned(st, "urg_benchmark_chatter");
+}
+BENCHMARK_REGISTER_F(PublishPerformanceTest, publish_loaned_collected)
+->RangeMultiplier(16)->Range(kMinSize, kMaxSize);
@@ -0,0 +1,126 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "performance_test_fixture/performance_test_fixture.hpp"
+
+#include "./serialized_size.h"
+
+#include "rcl/error_handling.h"
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+#include "rosidl_runtime_c/primitives_sequence_functions.h"
+#include "rosidl_runtime_c/string_functions.h"
+#include "test_msgs/msg/basic_types.h"
+#include "test_msgs/msg/unbounded_sequences.h"
+
+using performance_test_fixture::PerformanceTest;
+
+namespace
+{
+constexpr size_t kSequenceLength = 256u;
+
+void estimate(benchmark::State & st, const rosidl_message_type_support_t * ts, const void * msg)
+{
+  rcl_serialized_size_estimator_t estimator = rcl_get_zero_initialized_serialized_size_estimator();
+  if (RCL_RET_OK != rcl_serialized_size_estimator_init(&estimator, ts)) {
+    st.SkipWithError(rcl_get_error_string().str);
+    return;
+  }
+  for (auto _ : st) {
+    benchmark::DoNotOptimize(rcl_estimate_serialized_size(&estimator, msg));
+  }
+}
+
+void serialize(benchmark::State & st, const rosidl_message_type_support_t * ts, const void * msg)
+{
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rmw_serialized_message_t serialized_message = rmw_get_zero_initialized_serialized_message();
+  if (RMW_RET_OK != rmw_serialized_message_init(&serialized_message, 0u, &allocator)) {
+    st.SkipWithError(rmw_get_error_string().str);
+    return;
+  }
+  for (auto _ : st) {
+    // reuse the buffer so only the serialization itself is measured
+    serialized_message.buffer_length = 0u;
+    if (RMW_RET_OK != rmw_serialize(msg, ts, &serialized_message)) {
+      st.SkipWithError(rmw_get_error_string().str);
+      break;
+    }
+  }
+  if (RMW_RET_OK != rmw_serialized_message_fini(&serialized_message)) {
+    st.SkipWithError(rmw_get_error_string().str);
+  }
+}
+
+bool fill_sequences(test_msgs__msg__UnboundedSequences * msg)
+{
+  if (!rosidl_runtime_c__boolean__Sequence__init(&msg->bool_values, kSequenceLength) ||
+    !rosidl_runtime_c__int16__Sequence__init(&msg->int16_values, kSequenceLength) ||
+    !rosidl_runtime_c__float64__Sequence__init(&msg->float64_values, kSequenceLength) ||
+    !rosidl_runtime_c__String__Sequence__init(&msg->string_values, kSequenceLength))
+  {
+    return false;
+  }
+  for (size_t i = 0u; i < kSequenceLength; ++i) {
+    if (!rosidl_runtime_c__String__assign(&msg->string_values.data[i], "sequence element")) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+BENCHMARK_F(PerformanceTest, estimate_fixed_size)(benchmark::State & st)
+{
+  test_msgs__msg__BasicTypes msg;
+  test_msgs__msg__BasicTypes__init(&msg);
+  reset_heap_counters();
+  estimate(st, ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes), &msg);
+  test_msgs__msg__BasicTypes__fini(&msg);
+}
+
+BENCHMARK_F(PerformanceTest, serialize_fixed_size)(benchmark::State & st)
+{
+  test_msgs__msg__BasicTypes msg;
+  test_msgs__msg__BasicTypes__init(&msg);
+  reset_heap_counters();
+  serialize(st, ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes), &msg);
+  test_msgs__msg__BasicTypes__fini(&msg);
+}
+
+BENCHMARK_F(PerformanceTest, estimate_sequences)(benchmark::State & st)
+{
+  test_msgs__msg__UnboundedSequences msg;
+  test_msgs__msg__UnboundedSequences__init(&msg);
+  if (!fill_sequences(&msg)) {
+    st.SkipWithError("failed to fill sequences");
+  } else {
+    reset_heap_counters();
+    estimate(st, ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, UnboundedSequences), &msg);
+  }
+  test_msgs__msg__UnboundedSequences__fini(&msg);
+}
+
+BENCHMARK_F(PerformanceTest, serialize_sequences)(benchmark::State & st)
+{
+  test_msgs__msg__UnboundedSequences msg;
+  test_msgs__msg__UnboundedSequences__init(&msg);
+  if (!fill_sequences(&msg)) {
+    st.SkipWithError("failed to fill sequences");
+  } else {
+    reset_heap_counters();
+    serialize(st, ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, UnboundedSequences), &msg);
+  }
+  test_msgs__msg__UnboundedSequences__fini(&msg);
+}
@@ -0,0 +1,1010 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "rcl/publisher.h"
+
+#include "rcl/rcl.h"
+#include "rcl/subscription.h"
+#include "rcl_interfaces/msg/traffic_model.h"
+#include "rcutils/env.h"
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+#include "rosidl_runtime_c/message_type_support_struct.h"
+#include "rosidl_runtime_c/string_functions.h"
+#include "test_msgs/msg/basic_types.h"
+#include "test_msgs/msg/strings.h"
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+#include "rcl/collector_histogram.h"
+#include "rcl/error_handling.h"
+#include "wait_for_entity_helpers.hpp"
+
+#include "../mocking_utils/patch.hpp"
+
+#ifdef RMW_IMPLEMENTATION
+# define CLASSNAME_(NAME, SUFFIX) NAME ## __ ## SUFFIX
+# define CLASSNAME(NAME, SUFFIX) CLASSNAME_(NAME, SUFFIX)
+#else
+# define CLASSNAME(NAME, SUFFIX) NAME
+#endif
+
+class CLASSNAME (TestCollectorFixture, RMW_IMPLEMENTATION) : public ::testing::Test
+{
+public:
+  rcl_context_t * context_ptr;
+  rcl_node_t * node_ptr;
+  void SetUp()
+  {
+    ASSERT_TRUE(rcutils_set_env("ROS_MACHINE_ID", "test_collector"));
+    rcl_ret_t ret;
+    {
+      rcl_init_options_t init_options = rcl_get_zero_initialized_init_options();
+      ret = rcl_init_options_init(&init_options, rcl_get_default_allocator());
+      ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+      OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+      {
+        EXPECT_EQ(RCL_RET_OK, rcl_init_options_fini(&init_options)) << rcl_get_error_string().str;
+      });
+      this->context_ptr = new rcl_context_t;
+      *this->context_ptr = rcl_get_zero_initialized_context();
+      ret = rcl_init(0, nullptr, &init_options, this->context_ptr);
+      ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    }
+    this->node_ptr = new rcl_node_t;
+    *this->node_ptr = rcl_get_zero_initialized_node();
+    constexpr char name[] = "test_collector_node";
+    rcl_node_options_t node_options = rcl_node_get_default_options();
+    ret = rcl_node_init(this->node_ptr, name, "", this->context_ptr, &node_options);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  }
+
+  void TearDown()
+  {
+    rcl_ret_t ret = rcl_node_fini(this->node_ptr);
+    delete this->node_ptr;
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    ret = rcl_shutdown(this->context_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    ret = rcl_context_fini(this->context_ptr);
+    delete this->context_ptr;
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    EXPECT_TRUE(rcutils_set_env("ROS_MACHINE_ID", NULL));
+  }
+};
+
+/* Urgent publishes of a fixed size message reuse a single serialization buffer.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_collector_publish_fixed_size) {
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  rcl_ret_t ret;
+  {
+    // without introspection type support there is no size estimator, messages are serialized
+    auto mock = mocking_utils::patch_and_return(
+      "lib:rcl", get_message_typesupport_handle, nullptr);
+    ret = rcl_publisher_init(&publisher, this->node_ptr, ts, "urg_chatter", &publisher_options);
+  }
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  test_msgs__msg__BasicTypes msg;
+  ASSERT_TRUE(test_msgs__msg__BasicTypes__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__BasicTypes__fini(&msg);
+  });
+  std::vector<const uint8_t *> buffers;
+  std::vector<size_t> capacities;
+  auto mock = mocking_utils::patch(
+    "lib:rcl", rmw_publish_serialized_message,
+    ([&, base = rmw_publish_serialized_message](
+      const rmw_publisher_t * rmw_publisher, const rmw_serialized_message_t * serialized_message,
+      rmw_publisher_allocation_t * allocation)
+    {
+      buffers.push_back(serialized_message->buffer);
+      capacities.push_back(serialized_message->buffer_capacity);
+      return base(rmw_publisher, serialized_message, allocation);
+    }));
+  for (int i = 0; i < 50; ++i) {
+    msg.int64_value = i;
+    ret = rcl_publish(&publisher, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  }
+  ASSERT_EQ(50u, buffers.size());
+  // once the size model exists the buffer fits every message, it is neither grown nor replaced
+  for (size_t i = 25u; i < buffers.size(); ++i) {
+    EXPECT_EQ(buffers[24], buffers[i]) << "publish " << i;
+    EXPECT_EQ(capacities[24], capacities[i]) << "publish " << i;
+  }
+}
+
+/* Urgent publishes of growing messages outgrow the reserved serialization buffer.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_collector_publish_growing) {
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Strings);
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  rcl_ret_t ret;
+  {
+    // without introspection type support there is no size estimator, messages are serialized
+    auto mock = mocking_utils::patch_and_return(
+      "lib:rcl", get_message_typesupport_handle, nullptr);
+    ret = rcl_publisher_init(&publisher, this->node_ptr, ts, "urg_strings", &publisher_options);
+  }
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  test_msgs__msg__Strings msg;
+  ASSERT_TRUE(test_msgs__msg__Strings__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__Strings__fini(&msg);
+  });
+  std::vector<size_t> lengths;
+  std::vector<size_t> capacities;
+  auto mock = mocking_utils::patch(
+    "lib:rcl", rmw_publish_serialized_message,
+    ([&, base = rmw_publish_serialized_message](
+      const rmw_publisher_t * rmw_publisher, const rmw_serialized_message_t * serialized_message,
+      rmw_publisher_allocation_t * allocation)
+    {
+      lengths.push_back(serialized_message->buffer_length);
+      capacities.push_back(serialized_message->buffer_capacity);
+      return base(rmw_publisher, serialized_message, allocation);
+    }));
+  std::string value;
+  for (int i = 0; i < 50; ++i) {
+    value.append(static_cast<size_t>(i) * 64u, 'x');
+    ASSERT_TRUE(rosidl_runtime_c__String__assign(&msg.string_value, value.c_str()));
+    ret = rcl_publish(&publisher, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  }
+  // small messages after the large ones still go into the grown buffer
+  ASSERT_TRUE(rosidl_runtime_c__String__assign(&msg.string_value, ""));
+  for (int i = 0; i < 10; ++i) {
+    ret = rcl_publish(&publisher, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  }
+  ASSERT_EQ(60u, capacities.size());
+  const size_t largest = lengths[49];
+  for (size_t i = 1u; i < capacities.size(); ++i) {
+    EXPECT_LE(capacities[i - 1], capacities[i]) << "publish " << i;
+  }
+  for (size_t i = 50u; i < capacities.size(); ++i) {
+    EXPECT_LT(lengths[i], largest) << "publish " << i;
+    EXPECT_GE(capacities[i], largest) << "publish " << i;
+  }
+}
+
+/* Model updates are published in the background on the machine's report topic.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_collector_reports_model) {
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  rcl_ret_t ret = rcl_subscription_init(
+    &subscription, this->node_ptr, ROSIDL_GET_MSG_TYPE_SUPPORT(rcl_interfaces, msg, TrafficModel),
+    "ros_traffic_model_test_collector", &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_subscription_fini(&subscription, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Strings);
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  ret = rcl_publisher_init(
+    &publisher, this->node_ptr, ts, "urg_strings", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  test_msgs__msg__Strings msg;
+  ASSERT_TRUE(test_msgs__msg__Strings__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__Strings__fini(&msg);
+  });
+  const std::string outlier(1024u, 'x');
+  bool reported = false;
+  for (int i = 0; i < 200 && !reported; ++i) {
+    // occasional size outliers keep forcing model updates
+    ASSERT_TRUE(
+      rosidl_runtime_c__String__assign(&msg.string_value, i % 25 ? "" : outlier.c_str()));
+    ret = rcl_publish(&publisher, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    // wait longer than the reporter period so reports can go out in between
+    reported = wait_for_subscription_to_be_ready(&subscription, this->context_ptr, 1, 20);
+  }
+  ASSERT_TRUE(reported);
+
+  rcl_interfaces__msg__TrafficModel report;
+  ASSERT_TRUE(rcl_interfaces__msg__TrafficModel__init(&report));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_interfaces__msg__TrafficModel__fini(&report);
+  });
+  ret = rcl_take(&subscription, &report, nullptr, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_STREQ("/urg_strings", report.id.data);
+  EXPECT_GT(report.s, 0.0);
+}
+
+/* Loaned publishes are modelled with the serialized size of the message.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_collector_publish_loaned) {
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  rcl_ret_t ret = rcl_subscription_init(
+    &subscription, this->node_ptr, ROSIDL_GET_MSG_TYPE_SUPPORT(rcl_interfaces, msg, TrafficModel),
+    "ros_traffic_model_test_collector", &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_subscription_fini(&subscription, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, "urg_loaned", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  test_msgs__msg__BasicTypes msg;
+  ASSERT_TRUE(test_msgs__msg__BasicTypes__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__BasicTypes__fini(&msg);
+  });
+  rcl_serialized_message_t serialized_msg = rmw_get_zero_initialized_serialized_message();
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  ASSERT_EQ(RMW_RET_OK, rmw_serialized_message_init(&serialized_msg, 0u, &allocator));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RMW_RET_OK, rmw_serialized_message_fini(&serialized_msg));
+  });
+  ASSERT_EQ(RMW_RET_OK, rmw_serialize(&msg, ts, &serialized_msg));
+
+  {
+    // not every middleware loans, the message stands in for a loan it never sees
+    auto mock = mocking_utils::patch_and_return("lib:rcl", rmw_publish_loaned_message, RMW_RET_OK);
+    bool reported = false;
+    for (int i = 0; i < 200 && !reported; ++i) {
+      ret = rcl_publish_loaned_message(&publisher, &msg, nullptr);
+      ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+      reported = wait_for_subscription_to_be_ready(&subscription, this->context_ptr, 1, 20);
+    }
+    ASSERT_TRUE(reported);
+  }
+
+  rcl_interfaces__msg__TrafficModel report;
+  ASSERT_TRUE(rcl_interfaces__msg__TrafficModel__init(&report));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_interfaces__msg__TrafficModel__fini(&report);
+  });
+  ret = rcl_take(&subscription, &report, nullptr, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_STREQ("/urg_loaned", report.id.data);
+  EXPECT_DOUBLE_EQ(static_cast<double>(serialized_msg.buffer_length), report.s);
+  EXPECT_DOUBLE_EQ(0.0, report.sigma_s);
+}
+
+/* Loans of a type without size estimator are timed, but leave the size model as it is.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_collector_publish_loaned_unsized) {
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  subscription_options.qos.depth = 100u;
+  rcl_ret_t ret = rcl_subscription_init(
+    &subscription, this->node_ptr, ROSIDL_GET_MSG_TYPE_SUPPORT(rcl_interfaces, msg, TrafficModel),
+    "ros_traffic_model_test_collector", &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_subscription_fini(&subscription, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Strings);
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  // every message refits the model, and is reported
+  publisher_options.collector_options.model_freshness = 1e-3;
+  {
+    // without introspection type support there is no size estimator
+    auto mock = mocking_utils::patch_and_return(
+      "lib:rcl", get_message_typesupport_handle, nullptr);
+    ret = rcl_publisher_init(
+      &publisher, this->node_ptr, ts, "urg_loaned_unsized", &publisher_options);
+  }
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+  size_t publisher_count = 0u;
+  for (int i = 0; i < 100 && 0u == publisher_count; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ret = rcl_subscription_get_publisher_count(&subscription, &publisher_count);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  }
+  ASSERT_LT(0u, publisher_count);
+
+  test_msgs__msg__Strings msg;
+  ASSERT_TRUE(test_msgs__msg__Strings__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__Strings__fini(&msg);
+  });
+  rcl_interfaces__msg__TrafficModel report;
+  ASSERT_TRUE(rcl_interfaces__msg__TrafficModel__init(&report));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_interfaces__msg__TrafficModel__fini(&report);
+  });
+  // the size model of the last report, once no more come
+  auto last_reported_size = [&](double & s, double & sigma_s) {
+    bool reported = false;
+    while (wait_for_subscription_to_be_ready(&subscription, this->context_ptr, 10, 20)) {
+      if (RCL_RET_OK == rcl_take(&subscription, &report, nullptr, nullptr) &&
+        0 == strcmp("/urg_loaned_unsized", report.id.data))
+      {
+        s = report.s;
+        sigma_s = report.sigma_s;
+        reported = true;
+      }
+    }
+    return reported;
+  };
+
+  // messages of two sizes, serialized to learn them
+  const std::string value(64u, 'x');
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_TRUE(rosidl_runtime_c__String__assign(&msg.string_value, i % 2 ? "" : value.c_str()));
+    ret = rcl_publish(&publisher, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  double s = 0.0, sigma_s = 0.0;
+  ASSERT_TRUE(last_reported_size(s, sigma_s));
+  EXPECT_LT(0.0, sigma_s);
+
+  {
+    // not every middleware loans, the message stands in for a loan it never sees
+    auto mock = mocking_utils::patch_and_return("lib:rcl", rmw_publish_loaned_message, RMW_RET_OK);
+    for (int i = 0; i < 20; ++i) {
+      ret = rcl_publish_loaned_message(&publisher, &msg, nullptr);
+      ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+  // the loans refitted the time model, the size model is still the one of the sizes seen
+  double loaned_s = 0.0, loaned_sigma_s = 0.0;
+  ASSERT_TRUE(last_reported_size(loaned_s, loaned_sigma_s));
+  EXPECT_DOUBLE_EQ(s, loaned_s);
+  EXPECT_DOUBLE_EQ(sigma_s, loaned_sigma_s);
+}
+
+/* All urgent publishers of a context report through a single publisher.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_collector_shared_report_publisher) {
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  rcl_ret_t ret = rcl_subscription_init(
+    &subscription, this->node_ptr, ROSIDL_GET_MSG_TYPE_SUPPORT(rcl_interfaces, msg, TrafficModel),
+    "ros_traffic_model_test_collector", &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_subscription_fini(&subscription, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  rcl_publisher_t publisher_a = rcl_get_zero_initialized_publisher();
+  ret = rcl_publisher_init(&publisher_a, this->node_ptr, ts, "urg_a", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher_a, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+  rcl_publisher_t publisher_b = rcl_get_zero_initialized_publisher();
+  ret = rcl_publisher_init(&publisher_b, this->node_ptr, ts, "urg_b", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher_b, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  // give discovery time to see every report publisher there is
+  size_t publisher_count = 0u;
+  for (int i = 0; i < 10; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ret = rcl_subscription_get_publisher_count(&subscription, &publisher_count);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  }
+  EXPECT_EQ(1u, publisher_count);
+}
+
+/* Collector settings come from the publisher options or the environment.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_collector_options) {
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  subscription_options.qos.depth = 100u;
+  rcl_ret_t ret = rcl_subscription_init(
+    &subscription, this->node_ptr, ROSIDL_GET_MSG_TYPE_SUPPORT(rcl_interfaces, msg, TrafficModel),
+    "ros_traffic_model_test_collector", &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_subscription_fini(&subscription, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+  rcl_interfaces__msg__TrafficModel report;
+  ASSERT_TRUE(rcl_interfaces__msg__TrafficModel__init(&report));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_interfaces__msg__TrafficModel__fini(&report);
+  });
+
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  test_msgs__msg__BasicTypes msg;
+  ASSERT_TRUE(test_msgs__msg__BasicTypes__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__BasicTypes__fini(&msg);
+  });
+  // the first model is fitted, and reported, once warmup messages were collected,
+  // returns the number of publishes until its report, 0 if there was none
+  auto publishes_until_report = [&](rcl_publisher_t * publisher, const char * id) {
+    size_t publisher_count = 0u;
+    for (int i = 0; i < 100 && 0u == publisher_count; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      EXPECT_EQ(
+        RCL_RET_OK, rcl_subscription_get_publisher_count(&subscription, &publisher_count));
+    }
+    EXPECT_LT(0u, publisher_count) << "the report publisher was not discovered";
+    for (int i = 1; i <= 20; ++i) {
+      EXPECT_EQ(RCL_RET_OK, rcl_publish(publisher, &msg, nullptr)) << rcl_get_error_string().str;
+      // a report goes out within a reporter period of the fit
+      while (wait_for_subscription_to_be_ready(&subscription, this->context_ptr, 10, 20)) {
+        if (RCL_RET_OK == rcl_take(&subscription, &report, nullptr, nullptr) &&
+          0 == strcmp(id, report.id.data))
+        {
+          return i;
+        }
+      }
+    }
+    return 0;
+  };
+
+  // out of range values are clamped, the history and the warmup to 3 messages
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  EXPECT_EQ(0u, publisher_options.collector_options.history_length);
+  publisher_options.collector_options.history_length = 1u;
+  publisher_options.collector_options.warmup = 100u;
+  publisher_options.collector_options.model_freshness = 1e-3;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, "urg_chatter", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(3, publishes_until_report(&publisher, "/urg_chatter"));
+  EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+    rcl_get_error_string().str;
+
+  // invalid environment values fall back to the defaults, valid ones are used
+  ASSERT_TRUE(rcutils_set_env("ROS_TRAFFIC_MODEL_HISTORY_LENGTH", "not a number"));
+  ASSERT_TRUE(rcutils_set_env("ROS_TRAFFIC_MODEL_WARMUP", "5"));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_TRUE(rcutils_set_env("ROS_TRAFFIC_MODEL_HISTORY_LENGTH", NULL));
+    EXPECT_TRUE(rcutils_set_env("ROS_TRAFFIC_MODEL_WARMUP", NULL));
+  });
+  publisher_options = rcl_publisher_get_default_options();
+  publisher = rcl_get_zero_initialized_publisher();
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, "urg_warmup", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  // a history shorter than 5 messages would have clamped the warmup
+  EXPECT_EQ(5, publishes_until_report(&publisher, "/urg_warmup"));
+  EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+    rcl_get_error_string().str;
+}
+
+/* Bursts of messages are reported as a composite model with one component per message.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_collector_reports_components) {
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  subscription_options.qos.depth = 100u;
+  rcl_ret_t ret = rcl_subscription_init(
+    &subscription, this->node_ptr, ROSIDL_GET_MSG_TYPE_SUPPORT(rcl_interfaces, msg, TrafficModel),
+    "ros_traffic_model_test_collector", &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_subscription_fini(&subscription, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  publisher_options.collector_options.history_length = 30u;
+  publisher_options.collector_options.max_period_components = 4u;
+  // refit regularly so that reports keep coming even if early ones are missed
+  publisher_options.collector_options.model_freshness = 0.5;
+  ret = rcl_publisher_init(
+    &publisher, this->node_ptr, ts, "urg_burst", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  test_msgs__msg__BasicTypes msg;
+  ASSERT_TRUE(test_msgs__msg__BasicTypes__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__BasicTypes__fini(&msg);
+  });
+  rcl_interfaces__msg__TrafficModel report;
+  ASSERT_TRUE(rcl_interfaces__msg__TrafficModel__init(&report));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_interfaces__msg__TrafficModel__fini(&report);
+  });
+
+  // three messages 5 ms apart every 60 ms, like a camera triggered at ~16 Hz
+  std::string component_id;
+  for (int cycle = 0; cycle < 40 && component_id.empty(); ++cycle) {
+    for (int i = 0; i < 3; ++i) {
+      ret = rcl_publish(&publisher, &msg, nullptr);
+      ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    // a fixed pause, waiting on the subscription would distort the pattern
+    std::this_thread::sleep_for(std::chrono::milliseconds(45));
+    while (RCL_RET_OK == rcl_take(&subscription, &report, nullptr, nullptr)) {
+      if (std::string(report.id.data).find('#') != std::string::npos) {
+        component_id = report.id.data;
+        EXPECT_NEAR(0.06, report.a, 0.02);
+      }
+    }
+  }
+  EXPECT_EQ(0u, component_id.find("/urg_burst#")) << component_id;
+  EXPECT_NE(std::string::npos, component_id.find("/3")) << component_id;
+}
+
+/* Urgent subscriptions report a receive-side model and its latency next to the publish-side one.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_collector_receive_side) {
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  subscription_options.qos.depth = 100u;
+  rcl_subscription_t report_subscription = rcl_get_zero_initialized_subscription();
+  rcl_ret_t ret = rcl_subscription_init(
+    &report_subscription, this->node_ptr,
+    ROSIDL_GET_MSG_TYPE_SUPPORT(rcl_interfaces, msg, TrafficModel),
+    "ros_traffic_model_test_collector", &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_subscription_fini(&report_subscription, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  subscription_options.collector_options.model_freshness = 0.2;
+  ret = rcl_subscription_init(
+    &subscription, this->node_ptr, ts, "urg_rx", &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_subscription_fini(&subscription, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, "urg_rx", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+  ASSERT_TRUE(wait_for_established_subscription(&publisher, 10, 100));
+
+  test_msgs__msg__BasicTypes msg;
+  ASSERT_TRUE(test_msgs__msg__BasicTypes__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__BasicTypes__fini(&msg);
+  });
+  rcl_interfaces__msg__TrafficModel report;
+  ASSERT_TRUE(rcl_interfaces__msg__TrafficModel__init(&report));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_interfaces__msg__TrafficModel__fini(&report);
+  });
+
+  bool receive_reported = false;
+  bool latency_reported = false;
+  for (int i = 0; i < 100 && !(receive_reported && latency_reported); ++i) {
+    ret = rcl_publish(&publisher, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    if (wait_for_subscription_to_be_ready(&subscription, this->context_ptr, 10, 10)) {
+      ret = rcl_take(&subscription, &msg, nullptr, nullptr);
+      ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    while (RCL_RET_OK == rcl_take(&report_subscription, &report, nullptr, nullptr)) {
+      const std::string id(report.id.data);
+      if (id == "/urg_rx@/test_collector_node") {
+        receive_reported = true;
+        EXPECT_GT(report.s, 0.0);
+      } else if (id == "/urg_rx@/test_collector_node/latency") {
+        latency_reported = true;
+        EXPECT_GE(report.s, 0.0);
+      }
+    }
+  }
+  EXPECT_TRUE(receive_reported);
+  EXPECT_TRUE(latency_reported);
+}
+
+/* Shaped publishes are deferred out of the guard time of predicted urgent messages,
+ * and token bucket shaping limits the publish rate.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_traffic_shaping) {
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  rcl_publisher_t urgent_publisher = rcl_get_zero_initialized_publisher();
+  rcl_ret_t ret = rcl_publisher_init(
+    &urgent_publisher, this->node_ptr, ts, "urg_paced", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&urgent_publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  publisher_options.traffic_shaping.mode = RCL_TRAFFIC_SHAPING_TOKEN_BUCKET;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, "shaped", &publisher_options);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  publisher_options.traffic_shaping.mode = RCL_TRAFFIC_SHAPING_PACED;
+  publisher_options.traffic_shaping.guard_time = 0.01;
+  publisher_options.traffic_shaping.max_delay = 0.05;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, "shaped", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  test_msgs__msg__BasicTypes msg;
+  ASSERT_TRUE(test_msgs__msg__BasicTypes__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__BasicTypes__fini(&msg);
+  });
+  // a 10 Hz urgent topic, long enough for its model to be fitted and reported
+  constexpr auto period = std::chrono::milliseconds(100);
+  auto last = std::chrono::steady_clock::now();
+  for (int i = 0; i < 15; ++i) {
+    last += period;
+    std::this_thread::sleep_until(last);
+    ASSERT_EQ(RCL_RET_OK, rcl_publish(&urgent_publisher, &msg, nullptr)) <<
+      rcl_get_error_string().str;
+  }
+
+  // between two urgent messages the shaped publish goes out right away
+  std::this_thread::sleep_until(last + period / 2);
+  ASSERT_EQ(RCL_RET_OK, rcl_publish(&publisher, &msg, nullptr)) << rcl_get_error_string().str;
+  EXPECT_LT(std::chrono::steady_clock::now(), last + period / 2 + std::chrono::milliseconds(10));
+  // close to the next one it waits until the guard time after it
+  std::this_thread::sleep_until(last + period - std::chrono::milliseconds(5));
+  ASSERT_EQ(RCL_RET_OK, rcl_publish(&publisher, &msg, nullptr)) << rcl_get_error_string().str;
+  EXPECT_GE(std::chrono::steady_clock::now(), last + period + std::chrono::milliseconds(5));
+
+  rcl_publisher_t limited_publisher = rcl_get_zero_initialized_publisher();
+  publisher_options.traffic_shaping.mode = RCL_TRAFFIC_SHAPING_TOKEN_BUCKET;
+  publisher_options.traffic_shaping.rate = 100.0;
+  publisher_options.traffic_shaping.burst = 5u;
+  ret = rcl_publisher_init(
+    &limited_publisher, this->node_ptr, ts, "shaped_limited", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&limited_publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+  // the burst goes out at once, the other 10 messages at 100 per second
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 15; ++i) {
+    ASSERT_EQ(RCL_RET_OK, rcl_publish(&limited_publisher, &msg, nullptr)) <<
+      rcl_get_error_string().str;
+  }
+  EXPECT_GE(std::chrono::steady_clock::now(), start + std::chrono::milliseconds(95));
+}
+
+/* Publishes off the model raise traffic anomaly events, which wake waits.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_traffic_anomaly_event) {
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Strings);
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  rcl_ret_t ret = rcl_publisher_init(
+    &publisher, this->node_ptr, ts, "urg_anomalies", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  // only collected publishers detect anomalies, one event each
+  rcl_publisher_t plain_publisher = rcl_get_zero_initialized_publisher();
+  ret = rcl_publisher_init(
+    &plain_publisher, this->node_ptr, ts, "anomalies", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&plain_publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+  rcl_event_t event = rcl_get_zero_initialized_event();
+  ret = rcl_publisher_event_init(&event, &plain_publisher, RCL_PUBLISHER_TRAFFIC_ANOMALY);
+  EXPECT_EQ(RCL_RET_UNSUPPORTED, ret);
+  rcl_reset_error();
+  ret = rcl_publisher_event_init(&event, &publisher, RCL_PUBLISHER_TRAFFIC_ANOMALY);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_event_fini(&event)) << rcl_get_error_string().str;
+  });
+  rcl_event_t other_event = rcl_get_zero_initialized_event();
+  ret = rcl_publisher_event_init(&other_event, &publisher, RCL_PUBLISHER_TRAFFIC_ANOMALY);
+  EXPECT_EQ(RCL_RET_ERROR, ret);
+  rcl_reset_error();
+
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(
+    &wait_set, 0, 0, 0, 0, 0, 1, this->context_ptr, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_wait_set_fini(&wait_set)) << rcl_get_error_string().str;
+  });
+  auto wait_for_event = [&](std::chrono::nanoseconds timeout) {
+      EXPECT_EQ(RCL_RET_OK, rcl_wait_set_clear(&wait_set)) << rcl_get_error_string().str;
+      EXPECT_EQ(RCL_RET_OK, rcl_wait_set_add_event(&wait_set, &event, nullptr)) <<
+        rcl_get_error_string().str;
+      rcl_ret_t ret = rcl_wait(&wait_set, timeout.count());
+      EXPECT_TRUE(RCL_RET_OK == ret || RCL_RET_TIMEOUT == ret) << rcl_get_error_string().str;
+      return RCL_RET_OK == ret && nullptr != wait_set.events[0];
+    };
+  rcl_traffic_anomaly_status_t status;
+  EXPECT_FALSE(wait_for_event(std::chrono::milliseconds(0)));
+  ASSERT_EQ(RCL_RET_OK, rcl_take_event(&event, &status)) << rcl_get_error_string().str;
+  EXPECT_EQ(0, status.total_count);
+  EXPECT_EQ(0, status.total_count_change);
+
+  test_msgs__msg__Strings msg;
+  ASSERT_TRUE(test_msgs__msg__Strings__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__Strings__fini(&msg);
+  });
+  // a 10 Hz topic of empty strings, long enough for its model to be fitted
+  constexpr auto period = std::chrono::milliseconds(100);
+  auto last = std::chrono::steady_clock::now();
+  for (int i = 0; i < 15; ++i) {
+    last += period;
+    std::this_thread::sleep_until(last);
+    ASSERT_EQ(RCL_RET_OK, rcl_publish(&publisher, &msg, nullptr)) << rcl_get_error_string().str;
+  }
+  // scheduling jitter may break the model as well, those anomalies are not looked at
+  (void)wait_for_event(std::chrono::milliseconds(0));
+  ASSERT_EQ(RCL_RET_OK, rcl_take_event(&event, &status)) << rcl_get_error_string().str;
+  int32_t total_count = status.total_count;
+
+  // three periods go by without a publish
+  last += 4 * period;
+  std::this_thread::sleep_until(last);
+  ASSERT_EQ(RCL_RET_OK, rcl_publish(&publisher, &msg, nullptr)) << rcl_get_error_string().str;
+  EXPECT_TRUE(wait_for_event(std::chrono::seconds(1)));
+  ASSERT_EQ(RCL_RET_OK, rcl_take_event(&event, &status)) << rcl_get_error_string().str;
+  EXPECT_GE(status.total_count_change, 1);
+  EXPECT_EQ(total_count + status.total_count_change, status.total_count);
+  EXPECT_EQ(RCL_TRAFFIC_ANOMALY_MISSED_PERIOD, status.last_kind);
+  EXPECT_NEAR(0.3, status.offset, 0.05);
+  EXPECT_GT(status.deviation, 3.0);
+  // taken, nothing to wait for until the next anomaly
+  EXPECT_FALSE(wait_for_event(std::chrono::milliseconds(0)));
+  ASSERT_EQ(RCL_RET_OK, rcl_take_event(&event, &status)) << rcl_get_error_string().str;
+  EXPECT_EQ(0, status.total_count_change);
+
+  // a message much larger than the others
+  const std::string outlier(1024u, 'x');
+  ASSERT_TRUE(rosidl_runtime_c__String__assign(&msg.string_value, outlier.c_str()));
+  ASSERT_EQ(RCL_RET_OK, rcl_publish(&publisher, &msg, nullptr)) << rcl_get_error_string().str;
+  EXPECT_TRUE(wait_for_event(std::chrono::seconds(1)));
+  ASSERT_EQ(RCL_RET_OK, rcl_take_event(&event, &status)) << rcl_get_error_string().str;
+  EXPECT_GE(status.total_count_change, 1);
+  EXPECT_EQ(RCL_TRAFFIC_ANOMALY_SIZE_OUTLIER, status.last_kind);
+  EXPECT_GT(status.offset, 1000.0);
+}
+
+/* Concurrent publishes on one collected publisher are all accounted for, and fit one model.
+ */
+TEST_F(CLASSNAME(TestCollectorFixture, RMW_IMPLEMENTATION), test_collector_concurrent_publish) {
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  subscription_options.qos.depth = 100u;
+  rcl_subscription_t report_subscription = rcl_get_zero_initialized_subscription();
+  rcl_ret_t ret = rcl_subscription_init(
+    &report_subscription, this->node_ptr,
+    ROSIDL_GET_MSG_TYPE_SUPPORT(rcl_interfaces, msg, TrafficModel),
+    "ros_traffic_model_test_collector", &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_subscription_fini(&report_subscription, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  ret = rcl_publisher_init(
+    &publisher, this->node_ptr, ts, "urg_concurrent", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr)) <<
+      rcl_get_error_string().str;
+  });
+
+  constexpr size_t thread_count = 8u;
+  constexpr size_t publish_count = 2000u;
+  std::vector<std::thread> threads;
+  for (size_t t = 0u; t < thread_count; ++t) {
+    threads.emplace_back(
+      [&publisher]() {
+        test_msgs__msg__BasicTypes msg;
+        ASSERT_TRUE(test_msgs__msg__BasicTypes__init(&msg));
+        for (size_t i = 0u; i < publish_count; ++i) {
+          msg.uint64_value = i;
+          EXPECT_EQ(RCL_RET_OK, rcl_publish(&publisher, &msg, nullptr)) <<
+            rcl_get_error_string().str;
+        }
+        test_msgs__msg__BasicTypes__fini(&msg);
+      });
+  }
+  for (std::thread & thread : threads) {
+    thread.join();
+  }
+
+#ifndef _WIN32
+  // every message was either recorded or counted as dropped in the shared histograms
+  char name[64];
+  snprintf(
+    name, sizeof(name), "/rcl_traffic_histograms_%lld_%llu",
+    static_cast<long long>(getpid()),  // NOLINT(runtime/int)
+    static_cast<unsigned long long>(  // NOLINT(runtime/int)
+      rcl_context_get_instance_id(this->context_ptr)));
+  int fd = shm_open(name, O_RDONLY, 0);
+  ASSERT_GE(fd, 0) << name;
+  size_t size = sizeof(rcl_collector_histogram_file_header_t) +
+    RCL_COLLECTOR_HISTOGRAM_SLOT_COUNT * sizeof(rcl_collector_histogram_slot_t);
+  void * mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  ASSERT_NE(MAP_FAILED, mapping);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    munmap(mapping, size);
+  });
+  auto header = static_cast<const rcl_collector_histogram_file_header_t *>(mapping);
+  auto slots = reinterpret_cast<const rcl_collector_histogram_slot_t *>(header + 1);
+  const rcl_collector_histogram_slot_t * slot = nullptr;
+  for (size_t i = 0u; i < header->slot_count; ++i) {
+    if (slots[i].in_use && 0 == strcmp("/urg_concurrent", slots[i].topic_name)) {
+      slot = &slots[i];
+    }
+  }
+  ASSERT_NE(nullptr, slot);
+  EXPECT_GT(slot->size.total, 0u);
+  EXPECT_EQ(thread_count * publish_count, slot->size.total + slot->dropped);
+  EXPECT_EQ(slot->size.total, slot->interval.total + 1u);
+  EXPECT_LE(slot->duration.total, thread_count * publish_count);
+#endif
+
+  // the model of fixed size messages has no size spread, and a positive period
+  rcl_interfaces__msg__TrafficModel report;
+  ASSERT_TRUE(rcl_interfaces__msg__TrafficModel__init(&report));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_interfaces__msg__TrafficModel__fini(&report);
+  });
+  bool reported = false;
+  for (int i = 0; i < 10 && !reported; ++i) {
+    if (!wait_for_subscription_to_be_ready(&report_subscription, this->context_ptr, 10, 100)) {
+      continue;
+    }
+    while (RCL_RET_OK == rcl_take(&report_subscription, &report, nullptr, nullptr)) {
+      if (std::string(report.id.data) == "/urg_concurrent") {
+        reported = true;
+        EXPECT_GT(report.s, 0.0);
+        EXPECT_EQ(0.0, report.sigma_s);
+        EXPECT_TRUE(std::isfinite(report.a));
+        EXPECT_GT(report.a, 0.0);
+      }
+    }
+  }
+  EXPECT_TRUE(reported);
+}
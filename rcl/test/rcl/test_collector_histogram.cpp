@@ -0,0 +1,92 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+
+#include "./collector_histogram_file.h"
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+
+TEST(TestCollectorHistogram, test_buckets) {
+  // every value falls in the bucket whose range covers it
+  for (uint64_t value = 0u; value < (1u << 16); ++value) {
+    size_t index = rcl_collector_histogram_index(value);
+    ASSERT_LT(index, static_cast<size_t>(RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT));
+    EXPECT_LE(rcl_collector_histogram_lowest(index), value);
+    if (index + 1 < RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT) {
+      EXPECT_GT(rcl_collector_histogram_lowest(index + 1), value);
+    }
+  }
+  for (size_t index = 1u; index < RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT; ++index) {
+    EXPECT_LT(rcl_collector_histogram_lowest(index - 1), rcl_collector_histogram_lowest(index));
+  }
+  // small values are exact, large values saturate into the last bucket
+  EXPECT_EQ(7u, rcl_collector_histogram_index(7u));
+  EXPECT_EQ(
+    static_cast<size_t>(RCL_COLLECTOR_HISTOGRAM_BUCKET_COUNT - 1),
+    rcl_collector_histogram_index(UINT64_MAX));
+}
+
+TEST(TestCollectorHistogram, test_percentile) {
+  auto histogram = std::make_unique<rcl_collector_histogram_t>();
+  std::memset(histogram.get(), 0, sizeof(rcl_collector_histogram_t));
+  EXPECT_EQ(0u, rcl_collector_histogram_percentile(histogram.get(), 50.0));
+
+  for (uint64_t value = 1u; value <= 1000u; ++value) {
+    rcl_collector_histogram_record(histogram.get(), value * 1000u);
+  }
+  EXPECT_EQ(1000u, histogram->total);
+  // within the ~3% relative precision of the buckets
+  EXPECT_NEAR(500000.0, rcl_collector_histogram_percentile(histogram.get(), 50.0), 500000.0 * 0.04);
+  EXPECT_NEAR(990000.0, rcl_collector_histogram_percentile(histogram.get(), 99.0), 990000.0 * 0.04);
+  EXPECT_NEAR(1000.0, rcl_collector_histogram_percentile(histogram.get(), 0.0), 1000.0 * 0.04);
+}
+
+TEST(TestCollectorHistogram, test_slots) {
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_collector_histogram_file_t file;
+  std::memset(&file, 0, sizeof(file));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_collector_histogram_file_fini(&file);
+  });
+
+  // more slots than the file holds spill over to the heap
+  rcl_collector_histogram_slot_t * slots[RCL_COLLECTOR_HISTOGRAM_SLOT_COUNT + 1];
+  for (auto & slot : slots) {
+    slot = rcl_collector_histogram_slot_acquire(&file, 42u, "urg_topic", allocator);
+    ASSERT_NE(nullptr, slot);
+    EXPECT_EQ(1u, slot->in_use);
+    EXPECT_STREQ("urg_topic", slot->topic_name);
+    EXPECT_EQ(0u, slot->interval.total);
+  }
+  if (nullptr != file.header) {
+    EXPECT_EQ(0, std::memcmp(RCL_COLLECTOR_HISTOGRAM_MAGIC, file.header->magic, 8));
+    EXPECT_EQ(RCL_COLLECTOR_HISTOGRAM_SLOT_COUNT, file.header->slot_count);
+    EXPECT_EQ(&file.slots[0], slots[0]);
+  }
+  for (auto & slot : slots) {
+    rcl_collector_histogram_slot_release(&file, slot, allocator);
+  }
+  // released slots are reused
+  rcl_collector_histogram_slot_t * slot =
+    rcl_collector_histogram_slot_acquire(&file, 42u, "urg_other", allocator);
+  ASSERT_NE(nullptr, slot);
+  EXPECT_EQ(slots[0], slot);
+  EXPECT_STREQ("urg_other", slot->topic_name);
+  rcl_collector_histogram_slot_release(&file, slot, allocator);
+}
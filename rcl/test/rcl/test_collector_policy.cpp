@@ -0,0 +1,183 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "rcl/rcl.h"
+#include "rcl/error_handling.h"
+#include "rcutils/env.h"
+
+#include "./arg_macros.hpp"
+#include "./collector_policy.h"
+
+#ifdef RMW_IMPLEMENTATION
+# define CLASSNAME_(NAME, SUFFIX) NAME ## __ ## SUFFIX
+# define CLASSNAME(NAME, SUFFIX) CLASSNAME_(NAME, SUFFIX)
+#else
+# define CLASSNAME(NAME, SUFFIX) NAME
+#endif
+
+class CLASSNAME (TestCollectorPolicyFixture, RMW_IMPLEMENTATION) : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    ASSERT_TRUE(rcutils_set_env("ROS_MACHINE_ID", "test_collector_policy"));
+  }
+
+  void TearDown()
+  {
+    EXPECT_TRUE(rcutils_set_env("ROS_MACHINE_ID", NULL));
+  }
+};
+
+static rcl_collector_policy_match_t
+match_topic(const rcl_node_t * node, const char * topic_name)
+{
+  rcl_collector_policy_match_t match;
+  rcl_ret_t ret = rcl_collector_policy_match(
+    node, topic_name, rcl_get_default_allocator(), &match);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  rcl_reset_error();
+  return match;
+}
+
+TEST_F(CLASSNAME(TestCollectorPolicyFixture, RMW_IMPLEMENTATION), test_default_policy) {
+  int argc;
+  char ** argv;
+  SCOPE_GLOBAL_ARGS(argc, argv, "process_name");
+
+  rcl_node_t node = rcl_get_zero_initialized_node();
+  rcl_node_options_t options = rcl_node_get_default_options();
+  ASSERT_EQ(RCL_RET_OK, rcl_node_init(&node, "policy_node", "/ns", &context, &options));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_node_fini(&node)) << rcl_get_error_string().str;
+  });
+
+  rcl_collector_policy_match_t match = match_topic(&node, "/urg_chatter");
+  EXPECT_TRUE(match.enabled);
+  EXPECT_EQ(1u, match.sampling);
+  EXPECT_EQ(0.0, match.overhead_budget);
+  EXPECT_TRUE(match_topic(&node, "/ns/urg_x").enabled);
+  EXPECT_FALSE(match_topic(&node, "/chatter").enabled);
+  EXPECT_FALSE(match_topic(&node, "/urg_ns/chatter").enabled);
+
+  // without a machine id there is nowhere to report to
+  ASSERT_TRUE(rcutils_set_env("ROS_MACHINE_ID", ""));
+  EXPECT_FALSE(match_topic(&node, "/urg_chatter").enabled);
+
+  rcl_collector_policy_match_t unused;
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_collector_policy_match(&node, nullptr, rcl_get_default_allocator(), &unused));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_collector_policy_match(&node, "/urg_chatter", rcl_get_default_allocator(), nullptr));
+  rcl_reset_error();
+}
+
+TEST_F(CLASSNAME(TestCollectorPolicyFixture, RMW_IMPLEMENTATION), test_global_rules) {
+  int argc;
+  char ** argv;
+  SCOPE_GLOBAL_ARGS(
+    argc, argv, "process_name", "--ros-args",
+    "-p", "traffic_collector.overhead_budget:=0.01",
+    "-p", "traffic_collector.rules.camera.topic:=/camera/**",
+    "-p", "traffic_collector.rules.camera.sampling:=10",
+    "-p", "traffic_collector.rules.urgent.enabled:=false",
+    "-p", "traffic_collector.rules.fast.regex:=^/fast_[0-9]+$",
+    "-p", "traffic_collector.rules.fast.sampling:=100",
+    "-p", "traffic_collector.rules.fast.overhead_budget:=0.001");
+
+  rcl_node_t node = rcl_get_zero_initialized_node();
+  rcl_node_options_t options = rcl_node_get_default_options();
+  ASSERT_EQ(RCL_RET_OK, rcl_node_init(&node, "policy_node", "", &context, &options));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_node_fini(&node)) << rcl_get_error_string().str;
+  });
+
+  rcl_collector_policy_match_t match = match_topic(&node, "/camera/left/image");
+  EXPECT_TRUE(match.enabled);
+  EXPECT_EQ(10u, match.sampling);
+  EXPECT_EQ(0.01, match.overhead_budget);
+  EXPECT_FALSE(match_topic(&node, "/camera").enabled);
+  EXPECT_FALSE(match_topic(&node, "/urg_chatter").enabled);
+#ifndef _WIN32
+  match = match_topic(&node, "/fast_12");
+  EXPECT_TRUE(match.enabled);
+  EXPECT_EQ(100u, match.sampling);
+  EXPECT_EQ(0.001, match.overhead_budget);
+  EXPECT_FALSE(match_topic(&node, "/fast_x").enabled);
+#endif
+}
+
+TEST_F(CLASSNAME(TestCollectorPolicyFixture, RMW_IMPLEMENTATION), test_node_rules) {
+  int argc;
+  char ** argv;
+  SCOPE_GLOBAL_ARGS(
+    argc, argv, "process_name", "--ros-args",
+    "-p", "traffic_collector.rules.camera.topic:=/camera/*",
+    "-p", "policy_node:traffic_collector.rules.camera.sampling:=5",
+    "-p", "other_node:traffic_collector.rules.camera.sampling:=7");
+
+  rcl_arguments_t local_arguments;
+  SCOPE_ARGS(
+    local_arguments, "process_name", "--ros-args",
+    "-p", "traffic_collector.rules.camera.enabled:=false",
+    "-p", "traffic_collector.rules.image.topic:=/camera/image");
+
+  {  // rule fields apply to the matching node only
+    rcl_node_t node = rcl_get_zero_initialized_node();
+    rcl_node_options_t options = rcl_node_get_default_options();
+    ASSERT_EQ(RCL_RET_OK, rcl_node_init(&node, "policy_node", "", &context, &options));
+    OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+    {
+      EXPECT_EQ(RCL_RET_OK, rcl_node_fini(&node)) << rcl_get_error_string().str;
+    });
+    rcl_collector_policy_match_t match = match_topic(&node, "/camera/image");
+    EXPECT_TRUE(match.enabled);
+    EXPECT_EQ(5u, match.sampling);
+    EXPECT_FALSE(match_topic(&node, "/camera/left/image").enabled);
+  }
+  {  // node arguments override global rule fields, rules keep their first position
+    rcl_node_t node = rcl_get_zero_initialized_node();
+    rcl_node_options_t options = rcl_node_get_default_options();
+    options.arguments = local_arguments;
+    ASSERT_EQ(RCL_RET_OK, rcl_node_init(&node, "policy_node", "", &context, &options));
+    OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+    {
+      EXPECT_EQ(RCL_RET_OK, rcl_node_fini(&node)) << rcl_get_error_string().str;
+    });
+    rcl_collector_policy_match_t match = match_topic(&node, "/camera/image");
+    EXPECT_FALSE(match.enabled);
+    EXPECT_TRUE(match_topic(&node, "/urg_chatter").enabled);
+  }
+  {  // global arguments are ignored if the node does not use them
+    rcl_node_t node = rcl_get_zero_initialized_node();
+    rcl_node_options_t options = rcl_node_get_default_options();
+    options.use_global_arguments = false;
+    options.arguments = local_arguments;
+    ASSERT_EQ(RCL_RET_OK, rcl_node_init(&node, "policy_node", "", &context, &options));
+    OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+    {
+      EXPECT_EQ(RCL_RET_OK, rcl_node_fini(&node)) << rcl_get_error_string().str;
+    });
+    rcl_collector_policy_match_t match = match_topic(&node, "/camera/image");
+    EXPECT_TRUE(match.enabled);
+    EXPECT_EQ(1u, match.sampling);
+  }
+}
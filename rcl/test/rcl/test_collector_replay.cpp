@@ -0,0 +1,205 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "rcl/collector_replay.h"
+#include "rcl/error_handling.h"
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+
+namespace
+{
+struct Trace
+{
+  std::vector<int64_t> times;
+  std::vector<size_t> sizes;
+};
+
+struct Update
+{
+  rcl_collector_replay_update_t update;
+  std::vector<rcl_collector_replay_component_t> components;
+};
+
+void
+record_update(const rcl_collector_replay_update_t * update, void * state)
+{
+  auto updates = static_cast<std::vector<Update> *>(state);
+  updates->push_back(
+    {*update, {update->components, update->components + update->component_count}});
+}
+
+// messages every period starting at 1 s, each cycle sending one per offset
+Trace
+make_trace(
+  size_t cycles, double period, const std::vector<std::pair<double, size_t>> & offsets,
+  double jitter)
+{
+  std::mt19937 generator(42);
+  std::normal_distribution<double> noise(0.0, jitter);
+  Trace trace;
+  for (size_t i = 0u; i < cycles; ++i) {
+    for (const auto & offset : offsets) {
+      double time = 1.0 + static_cast<double>(i) * period + offset.first + noise(generator);
+      trace.times.push_back(static_cast<int64_t>(time * 1e9));
+      trace.sizes.push_back(offset.second);
+    }
+  }
+  return trace;
+}
+}  // namespace
+
+TEST(TestCollectorReplay, test_invalid_arguments) {
+  rcl_collector_options_t options = {0u, 0u, 0.0, 0.0, 0u};
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_collector_replay_t replay = rcl_get_zero_initialized_collector_replay();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_collector_replay_init(nullptr, &options, 1u, nullptr, nullptr, allocator));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_collector_replay_init(&replay, nullptr, 1u, nullptr, nullptr, allocator));
+  rcl_reset_error();
+  rcl_allocator_t invalid_allocator = rcutils_get_zero_initialized_allocator();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_collector_replay_init(&replay, &options, 1u, nullptr, nullptr, invalid_allocator));
+  rcl_reset_error();
+
+  int64_t time = 0;
+  size_t size = 0u;
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_collector_replay_feed(&replay, &time, &size, 1u));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_OK, rcl_collector_replay_fini(&replay));
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_collector_replay_fini(nullptr));
+  rcl_reset_error();
+
+  ASSERT_EQ(
+    RCL_RET_OK, rcl_collector_replay_init(&replay, &options, 1u, nullptr, nullptr, allocator)) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_collector_replay_fini(&replay)) << rcl_get_error_string().str;
+  });
+  EXPECT_EQ(
+    RCL_RET_ALREADY_INIT,
+    rcl_collector_replay_init(&replay, &options, 1u, nullptr, nullptr, allocator));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_collector_replay_feed(&replay, nullptr, &size, 1u));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_collector_replay_feed(&replay, &time, nullptr, 1u));
+  rcl_reset_error();
+  // a replay without callback fits models all the same
+  EXPECT_EQ(RCL_RET_OK, rcl_collector_replay_feed(&replay, &time, &size, 1u));
+}
+
+TEST(TestCollectorReplay, test_periodic_trace) {
+  Trace trace = make_trace(3000u, 0.1, {{0.0, 128u}}, 1e-4);
+  rcl_collector_options_t options = {0u, 0u, 0.0, 0.0, 0u};
+  std::vector<Update> updates;
+  rcl_collector_replay_t replay = rcl_get_zero_initialized_collector_replay();
+  ASSERT_EQ(
+    RCL_RET_OK, rcl_collector_replay_init(
+      &replay, &options, 1u, record_update, &updates, rcl_get_default_allocator())) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_collector_replay_fini(&replay)) << rcl_get_error_string().str;
+  });
+
+  // feeding in batches is the same as feeding at once
+  size_t half = trace.times.size() / 2u;
+  ASSERT_EQ(
+    RCL_RET_OK, rcl_collector_replay_feed(&replay, trace.times.data(), trace.sizes.data(), half));
+  ASSERT_EQ(
+    RCL_RET_OK, rcl_collector_replay_feed(
+      &replay, trace.times.data() + half, trace.sizes.data() + half, trace.times.size() - half));
+
+  ASSERT_FALSE(updates.empty());
+  size_t last_sample = 0u;
+  for (const Update & update : updates) {
+    EXPECT_GT(update.update.sample, last_sample);
+    last_sample = update.update.sample;
+    EXPECT_NEAR(0.1, update.update.a, 1e-4);
+    EXPECT_NEAR(0.0, update.update.sigma_t, 1e-3);
+    EXPECT_DOUBLE_EQ(128.0, update.update.s);
+    EXPECT_EQ(0u, update.update.component_count);
+    // the phase is a message time of the trace
+    EXPECT_NEAR(0.0, std::remainder(update.update.b - 1.0, 0.1), 1e-3);
+    EXPECT_DOUBLE_EQ(
+      static_cast<double>(trace.times[update.update.sample - 1u]) * 1e-9, update.update.time);
+  }
+}
+
+TEST(TestCollectorReplay, test_composite_trace) {
+  // three messages of different sizes every 100 ms
+  Trace trace = make_trace(2000u, 0.1, {{0.0, 64u}, {0.01, 256u}, {0.03, 1024u}}, 5e-5);
+  rcl_collector_options_t options = {0u, 0u, 0.0, 0.0, 4u};
+  std::vector<Update> updates;
+  rcl_collector_replay_t replay = rcl_get_zero_initialized_collector_replay();
+  ASSERT_EQ(
+    RCL_RET_OK, rcl_collector_replay_init(
+      &replay, &options, 1u, record_update, &updates, rcl_get_default_allocator())) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_collector_replay_fini(&replay)) << rcl_get_error_string().str;
+  });
+  ASSERT_EQ(
+    RCL_RET_OK, rcl_collector_replay_feed(
+      &replay, trace.times.data(), trace.sizes.data(), trace.times.size()));
+
+  ASSERT_FALSE(updates.empty());
+  const Update & last = updates.back();
+  ASSERT_EQ(3u, last.update.component_count);
+  EXPECT_NEAR(0.1, last.update.cycle, 1e-4);
+  std::vector<double> sizes;
+  for (const auto & component : last.components) {
+    sizes.push_back(component.s);
+  }
+  std::sort(sizes.begin(), sizes.end());
+  EXPECT_DOUBLE_EQ(64.0, sizes[0]);
+  EXPECT_DOUBLE_EQ(256.0, sizes[1]);
+  EXPECT_DOUBLE_EQ(1024.0, sizes[2]);
+}
+
+TEST(TestCollectorReplay, test_sampling) {
+  Trace trace = make_trace(6000u, 0.1, {{0.0, 128u}}, 1e-4);
+  rcl_collector_options_t options = {0u, 0u, 0.0, 0.0, 0u};
+  std::vector<Update> updates;
+  rcl_collector_replay_t replay = rcl_get_zero_initialized_collector_replay();
+  ASSERT_EQ(
+    RCL_RET_OK, rcl_collector_replay_init(
+      &replay, &options, 2u, record_update, &updates, rcl_get_default_allocator())) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_collector_replay_fini(&replay)) << rcl_get_error_string().str;
+  });
+  ASSERT_EQ(
+    RCL_RET_OK, rcl_collector_replay_feed(
+      &replay, trace.times.data(), trace.sizes.data(), trace.times.size()));
+
+  // the period is reported for the topic, not for the collected samples
+  ASSERT_FALSE(updates.empty());
+  EXPECT_NEAR(0.1, updates.back().update.a, 1e-4);
+}
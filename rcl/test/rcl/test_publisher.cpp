@@ -370,6 +370,91 @@ TEST_F(CLASSNAME(TestPublisherFixture, RMW_IMPLEMENTATION), test_publisher_loan)
   }
 }
 
+/* Serialized message buffers are recycled through the publisher's bounded pool.
+ */
+TEST_F(
+  CLASSNAME(TestPublisherFixture, RMW_IMPLEMENTATION), test_publisher_serialized_message_pool)
+{
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Strings);
+  constexpr char topic_name[] = "chatter";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  rcl_publisher_t plain_publisher = rcl_get_zero_initialized_publisher();
+  rcl_ret_t ret =
+    rcl_publisher_init(&plain_publisher, this->node_ptr, ts, topic_name, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_ret_t ret = rcl_publisher_fini(&plain_publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  });
+  rcl_serialized_message_t * buffers[3] = {nullptr, nullptr, nullptr};
+  EXPECT_EQ(
+    RCL_RET_UNSUPPORTED, rcl_publisher_acquire_serialized_message(&plain_publisher, buffers));
+  rcl_reset_error();
+
+  publisher_options.serialized_message_pool_size = 2u;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic_name, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  });
+  EXPECT_EQ(RCL_RET_PUBLISHER_INVALID, rcl_publisher_acquire_serialized_message(nullptr, buffers));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT, rcl_publisher_acquire_serialized_message(&publisher, nullptr));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT, rcl_publisher_release_serialized_message(&publisher, nullptr));
+  rcl_reset_error();
+
+  // more buffers than the pool keeps can be in use at once
+  for (rcl_serialized_message_t *& buffer : buffers) {
+    ASSERT_EQ(RCL_RET_OK, rcl_publisher_acquire_serialized_message(&publisher, &buffer)) <<
+      rcl_get_error_string().str;
+    ASSERT_NE(nullptr, buffer);
+    EXPECT_EQ(0u, buffer->buffer_length);
+  }
+  EXPECT_NE(buffers[0], buffers[1]);
+  EXPECT_NE(buffers[1], buffers[2]);
+  EXPECT_NE(buffers[0], buffers[2]);
+
+  test_msgs__msg__Strings msg;
+  ASSERT_TRUE(test_msgs__msg__Strings__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__Strings__fini(&msg);
+  });
+  ASSERT_TRUE(rosidl_runtime_c__String__assign(&msg.string_value, "testing the pool"));
+  ASSERT_EQ(RMW_RET_OK, rmw_serialize(&msg, ts, buffers[0]));
+  size_t length = buffers[0]->buffer_length;
+  EXPECT_EQ(
+    RCL_RET_OK, rcl_publish_serialized_message(&publisher, buffers[0], nullptr)) <<
+    rcl_get_error_string().str;
+  for (rcl_serialized_message_t * buffer : buffers) {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_release_serialized_message(&publisher, buffer)) <<
+      rcl_get_error_string().str;
+  }
+
+  // the pool kept two of them, emptied and sized for the messages published
+  rcl_serialized_message_t * recycled[2] = {nullptr, nullptr};
+  for (rcl_serialized_message_t *& buffer : recycled) {
+    ASSERT_EQ(RCL_RET_OK, rcl_publisher_acquire_serialized_message(&publisher, &buffer)) <<
+      rcl_get_error_string().str;
+    EXPECT_TRUE(buffer == buffers[0] || buffer == buffers[1] || buffer == buffers[2]);
+    EXPECT_EQ(0u, buffer->buffer_length);
+    EXPECT_GE(buffer->buffer_capacity, length / 2u);
+  }
+  EXPECT_NE(recycled[0], recycled[1]);
+  for (rcl_serialized_message_t * buffer : recycled) {
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_release_serialized_message(&publisher, buffer)) <<
+      rcl_get_error_string().str;
+  }
+}
+
 TEST_F(CLASSNAME(TestPublisherFixture, RMW_IMPLEMENTATION), test_invalid_publisher) {
   rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
   const rosidl_message_type_support_t * ts =
@@ -587,6 +672,112 @@ TEST_F(CLASSNAME(TestPublisherFixtureInit, RMW_IMPLEMENTATION), test_mock_publis
   rcl_reset_error();
 }
 
+TEST_F(CLASSNAME(TestPublisherFixtureInit, RMW_IMPLEMENTATION), test_publish_batch) {
+  test_msgs__msg__BasicTypes msgs[3];
+  const void * messages[3];
+  for (size_t i = 0u; i < 3u; ++i) {
+    test_msgs__msg__BasicTypes__init(&msgs[i]);
+    msgs[i].int64_value = static_cast<int64_t>(i);
+    messages[i] = &msgs[i];
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    for (size_t i = 0u; i < 3u; ++i) {
+      test_msgs__msg__BasicTypes__fini(&msgs[i]);
+    }
+  });
+  size_t published_count = 42u;
+  EXPECT_EQ(
+    RCL_RET_PUBLISHER_INVALID, rcl_publish_batch(nullptr, messages, 3u, nullptr, &published_count));
+  EXPECT_EQ(0u, published_count);
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_OK, rcl_publish_batch(&publisher, nullptr, 0u, nullptr, &published_count));
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT, rcl_publish_batch(&publisher, nullptr, 3u, nullptr, nullptr));
+  rcl_reset_error();
+  const void * with_null[] = {&msgs[0], nullptr};
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_publish_batch(&publisher, with_null, 2u, nullptr, &published_count));
+  EXPECT_EQ(0u, published_count);
+  rcl_reset_error();
+
+  EXPECT_EQ(
+    RCL_RET_OK, rcl_publish_batch(&publisher, messages, 3u, nullptr, &published_count)) <<
+    rcl_get_error_string().str;
+  EXPECT_EQ(3u, published_count);
+
+  {
+    // publishing stops at the first message the middleware fails to publish
+    auto mock = mocking_utils::patch(
+      "lib:rcl", rmw_publish, [](auto, const void * ros_message, auto) {
+        const auto msg = static_cast<const test_msgs__msg__BasicTypes *>(ros_message);
+        return 1 == msg->int64_value ? RMW_RET_ERROR : RMW_RET_OK;
+      });
+    EXPECT_EQ(
+      RCL_RET_ERROR, rcl_publish_batch(&publisher, messages, 3u, nullptr, &published_count));
+    EXPECT_EQ(1u, published_count);
+    EXPECT_TRUE(rcl_error_is_set());
+    rcl_reset_error();
+  }
+}
+
+TEST_F(CLASSNAME(TestPublisherFixtureInit, RMW_IMPLEMENTATION), test_publisher_statistics) {
+  rcl_publisher_statistics_t statistics;
+  EXPECT_EQ(RCL_RET_PUBLISHER_INVALID, rcl_publisher_get_statistics(nullptr, &statistics));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_publisher_get_statistics(&publisher, nullptr));
+  rcl_reset_error();
+  rcl_ret_t ret = rcl_publisher_get_statistics(&publisher, &statistics);
+  if (RCL_RET_UNSUPPORTED == ret) {
+    // built without RCL_ENABLE_PUBLISHER_STATISTICS
+    rcl_reset_error();
+    return;
+  }
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(0u, statistics.message_count);
+  EXPECT_EQ(0u, statistics.byte_count);
+  EXPECT_EQ(0u, statistics.error_count);
+
+  test_msgs__msg__BasicTypes msg;
+  test_msgs__msg__BasicTypes__init(&msg);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__BasicTypes__fini(&msg);
+  });
+  for (int i = 0; i < 3; ++i) {
+    ret = rcl_publish(&publisher, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  }
+  rcl_serialized_message_t serialized_msg = rmw_get_zero_initialized_serialized_message();
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  ASSERT_EQ(RMW_RET_OK, rmw_serialized_message_init(&serialized_msg, 0u, &allocator));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RMW_RET_OK, rmw_serialized_message_fini(&serialized_msg));
+  });
+  ASSERT_EQ(RMW_RET_OK, rmw_serialize(&msg, ts, &serialized_msg));
+  ret = rcl_publish_serialized_message(&publisher, &serialized_msg, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  {
+    auto mock = mocking_utils::patch_and_return("lib:rcl", rmw_publish, RMW_RET_ERROR);
+    EXPECT_EQ(RCL_RET_ERROR, rcl_publish(&publisher, &msg, nullptr));
+    rcl_reset_error();
+  }
+
+  ret = rcl_publisher_get_statistics(&publisher, &statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(4u, statistics.message_count);
+  // only the serialized message has a size known to rcl, the topic has no collector
+  EXPECT_EQ(serialized_msg.buffer_length, statistics.byte_count);
+  EXPECT_EQ(1u, statistics.error_count);
+  uint64_t publish_count = 0u;
+  for (uint64_t count : statistics.publish_duration) {
+    publish_count += count;
+  }
+  EXPECT_EQ(5u, publish_count);
+}
+
 // Mocking rmw_publish_serialized_message to make rcl_publish_serialized_message fail
 TEST_F(
   CLASSNAME(TestPublisherFixtureInit, RMW_IMPLEMENTATION), test_mock_publish_serialized_message)
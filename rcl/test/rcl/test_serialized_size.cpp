@@ -0,0 +1,210 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "./serialized_size.h"
+
+#include "rcl/error_handling.h"
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+#include "rosidl_runtime_c/primitives_sequence_functions.h"
+#include "rosidl_runtime_c/string_functions.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+#include "rosidl_typesupport_introspection_c/identifier.h"
+#include "rosidl_typesupport_introspection_c/message_introspection.h"
+#include "test_msgs/msg/arrays.h"
+#include "test_msgs/msg/basic_types.h"
+#include "test_msgs/msg/nested.h"
+#include "test_msgs/msg/strings.h"
+#include "test_msgs/msg/unbounded_sequences.h"
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+
+#ifdef RMW_IMPLEMENTATION
+# define CLASSNAME_(NAME, SUFFIX) NAME ## __ ## SUFFIX
+# define CLASSNAME(NAME, SUFFIX) CLASSNAME_(NAME, SUFFIX)
+#else
+# define CLASSNAME(NAME, SUFFIX) NAME
+#endif
+
+// Middlewares may pad the end of the payload up to the next 4 byte boundary.
+constexpr size_t kTrailingPadding = 3u;
+
+class CLASSNAME (TestSerializedSizeFixture, RMW_IMPLEMENTATION) : public ::testing::Test
+{
+public:
+  void expect_estimate_matches(const rosidl_message_type_support_t * ts, const void * msg)
+  {
+    rcl_serialized_size_estimator_t estimator = rcl_get_zero_initialized_serialized_size_estimator();
+    ASSERT_EQ(RCL_RET_OK, rcl_serialized_size_estimator_init(&estimator, ts)) <<
+      rcl_get_error_string().str;
+
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    rmw_serialized_message_t serialized_message = rmw_get_zero_initialized_serialized_message();
+    ASSERT_EQ(RMW_RET_OK, rmw_serialized_message_init(&serialized_message, 0u, &allocator));
+    OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+    {
+      EXPECT_EQ(RMW_RET_OK, rmw_serialized_message_fini(&serialized_message));
+    });
+    ASSERT_EQ(RMW_RET_OK, rmw_serialize(msg, ts, &serialized_message)) <<
+      rmw_get_error_string().str;
+
+    size_t estimate = rcl_estimate_serialized_size(&estimator, msg);
+    EXPECT_LE(estimate, serialized_message.buffer_length);
+    EXPECT_LE(serialized_message.buffer_length, estimate + kTrailingPadding);
+  }
+};
+
+TEST_F(CLASSNAME(TestSerializedSizeFixture, RMW_IMPLEMENTATION), test_estimator_init) {
+  rcl_serialized_size_estimator_t estimator = rcl_get_zero_initialized_serialized_size_estimator();
+  EXPECT_EQ(0u, rcl_estimate_serialized_size(&estimator, nullptr));
+
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_serialized_size_estimator_init(nullptr, nullptr));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_serialized_size_estimator_init(&estimator, nullptr));
+  rcl_reset_error();
+
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  ASSERT_EQ(RCL_RET_OK, rcl_serialized_size_estimator_init(&estimator, ts)) <<
+    rcl_get_error_string().str;
+  EXPECT_NE(nullptr, estimator.estimate);
+  // no strings or sequences, the size is known up front
+  EXPECT_NE(0u, estimator.fixed_size);
+  EXPECT_EQ(estimator.fixed_size, rcl_estimate_serialized_size(&estimator, nullptr));
+
+  ts = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Strings);
+  ASSERT_EQ(RCL_RET_OK, rcl_serialized_size_estimator_init(&estimator, ts)) <<
+    rcl_get_error_string().str;
+  EXPECT_EQ(0u, estimator.fixed_size);
+}
+
+TEST_F(CLASSNAME(TestSerializedSizeFixture, RMW_IMPLEMENTATION), test_estimate_basic_types) {
+  test_msgs__msg__BasicTypes msg;
+  ASSERT_TRUE(test_msgs__msg__BasicTypes__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__BasicTypes__fini(&msg);
+  });
+  expect_estimate_matches(ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes), &msg);
+}
+
+TEST_F(CLASSNAME(TestSerializedSizeFixture, RMW_IMPLEMENTATION), test_estimate_arrays) {
+  test_msgs__msg__Arrays msg;
+  ASSERT_TRUE(test_msgs__msg__Arrays__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__Arrays__fini(&msg);
+  });
+  ASSERT_TRUE(rosidl_runtime_c__String__assign(&msg.string_values[1], "a string in an array"));
+  expect_estimate_matches(ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Arrays), &msg);
+}
+
+TEST_F(CLASSNAME(TestSerializedSizeFixture, RMW_IMPLEMENTATION), test_estimate_strings) {
+  test_msgs__msg__Strings msg;
+  ASSERT_TRUE(test_msgs__msg__Strings__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__Strings__fini(&msg);
+  });
+  const rosidl_message_type_support_t * ts = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Strings);
+  expect_estimate_matches(ts, &msg);
+  ASSERT_TRUE(rosidl_runtime_c__String__assign(&msg.string_value, "odd"));
+  expect_estimate_matches(ts, &msg);
+  ASSERT_TRUE(rosidl_runtime_c__String__assign(&msg.bounded_string_value, "even"));
+  expect_estimate_matches(ts, &msg);
+}
+
+TEST_F(CLASSNAME(TestSerializedSizeFixture, RMW_IMPLEMENTATION), test_estimate_unbounded_sequences) {
+  test_msgs__msg__UnboundedSequences msg;
+  ASSERT_TRUE(test_msgs__msg__UnboundedSequences__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__UnboundedSequences__fini(&msg);
+  });
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, UnboundedSequences);
+  expect_estimate_matches(ts, &msg);
+
+  // odd element counts so that every following member needs realignment
+  ASSERT_TRUE(rosidl_runtime_c__boolean__Sequence__init(&msg.bool_values, 3u));
+  ASSERT_TRUE(rosidl_runtime_c__int16__Sequence__init(&msg.int16_values, 5u));
+  ASSERT_TRUE(rosidl_runtime_c__float64__Sequence__init(&msg.float64_values, 7u));
+  ASSERT_TRUE(rosidl_runtime_c__String__Sequence__init(&msg.string_values, 2u));
+  ASSERT_TRUE(rosidl_runtime_c__String__assign(&msg.string_values.data[0], "first"));
+  ASSERT_TRUE(rosidl_runtime_c__int64__Sequence__init(&msg.int64_values, 1u));
+  expect_estimate_matches(ts, &msg);
+}
+
+TEST_F(CLASSNAME(TestSerializedSizeFixture, RMW_IMPLEMENTATION), test_estimate_nested) {
+  test_msgs__msg__Nested msg;
+  ASSERT_TRUE(test_msgs__msg__Nested__init(&msg));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__Nested__fini(&msg);
+  });
+  msg.basic_types_value.int64_value = 42;
+  expect_estimate_matches(ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Nested), &msg);
+}
+
+namespace
+{
+// No generated message has a wchar, this one places it after a byte to show its alignment.
+struct WCharMessage
+{
+  uint8_t uint8_value;
+  uint16_t wchar_value;
+  uint8_t char_value;
+};
+}  // namespace
+
+TEST_F(CLASSNAME(TestSerializedSizeFixture, RMW_IMPLEMENTATION), test_estimate_wchar) {
+  rosidl_typesupport_introspection_c__MessageMember members[3] = {};
+  members[0].name_ = "uint8_value";
+  members[0].type_id_ = rosidl_typesupport_introspection_c__ROS_TYPE_UINT8;
+  members[0].offset_ = offsetof(WCharMessage, uint8_value);
+  members[1].name_ = "wchar_value";
+  members[1].type_id_ = rosidl_typesupport_introspection_c__ROS_TYPE_WCHAR;
+  members[1].offset_ = offsetof(WCharMessage, wchar_value);
+  members[2].name_ = "char_value";
+  members[2].type_id_ = rosidl_typesupport_introspection_c__ROS_TYPE_CHAR;
+  members[2].offset_ = offsetof(WCharMessage, char_value);
+  rosidl_typesupport_introspection_c__MessageMembers message_members = {};
+  message_members.message_namespace_ = "test_msgs__msg";
+  message_members.message_name_ = "WCharMessage";
+  message_members.member_count_ = 3u;
+  message_members.size_of_ = sizeof(WCharMessage);
+  message_members.members_ = members;
+  rosidl_message_type_support_t ts = {};
+  ts.typesupport_identifier = rosidl_typesupport_introspection_c__identifier;
+  ts.data = &message_members;
+  ts.func = get_message_typesupport_handle_function;
+
+  rcl_serialized_size_estimator_t estimator = rcl_get_zero_initialized_serialized_size_estimator();
+  ASSERT_EQ(RCL_RET_OK, rcl_serialized_size_estimator_init(&estimator, &ts)) <<
+    rcl_get_error_string().str;
+  WCharMessage msg = {1u, 2u, 3u};
+  // encapsulation, the byte, padding to the 4 byte wchar, the wchar and the char
+  EXPECT_EQ(4u + 1u + 3u + 4u + 1u, rcl_estimate_serialized_size(&estimator, &msg));
+
+  // only the dynamic Fast-RTPS middleware serializes introspection type support
+  if (std::string(rmw_get_implementation_identifier()) == "rmw_fastrtps_dynamic_cpp") {
+    expect_estimate_matches(&ts, &msg);
+  }
+}
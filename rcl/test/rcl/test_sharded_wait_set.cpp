@@ -0,0 +1,249 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <vector>
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+#include "rcl/error_handling.h"
+#include "rcl/rcl.h"
+#include "rcl/sharded_wait_set.h"
+#include "rcl/work_deque.h"
+
+#ifdef RMW_IMPLEMENTATION
+# define CLASSNAME_(NAME, SUFFIX) NAME ## __ ## SUFFIX
+# define CLASSNAME(NAME, SUFFIX) CLASSNAME_(NAME, SUFFIX)
+#else
+# define CLASSNAME(NAME, SUFFIX) NAME
+#endif
+
+class CLASSNAME (TestShardedWaitSetFixture, RMW_IMPLEMENTATION) : public ::testing::Test
+{
+public:
+  rcl_context_t * context_ptr;
+  rcl_work_deque_t deque;
+
+  void SetUp()
+  {
+    rcl_ret_t ret;
+    rcl_init_options_t init_options = rcl_get_zero_initialized_init_options();
+    ret = rcl_init_options_init(&init_options, rcl_get_default_allocator());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+    {
+      EXPECT_EQ(RCL_RET_OK, rcl_init_options_fini(&init_options)) << rcl_get_error_string().str;
+    });
+    this->context_ptr = new rcl_context_t;
+    *this->context_ptr = rcl_get_zero_initialized_context();
+    ret = rcl_init(0, nullptr, &init_options, this->context_ptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    this->deque = rcl_get_zero_initialized_work_deque();
+    ret = rcl_work_deque_init(&this->deque, 4u, rcl_get_default_allocator());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  }
+
+  void TearDown()
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_work_deque_fini(&this->deque)) << rcl_get_error_string().str;
+    EXPECT_EQ(RCL_RET_OK, rcl_shutdown(this->context_ptr)) << rcl_get_error_string().str;
+    EXPECT_EQ(RCL_RET_OK, rcl_context_fini(this->context_ptr)) << rcl_get_error_string().str;
+    delete this->context_ptr;
+  }
+
+  // Pop the work pushed to the deque.
+  std::set<const rcl_sharded_work_t *> pop_all()
+  {
+    std::set<const rcl_sharded_work_t *> work;
+    void * item = nullptr;
+    while (rcl_work_deque_pop(&this->deque, &item)) {
+      EXPECT_TRUE(work.insert(static_cast<const rcl_sharded_work_t *>(item)).second);
+    }
+    return work;
+  }
+};
+
+TEST_F(CLASSNAME(TestShardedWaitSetFixture, RMW_IMPLEMENTATION), test_invalid_arguments) {
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_sharded_wait_set_t set = rcl_get_zero_initialized_sharded_wait_set();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_sharded_wait_set_init(nullptr, 2u, 0u, 2u, 0u, 0u, 0u, 0u, context_ptr, allocator));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_sharded_wait_set_init(&set, 0u, 0u, 2u, 0u, 0u, 0u, 0u, context_ptr, allocator));
+  rcl_reset_error();
+
+  rcl_guard_condition_t guard_condition = rcl_get_zero_initialized_guard_condition();
+  size_t work_count = 0u;
+  EXPECT_EQ(
+    RCL_RET_WAIT_SET_INVALID,
+    rcl_sharded_wait_set_add_guard_condition(&set, &guard_condition, nullptr));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_WAIT_SET_INVALID, rcl_sharded_wait_set_wait(&set, 0u, 0, &deque, &work_count));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_WAIT_SET_INVALID, rcl_sharded_wait_set_wake_all(&set));
+  rcl_reset_error();
+
+  ASSERT_EQ(
+    RCL_RET_OK,
+    rcl_sharded_wait_set_init(&set, 2u, 0u, 3u, 0u, 0u, 0u, 0u, context_ptr, allocator)) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_sharded_wait_set_fini(&set)) << rcl_get_error_string().str;
+  });
+  EXPECT_EQ(2u, set.size_of_shards);
+  EXPECT_EQ(
+    RCL_RET_ALREADY_INIT,
+    rcl_sharded_wait_set_init(&set, 2u, 0u, 2u, 0u, 0u, 0u, 0u, context_ptr, allocator));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT, rcl_sharded_wait_set_add_guard_condition(&set, nullptr, nullptr));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT, rcl_sharded_wait_set_wait(&set, 2u, 0, &deque, &work_count));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_sharded_wait_set_wait(&set, 0u, 0, nullptr, nullptr));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_sharded_wait_set_wake(&set, 2u));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_sharded_wait_set_remove(&set, nullptr));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_sharded_wait_set_done(&set, nullptr));
+  rcl_reset_error();
+
+  // Nothing is ready in an empty shard.
+  EXPECT_EQ(RCL_RET_TIMEOUT, rcl_sharded_wait_set_wait(&set, 0u, 0, &deque, &work_count));
+  rcl_reset_error();
+  EXPECT_EQ(0u, work_count);
+}
+
+TEST_F(CLASSNAME(TestShardedWaitSetFixture, RMW_IMPLEMENTATION), test_work_of_guard_conditions) {
+  rcl_sharded_wait_set_t set = rcl_get_zero_initialized_sharded_wait_set();
+  ASSERT_EQ(
+    RCL_RET_OK,
+    rcl_sharded_wait_set_init(
+      &set, 2u, 0u, 3u, 0u, 0u, 0u, 0u, context_ptr, rcl_get_default_allocator())) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_sharded_wait_set_fini(&set)) << rcl_get_error_string().str;
+  });
+
+  std::vector<rcl_guard_condition_t> guard_conditions(4u);
+  for (rcl_guard_condition_t & guard_condition : guard_conditions) {
+    guard_condition = rcl_get_zero_initialized_guard_condition();
+    ASSERT_EQ(
+      RCL_RET_OK,
+      rcl_guard_condition_init(
+        &guard_condition, context_ptr, rcl_guard_condition_get_default_options())) <<
+      rcl_get_error_string().str;
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    for (rcl_guard_condition_t & guard_condition : guard_conditions) {
+      EXPECT_EQ(RCL_RET_OK, rcl_guard_condition_fini(&guard_condition)) <<
+        rcl_get_error_string().str;
+    }
+  });
+
+  // Three guard conditions are spread across the two shards, the fourth does not fit.
+  std::vector<const rcl_sharded_work_t *> work(3u, nullptr);
+  for (size_t i = 0u; i < work.size(); ++i) {
+    ASSERT_EQ(
+      RCL_RET_OK,
+      rcl_sharded_wait_set_add_guard_condition(&set, &guard_conditions[i], &work[i])) <<
+      rcl_get_error_string().str;
+    ASSERT_NE(nullptr, work[i]);
+    EXPECT_EQ(RCL_SHARDED_WORK_GUARD_CONDITION, work[i]->type);
+    EXPECT_EQ(&guard_conditions[i], work[i]->entity);
+  }
+  EXPECT_EQ(0u, work[0]->shard);
+  EXPECT_EQ(1u, work[1]->shard);
+  EXPECT_EQ(0u, work[2]->shard);
+  EXPECT_EQ(
+    RCL_RET_WAIT_SET_FULL,
+    rcl_sharded_wait_set_add_guard_condition(&set, &guard_conditions[3], nullptr));
+  rcl_reset_error();
+
+  // The work of ready entities is pushed once, only to the deque of their shard.
+  for (size_t i = 0u; i < work.size(); ++i) {
+    ASSERT_EQ(RCL_RET_OK, rcl_trigger_guard_condition(&guard_conditions[i])) <<
+      rcl_get_error_string().str;
+  }
+  size_t work_count = 0u;
+  ASSERT_EQ(RCL_RET_OK, rcl_sharded_wait_set_wait(&set, 0u, RCL_MS_TO_NS(100), &deque, &work_count))
+    << rcl_get_error_string().str;
+  EXPECT_EQ(2u, work_count);
+  EXPECT_EQ((std::set<const rcl_sharded_work_t *>{work[0], work[2]}), pop_all());
+  ASSERT_EQ(RCL_RET_OK, rcl_sharded_wait_set_wait(&set, 1u, RCL_MS_TO_NS(100), &deque, &work_count))
+    << rcl_get_error_string().str;
+  EXPECT_EQ(1u, work_count);
+  EXPECT_EQ((std::set<const rcl_sharded_work_t *>{work[1]}), pop_all());
+
+  // Queued entities are not waited on until their work is done.
+  ASSERT_EQ(RCL_RET_OK, rcl_trigger_guard_condition(&guard_conditions[0])) <<
+    rcl_get_error_string().str;
+  EXPECT_EQ(
+    RCL_RET_TIMEOUT, rcl_sharded_wait_set_wait(&set, 0u, RCL_MS_TO_NS(10), &deque, &work_count));
+  rcl_reset_error();
+  EXPECT_EQ(0u, work_count);
+
+  // Handing back work wakes its shard, which waits for the entity again.
+  EXPECT_EQ(RCL_RET_OK, rcl_sharded_wait_set_done(&set, work[0])) << rcl_get_error_string().str;
+  ASSERT_EQ(RCL_RET_OK, rcl_sharded_wait_set_wait(&set, 0u, RCL_MS_TO_NS(100), &deque, &work_count))
+    << rcl_get_error_string().str;
+  if (0u == work_count) {
+    // The wake alone ended the wait, the guard condition is ready on the next one.
+    ASSERT_EQ(
+      RCL_RET_OK, rcl_sharded_wait_set_wait(&set, 0u, RCL_MS_TO_NS(100), &deque, &work_count)) <<
+      rcl_get_error_string().str;
+  }
+  EXPECT_EQ(1u, work_count);
+  EXPECT_EQ((std::set<const rcl_sharded_work_t *>{work[0]}), pop_all());
+
+  // Waking a shard ends its wait without any work.
+  EXPECT_EQ(RCL_RET_OK, rcl_sharded_wait_set_wake(&set, 1u)) << rcl_get_error_string().str;
+  ASSERT_EQ(RCL_RET_OK, rcl_sharded_wait_set_wait(&set, 1u, RCL_MS_TO_NS(100), &deque, &work_count))
+    << rcl_get_error_string().str;
+  EXPECT_EQ(0u, work_count);
+
+  // Removing queued work frees it once handed back, and makes room for another entity.
+  EXPECT_EQ(RCL_RET_OK, rcl_sharded_wait_set_remove(&set, work[1])) << rcl_get_error_string().str;
+  EXPECT_EQ(nullptr, work[1]->entity);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_sharded_wait_set_remove(&set, work[1]));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_OK, rcl_sharded_wait_set_done(&set, work[1])) << rcl_get_error_string().str;
+  const rcl_sharded_work_t * added = nullptr;
+  ASSERT_EQ(
+    RCL_RET_OK,
+    rcl_sharded_wait_set_add_guard_condition(&set, &guard_conditions[3], &added)) <<
+    rcl_get_error_string().str;
+  EXPECT_EQ(1u, added->shard);
+  ASSERT_EQ(RCL_RET_OK, rcl_trigger_guard_condition(&guard_conditions[3])) <<
+    rcl_get_error_string().str;
+  ASSERT_EQ(RCL_RET_OK, rcl_sharded_wait_set_wait(&set, 1u, RCL_MS_TO_NS(100), &deque, &work_count))
+    << rcl_get_error_string().str;
+  if (0u == work_count) {
+    ASSERT_EQ(
+      RCL_RET_OK, rcl_sharded_wait_set_wait(&set, 1u, RCL_MS_TO_NS(100), &deque, &work_count)) <<
+      rcl_get_error_string().str;
+  }
+  EXPECT_EQ(1u, work_count);
+  EXPECT_EQ((std::set<const rcl_sharded_work_t *>{added}), pop_all());
+}
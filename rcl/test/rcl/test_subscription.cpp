@@ -538,6 +538,174 @@ TEST_F(
   }
 }
 
+/* Messages coalesced into frames by the publisher are split again by the subscription
+ */
+TEST_F(CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription_coalesced) {
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  constexpr char topic[] = "rcl_test_subscription_coalesced_chatter";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  // frames only go out full or flushed during the test
+  publisher_options.coalescing.window = 60.0;
+  publisher_options.coalescing.max_messages = 3u;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  subscription_options.qos.depth = 10u;
+  subscription_options.split_coalesced_frames = true;
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  });
+  // frames go on a topic of their own, subscriptions not splitting them never see one
+  EXPECT_STREQ(
+    "/rcl_test_subscription_coalesced_chatter/_coalesced",
+    rcl_publisher_get_topic_name(&publisher));
+  EXPECT_STREQ(
+    "/rcl_test_subscription_coalesced_chatter/_coalesced",
+    rcl_subscription_get_topic_name(&subscription));
+  rcl_subscription_t plain_subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t plain_subscription_options = rcl_subscription_get_default_options();
+  ret = rcl_subscription_init(
+    &plain_subscription, this->node_ptr, ts, topic, &plain_subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_ret_t ret = rcl_subscription_fini(&plain_subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  });
+  ASSERT_TRUE(wait_for_established_subscription(&publisher, 10, 100));
+
+  test_msgs__msg__BasicTypes msg;
+  test_msgs__msg__BasicTypes__init(&msg);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__BasicTypes__fini(&msg);
+  });
+  for (int64_t i = 0; i < 5; ++i) {
+    msg.int64_value = i;
+    ret = rcl_publish(&publisher, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  }
+  // a serialized message is coalesced like any other
+  rcl_serialized_message_t serialized_msg = rmw_get_zero_initialized_serialized_message();
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  ASSERT_EQ(RMW_RET_OK, rmw_serialized_message_init(&serialized_msg, 0u, &allocator));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RMW_RET_OK, rmw_serialized_message_fini(&serialized_msg));
+  });
+  msg.int64_value = 5;
+  ASSERT_EQ(RMW_RET_OK, rmw_serialize(&msg, ts, &serialized_msg));
+  ret = rcl_publish_serialized_message(&publisher, &serialized_msg, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  msg.int64_value = 6;
+  ret = rcl_publish(&publisher, &msg, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  // two full frames are out, the last message waits for the window or a flush
+  ASSERT_TRUE(wait_for_subscription_to_be_ready(&subscription, context_ptr, 10, 100));
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  for (int64_t i = 0; i < 4; ++i) {
+    msg.int64_value = -1;
+    ret = rcl_take(&subscription, &msg, nullptr, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    EXPECT_EQ(i, msg.int64_value);
+  }
+
+  auto sequence = test_msgs__msg__BasicTypes__Sequence__create(5u);
+  rmw_message_sequence_t messages;
+  ASSERT_EQ(RMW_RET_OK, rmw_message_sequence_init(&messages, 5u, &allocator));
+  rmw_message_info_sequence_t message_infos;
+  ASSERT_EQ(RMW_RET_OK, rmw_message_info_sequence_init(&message_infos, 5u, &allocator));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rmw_message_info_sequence_fini(&message_infos);
+    rmw_message_sequence_fini(&messages);
+    test_msgs__msg__BasicTypes__Sequence__destroy(sequence);
+  });
+  for (size_t i = 0u; i < 5u; ++i) {
+    messages.data[i] = &sequence->data[i];
+  }
+  ret = rcl_take_sequence(&subscription, 5u, &messages, &message_infos, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  ASSERT_EQ(2u, messages.size);
+  EXPECT_EQ(4, sequence->data[0].int64_value);
+  EXPECT_EQ(5, sequence->data[1].int64_value);
+
+  ret = rcl_publisher_flush(&publisher);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  ASSERT_TRUE(wait_for_subscription_to_be_ready(&subscription, context_ptr, 10, 100));
+  ret = rcl_take(&subscription, &msg, nullptr, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(6, msg.int64_value);
+  ret = rcl_take(&subscription, &msg, nullptr, nullptr);
+  EXPECT_EQ(RCL_RET_SUBSCRIPTION_TAKE_FAILED, ret);
+
+  size_t publisher_count = 1u;
+  ret = rcl_subscription_get_publisher_count(&plain_subscription, &publisher_count);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(0u, publisher_count);
+  ret = rcl_take(&plain_subscription, &msg, nullptr, nullptr);
+  EXPECT_EQ(RCL_RET_SUBSCRIPTION_TAKE_FAILED, ret);
+}
+
+/* A frame whose window elapsed is published while its publisher is idle
+ */
+TEST_F(CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription_coalesced_idle) {
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  constexpr char topic[] = "rcl_test_subscription_coalesced_idle_chatter";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  publisher_options.coalescing.window = 0.05;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  subscription_options.split_coalesced_frames = true;
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  });
+  ASSERT_TRUE(wait_for_established_subscription(&publisher, 10, 100));
+
+  test_msgs__msg__BasicTypes msg;
+  test_msgs__msg__BasicTypes__init(&msg);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    test_msgs__msg__BasicTypes__fini(&msg);
+  });
+  msg.int64_value = 42;
+  ret = rcl_publish(&publisher, &msg, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  // no later message and no flush, the frame goes out once the window elapsed
+  ASSERT_TRUE(wait_for_subscription_to_be_ready(&subscription, context_ptr, 10, 100));
+  msg.int64_value = -1;
+  ret = rcl_take(&subscription, &msg, nullptr, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(42, msg.int64_value);
+}
+
 /* Basic nominal test of a subscription with take_serialize msg
  */
 TEST_F(CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription_serialized) {
@@ -15,6 +15,7 @@
 #include <gtest/gtest.h>
 #include <chrono>
 #include <thread>
+#include <vector>
 
 #include "rcl/timer.h"
 
@@ -870,6 +871,20 @@ TEST_F(TestPreInitTimer, test_timer_get_period) {
   rcl_reset_error();
 }
 
+TEST_F(TestPreInitTimer, test_timer_get_next_call_time) {
+  int64_t next_call_start = 0;
+  int64_t next_call_end = 0;
+  ASSERT_EQ(RCL_RET_OK, rcl_timer_get_next_call_time(&timer, &next_call_start));
+  ASSERT_EQ(RCL_RET_OK, rcl_timer_call(&timer)) << rcl_get_error_string().str;
+  ASSERT_EQ(RCL_RET_OK, rcl_timer_get_next_call_time(&timer, &next_call_end));
+  EXPECT_EQ(next_call_start + RCL_S_TO_NS(1), next_call_end);
+
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_timer_get_next_call_time(nullptr, &next_call_end));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_timer_get_next_call_time(&timer, nullptr));
+  rcl_reset_error();
+}
+
 TEST_F(TestPreInitTimer, test_time_since_last_call) {
   rcl_time_point_value_t time_sice_next_call_start = 0u;
   rcl_time_point_value_t time_sice_next_call_end = 0u;
@@ -880,3 +895,221 @@ TEST_F(TestPreInitTimer, test_time_since_last_call) {
   ASSERT_EQ(RCL_RET_OK, rcl_timer_get_time_since_last_call(&timer, &time_sice_next_call_end));
   EXPECT_GT(time_sice_next_call_end, time_sice_next_call_start);
 }
+
+struct wheel_call_t
+{
+  rcl_timer_wheel_entry_id_t id;
+  int64_t time;
+};
+
+static std::vector<wheel_call_t> wheel_calls;
+static rcl_clock_t * wheel_clock = nullptr;
+
+static void wheel_callback(rcl_timer_wheel_entry_id_t id, void * data)
+{
+  (void) data;
+  wheel_call_t call = {id, 0};
+  EXPECT_EQ(RCL_RET_OK, rcl_clock_get_now(wheel_clock, &call.time));
+  wheel_calls.push_back(call);
+}
+
+TEST_F(TestTimerFixture, test_timer_wheel_invalid_arguments) {
+  rcl_clock_t clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  ASSERT_EQ(RCL_RET_OK, rcl_clock_init(RCL_ROS_TIME, &clock, &allocator)) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&clock)) << rcl_get_error_string().str;
+  });
+  rcl_clock_t steady_clock;
+  ASSERT_EQ(RCL_RET_OK, rcl_clock_init(RCL_STEADY_TIME, &steady_clock, &allocator)) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&steady_clock)) << rcl_get_error_string().str;
+  });
+
+  rcl_timer_wheel_t wheel = rcl_get_zero_initialized_timer_wheel();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_timer_wheel_init(&wheel, &clock, context_ptr, RCL_MS_TO_NS(1), 8, allocator));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_timer_wheel_init(&wheel, &steady_clock, context_ptr, 0, 8, allocator));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_timer_wheel_init(&wheel, &steady_clock, context_ptr, RCL_MS_TO_NS(1), 0, allocator));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_timer_wheel_init(nullptr, &steady_clock, context_ptr, RCL_MS_TO_NS(1), 8, allocator));
+  rcl_reset_error();
+  EXPECT_EQ(nullptr, rcl_timer_wheel_get_timer(&wheel));
+
+  rcl_timer_wheel_entry_id_t id = 0;
+  EXPECT_EQ(
+    RCL_RET_TIMER_INVALID, rcl_timer_wheel_schedule(&wheel, 0, 0, wheel_callback, nullptr, &id));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_TIMER_INVALID, rcl_timer_wheel_cancel(&wheel, id));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_TIMER_INVALID, rcl_timer_wheel_advance(&wheel));
+  rcl_reset_error();
+
+  ASSERT_EQ(
+    RCL_RET_OK,
+    rcl_timer_wheel_init(&wheel, &steady_clock, context_ptr, RCL_MS_TO_NS(1), 1, allocator)) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_timer_wheel_fini(&wheel)) << rcl_get_error_string().str;
+  });
+  EXPECT_EQ(
+    RCL_RET_ALREADY_INIT,
+    rcl_timer_wheel_init(&wheel, &steady_clock, context_ptr, RCL_MS_TO_NS(1), 1, allocator));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_timer_wheel_schedule(&wheel, -1, 0, wheel_callback, nullptr, &id));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT, rcl_timer_wheel_schedule(&wheel, 0, 0, nullptr, nullptr, &id));
+  rcl_reset_error();
+  EXPECT_EQ(
+    RCL_RET_INVALID_ARGUMENT,
+    rcl_timer_wheel_schedule(&wheel, 0, 0, wheel_callback, nullptr, nullptr));
+  rcl_reset_error();
+
+  // The wheel's timer is canceled while there are no entries.
+  bool is_canceled = false;
+  rcl_timer_t * timer = rcl_timer_wheel_get_timer(&wheel);
+  ASSERT_NE(nullptr, timer);
+  ASSERT_EQ(RCL_RET_OK, rcl_timer_is_canceled(timer, &is_canceled));
+  EXPECT_TRUE(is_canceled);
+
+  ASSERT_EQ(
+    RCL_RET_OK, rcl_timer_wheel_schedule(&wheel, RCL_S_TO_NS(10), 0, wheel_callback, nullptr, &id));
+  EXPECT_NE(0u, id);
+  ASSERT_EQ(RCL_RET_OK, rcl_timer_is_canceled(timer, &is_canceled));
+  EXPECT_FALSE(is_canceled);
+  rcl_timer_wheel_entry_id_t other_id = 0;
+  EXPECT_EQ(
+    RCL_RET_ERROR, rcl_timer_wheel_schedule(&wheel, 0, 0, wheel_callback, nullptr, &other_id));
+  rcl_reset_error();
+
+  EXPECT_EQ(RCL_RET_OK, rcl_timer_wheel_cancel(&wheel, id)) << rcl_get_error_string().str;
+  EXPECT_EQ(RCL_RET_TIMER_CANCELED, rcl_timer_wheel_cancel(&wheel, id));
+  rcl_reset_error();
+  ASSERT_EQ(RCL_RET_OK, rcl_timer_is_canceled(timer, &is_canceled));
+  EXPECT_TRUE(is_canceled);
+
+  // The slot is reused under another identifier.
+  ASSERT_EQ(
+    RCL_RET_OK,
+    rcl_timer_wheel_schedule(&wheel, RCL_S_TO_NS(10), 0, wheel_callback, nullptr, &other_id));
+  EXPECT_NE(id, other_id);
+  EXPECT_EQ(RCL_RET_TIMER_CANCELED, rcl_timer_wheel_cancel(&wheel, id));
+  rcl_reset_error();
+}
+
+TEST_F(TestTimerFixture, test_timer_wheel_in_wait_set) {
+  rcl_clock_t clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  ASSERT_EQ(RCL_RET_OK, rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator)) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&clock)) << rcl_get_error_string().str;
+  });
+  wheel_clock = &clock;
+  wheel_calls.clear();
+
+  // With ticks of 1us the delays below span all four levels of the wheel.
+  rcl_timer_wheel_t wheel = rcl_get_zero_initialized_timer_wheel();
+  ASSERT_EQ(
+    RCL_RET_OK,
+    rcl_timer_wheel_init(&wheel, &clock, context_ptr, RCL_US_TO_NS(1), 16, allocator)) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_timer_wheel_fini(&wheel)) << rcl_get_error_string().str;
+  });
+  const int64_t delays[] = {
+    RCL_US_TO_NS(20), RCL_MS_TO_NS(2), RCL_MS_TO_NS(30), RCL_MS_TO_NS(300), RCL_MS_TO_NS(60)};
+  rcl_timer_wheel_entry_id_t ids[5];
+  int64_t start = 0;
+  ASSERT_EQ(RCL_RET_OK, rcl_clock_get_now(&clock, &start));
+  for (size_t i = 0; i < 5; ++i) {
+    ASSERT_EQ(
+      RCL_RET_OK,
+      rcl_timer_wheel_schedule(&wheel, delays[i], 0, wheel_callback, nullptr, &ids[i])) <<
+      rcl_get_error_string().str;
+  }
+  rcl_timer_wheel_entry_id_t periodic_id = 0;
+  ASSERT_EQ(
+    RCL_RET_OK,
+    rcl_timer_wheel_schedule(
+      &wheel, RCL_MS_TO_NS(25), RCL_MS_TO_NS(25), wheel_callback, nullptr, &periodic_id)) <<
+    rcl_get_error_string().str;
+  EXPECT_EQ(RCL_RET_OK, rcl_timer_wheel_cancel(&wheel, ids[4])) << rcl_get_error_string().str;
+
+  // The whole wheel is a single timer of the wait set.
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ASSERT_EQ(
+    RCL_RET_OK,
+    rcl_wait_set_init(&wait_set, 0, 0, 1, 0, 0, 0, context_ptr, allocator)) <<
+    rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    EXPECT_EQ(RCL_RET_OK, rcl_wait_set_fini(&wait_set)) << rcl_get_error_string().str;
+  });
+  size_t periodic_calls = 0;
+  while (wheel_calls.size() - periodic_calls < 4) {
+    ASSERT_EQ(RCL_RET_OK, rcl_wait_set_clear(&wait_set)) << rcl_get_error_string().str;
+    ASSERT_EQ(
+      RCL_RET_OK,
+      rcl_wait_set_add_timer(&wait_set, rcl_timer_wheel_get_timer(&wheel), NULL)) <<
+      rcl_get_error_string().str;
+    rcl_ret_t ret = rcl_wait(&wait_set, RCL_S_TO_NS(1));
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    if (NULL == wait_set.timers[0]) {
+      continue;
+    }
+    const size_t calls = wheel_calls.size();
+    ASSERT_EQ(RCL_RET_OK, rcl_timer_call(rcl_timer_wheel_get_timer(&wheel))) <<
+      rcl_get_error_string().str;
+    for (size_t i = calls; i < wheel_calls.size(); ++i) {
+      if (periodic_id == wheel_calls[i].id) {
+        ++periodic_calls;
+      }
+    }
+  }
+  EXPECT_EQ(RCL_RET_OK, rcl_timer_wheel_cancel(&wheel, periodic_id)) << rcl_get_error_string().str;
+
+  // Every entry was called once, in the order of its delay and never early.
+  const size_t expected_order[] = {0, 1, 2, 3};
+  size_t next = 0;
+  for (const wheel_call_t & call : wheel_calls) {
+    if (periodic_id == call.id) {
+      continue;
+    }
+    ASSERT_LT(next, 4u);
+    const size_t i = expected_order[next++];
+    EXPECT_EQ(ids[i], call.id);
+    EXPECT_GE(call.time - start, delays[i]);
+  }
+  EXPECT_GE(periodic_calls, 5u);
+
+  // Without entries the wheel's timer is canceled and the wait times out.
+  bool is_canceled = false;
+  ASSERT_EQ(RCL_RET_OK, rcl_timer_is_canceled(rcl_timer_wheel_get_timer(&wheel), &is_canceled));
+  EXPECT_TRUE(is_canceled);
+  ASSERT_EQ(RCL_RET_OK, rcl_wait_set_clear(&wait_set)) << rcl_get_error_string().str;
+  ASSERT_EQ(
+    RCL_RET_OK, rcl_wait_set_add_timer(&wait_set, rcl_timer_wheel_get_timer(&wheel), NULL)) <<
+    rcl_get_error_string().str;
+  EXPECT_EQ(RCL_RET_TIMEOUT, rcl_wait(&wait_set, RCL_MS_TO_NS(10)));
+  wheel_clock = nullptr;
+}
@@ -623,6 +623,236 @@ TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), add_with_index) {
   }
 }
 
+// Check that a persistent wait set keeps its entities and reports the ready ones
+TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), persistent) {
+  const size_t kNumEntities = 3u;
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  rcl_ret_t ret = rcl_wait_set_init(
+    &wait_set, 0, kNumEntities, 0, 0, 0, 0, context_ptr, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    ret = rcl_wait_set_fini(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  });
+
+  rcl_wait_set_ready_t ready;
+  EXPECT_FALSE(rcl_wait_set_is_persistent(&wait_set));
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_wait_set_get_ready(&wait_set, &ready));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_wait_set_remove_guard_condition(&wait_set, 0u));
+  rcl_reset_error();
+  ret = rcl_wait_set_set_persistent(&wait_set, true);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_TRUE(rcl_wait_set_is_persistent(&wait_set));
+
+  rcl_guard_condition_t guard_conditions[kNumEntities];
+  for (size_t i = 0u; i < kNumEntities; ++i) {
+    guard_conditions[i] = rcl_get_zero_initialized_guard_condition();
+    ret = rcl_guard_condition_init(
+      &guard_conditions[i], this->context_ptr, rcl_guard_condition_get_default_options());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    size_t index = 42u;
+    ret = rcl_wait_set_add_guard_condition(&wait_set, &guard_conditions[i], &index);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    EXPECT_EQ(i, index);
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    for (size_t i = 0u; i < kNumEntities; ++i) {
+      ret = rcl_guard_condition_fini(&guard_conditions[i]);
+      EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    }
+  });
+
+  // The entities stay in the wait set across waits, only the ready ones are reported.
+  for (size_t i = 0u; i < kNumEntities; ++i) {
+    ret = rcl_trigger_guard_condition(&guard_conditions[i]);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    ret = rcl_wait(&wait_set, RCL_MS_TO_NS(1000));
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    ret = rcl_wait_set_get_ready(&wait_set, &ready);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    ASSERT_EQ(1u, ready.size_of_guard_conditions);
+    EXPECT_EQ(i, ready.guard_conditions[0]);
+    EXPECT_EQ(0u, ready.size_of_subscriptions);
+    for (size_t j = 0u; j < kNumEntities; ++j) {
+      EXPECT_EQ(&guard_conditions[j], wait_set.guard_conditions[j]);
+    }
+  }
+  ret = rcl_wait(&wait_set, 0);
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret) << rcl_get_error_string().str;
+  ret = rcl_wait_set_get_ready(&wait_set, &ready);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(0u, ready.size_of_guard_conditions);
+
+  // A removed entity is not waited on, and its place is reused.
+  ret = rcl_wait_set_remove_guard_condition(&wait_set, 1u);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(nullptr, wait_set.guard_conditions[1]);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_wait_set_remove_guard_condition(&wait_set, 1u));
+  rcl_reset_error();
+  ret = rcl_trigger_guard_condition(&guard_conditions[1]);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  ret = rcl_wait(&wait_set, 0);
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret) << rcl_get_error_string().str;
+  size_t index = 42u;
+  ret = rcl_wait_set_add_guard_condition(&wait_set, &guard_conditions[1], &index);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(1u, index);
+  ret = rcl_trigger_guard_condition(&guard_conditions[1]);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(1000));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  ret = rcl_wait_set_get_ready(&wait_set, &ready);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  ASSERT_EQ(1u, ready.size_of_guard_conditions);
+  EXPECT_EQ(1u, ready.guard_conditions[0]);
+
+  // Leaving the persistent mode clears the wait set.
+  ret = rcl_wait_set_set_persistent(&wait_set, false);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(nullptr, wait_set.guard_conditions[0]);
+}
+
+// Check that a persistent wait set wakes for its first due timer only
+TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), persistent_timers) {
+  const size_t kNumTimers = 3u;
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  rcl_ret_t ret = rcl_wait_set_init(
+    &wait_set, 0, 0, kNumTimers, 0, 0, 0, context_ptr, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    ret = rcl_wait_set_fini(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  });
+  ret = rcl_wait_set_set_persistent(&wait_set, true);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+
+  rcl_clock_t clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  ret = rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    ret = rcl_clock_fini(&clock);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  });
+
+  // Added latest first, the heap has to reorder them.
+  const int64_t periods[kNumTimers] = {RCL_S_TO_NS(10), RCL_S_TO_NS(5), RCL_MS_TO_NS(10)};
+  rcl_timer_t timers[kNumTimers];
+  for (size_t i = 0u; i < kNumTimers; ++i) {
+    timers[i] = rcl_get_zero_initialized_timer();
+    ret = rcl_timer_init(
+      &timers[i], &clock, this->context_ptr, periods[i], nullptr, rcl_get_default_allocator());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    ret = rcl_wait_set_add_timer(&wait_set, &timers[i], NULL);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    for (size_t i = 0u; i < kNumTimers; ++i) {
+      ret = rcl_timer_fini(&timers[i]);
+      EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    }
+  });
+
+  rcl_wait_set_ready_t ready;
+  std::chrono::steady_clock::time_point before_sc = std::chrono::steady_clock::now();
+  ret = rcl_wait(&wait_set, -1);
+  std::chrono::steady_clock::time_point after_sc = std::chrono::steady_clock::now();
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  int64_t diff = std::chrono::duration_cast<std::chrono::nanoseconds>(after_sc - before_sc).count();
+  EXPECT_LE(diff, RCL_MS_TO_NS(10) + TOLERANCE);
+  ret = rcl_wait_set_get_ready(&wait_set, &ready);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  ASSERT_EQ(1u, ready.size_of_timers);
+  EXPECT_EQ(2u, ready.timers[0]);
+
+  // A called timer is due a period later, and a canceled one not at all.
+  ret = rcl_timer_call(&timers[2]);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  ret = rcl_wait(&wait_set, 0);
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret) << rcl_get_error_string().str;
+  ret = rcl_timer_cancel(&timers[2]);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(50));
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret) << rcl_get_error_string().str;
+  ret = rcl_wait_set_get_ready(&wait_set, &ready);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(0u, ready.size_of_timers);
+
+  // Resetting it makes it due again.
+  ret = rcl_timer_reset(&timers[2]);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(1000));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  ret = rcl_wait_set_get_ready(&wait_set, &ready);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  ASSERT_EQ(1u, ready.size_of_timers);
+  EXPECT_EQ(2u, ready.timers[0]);
+}
+
+// Check that the ready lists match the entities left in the wait set
+TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), ready_lists) {
+  const size_t kNumEntities = 3u;
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  rcl_ret_t ret = rcl_wait_set_init(
+    &wait_set, 0, kNumEntities, 0, 0, 0, 0, context_ptr, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    ret = rcl_wait_set_fini(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  });
+  ret = rcl_wait_set_set_ready_lists(&wait_set, true);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+
+  rcl_guard_condition_t guard_conditions[kNumEntities];
+  for (size_t i = 0u; i < kNumEntities; ++i) {
+    guard_conditions[i] = rcl_get_zero_initialized_guard_condition();
+    ret = rcl_guard_condition_init(
+      &guard_conditions[i], this->context_ptr, rcl_guard_condition_get_default_options());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT(
+  {
+    for (size_t i = 0u; i < kNumEntities; ++i) {
+      ret = rcl_guard_condition_fini(&guard_conditions[i]);
+      EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    }
+  });
+
+  rcl_wait_set_ready_t ready;
+  for (size_t i = 0u; i < kNumEntities; ++i) {
+    ret = rcl_wait_set_clear(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    for (size_t j = 0u; j < kNumEntities; ++j) {
+      ret = rcl_wait_set_add_guard_condition(&wait_set, &guard_conditions[j], NULL);
+      EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    }
+    ret = rcl_trigger_guard_condition(&guard_conditions[i]);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    ret = rcl_wait(&wait_set, RCL_MS_TO_NS(1000));
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    ret = rcl_wait_set_get_ready(&wait_set, &ready);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+    ASSERT_EQ(1u, ready.size_of_guard_conditions);
+    EXPECT_EQ(i, ready.guard_conditions[0]);
+    for (size_t j = 0u; j < kNumEntities; ++j) {
+      EXPECT_EQ(i == j ? &guard_conditions[j] : nullptr, wait_set.guard_conditions[j]);
+    }
+  }
+
+  ret = rcl_wait_set_set_ready_lists(&wait_set, false);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string().str;
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_wait_set_get_ready(&wait_set, &ready));
+  rcl_reset_error();
+}
+
 // Extra invalid arguments not tested
 TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), wait_set_valid_arguments) {
   rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
@@ -0,0 +1,134 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "rcl/error_handling.h"
+#include "rcl/work_deque.h"
+
+TEST(TestWorkDeque, test_invalid_arguments) {
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_work_deque_t deque = rcl_get_zero_initialized_work_deque();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_work_deque_init(nullptr, 4u, allocator));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_work_deque_init(&deque, 0u, allocator));
+  rcl_reset_error();
+
+  int item = 0;
+  void * popped = nullptr;
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_work_deque_push(&deque, &item));
+  rcl_reset_error();
+  EXPECT_FALSE(rcl_work_deque_pop(&deque, &popped));
+  EXPECT_FALSE(rcl_work_deque_steal(&deque, &popped));
+  EXPECT_EQ(0u, rcl_work_deque_size(&deque));
+
+  ASSERT_EQ(RCL_RET_OK, rcl_work_deque_init(&deque, 4u, allocator)) << rcl_get_error_string().str;
+  EXPECT_EQ(RCL_RET_ALREADY_INIT, rcl_work_deque_init(&deque, 4u, allocator));
+  rcl_reset_error();
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_work_deque_push(&deque, nullptr));
+  rcl_reset_error();
+  EXPECT_FALSE(rcl_work_deque_pop(&deque, nullptr));
+
+  EXPECT_EQ(RCL_RET_OK, rcl_work_deque_fini(&deque)) << rcl_get_error_string().str;
+  EXPECT_EQ(RCL_RET_OK, rcl_work_deque_fini(&deque)) << rcl_get_error_string().str;
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, rcl_work_deque_fini(nullptr));
+  rcl_reset_error();
+}
+
+TEST(TestWorkDeque, test_push_pop_steal) {
+  rcl_work_deque_t deque = rcl_get_zero_initialized_work_deque();
+  ASSERT_EQ(RCL_RET_OK, rcl_work_deque_init(&deque, 3u, rcl_get_default_allocator())) <<
+    rcl_get_error_string().str;
+
+  // Push past the capacity, so that the deque grows twice.
+  std::vector<int> items(13u);
+  for (int & item : items) {
+    ASSERT_EQ(RCL_RET_OK, rcl_work_deque_push(&deque, &item)) << rcl_get_error_string().str;
+  }
+  EXPECT_EQ(items.size(), rcl_work_deque_size(&deque));
+
+  // The owner takes the newest items, thieves the oldest ones.
+  void * item = nullptr;
+  ASSERT_TRUE(rcl_work_deque_pop(&deque, &item));
+  EXPECT_EQ(&items[12], item);
+  ASSERT_TRUE(rcl_work_deque_steal(&deque, &item));
+  EXPECT_EQ(&items[0], item);
+  ASSERT_TRUE(rcl_work_deque_steal(&deque, &item));
+  EXPECT_EQ(&items[1], item);
+  EXPECT_EQ(items.size() - 3u, rcl_work_deque_size(&deque));
+  for (size_t i = 11u; i >= 2u; --i) {
+    ASSERT_TRUE(rcl_work_deque_pop(&deque, &item));
+    EXPECT_EQ(&items[i], item);
+  }
+  EXPECT_FALSE(rcl_work_deque_pop(&deque, &item));
+  EXPECT_FALSE(rcl_work_deque_steal(&deque, &item));
+  EXPECT_EQ(0u, rcl_work_deque_size(&deque));
+
+  // The deque is usable again once emptied.
+  ASSERT_EQ(RCL_RET_OK, rcl_work_deque_push(&deque, &items[5])) << rcl_get_error_string().str;
+  ASSERT_TRUE(rcl_work_deque_steal(&deque, &item));
+  EXPECT_EQ(&items[5], item);
+
+  EXPECT_EQ(RCL_RET_OK, rcl_work_deque_fini(&deque)) << rcl_get_error_string().str;
+}
+
+TEST(TestWorkDeque, test_concurrent_steals) {
+  rcl_work_deque_t deque = rcl_get_zero_initialized_work_deque();
+  ASSERT_EQ(RCL_RET_OK, rcl_work_deque_init(&deque, 16u, rcl_get_default_allocator())) <<
+    rcl_get_error_string().str;
+
+  constexpr size_t number_of_items = 100000u;
+  std::vector<std::atomic<int>> taken(number_of_items);
+  for (std::atomic<int> & count : taken) {
+    count = 0;
+  }
+  std::atomic<bool> pushing{true};
+  std::vector<std::thread> thieves;
+  for (size_t i = 0u; i < 3u; ++i) {
+    thieves.emplace_back(
+      [&deque, &taken, &pushing]() {
+        void * item = nullptr;
+        while (pushing || rcl_work_deque_size(&deque) > 0u) {
+          if (rcl_work_deque_steal(&deque, &item)) {
+            ++*static_cast<std::atomic<int> *>(item);
+          }
+        }
+      });
+  }
+  // The owner pops every third item it pushes, and leaves the rest to thieves.
+  void * item = nullptr;
+  for (size_t i = 0u; i < number_of_items; ++i) {
+    EXPECT_EQ(RCL_RET_OK, rcl_work_deque_push(&deque, &taken[i]));
+    if (0u == i % 3u && rcl_work_deque_pop(&deque, &item)) {
+      ++*static_cast<std::atomic<int> *>(item);
+    }
+  }
+  pushing = false;
+  for (std::thread & thief : thieves) {
+    thief.join();
+  }
+  while (rcl_work_deque_pop(&deque, &item)) {
+    ++*static_cast<std::atomic<int> *>(item);
+  }
+
+  // Every item was taken exactly once.
+  for (size_t i = 0u; i < number_of_items; ++i) {
+    EXPECT_EQ(1, taken[i].load()) << "item " << i;
+  }
+  EXPECT_EQ(RCL_RET_OK, rcl_work_deque_fini(&deque)) << rcl_get_error_string().str;
+}